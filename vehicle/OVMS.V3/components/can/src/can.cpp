@@ -320,6 +320,11 @@ void can_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, con
     }
   }
 
+void can_listeners(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  MyCan.ShowListeners(writer);
+  }
+
 void can_clearstatus(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
   const char* bus = cmd->GetParent()->GetName();
@@ -387,20 +392,25 @@ void can_set_register(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int a
 
 canfilter::canfilter()
   {
+  vPortCPUInitializeMutex(&m_lock);
+  m_compiled = NULL;
   }
 
 canfilter::~canfilter()
   {
   ClearFilters();
+  FreeCompiled(m_compiled);
   }
 
 void canfilter::ClearFilters()
   {
+  OvmsMutexLock lock(&m_mutex);
   for (CAN_filter_t* filter : m_filters)
     {
     delete filter;
     }
   m_filters.clear();
+  Compile();
   }
 
 void canfilter::AddFilter(uint8_t bus, uint32_t id_from, uint32_t id_to)
@@ -409,7 +419,9 @@ void canfilter::AddFilter(uint8_t bus, uint32_t id_from, uint32_t id_to)
   f->bus = bus;
   f->id_from = id_from;
   f->id_to = id_to;
+  OvmsMutexLock lock(&m_mutex);
   m_filters.push_back(f);
+  Compile();
   }
 
 void canfilter::AddFilter(const char* filterstring)
@@ -440,55 +452,178 @@ void canfilter::AddFilter(const char* filterstring)
 
 bool canfilter::RemoveFilter(uint8_t bus, uint32_t id_from, uint32_t id_to)
   {
-  for (CAN_filter_t* filter : m_filters)
+  OvmsMutexLock lock(&m_mutex);
+  for (CAN_filter_list_t::iterator it = m_filters.begin(); it != m_filters.end(); ++it)
     {
+    CAN_filter_t* filter = *it;
     if ((filter->bus == bus)&&
         (filter->id_from == id_from)&&
         (filter->id_to == id_to))
       {
+      m_filters.erase(it);
       delete filter;
+      Compile();
       return true;
       }
     }
   return false;
   }
 
-bool canfilter::IsFiltered(const CAN_frame_t* p_frame)
+void canfilter::FreeCompiled(CAN_filter_compiled_t* compiled)
   {
-  if (m_filters.size() == 0) return true;
-  if (! p_frame) return false;
+  if (!compiled)
+    return;
+  for (int k = 0; k < CAN_FILTER_BUSKEYS; k++)
+    {
+    if (compiled->stdmap[k])
+      free(compiled->stdmap[k]);
+    }
+  delete compiled;
+  }
 
-  char buskey = '0';
-  if (p_frame->origin) buskey = p_frame->origin->m_busnumber + '1';
+/**
+ * Compile: build the per bus key lookup structures from the filter list
+ *  (called with m_mutex locked)
+ *  The new structures are built aside and swapped in under the spinlock,
+ *  so IsFiltered() never sees a partial state. If a bitmap cannot be
+ *  allocated, the standard IDs of that key are checked by range instead.
+ */
+void canfilter::Compile()
+  {
+  CAN_filter_compiled_t* c = new CAN_filter_compiled_t;
+  c->count = m_filters.size();
+  for (int k = 0; k < CAN_FILTER_BUSKEYS; k++)
+    {
+    c->stdmap[k] = NULL;
+    c->busfilter[k] = false;
+    }
 
   for (CAN_filter_t* filter : m_filters)
     {
-    if ((filter->bus)&&(filter->bus != buskey)) continue;
-    if ((p_frame->MsgID >= filter->id_from) && (p_frame->MsgID <= filter->id_to))
-      return true;
+    if (filter->bus > '0' && filter->bus < '0' + CAN_FILTER_BUSKEYS)
+      c->busfilter[filter->bus - '0'] = true;
+    if (filter->id_from > filter->id_to) continue;
+    for (int k = 0; k < CAN_FILTER_BUSKEYS; k++)
+      {
+      if ((filter->bus)&&(filter->bus != '0' + k)) continue;
+
+      // standard ID part:
+      if (filter->id_from <= 0x7ff)
+        {
+        uint32_t to = (filter->id_to > 0x7ff) ? 0x7ff : filter->id_to;
+        if (!c->stdmap[k])
+          c->stdmap[k] = (uint32_t*)ExternalRamCalloc(CAN_FILTER_STDWORDS, sizeof(uint32_t));
+        if (c->stdmap[k])
+          {
+          for (uint32_t id = filter->id_from; id <= to; id++)
+            c->stdmap[k][id >> 5] |= (1 << (id & 31));
+          }
+        else
+          {
+          ESP_LOGW(TAG, "canfilter: out of memory for ID bitmap, using range search");
+          c->ranges[k].push_back({ filter->id_from, to });
+          }
+        }
+
+      // extended ID part:
+      if (filter->id_to > 0x7ff)
+        {
+        CAN_filter_range_t range;
+        range.id_from = (filter->id_from > 0x7ff) ? filter->id_from : 0x800;
+        range.id_to = filter->id_to;
+        c->ranges[k].push_back(range);
+        }
+      }
     }
 
-  return false;
+  // sort & merge ranges:
+  for (int k = 0; k < CAN_FILTER_BUSKEYS; k++)
+    {
+    std::vector<CAN_filter_range_t>& ranges = c->ranges[k];
+    if (ranges.size() < 2) continue;
+    std::sort(ranges.begin(), ranges.end(),
+      [](const CAN_filter_range_t& a, const CAN_filter_range_t& b) { return a.id_from < b.id_from; });
+    std::vector<CAN_filter_range_t> merged;
+    for (auto& range : ranges)
+      {
+      if (!merged.empty() &&
+          (merged.back().id_to == UINT32_MAX || range.id_from <= merged.back().id_to + 1))
+        {
+        if (range.id_to > merged.back().id_to)
+          merged.back().id_to = range.id_to;
+        }
+      else
+        {
+        merged.push_back(range);
+        }
+      }
+    ranges.swap(merged);
+    }
+
+  portENTER_CRITICAL(&m_lock);
+  CAN_filter_compiled_t* old = m_compiled;
+  m_compiled = c;
+  portEXIT_CRITICAL(&m_lock);
+  FreeCompiled(old);
   }
 
-bool canfilter::IsFiltered(canbus* bus)
+bool canfilter::IsFiltered(const CAN_frame_t* p_frame)
   {
-  if (m_filters.size() == 0) return true;
-  if (bus == NULL) return true;
-
-  char buskey = bus->GetName()[3];
-
-  for (CAN_filter_t* filter : m_filters)
+  bool result;
+  portENTER_CRITICAL(&m_lock);
+  const CAN_filter_compiled_t* c = m_compiled;
+  if (!c || c->count == 0)
     {
-    if ((filter->bus)&&(filter->bus == buskey)) return true;
+    result = true;
     }
+  else if (!p_frame)
+    {
+    result = false;
+    }
+  else
+    {
+    int buskey = 0;
+    if (p_frame->origin) buskey = p_frame->origin->m_busnumber + 1;
+    uint32_t id = p_frame->MsgID;
+    if ((buskey < 0)||(buskey >= CAN_FILTER_BUSKEYS))
+      {
+      result = false;
+      }
+    else if (id <= 0x7ff && c->stdmap[buskey])
+      {
+      result = (c->stdmap[buskey][id >> 5] & (1 << (id & 31))) != 0;
+      }
+    else
+      {
+      // find the last range starting at or below the ID:
+      const std::vector<CAN_filter_range_t>& ranges = c->ranges[buskey];
+      auto it = std::upper_bound(ranges.begin(), ranges.end(), id,
+        [](uint32_t id, const CAN_filter_range_t& r) { return id < r.id_from; });
+      result = (it != ranges.begin()) && (id <= (--it)->id_to);
+      }
+    }
+  portEXIT_CRITICAL(&m_lock);
+  return result;
+  }
 
-  return false;
+bool canfilter::IsFiltered(canbus* bus)
+  {
+  bool result;
+  int buskey = bus ? bus->GetName()[3] - '0' : 0;
+  portENTER_CRITICAL(&m_lock);
+  const CAN_filter_compiled_t* c = m_compiled;
+  if (!c || c->count == 0 || bus == NULL)
+    result = true;
+  else
+    result = (buskey > 0 && buskey < CAN_FILTER_BUSKEYS && c->busfilter[buskey]);
+  portEXIT_CRITICAL(&m_lock);
+  return result;
   }
 
 std::string canfilter::Info()
   {
   std::ostringstream buf;
+  OvmsMutexLock lock(&m_mutex);
 
   for (CAN_filter_t* filter : m_filters)
     {
@@ -713,6 +848,7 @@ uint32_t can::AddPlayer(canplay* player, int filterc, const char* const* filterv
   OvmsMutexLock lock(&m_playermap_mutex);
   uint32_t id = m_player_id++;
   m_playermap[id] = player;
+  player->Start();
 
   return id;
   }
@@ -742,8 +878,8 @@ bool can::RemovePlayer(uint32_t id)
   auto k = m_playermap.find(id);
   if (k != m_playermap.end())
     {
+    k->second->Stop();
     k->second->Close();
-    vTaskDelay(pdMS_TO_TICKS(100)); // give logger task time to finish
     delete k->second;
     m_playermap.erase(k);
     return true;
@@ -757,8 +893,8 @@ void can::RemovePlayers()
 
   for (canplay_map_t::iterator it=m_playermap.begin(); it!=m_playermap.end();)
     {
+    it->second->Stop();
     it->second->Close();
-    vTaskDelay(pdMS_TO_TICKS(100)); // give logger task time to finish
     delete it->second;
     it = m_playermap.erase(it);
     }
@@ -825,6 +961,10 @@ can::can()
 
   m_logger_id = 1;
   m_player_id = 1;
+  m_listener_frames = 0;
+  m_listener_copies = 0;
+  m_dispatch = NULL;
+  m_dispatch_readers = 0;
 
   MyConfig.RegisterParam("can", "CAN Configuration", true, true);
 
@@ -856,6 +996,7 @@ can::can()
     }
 
   cmd_can->RegisterCommand("list", "List CAN buses", can_list);
+  cmd_can->RegisterCommand("listeners", "Show CAN frame listeners & routing", can_listeners);
 
   m_rxqueue = xQueueCreate(CONFIG_OVMS_HW_CAN_RX_QUEUE_SIZE,sizeof(CAN_queue_msg_t));
   xTaskCreatePinnedToCore(CAN_rxtask, "OVMS CanRx", 2*2048, (void*)this, 23, &m_rxtask, CORE(0));
@@ -896,22 +1037,334 @@ void can::IncomingFrame(CAN_frame_t* p_frame)
 
 void can::RegisterListener(QueueHandle_t queue, bool txfeedback)
   {
-  m_listeners[queue] = txfeedback;
+    {
+    OvmsMutexLock lock(&m_listeners_mutex);
+    auto it = m_listeners.begin();
+    for (; it != m_listeners.end(); ++it)
+      {
+      if (it->queue == queue)
+        break;
+      }
+    if (it != m_listeners.end())
+      {
+      it->txfeedback = txfeedback;
+      }
+    else if (m_listeners.size() >= CAN_MAXLISTENERS)
+      {
+      ESP_LOGE(TAG, "RegisterListener: max %d listeners reached", CAN_MAXLISTENERS);
+      return;
+      }
+    else
+      {
+      CAN_listener_t listener;
+      listener.queue = queue;
+      listener.txfeedback = txfeedback;
+      m_listeners.push_back(listener);
+      }
+    }
+  UpdateDispatch();
   }
 
 void can::DeregisterListener(QueueHandle_t queue)
   {
-  auto it = m_listeners.find(queue);
-  if (it != m_listeners.end())
+    {
+    OvmsMutexLock lock(&m_listeners_mutex);
+    auto it = m_listeners.begin();
+    for (; it != m_listeners.end(); ++it)
+      {
+      if (it->queue == queue)
+        break;
+      }
+    if (it == m_listeners.end())
+      return;
     m_listeners.erase(it);
+    }
+  UpdateDispatch();
+  }
+
+/**
+ * AddListenerFilter: restrict a registered listener to frames matching its filters
+ *  - a listener without filters receives all frames
+ *  - masks are supported for 11 bit IDs only
+ */
+bool can::AddListenerFilter(QueueHandle_t queue, const CAN_listener_filter_t& filter)
+  {
+  CAN_listener_filter_t f = filter;
+  uint32_t maxid = (f.ff == CAN_frame_std) ? 0x7ff : 0x1fffffff;
+  if (f.mask && f.ff != CAN_frame_std)
+    {
+    ESP_LOGE(TAG, "AddListenerFilter: masks are only supported for 11 bit IDs");
+    return false;
+    }
+  if (!f.mask)
+    {
+    if (f.to > maxid) f.to = maxid;
+    if (f.from > f.to)
+      {
+      ESP_LOGE(TAG, "AddListenerFilter: invalid ID range %x-%x", f.from, f.to);
+      return false;
+      }
+    }
+
+    {
+    OvmsMutexLock lock(&m_listeners_mutex);
+    auto it = m_listeners.begin();
+    for (; it != m_listeners.end(); ++it)
+      {
+      if (it->queue == queue)
+        break;
+      }
+    if (it == m_listeners.end())
+      {
+      ESP_LOGE(TAG, "AddListenerFilter: listener not registered");
+      return false;
+      }
+    for (auto& lf : it->filters)
+      {
+      if (lf.bus == f.bus && lf.ff == f.ff && lf.from == f.from && lf.to == f.to && lf.mask == f.mask)
+        return true; // already set
+      }
+    it->filters.push_back(f);
+    }
+  UpdateDispatch();
+  return true;
   }
 
+bool can::AddListenerBus(QueueHandle_t queue, canbus* bus)
+  {
+  return AddListenerRange(queue, bus, CAN_frame_std, 0, 0x7ff)
+      && AddListenerRange(queue, bus, CAN_frame_ext, 0, 0x1fffffff);
+  }
+
+bool can::AddListenerRange(QueueHandle_t queue, canbus* bus, CAN_frame_format_t ff, uint32_t from, uint32_t to)
+  {
+  CAN_listener_filter_t filter = { bus, ff, from, to, 0 };
+  return AddListenerFilter(queue, filter);
+  }
+
+bool can::AddListenerMask(QueueHandle_t queue, canbus* bus, uint32_t id, uint32_t mask)
+  {
+  CAN_listener_filter_t filter = { bus, CAN_frame_std, id, id, mask };
+  return AddListenerFilter(queue, filter);
+  }
+
+/**
+ * UpdateDispatch: replace the routing table after a listener change
+ *  The table is built from a copy of the listener list outside the listener
+ *  lock, then swapped in atomically. The old table is freed once no
+ *  NotifyListeners() call can still be using it.
+ */
+void can::UpdateDispatch()
+  {
+  OvmsMutexLock dlock(&m_dispatch_mutex);
+  CanListenerList_t listeners;
+    {
+    OvmsMutexLock lock(&m_listeners_mutex);
+    listeners = m_listeners;
+    }
+  CAN_dispatch_table_t* table = BuildDispatch(listeners);
+  CAN_dispatch_table_t* old = m_dispatch.exchange(table);
+  while (m_dispatch_readers.load() != 0)
+    vTaskDelay(1);
+  FreeDispatch(old);
+  }
+
+void can::FreeDispatch(CAN_dispatch_table_t* table)
+  {
+  if (!table)
+    return;
+  for (int b = 0; b < CAN_MAXBUSES; b++)
+    {
+    if (table->bus[b].std)
+      free(table->bus[b].std);
+    }
+  delete table;
+  }
+
+/**
+ * BuildDispatch: build the per bus routing tables from the listener filters
+ */
+CAN_dispatch_table_t* can::BuildDispatch(const CanListenerList_t& listeners)
+  {
+  CAN_dispatch_table_t* table = new CAN_dispatch_table_t;
+  table->all = 0;
+  table->tx = 0;
+  for (int b = 0; b < CAN_MAXBUSES; b++)
+    {
+    CAN_dispatch_t& d = table->bus[b];
+    d.stdall = d.extall = 0;
+    d.std = NULL;
+    }
+
+  for (int i = 0; i < listeners.size(); i++)
+    {
+    const CAN_listener_t& listener = listeners[i];
+    uint32_t bit = 1 << i;
+    table->queue[i] = listener.queue;
+    table->all |= bit;
+    if (listener.txfeedback)
+      table->tx |= bit;
+
+    if (listener.filters.empty())
+      {
+      for (int b = 0; b < CAN_MAXBUSES; b++)
+        {
+        table->bus[b].stdall |= bit;
+        table->bus[b].extall |= bit;
+        }
+      continue;
+      }
+
+    for (auto& f : listener.filters)
+      {
+      for (int b = 0; b < CAN_MAXBUSES; b++)
+        {
+        if (f.bus && f.bus->m_busnumber != b)
+          continue;
+        CAN_dispatch_t& d = table->bus[b];
+        if (f.ff == CAN_frame_ext)
+          {
+          if (f.from == 0 && f.to == 0x1fffffff)
+            d.extall |= bit;
+          else
+            d.ext.push_back({ f.from, f.to, bit });
+          }
+        else if (!f.mask && f.from == 0 && f.to == 0x7ff)
+          {
+          d.stdall |= bit;
+          }
+        else
+          {
+          if (!d.std)
+            d.std = (uint32_t*)ExternalRamCalloc(2048, sizeof(uint32_t));
+          if (!d.std)
+            {
+            d.stdall |= bit; // fallback: deliver all
+            continue;
+            }
+          for (uint32_t id = 0; id < 2048; id++)
+            {
+            if (f.mask ? ((id & f.mask) == (f.from & f.mask)) : (id >= f.from && id <= f.to))
+              d.std[id] |= bit;
+            }
+          }
+        }
+      }
+    }
+
+  for (int b = 0; b < CAN_MAXBUSES; b++)
+    {
+    CAN_dispatch_t& d = table->bus[b];
+
+    // Convert 29 bit ranges into sorted disjoint segments:
+    if (d.ext.size() < 2)
+      continue;
+    std::vector<uint32_t> points;
+    for (auto& r : d.ext)
+      {
+      points.push_back(r.from);
+      points.push_back(r.to + 1);
+      }
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    std::vector<CAN_idrange_t> segments;
+    for (int i = 0; i+1 < points.size(); i++)
+      {
+      CAN_idrange_t seg = { points[i], points[i+1] - 1, 0 };
+      for (auto& r : d.ext)
+        {
+        if (r.from <= seg.from && r.to >= seg.to)
+          seg.listeners |= r.listeners;
+        }
+      if (seg.listeners == 0)
+        continue;
+      if (!segments.empty() && segments.back().to + 1 == seg.from && segments.back().listeners == seg.listeners)
+        segments.back().to = seg.to;
+      else
+        segments.push_back(seg);
+      }
+    d.ext.swap(segments);
+    }
+
+  return table;
+  }
+
+uint32_t can::Route(const CAN_dispatch_table_t* table, const CAN_frame_t* frame)
+  {
+  if (!table)
+    return 0;
+  int b = frame->origin ? frame->origin->m_busnumber : -1;
+  if (b < 0 || b >= CAN_MAXBUSES)
+    return table->all;
+
+  const CAN_dispatch_t& d = table->bus[b];
+  if (frame->FIR.B.FF == CAN_frame_std)
+    return d.stdall | (d.std ? d.std[frame->MsgID & 0x7ff] : 0);
+
+  uint32_t listeners = d.extall;
+  if (!d.ext.empty())
+    {
+    // find the last segment starting at or below the ID:
+    auto it = std::upper_bound(d.ext.begin(), d.ext.end(), frame->MsgID,
+      [](uint32_t id, const CAN_idrange_t& r) { return id < r.from; });
+    if (it != d.ext.begin() && frame->MsgID <= (--it)->to)
+      listeners |= it->listeners;
+    }
+  return listeners;
+  }
+
+uint32_t can::RouteFrame(const CAN_frame_t* frame)
+  {
+  m_dispatch_readers++;
+  uint32_t listeners = Route(m_dispatch.load(), frame);
+  m_dispatch_readers--;
+  return listeners;
+  }
+
+/**
+ * NotifyListeners: queue a frame to the listeners routed to (lock free)
+ */
 void can::NotifyListeners(const CAN_frame_t* frame, bool tx)
   {
-  for (CanListenerMap_t::iterator it = m_listeners.begin(); it != m_listeners.end(); ++it)
+  m_dispatch_readers++;
+  const CAN_dispatch_table_t* table = m_dispatch.load();
+  uint32_t listeners = Route(table, frame);
+  if (tx && table)
+    listeners &= table->tx;
+  m_listener_frames++;
+  for (int i = 0; listeners; i++, listeners >>= 1)
     {
-    if (!tx || (tx && it->second))
-      xQueueSend(it->first,frame,0);
+    if (listeners & 1)
+      {
+      xQueueSend(table->queue[i], frame, 0);
+      m_listener_copies++;
+      }
+    }
+  m_dispatch_readers--;
+  }
+
+void can::ShowListeners(OvmsWriter* writer)
+  {
+  OvmsMutexLock lock(&m_listeners_mutex);
+  writer->printf("%d listeners, %u frames routed, %u queued (%.1f per frame)\n",
+    m_listeners.size(), m_listener_frames, m_listener_copies,
+    m_listener_frames ? (float)m_listener_copies / m_listener_frames : 0.0);
+  for (int i = 0; i < m_listeners.size(); i++)
+    {
+    CAN_listener_t& listener = m_listeners[i];
+    writer->printf("  #%d queue %p%s: %s\n", i, listener.queue,
+      listener.txfeedback ? " +tx" : "",
+      listener.filters.empty() ? "all frames" : "filtered");
+    for (auto& f : listener.filters)
+      {
+      const char* bus = f.bus ? f.bus->GetName() : "all";
+      if (f.mask)
+        writer->printf("    %s std %03x mask %03x\n", bus, f.from, f.mask);
+      else if (f.ff == CAN_frame_std)
+        writer->printf("    %s std %03x-%03x\n", bus, f.from, f.to);
+      else
+        writer->printf("    %s ext %08x-%08x\n", bus, f.from, f.to);
+      }
     }
   }
 
@@ -1053,7 +1506,7 @@ dbcfile* canbus::GetDBC()
   return m_dbcfile;
   }
 
-void canbus::BusTicker10(std::string event, void* data)
+void canbus::BusTicker10(const std::string& event, void* data)
   {
   if ((m_powermode==On)&&(StandardMetrics.ms_v_env_on->AsBool()))
     {
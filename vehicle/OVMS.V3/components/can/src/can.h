@@ -42,6 +42,8 @@
 #include <stdint.h>
 #include <functional>
 #include <list>
+#include <vector>
+#include <atomic>
 #include "pcp.h"
 #include <esp_err.h>
 #include "ovms_events.h"
@@ -211,6 +213,26 @@ typedef struct
 
 typedef std::list<CAN_filter_t*> CAN_filter_list_t;
 
+typedef struct
+  {
+  uint32_t id_from;
+  uint32_t id_to;
+  } CAN_filter_range_t;
+
+// The filter list is compiled into a lookup structure per bus key
+// ('0' = no origin, '1'…): a bitmap for IDs 0…0x7ff and sorted disjoint
+// ranges for higher IDs. Filters for all buses are merged into each key.
+#define CAN_FILTER_BUSKEYS    (CAN_MAXBUSES+1)
+#define CAN_FILTER_STDWORDS   (2048/32)
+
+typedef struct
+  {
+  size_t count;                                           // number of filters, 0 = pass all
+  uint32_t* stdmap[CAN_FILTER_BUSKEYS];                   // NULL = no bitmap, check ranges
+  std::vector<CAN_filter_range_t> ranges[CAN_FILTER_BUSKEYS];
+  bool busfilter[CAN_FILTER_BUSKEYS];                     // key has bus specific filters
+  } CAN_filter_compiled_t;
+
 class canfilter
   {
   public:
@@ -228,8 +250,15 @@ class canfilter
     bool IsFiltered(canbus* bus);
     std::string Info();
 
+  protected:
+    void Compile();
+    static void FreeCompiled(CAN_filter_compiled_t* compiled);
+
   protected:
     CAN_filter_list_t m_filters;
+    OvmsMutex m_mutex;                                        // filter list changes
+    portMUX_TYPE m_lock;                                      // m_compiled swap vs. IsFiltered()
+    CAN_filter_compiled_t* m_compiled;
   };
 
 ////////////////////////////////////////////////////////////////////////
@@ -312,7 +341,7 @@ class canbus : public pcp, public InternalRamAllocated
 
   protected:
     virtual esp_err_t QueueWrite(const CAN_frame_t* p_frame, TickType_t maxqueuewait=0);
-    void BusTicker10(std::string event, void* data);
+    void BusTicker10(const std::string& event, void* data);
 
   public:
     void LogFrame(CAN_log_type_t type, const CAN_frame_t* p_frame);
@@ -340,7 +369,54 @@ class canbus : public pcp, public InternalRamAllocated
 // can - the CAN system controller
 ////////////////////////////////////////////////////////////////////////
 
-typedef std::map<QueueHandle_t, bool> CanListenerMap_t;
+// Listener frame routing:
+//  Listeners without filters receive all frames. Filters restrict a listener
+//  to ID ranges or (11 bit) ID masks, per bus or on all buses. Frames are
+//  routed using a per bus dispatch table: a listener bitmap for 11 bit IDs
+//  and sorted disjoint ID ranges for 29 bit IDs.
+
+#define CAN_MAXLISTENERS 32       // Limit of number of listener queues supported
+
+typedef struct
+  {
+  canbus*             bus;        // NULL = all buses
+  CAN_frame_format_t  ff;
+  uint32_t            from;       // ID range from…to, or ID if mask is set
+  uint32_t            to;
+  uint32_t            mask;       // 0 = range filter, else (ID & mask) == (from & mask)
+  } CAN_listener_filter_t;
+
+typedef struct
+  {
+  QueueHandle_t       queue;
+  bool                txfeedback;
+  std::vector<CAN_listener_filter_t> filters;   // empty = all frames
+  } CAN_listener_t;
+
+typedef struct
+  {
+  uint32_t            from;
+  uint32_t            to;
+  uint32_t            listeners;  // listener bits
+  } CAN_idrange_t;
+
+typedef struct
+  {
+  uint32_t            stdall;     // listener bits for all 11 bit IDs on the bus
+  uint32_t            extall;     // listener bits for all 29 bit IDs on the bus
+  uint32_t*           std;        // 2048 listener bit sets for 11 bit IDs, NULL = none
+  std::vector<CAN_idrange_t> ext; // sorted disjoint ranges for 29 bit IDs
+  } CAN_dispatch_t;
+
+typedef struct
+  {
+  QueueHandle_t       queue[CAN_MAXLISTENERS];
+  uint32_t            all;        // listener bits for frames without known bus
+  uint32_t            tx;         // listener bits for tx feedback
+  CAN_dispatch_t      bus[CAN_MAXBUSES];
+  } CAN_dispatch_table_t;
+
+typedef std::vector<CAN_listener_t> CanListenerList_t;
 
 
 class CanFrameCallbackEntry
@@ -376,7 +452,22 @@ class can : public InternalRamAllocated
   public:
     void RegisterListener(QueueHandle_t queue, bool txfeedback=false);
     void DeregisterListener(QueueHandle_t queue);
+    bool AddListenerFilter(QueueHandle_t queue, const CAN_listener_filter_t& filter);
+    bool AddListenerBus(QueueHandle_t queue, canbus* bus);
+    bool AddListenerRange(QueueHandle_t queue, canbus* bus, CAN_frame_format_t ff, uint32_t from, uint32_t to);
+    bool AddListenerMask(QueueHandle_t queue, canbus* bus, uint32_t id, uint32_t mask);
+    uint32_t RouteFrame(const CAN_frame_t* frame);
     void NotifyListeners(const CAN_frame_t* frame, bool tx);
+    int ListenerCount() { return m_listeners.size(); }
+
+  protected:
+    void UpdateDispatch();
+    static CAN_dispatch_table_t* BuildDispatch(const CanListenerList_t& listeners);
+    static void FreeDispatch(CAN_dispatch_table_t* table);
+    static uint32_t Route(const CAN_dispatch_table_t* table, const CAN_frame_t* frame);
+
+  public:
+    void ShowListeners(OvmsWriter* writer);
 
   public:
     void RegisterCallback(const char* caller, CanFrameCallback callback, bool txfeedback=false);
@@ -419,7 +510,17 @@ class can : public InternalRamAllocated
 
   private:
     canbus* m_buslist[CAN_MAXBUSES];
-    CanListenerMap_t m_listeners;
+    CanListenerList_t m_listeners;
+    OvmsMutex m_listeners_mutex;
+    OvmsMutex m_dispatch_mutex;       // serializes dispatch table updates
+    std::atomic<CAN_dispatch_table_t*> m_dispatch;    // read lock free by NotifyListeners()
+    std::atomic<int> m_dispatch_readers;
+
+  public:
+    uint32_t m_listener_frames;       // frames routed
+    uint32_t m_listener_copies;       // frames queued to listeners
+
+  private:
     CanFrameCallbackList_t m_rxcallbacks;
     CanFrameCallbackList_t m_txcallbacks;
     TaskHandle_t m_rxtask;            // Task to handle reception
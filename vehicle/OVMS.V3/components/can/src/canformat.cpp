@@ -96,11 +96,31 @@ std::string canformat::get(CAN_log_message_t* message)
   return std::string("");
   }
 
+/**
+ * getbuf: format a message into a caller buffer (not terminated)
+ *  Returns the length written, 0 if the message has no output or does not fit.
+ *  CANFORMAT_MAXLEN bytes are sufficient for any message.
+ *  This default implementation uses get(), formats with high message rates
+ *  should override it to avoid the heap allocation.
+ */
+size_t canformat::getbuf(CAN_log_message_t* message, char* buffer, size_t size)
+  {
+  std::string result = get(message);
+  if (result.length() > size) return 0;
+  memcpy(buffer, result.data(), result.length());
+  return result.length();
+  }
+
 std::string canformat::getheader(struct timeval *time)
   {
   return std::string("");
   }
 
+std::string canformat::getfooter()
+  {
+  return std::string("");
+  }
+
 size_t canformat::put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata)
   {
   return 0;
@@ -159,6 +179,17 @@ size_t canformat::Stuff(uint8_t *buffer, size_t len)
   return consumed;
   }
 
+size_t canformat::GetStuffedSize()
+  {
+  return m_buf.UsedSpace();
+  }
+
+void canformat::ResetStuffing()
+  {
+  m_buf.EmptyAll();
+  m_servediscarding = false;
+  }
+
 canformat::canformat_serve_mode_t canformat::GetServeMode()
   {
   return m_servemode;
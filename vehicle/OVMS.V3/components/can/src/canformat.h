@@ -38,6 +38,7 @@
 using namespace std;
 
 #define CANFORMAT_SERVE_BUFFERSIZE 1024
+#define CANFORMAT_MAXLEN 256        // getbuf() buffer size sufficient for any message
 
 typedef void (*canformat_put_write_fn)(uint8_t *buffer, size_t len, void* data);
 
@@ -56,6 +57,8 @@ class canformat
   public: // Conversion from OVMS CAN log messages to specific format
     virtual std::string get(CAN_log_message_t* message);
     virtual std::string getheader(struct timeval *time = NULL);
+    virtual std::string getfooter();
+    virtual size_t getbuf(CAN_log_message_t* message, char* buffer, size_t size);
 
   public: // Conversion from specific format to OVMS CAN log messages
     virtual size_t put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata=NULL);
@@ -72,6 +75,8 @@ class canformat
     void SetPutCallback(canformat_put_write_fn callback);
     virtual size_t Serve(uint8_t *buffer, size_t len, void* userdata=NULL);
     virtual size_t Stuff(uint8_t *buffer, size_t len);
+    size_t GetStuffedSize();
+    virtual void ResetStuffing();
 
   protected:
     canformat_put_write_fn m_putcallback_fn;
@@ -0,0 +1,530 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        CAN logging framework
+;    Date:          18th January 2018
+;
+;    (C) 2018       Michael Balzer
+;    (C) 2019       Mark Webb-Johnson
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+#include "ovms_log.h"
+static const char *TAG = "canformat-cblock";
+
+#include <sys/param.h>
+#include "pcp.h"
+#include "ovms_malloc.h"
+#include "canformat_cblock.h"
+
+////////////////////////////////////////////////////////////////////////
+// Initialisation and Registration
+////////////////////////////////////////////////////////////////////////
+
+class OvmsCanFormatCBlockInit
+  {
+  public: OvmsCanFormatCBlockInit();
+} MyOvmsCanFormatCBlockInit  __attribute__ ((init_priority (4505)));
+
+OvmsCanFormatCBlockInit::OvmsCanFormatCBlockInit()
+  {
+  ESP_LOGI(TAG, "Registering CAN Format: CBLOCK (4505)");
+
+  MyCanFormatFactory.RegisterCanFormat<canformat_cblock>("cblock");
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Little endian & varint utilities
+////////////////////////////////////////////////////////////////////////
+
+static inline uint8_t* cb_put16(uint8_t* p, uint16_t v)
+  {
+  *p++ = v; *p++ = v >> 8;
+  return p;
+  }
+
+static inline uint8_t* cb_put32(uint8_t* p, uint32_t v)
+  {
+  *p++ = v; *p++ = v >> 8; *p++ = v >> 16; *p++ = v >> 24;
+  return p;
+  }
+
+static inline uint16_t cb_get16(const uint8_t* p)
+  {
+  return p[0] | (p[1] << 8);
+  }
+
+static inline uint32_t cb_get32(const uint8_t* p)
+  {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+static inline uint8_t* cb_putvarint(uint8_t* p, uint32_t v)
+  {
+  while (v >= 0x80)
+    {
+    *p++ = (v & 0x7f) | 0x80;
+    v >>= 7;
+    }
+  *p++ = v;
+  return p;
+  }
+
+static inline uint8_t cb_hash(uint32_t id, uint8_t flags)
+  {
+  return ((id ^ (flags << 29)) * 2654435761u) >> 24;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// CBLOCK format
+////////////////////////////////////////////////////////////////////////
+
+canformat_cblock::canformat_cblock(const char* type)
+  : canformat(type)
+  {
+  m_blk = (uint8_t*)ExternalRamMalloc(CBLOCK_BUFSIZE);
+  m_ids = (cblock_id_t*)ExternalRamMalloc(CBLOCK_MAXIDS * sizeof(cblock_id_t));
+  m_index = (cblock_index_t*)ExternalRamMalloc(CBLOCK_INDEXSIZE * sizeof(cblock_index_t));
+  m_dec_ids = (cblock_id_t*)ExternalRamMalloc(CBLOCK_MAXIDS * sizeof(cblock_id_t));
+
+  m_framelen = 0;
+  m_count = 0;
+  m_base_sec = 0;
+  m_base_usec = 0;
+  m_last_us = 0;
+  m_idcount = 0;
+  memset(m_hash, 0, sizeof(m_hash));
+  m_outpos = 0;
+  m_offset = CBLOCK_FILEHDRSIZE;
+  m_blockno = 0;
+  m_indexcount = 0;
+  m_indexstride = 1;
+
+  m_dstate = DecHeader;
+  m_dec_idcount = 0;
+  m_dec_idtotal = 0;
+  m_dec_count = 0;
+  m_dec_us = 0;
+  }
+
+canformat_cblock::~canformat_cblock()
+  {
+  if (m_blk) free(m_blk);
+  if (m_ids) free(m_ids);
+  if (m_index) free(m_index);
+  if (m_dec_ids) free(m_dec_ids);
+  }
+
+int canformat_cblock::FindId(cblock_id_t* ids, uint32_t id, uint8_t flags)
+  {
+  for (uint8_t h = cb_hash(id, flags); m_hash[h]; h++)
+    {
+    cblock_id_t* e = &ids[m_hash[h]-1];
+    if (e->id == id && e->flags == flags)
+      return m_hash[h]-1;
+    }
+  return -1;
+  }
+
+int canformat_cblock::AddId(uint32_t id, uint8_t flags)
+  {
+  uint8_t h = cb_hash(id, flags);
+  while (m_hash[h]) h++;
+  cblock_id_t* e = &m_ids[m_idcount];
+  e->id = id;
+  e->flags = flags;
+  e->dlc = 0xff;
+  m_hash[h] = ++m_idcount;
+  return m_idcount-1;
+  }
+
+/**
+ * CloseBlock: finish the current block & append it to the output queue
+ */
+void canformat_cblock::CloseBlock()
+  {
+  if (m_count == 0) return;
+
+  // Dictionary & header are placed in front of the frame data:
+  size_t dictlen = m_idcount * 5;
+  size_t blklen = CBLOCK_HDRSIZE + dictlen + m_framelen;
+  uint8_t* start = m_blk + CBLOCK_FRAMEOFS - dictlen - CBLOCK_HDRSIZE;
+  uint8_t* p = start;
+  p = cb_put32(p, CBLOCK_MAGIC_BLOCK);
+  p = cb_put16(p, dictlen + m_framelen);
+  p = cb_put16(p, m_count);
+  p = cb_put32(p, m_base_sec);
+  p = cb_put32(p, m_base_usec);
+  *p++ = m_idcount; *p++ = 0; *p++ = 0; *p++ = 0;
+  for (int k = 0; k < m_idcount; k++)
+    {
+    *p++ = m_ids[k].flags;
+    p = cb_put32(p, m_ids[k].id);
+    }
+  size_t queued = m_out.size() - m_outpos;
+  if (queued <= CBLOCK_OUTQUEUE && queued + blklen > CBLOCK_OUTQUEUE)
+    ESP_LOGW(TAG, "Output queue exceeds %u bytes, consumer too slow", CBLOCK_OUTQUEUE);
+  m_out.append((const char*)start, blklen);
+
+  // Index every m_indexstride'th block, decimate when full:
+  if ((m_blockno % m_indexstride) == 0)
+    {
+    if (m_indexcount == CBLOCK_INDEXSIZE)
+      {
+      for (int k = 0; k < CBLOCK_INDEXSIZE/2; k++)
+        m_index[k] = m_index[k*2];
+      m_indexcount = CBLOCK_INDEXSIZE/2;
+      m_indexstride *= 2;
+      }
+    if ((m_blockno % m_indexstride) == 0)
+      {
+      m_index[m_indexcount].offset = m_offset;
+      m_index[m_indexcount].ts_sec = m_base_sec;
+      m_indexcount++;
+      }
+    }
+  m_offset += blklen;
+  m_blockno++;
+
+  // Start next block:
+  m_count = 0;
+  m_framelen = 0;
+  m_idcount = 0;
+  memset(m_hash, 0, sizeof(m_hash));
+  }
+
+void canformat_cblock::EncodeFrame(CAN_log_message_t* message)
+  {
+  if (!m_blk || !m_ids || !m_index) return;
+
+  if ((message->type != CAN_LogFrame_RX)&&
+      (message->type != CAN_LogFrame_TX))
+    {
+    return;
+    }
+
+  uint8_t flags = (message->origin != NULL) ? (message->origin->m_busnumber & CBLOCK_FL_BUSMASK) : 0;
+  if (message->frame.FIR.B.FF == CAN_frame_ext) flags |= CBLOCK_FL_EXT;
+  if (message->type == CAN_LogFrame_TX) flags |= CBLOCK_FL_TX;
+  if (message->frame.FIR.B.RTR == CAN_RTR) flags |= CBLOCK_FL_RTR;
+  uint32_t id = message->frame.MsgID;
+  int64_t ts = (int64_t)message->timestamp.tv_sec * 1000000 + message->timestamp.tv_usec;
+
+  int idx = (m_count > 0) ? FindId(m_ids, id, flags) : -1;
+  if ((m_count > 0) &&
+      ((ts < m_last_us) || (ts - m_last_us > UINT32_MAX) ||
+       (idx < 0 && m_idcount == CBLOCK_MAXIDS) ||
+       (m_framelen + CBLOCK_MAXRECORD > CBLOCK_MAXDATA) ||
+       (m_count == UINT16_MAX)))
+    {
+    CloseBlock();
+    idx = -1;
+    }
+  if (m_count == 0)
+    {
+    m_base_sec = message->timestamp.tv_sec;
+    m_base_usec = message->timestamp.tv_usec;
+    m_last_us = ts;
+    }
+  if (idx < 0)
+    idx = AddId(id, flags);
+
+  uint8_t* p = m_blk + CBLOCK_FRAMEOFS + m_framelen;
+  p = cb_putvarint(p, ts - m_last_us);
+  m_last_us = ts;
+  *p++ = idx;
+
+  cblock_id_t* e = &m_ids[idx];
+  const uint8_t* data = message->frame.data.u8;
+  uint8_t dlc = MIN(message->frame.FIR.B.DLC, 8);
+  uint8_t mask = 0;
+  int changed = 0;
+  if (e->dlc == dlc)
+    {
+    for (int k = 0; k < dlc; k++)
+      {
+      if (data[k] != e->data[k])
+        {
+        mask |= (1 << k);
+        changed++;
+        }
+      }
+    }
+
+  if (e->dlc == dlc && changed == 0)
+    {
+    // repeat
+    *p++ = (1 << 4) | dlc;
+    }
+  else if (e->dlc == dlc && changed + 1 < dlc)
+    {
+    // delta
+    *p++ = (2 << 4) | dlc;
+    *p++ = mask;
+    for (int k = 0; k < dlc; k++)
+      {
+      if (mask & (1 << k)) *p++ = data[k];
+      }
+    }
+  else
+    {
+    // raw
+    *p++ = dlc;
+    memcpy(p, data, dlc);
+    p += dlc;
+    }
+
+  e->dlc = dlc;
+  memcpy(e->data, data, dlc);
+  m_framelen = p - (m_blk + CBLOCK_FRAMEOFS);
+  m_count++;
+  }
+
+std::string canformat_cblock::get(CAN_log_message_t* message)
+  {
+  EncodeFrame(message);
+  std::string result(m_out.data() + m_outpos, m_out.size() - m_outpos);
+  m_out.clear();
+  m_outpos = 0;
+  return result;
+  }
+
+/**
+ * getbuf: blocks are output as they complete, possibly spread over
+ *  multiple calls if the caller buffer is smaller than the block.
+ */
+size_t canformat_cblock::getbuf(CAN_log_message_t* message, char* buffer, size_t size)
+  {
+  EncodeFrame(message);
+  size_t len = MIN(m_out.size() - m_outpos, size);
+  if (len > 0)
+    {
+    memcpy(buffer, m_out.data() + m_outpos, len);
+    m_outpos += len;
+    if (m_outpos == m_out.size())
+      {
+      m_out.clear();
+      m_outpos = 0;
+      }
+    }
+  return len;
+  }
+
+std::string canformat_cblock::getheader(struct timeval *time)
+  {
+  uint8_t h[CBLOCK_FILEHDRSIZE];
+  cb_put32(h, CBLOCK_MAGIC_FILE);
+  h[4] = CBLOCK_VERSION;
+  h[5] = h[6] = h[7] = 0;
+
+  // New file: restart the index (pending output will follow the header)
+  m_offset = CBLOCK_FILEHDRSIZE + (m_out.size() - m_outpos);
+  m_blockno = 0;
+  m_indexcount = 0;
+  m_indexstride = 1;
+
+  return std::string((const char*)h, sizeof(h));
+  }
+
+/**
+ * getfooter: flush pending output & the current block, append the index
+ */
+std::string canformat_cblock::getfooter()
+  {
+  CloseBlock();
+  std::string result(m_out.data() + m_outpos, m_out.size() - m_outpos);
+  m_out.clear();
+  m_outpos = 0;
+  if (!m_index) return result;
+
+  uint32_t indexofs = m_offset;
+  uint8_t b[12];
+  cb_put32(b, CBLOCK_MAGIC_INDEX);
+  cb_put32(b+4, m_indexcount);
+  cb_put32(b+8, m_indexstride);
+  result.append((const char*)b, 12);
+  for (int k = 0; k < m_indexcount; k++)
+    {
+    cb_put32(b, m_index[k].offset);
+    cb_put32(b+4, m_index[k].ts_sec);
+    result.append((const char*)b, 8);
+    }
+  cb_put32(b, indexofs);
+  cb_put32(b+4, CBLOCK_MAGIC_END);
+  result.append((const char*)b, 8);
+
+  m_offset += result.length();
+  return result;
+  }
+
+void canformat_cblock::ResetStuffing()
+  {
+  canformat::ResetStuffing();
+  m_dstate = DecHeader;
+  m_dec_count = 0;
+  }
+
+size_t canformat_cblock::put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata)
+  {
+  if (m_buf.FreeSpace()==0) SetServeDiscarding(true); // Buffer full, so discard from now on
+  if (IsServeDiscarding()) return len;  // Quick return if discarding
+  if (!m_dec_ids) return len;
+
+  size_t consumed = Stuff(buffer,len);  // Stuff m_buf with as much as possible
+
+  uint8_t b[CBLOCK_HDRSIZE];
+  while (true)
+    {
+    size_t avail = m_buf.UsedSpace();
+    switch (m_dstate)
+      {
+      case DecHeader:
+        if (avail < 4) return consumed;
+        m_buf.Peek(4, b);
+        if (cb_get32(b) == CBLOCK_MAGIC_FILE)
+          {
+          if (avail < CBLOCK_FILEHDRSIZE) return consumed;
+          m_buf.Pop(CBLOCK_FILEHDRSIZE, b);
+          }
+        m_dstate = DecBlock;
+        break;
+
+      case DecBlock:
+        {
+        if (avail < 4) return consumed;
+        m_buf.Peek(4, b);
+        uint32_t magic = cb_get32(b);
+        if (magic == CBLOCK_MAGIC_BLOCK)
+          {
+          if (avail < CBLOCK_HDRSIZE) return consumed;
+          m_buf.Pop(CBLOCK_HDRSIZE, b);
+          m_dec_count = cb_get16(b+6);
+          m_dec_us = (int64_t)cb_get32(b+8) * 1000000 + cb_get32(b+12);
+          m_dec_idtotal = b[16];
+          m_dec_idcount = 0;
+          m_dstate = DecDict;
+          }
+        else if (magic == CBLOCK_MAGIC_INDEX)
+          {
+          // Index & trailer follow, no more frames
+          m_dstate = DecDone;
+          }
+        else
+          {
+          // Resynchronize on next block magic:
+          m_buf.Pop(1, b);
+          }
+        break;
+        }
+
+      case DecDict:
+        if (m_dec_idcount == m_dec_idtotal)
+          {
+          m_dstate = (m_dec_count > 0) ? DecFrames : DecBlock;
+          break;
+          }
+        if (m_dec_idtotal > CBLOCK_MAXIDS)
+          {
+          m_dstate = DecBlock;
+          break;
+          }
+        if (avail < 5) return consumed;
+        m_buf.Pop(5, b);
+        m_dec_ids[m_dec_idcount].flags = b[0];
+        m_dec_ids[m_dec_idcount].id = cb_get32(b+1);
+        m_dec_ids[m_dec_idcount].dlc = 0xff;
+        m_dec_idcount++;
+        break;
+
+      case DecFrames:
+        {
+        size_t n = m_buf.Peek(MIN(avail, (size_t)CBLOCK_MAXRECORD), b);
+        size_t pos = 0;
+        uint32_t dt = 0;
+        int shift = 0;
+        uint8_t v;
+        do
+          {
+          if (pos >= n) return consumed;
+          v = b[pos++];
+          dt |= (uint32_t)(v & 0x7f) << shift;
+          shift += 7;
+          } while ((v & 0x80) && shift < 35);
+        if (pos + 2 > n) return consumed;
+        uint8_t idx = b[pos++];
+        uint8_t mode = b[pos] >> 4;
+        uint8_t dlc = b[pos++] & 0x0f;
+        cblock_id_t* e = (idx < m_dec_idcount) ? &m_dec_ids[idx] : NULL;
+        if (!e || dlc > 8 || mode > 2 || (mode > 0 && e->dlc != dlc))
+          {
+          ESP_LOGW(TAG, "Invalid frame record, skipping block");
+          m_buf.Pop(1, b);
+          m_dstate = DecBlock;
+          break;
+          }
+        size_t need = pos;
+        if (mode == 0)
+          need += dlc;
+        else if (mode == 2)
+          need += 1 + ((pos < n) ? __builtin_popcount(b[pos]) : 0);
+        if (need > n || (mode == 2 && pos >= n))
+          {
+          if (n < CBLOCK_MAXRECORD) return consumed; // wait for more data
+          m_buf.Pop(1, b);
+          m_dstate = DecBlock;
+          break;
+          }
+
+        if (mode == 0)
+          {
+          memcpy(e->data, b+pos, dlc);
+          }
+        else if (mode == 2)
+          {
+          uint8_t mask = b[pos++];
+          for (int k = 0; k < dlc; k++)
+            {
+            if (mask & (1 << k)) e->data[k] = b[pos++];
+            }
+          }
+        e->dlc = dlc;
+        m_buf.Pop(need, b);
+
+        m_dec_us += dt;
+        message->type = (e->flags & CBLOCK_FL_TX) ? CAN_LogFrame_TX : CAN_LogFrame_RX;
+        message->timestamp.tv_sec = m_dec_us / 1000000;
+        message->timestamp.tv_usec = m_dec_us % 1000000;
+        message->origin = MyCan.GetBus(e->flags & CBLOCK_FL_BUSMASK);
+        message->frame.FIR.B.FF = (e->flags & CBLOCK_FL_EXT) ? CAN_frame_ext : CAN_frame_std;
+        message->frame.FIR.B.RTR = (e->flags & CBLOCK_FL_RTR) ? CAN_RTR : CAN_no_RTR;
+        message->frame.FIR.B.DLC = dlc;
+        message->frame.MsgID = e->id;
+        memcpy(message->frame.data.u8, e->data, dlc);
+
+        if (--m_dec_count == 0)
+          m_dstate = DecBlock;
+        return consumed;
+        }
+
+      case DecDone:
+        m_buf.EmptyAll();
+        return consumed;
+      }
+    }
+  }
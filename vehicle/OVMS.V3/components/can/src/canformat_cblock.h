@@ -0,0 +1,154 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        CAN logging framework
+;    Date:          18th January 2018
+;
+;    (C) 2018       Michael Balzer
+;    (C) 2019       Mark Webb-Johnson
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+#ifndef __CANFORMAT_CBLOCK_H__
+#define __CANFORMAT_CBLOCK_H__
+
+#include "canformat.h"
+
+/**
+ * cblock: compressed block CAN trace format (frames only, little endian)
+ *
+ * File header (8 bytes):
+ *    "OVCB", uint8 version, 3 bytes reserved
+ *
+ * Block:
+ *    uint32  magic "CBLK"
+ *    uint16  length of dictionary + frame data
+ *    uint16  frame count
+ *    uint32  base timestamp seconds
+ *    uint32  base timestamp microseconds
+ *    uint8   dictionary size, 3 bytes reserved
+ *    dictionary entries (5 bytes each):
+ *      uint8   flags: bits 0-2 = bus, 3 = extended, 4 = TX, 5 = RTR
+ *      uint32  CAN ID
+ *    frames:
+ *      varint  microseconds since previous frame (LEB128)
+ *      uint8   dictionary index
+ *      uint8   mode << 4 | DLC
+ *      mode 0: DLC data bytes
+ *      mode 1: no data, repeats the previous payload of this ID in the block
+ *      mode 2: uint8 change mask + changed bytes vs. the previous payload
+ *
+ * Index (appended on close, for seeking):
+ *    uint32  magic "CIDX", uint32 count, uint32 block stride
+ *    count × (uint32 file offset, uint32 timestamp seconds)
+ *    uint32  index file offset, uint32 magic "CEND"
+ *
+ * Blocks are self contained, readers can seek to any block start
+ * and resynchronize on the block magic after a truncated block.
+ *
+ * Completed blocks are appended to an output queue, which getbuf() drains
+ * in caller buffer sized parts, so a block can't be lost if the caller
+ * takes longer to fetch it than the next block takes to fill up.
+ */
+
+#define CBLOCK_VERSION          1
+#define CBLOCK_MAGIC_FILE       0x4243564f    // "OVCB"
+#define CBLOCK_MAGIC_BLOCK      0x4b4c4243    // "CBLK"
+#define CBLOCK_MAGIC_INDEX      0x58444943    // "CIDX"
+#define CBLOCK_MAGIC_END        0x444e4543    // "CEND"
+
+#define CBLOCK_FILEHDRSIZE      8
+#define CBLOCK_HDRSIZE          20
+#define CBLOCK_MAXIDS           128           // dictionary entries per block
+#define CBLOCK_MAXDATA          2048          // frame data bytes per block
+#define CBLOCK_MAXRECORD        16            // max encoded frame size
+#define CBLOCK_FRAMEOFS         (CBLOCK_HDRSIZE + CBLOCK_MAXIDS*5)
+#define CBLOCK_BUFSIZE          (CBLOCK_FRAMEOFS + CBLOCK_MAXDATA)
+#define CBLOCK_OUTQUEUE         (4 * CBLOCK_BUFSIZE)  // output queue warning level
+#define CBLOCK_INDEXSIZE        256           // max index entries (decimated)
+
+#define CBLOCK_FL_BUSMASK       0x07
+#define CBLOCK_FL_EXT           0x08
+#define CBLOCK_FL_TX            0x10
+#define CBLOCK_FL_RTR           0x20
+
+typedef struct
+  {
+  uint32_t id;
+  uint8_t flags;
+  uint8_t dlc;                  // 0xff = no payload yet
+  uint8_t data[8];
+  } cblock_id_t;
+
+typedef struct
+  {
+  uint32_t offset;
+  uint32_t ts_sec;
+  } cblock_index_t;
+
+class canformat_cblock : public canformat
+  {
+  public:
+    canformat_cblock(const char* type);
+    virtual ~canformat_cblock();
+
+  public:
+    virtual std::string get(CAN_log_message_t* message);
+    virtual std::string getheader(struct timeval *time);
+    virtual std::string getfooter();
+    virtual size_t getbuf(CAN_log_message_t* message, char* buffer, size_t size);
+    virtual size_t put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata=NULL);
+    virtual void ResetStuffing();
+
+  protected:
+    void EncodeFrame(CAN_log_message_t* message);
+    void CloseBlock();
+    int FindId(cblock_id_t* ids, uint32_t id, uint8_t flags);
+    int AddId(uint32_t id, uint8_t flags);
+
+  protected:
+    // Encoder:
+    uint8_t*            m_blk;            // block being filled
+    size_t              m_framelen;
+    uint16_t            m_count;
+    uint32_t            m_base_sec;
+    uint32_t            m_base_usec;
+    int64_t             m_last_us;
+    cblock_id_t*        m_ids;
+    uint8_t             m_idcount;
+    uint8_t             m_hash[256];      // ID hash → dictionary index + 1
+    extram::string      m_out;            // completed blocks output pending
+    size_t              m_outpos;         // output position in m_out
+    uint32_t            m_offset;         // stream offset of next block
+    uint32_t            m_blockno;
+    cblock_index_t*     m_index;
+    int                 m_indexcount;
+    uint32_t            m_indexstride;
+
+  protected:
+    // Decoder:
+    enum { DecHeader, DecBlock, DecDict, DecFrames, DecDone } m_dstate;
+    cblock_id_t*        m_dec_ids;
+    uint8_t             m_dec_idcount;
+    uint8_t             m_dec_idtotal;
+    uint16_t            m_dec_count;
+    int64_t             m_dec_us;
+  };
+
+#endif // __CANFORMAT_CBLOCK_H__
@@ -28,6 +28,7 @@
 static const char *TAG = "canformat-crtd";
 
 #include <errno.h>
+#include <sys/param.h>
 #include "pcp.h"
 #include "canformat_crtd.h"
 #include "ovms_utils.h"
@@ -56,7 +57,16 @@ canformat_crtd::~canformat_crtd()
 std::string canformat_crtd::get(CAN_log_message_t* message)
   {
   char buf[CANFORMAT_CRTD_MAXLEN];
-  char *p;
+  size_t len = getbuf(message, buf, sizeof(buf));
+  return std::string(buf, len);
+  }
+
+size_t canformat_crtd::getbuf(CAN_log_message_t* message, char* buffer, size_t size)
+  {
+  if (size < CANFORMAT_CRTD_MAXLEN) return 0;
+  size = CANFORMAT_CRTD_MAXLEN;
+  char *p = buffer;
+  int len;
 
   char busnumber;
   if (message->origin != NULL)
@@ -68,44 +78,43 @@ std::string canformat_crtd::get(CAN_log_message_t* message)
     {
     case CAN_LogFrame_RX:
     case CAN_LogFrame_TX:
-      snprintf(buf,sizeof(buf),"%ld.%06ld %c%c%s %0*X",
-        message->timestamp.tv_sec, message->timestamp.tv_usec,
-        busnumber,
-        (message->type == CAN_LogFrame_RX) ? 'R' : 'T',
-        (message->frame.FIR.B.FF == CAN_frame_std) ? "11":"29",
-        (message->frame.FIR.B.FF == CAN_frame_std) ? 3 : 8,
-        message->frame.MsgID);
-      p = buf+strlen(buf);
-      for (int k=0; k<message->frame.FIR.B.DLC; k++)
+    case CAN_LogFrame_TX_Queue:
+    case CAN_LogFrame_TX_Fail:
+      {
+      // i.e. "1524311386.811100 1R11 100 01 02 03"
+      //   or "1524311386.811100 1CER TX_Fail T11 100 01 02 03"
+      p = FormatUInt(p, message->timestamp.tv_sec);
+      *p++ = '.';
+      p = FormatUInt(p, message->timestamp.tv_usec, 6);
+      *p++ = ' ';
+      *p++ = busnumber;
+      if ((message->type == CAN_LogFrame_TX_Queue)||(message->type == CAN_LogFrame_TX_Fail))
+        {
+        *p++ = 'C'; *p++ = 'E'; *p++ = 'R'; *p++ = ' ';
+        for (const char* t = GetCanLogTypeName(message->type); *t; t++)
+          *p++ = *t;
+        *p++ = ' ';
+        }
+      *p++ = (message->type == CAN_LogFrame_RX) ? 'R' : 'T';
+      if (message->frame.FIR.B.FF == CAN_frame_std)
+        { *p++ = '1'; *p++ = '1'; }
+      else
+        { *p++ = '2'; *p++ = '9'; }
+      *p++ = ' ';
+      p = FormatHex(p, message->frame.MsgID,
+        (message->frame.FIR.B.FF == CAN_frame_std) ? 3 : 8, true);
+      int dlc = MIN(message->frame.FIR.B.DLC, 8);
+      for (int k=0; k<dlc; k++)
         {
         *p++ = ' ';
         p = HexByte(p,message->frame.data.u8[k]);
         }
-      *p = 0;
-      break;
-
-    case CAN_LogFrame_TX_Queue:
-    case CAN_LogFrame_TX_Fail:
-      snprintf(buf,sizeof(buf),"%ld.%06ld %cCER %s %c%s %0*X",
-        message->timestamp.tv_sec, message->timestamp.tv_usec,
-        busnumber,
-        GetCanLogTypeName(message->type),
-        (message->type == CAN_LogFrame_RX) ? 'R' : 'T',
-        (message->frame.FIR.B.FF == CAN_frame_std) ? "11":"29",
-        (message->frame.FIR.B.FF == CAN_frame_std) ? 3 : 8,
-        message->frame.MsgID);
-        p = buf+strlen(buf);
-        for (int k=0; k<message->frame.FIR.B.DLC; k++)
-          {
-          *p++ = ' ';
-          p = HexByte(p,message->frame.data.u8[k]);
-          }
-        *p = 0;
       break;
+      }
 
     case CAN_LogStatus_Error:
     case CAN_LogStatus_Statistics:
-      snprintf(buf,sizeof(buf),
+      len = snprintf(buffer,size-1,
         "%ld.%06ld %c%s %s intr=%d rxpkt=%d txpkt=%d errflags=%#x rxerr=%d txerr=%d"
         " rxinval=%d rxovr=%d txovr=%d txdelay=%d txfail=%d wdgreset=%d errreset=%d",
         message->timestamp.tv_sec, message->timestamp.tv_usec,
@@ -117,26 +126,29 @@ std::string canformat_crtd::get(CAN_log_message_t* message)
         message->status.rxbuf_overflow, message->status.txbuf_overflow,
         message->status.txbuf_delay, message->status.tx_fails, message->status.watchdog_resets,
         message->status.error_resets);
+      if (len < 0) return 0;
+      p = buffer + MIN((size_t)len, size-2);
       break;
 
     case CAN_LogInfo_Comment:
     case CAN_LogInfo_Config:
     case CAN_LogInfo_Event:
-      snprintf(buf,sizeof(buf),"%ld.%06ld %c%s %s %s",
+      len = snprintf(buffer,size-1,"%ld.%06ld %c%s %s %s",
         message->timestamp.tv_sec, message->timestamp.tv_usec,
         busnumber,
         (message->type == CAN_LogInfo_Event) ? "CEV" : "CXX",
         GetCanLogTypeName(message->type),
         message->text);
+      if (len < 0) return 0;
+      p = buffer + MIN((size_t)len, size-2);
       break;
 
     default:
-      buf[0] = 0;
-      break;
+      return 0;
     }
 
-  strcat(buf,"\n");
-  return std::string(buf);
+  *p++ = '\n';
+  return p - buffer;
   }
 
 std::string canformat_crtd::getheader(struct timeval *time)
@@ -171,10 +183,23 @@ size_t canformat_crtd::put(CAN_log_message_t* message, uint8_t *buffer, size_t l
     {
     std::string line = m_buf.ReadLine();
     const char *b = line.c_str();
+    char *p;
 
     // We look for something like
     // 1524311386.811100 1R11 100 01 02 03
     if (!isdigit(b[0])) return consumed;    // Discard invalid line
+    message->timestamp.tv_sec = strtol(b,&p,10);
+    if (*p == '.')
+      {
+      long usec = 0;
+      int digits = 0;
+      for (p++; isdigit(*p); p++)
+        {
+        if (digits++ < 6) usec = usec*10 + (*p - '0');
+        }
+      for (; digits < 6; digits++) usec *= 10;
+      message->timestamp.tv_usec = usec;
+      }
     for (;((*b != 0)&&(*b != ' '));b++) {}
     if (*b == 0) return consumed;           // Discard invalid line
     b++;
@@ -215,7 +240,6 @@ size_t canformat_crtd::put(CAN_log_message_t* message, uint8_t *buffer, size_t l
     if (b[3] != ' ') return consumed; // Discard invalid line
     b += 4;
 
-    char *p;
     errno = 0;
     message->frame.MsgID = (uint32_t)strtol(b,&p,16);
     if ((message->frame.MsgID == 0)&&(errno != 0)) return consumed; // Discard invalid line
@@ -30,7 +30,9 @@ static const char *TAG = "canformat-gvret";
 #include "canformat_gvret.h"
 #include <errno.h>
 #include <endian.h>
+#include <sys/param.h>
 #include "pcp.h"
+#include "ovms_utils.h"
 
 ////////////////////////////////////////////////////////////////////////
 // Initialisation and Registration
@@ -89,26 +91,39 @@ canformat_gvret_ascii::canformat_gvret_ascii(const char* type)
 std::string canformat_gvret_ascii::get(CAN_log_message_t* message)
   {
   char buf[CANFORMAT_GVRET_MAXLEN];
+  size_t len = getbuf(message, buf, sizeof(buf));
+  return std::string(buf, len);
+  }
+
+size_t canformat_gvret_ascii::getbuf(CAN_log_message_t* message, char* buffer, size_t size)
+  {
+  if (size < CANFORMAT_GVRET_MAXLEN) return 0;
 
   if ((message->type != CAN_LogFrame_RX)&&
       (message->type != CAN_LogFrame_TX))
     {
-    return std::string("");
+    return 0;
     }
 
-  char busnumber = (message->origin != NULL)?message->origin->m_busnumber + '0':'0';
-
-  sprintf(buf,"%u - %x %s %c %d",
-    (uint32_t)((message->timestamp.tv_sec * 1000000) + message->timestamp.tv_usec),
-    message->frame.MsgID,
-    (message->frame.FIR.B.FF == CAN_frame_std) ? "S" : "X",
-    busnumber,
-    message->frame.FIR.B.DLC);
-    for (int k=0; k<message->frame.FIR.B.DLC; k++)
-      sprintf(buf+strlen(buf)," %02x", message->frame.data.u8[k]);
-
-  strcat(buf,"\n");
-  return std::string(buf);
+  // i.e. "1000 - 100 S 0 4 01 02 03 04"
+  char *p = buffer;
+  p = FormatUInt(p, (uint32_t)message->timestamp.tv_sec * 1000000 + message->timestamp.tv_usec);
+  *p++ = ' '; *p++ = '-'; *p++ = ' ';
+  p = FormatHex(p, message->frame.MsgID);
+  *p++ = ' ';
+  *p++ = (message->frame.FIR.B.FF == CAN_frame_std) ? 'S' : 'X';
+  *p++ = ' ';
+  *p++ = (message->origin != NULL) ? message->origin->m_busnumber + '0' : '0';
+  *p++ = ' ';
+  p = FormatUInt(p, message->frame.FIR.B.DLC);
+  int dlc = MIN(message->frame.FIR.B.DLC, 8);
+  for (int k=0; k<dlc; k++)
+    {
+    *p++ = ' ';
+    p = HexByte(p, message->frame.data.u8[k]);
+    }
+  *p++ = '\n';
+  return p - buffer;
   }
 
 size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata)
@@ -125,7 +140,8 @@ size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, s
   else
     {
     std::string line = m_buf.ReadLine();
-    char *b = strdup(line.c_str());
+    char *s = strdup(line.c_str());
+    char *b = s;
 
     // We look for something like
     // 1000 - 100 S 0 4 01 02 03 04
@@ -134,8 +150,8 @@ size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, s
     message->type = CAN_LogFrame_RX;
 
     uint32_t timestamp = strtol(b,&b,10);
-    message->timestamp.tv_sec = timestamp % 1000000;
-    message->timestamp.tv_usec = timestamp / 1000000;
+    message->timestamp.tv_sec = timestamp / 1000000;
+    message->timestamp.tv_usec = timestamp % 1000000;
 
     b += 2; // Skip the '-'
 
@@ -151,7 +167,7 @@ size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, s
     else
       {
       // Bad frame type - discard
-      free(b);
+      free(s);
       return consumed;
       }
 
@@ -163,7 +179,7 @@ size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, s
     if (message->frame.FIR.B.DLC > 8)
       {
       // Bad frame length - discard
-      free(b);
+      free(s);
       return consumed;
       }
 
@@ -172,9 +188,9 @@ size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, s
       message->frame.data.u8[x] = strtol(b,&b,16);
       }
 
-    message->origin = MyCan.GetBus(busnumber-'0');
+    message->origin = MyCan.GetBus(busnumber);
 
-    free(b);
+    free(s);
     return consumed;
     }
   }
@@ -29,7 +29,7 @@
 
 #include "canformat.h"
 
-#define CANFORMAT_GVRET_MAXLEN 48
+#define CANFORMAT_GVRET_MAXLEN 64
 
 #define GVRET_SET_BINARY 0xe7
 #define GVRET_START_BYTE 0xf1
@@ -177,6 +177,7 @@ class canformat_gvret_ascii : public canformat_gvret
   public:
     canformat_gvret_ascii(const char* type);
     virtual std::string get(CAN_log_message_t* message);
+    virtual size_t getbuf(CAN_log_message_t* message, char* buffer, size_t size);
     virtual size_t put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata=NULL);
   };
 
@@ -28,7 +28,9 @@
 static const char *TAG = "canformat-lawricel";
 
 #include <errno.h>
+#include <sys/param.h>
 #include "pcp.h"
+#include "ovms_utils.h"
 #include "canformat_lawricel.h"
 
 ////////////////////////////////////////////////////////////////////////
@@ -63,28 +65,41 @@ canformat_lawricel::~canformat_lawricel()
 std::string canformat_lawricel::get(CAN_log_message_t* message)
   {
   char buf[CANFORMAT_LAWRICEL_MAXLEN];
+  size_t len = getbuf(message, buf, sizeof(buf));
+  return std::string(buf, len);
+  }
+
+size_t canformat_lawricel::getbuf(CAN_log_message_t* message, char* buffer, size_t size)
+  {
+  if (size < CANFORMAT_LAWRICEL_MAXLEN) return 0;
 
   if ((message->type != CAN_LogFrame_RX)&&
       (message->type != CAN_LogFrame_TX))
     {
-    return std::string("");
+    return 0;
     }
 
+  // i.e. "t1004010203040123"
+  char *p = buffer;
   if (message->frame.FIR.B.FF == CAN_frame_std)
     {
-    sprintf(buf,"t%03x%01d",message->frame.MsgID, message->frame.FIR.B.DLC);
+    *p++ = 't';
+    p = FormatHex(p, message->frame.MsgID, 3);
     }
   else
     {
-    sprintf(buf,"T%08x%01d",message->frame.MsgID, message->frame.FIR.B.DLC);
+    *p++ = 'T';
+    p = FormatHex(p, message->frame.MsgID, 8);
     }
+  p = FormatUInt(p, message->frame.FIR.B.DLC);
 
-  for (int k=0; k<message->frame.FIR.B.DLC; k++)
-    sprintf(buf+strlen(buf),"%02x", message->frame.data.u8[k]);
-  sprintf(buf+strlen(buf),"%04lx", message->timestamp.tv_usec/1000);
+  int dlc = MIN(message->frame.FIR.B.DLC, 8);
+  for (int k=0; k<dlc; k++)
+    p = HexByte(p, message->frame.data.u8[k]);
+  p = FormatHex(p, message->timestamp.tv_usec/1000, 4);
 
-  strcat(buf,"\n");
-  return std::string(buf);
+  *p++ = '\n';
+  return p - buffer;
   }
 
 std::string canformat_lawricel::getheader(struct timeval *time)
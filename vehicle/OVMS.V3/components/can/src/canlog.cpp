@@ -167,27 +167,38 @@ canlog::canlog(const char* type, std::string format, canformat::canformat_serve_
   m_msgcount = 0;
   m_dropcount = 0;
   m_filtercount = 0;
+  m_producing = true;
+  m_producers = 0;
 
   using std::placeholders::_1;
   using std::placeholders::_2;
   MyEvents.RegisterEvent(IDTAG, "*", std::bind(&canlog::EventListener, this, _1, _2));
 
-  int queuesize = MyConfig.GetParamValueInt("can", "log.queuesize",100);
-  m_queue = xQueueCreate(queuesize, sizeof(CAN_log_message_t));
+  // Frame ring size: next power of 2 of the configured queue size
+  int queuesize = MyConfig.GetParamValueInt("can", "log.queuesize",1024);
+  uint32_t ringsize = 16;
+  while (ringsize < queuesize && ringsize < 65536)
+    ringsize <<= 1;
+  m_ring = (CAN_log_record_t*)ExternalRamMalloc(ringsize * sizeof(CAN_log_record_t));
+  m_ringmask = (m_ring) ? ringsize-1 : 0;
+  m_ringhead = 0;
+  m_ringtail = 0;
+  m_ringidle = true;
+  vPortCPUInitializeMutex(&m_ringmux);
+
+  m_batch = (char*)ExternalRamMalloc(CANLOG_BATCH_SIZE);
+  m_batchlen = 0;
+  m_batchcount = 0;
+  m_batches = 0;
+
+  m_queue = xQueueCreate(CANLOG_INFOQUEUE_SIZE, sizeof(CAN_log_message_t));
   xTaskCreatePinnedToCore(RxTask, "OVMS CanLog", 4096, (void*)this, 10, &m_task, CORE(1));
   }
 
 canlog::~canlog()
   {
   MyEvents.DeregisterEvent(IDTAG);
-
-  if (m_task)
-    {
-    TaskHandle_t t = m_task;
-    m_task = NULL;
-
-    vTaskDelete(t);
-    }
+  Detach();
 
   if (m_queue)
     {
@@ -211,6 +222,18 @@ canlog::~canlog()
     vQueueDelete(q);
     }
 
+  if (m_ring)
+    {
+    free(m_ring);
+    m_ring = NULL;
+    }
+
+  if (m_batch)
+    {
+    free(m_batch);
+    m_batch = NULL;
+    }
+
   if (m_formatter)
     {
     delete m_formatter;
@@ -227,28 +250,112 @@ canlog::~canlog()
 void canlog::RxTask(void *context)
   {
   canlog* me = (canlog*) context;
-  CAN_log_message_t msg;
   while (1)
     {
-    if (xQueueReceive(me->m_queue, &msg, (portTickType)portMAX_DELAY) == pdTRUE)
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // Collect some more messages to output in one batch:
+    vTaskDelay(pdMS_TO_TICKS(CANLOG_BATCH_DELAY_MS));
+    OvmsMutexLock lock(&me->m_outputmutex);
+    me->Drain();
+    }
+  }
+
+/**
+ * StopProducers: reject further Log*() calls, wait for running calls to finish
+ */
+void canlog::StopProducers()
+  {
+  m_producing = false;
+  while (m_producers.load() != 0)
+    vTaskDelay(1);
+  }
+
+/**
+ * StartProducers: accept Log*() calls again
+ */
+void canlog::StartProducers()
+  {
+  m_producing = true;
+  }
+
+/**
+ * Detach: stop the producers and the logger task (idempotent)
+ *  Messages still in the ring & queue can be output by Drain() afterwards.
+ */
+void canlog::Detach()
+  {
+  StopProducers();
+  if (m_task)
+    {
+    OvmsMutexLock lock(&m_outputmutex);
+    TaskHandle_t t = m_task;
+    m_task = NULL;
+    vTaskDelete(t);
+    }
+  }
+
+/**
+ * Drain: output all queued messages & frame records in timestamp order,
+ *  then flush the batch. The ring is marked idle when found empty, so
+ *  the next frame producer will wake us.
+ *  Call with m_outputmutex locked.
+ */
+void canlog::Drain()
+  {
+  CAN_log_message_t msg, frame;
+  bool havemsg = (xQueueReceive(m_queue, &msg, 0) == pdTRUE);
+
+  while (true)
+    {
+    if (m_ringtail != m_ringhead)
+      {
+      const CAN_log_record_t* rec = &m_ring[m_ringtail & m_ringmask];
+      if (!havemsg ||
+          rec->ts_sec < msg.timestamp.tv_sec ||
+          (rec->ts_sec == msg.timestamp.tv_sec && rec->ts_usec <= msg.timestamp.tv_usec))
+        {
+        frame.type = (CAN_log_type_t) rec->type;
+        frame.timestamp.tv_sec = rec->ts_sec;
+        frame.timestamp.tv_usec = rec->ts_usec;
+        frame.frame.origin = MyCan.GetBus(rec->bus);
+        frame.frame.callback = NULL;
+        frame.frame.FIR.U = rec->fir;
+        frame.frame.MsgID = rec->msgid;
+        memcpy(frame.frame.data.u8, rec->data, 8);
+        m_ringtail++;
+        OutputMsg(frame);
+        continue;
+        }
+      }
+
+    if (havemsg)
       {
+      OutputMsg(msg);
       switch (msg.type)
         {
         case CAN_LogInfo_Comment:
         case CAN_LogInfo_Config:
         case CAN_LogInfo_Event:
-          me->OutputMsg(msg);
           free(msg.text);
           break;
         default:
-          me->OutputMsg(msg);
           break;
         }
+      havemsg = (xQueueReceive(m_queue, &msg, 0) == pdTRUE);
+      continue;
       }
+
+    portENTER_CRITICAL(&m_ringmux);
+    bool empty = (m_ringtail == m_ringhead);
+    if (empty) m_ringidle = true;
+    portEXIT_CRITICAL(&m_ringmux);
+    if (empty) break;
     }
+
+  FlushBatch();
   }
 
-void canlog::EventListener(std::string event, void* data)
+void canlog::EventListener(const std::string& event, void* data)
   {
   if (startsWith(event, "vehicle"))
     LogInfo(NULL, CAN_LogInfo_Event, event.c_str());
@@ -264,8 +371,43 @@ const char* canlog::GetFormat()
   return m_format.c_str();
   }
 
+/**
+ * OutputMsg: default implementation, adds the formatted message to the batch
+ */
 void canlog::OutputMsg(CAN_log_message_t& msg)
   {
+  if (m_formatter == NULL) return;
+
+  if (!m_batch)
+    {
+    char buf[CANFORMAT_MAXLEN];
+    size_t len = m_formatter->getbuf(&msg, buf, sizeof(buf));
+    m_batchends[0] = len;
+    if (len > 0) OutputBatch(buf, len, 1);
+    return;
+    }
+
+  if (CANLOG_BATCH_SIZE - m_batchlen < CANFORMAT_MAXLEN || m_batchcount == CANLOG_BATCH_MAXMSGS)
+    FlushBatch();
+  size_t len = m_formatter->getbuf(&msg, m_batch + m_batchlen, CANLOG_BATCH_SIZE - m_batchlen);
+  if (len > 0)
+    {
+    m_batchlen += len;
+    m_batchends[m_batchcount++] = m_batchlen;
+    }
+  }
+
+void canlog::OutputBatch(const char* data, size_t len, uint32_t count)
+  {
+  }
+
+void canlog::FlushBatch()
+  {
+  if (m_batchlen == 0) return;
+  OutputBatch(m_batch, m_batchlen, m_batchcount);
+  m_batches++;
+  m_batchlen = 0;
+  m_batchcount = 0;
   }
 
 std::string canlog::GetInfo()
@@ -297,13 +439,16 @@ std::string canlog::GetStats()
   std::ostringstream buf;
 
   float droprate = (m_msgcount > 0) ? ((float) m_dropcount/m_msgcount*100) : 0;
-  uint32_t waiting = uxQueueMessagesWaiting(m_queue);
+  uint32_t waiting = uxQueueMessagesWaiting(m_queue) + (m_ringhead - m_ringtail);
 
   buf << "total messages: " << m_msgcount
     << ", dropped: " << m_dropcount
     << ", filtered: " << m_filtercount
     << " = " << std::fixed << std::setprecision(1) << droprate << "%";
 
+  if (m_batches > 0)
+    buf << ", batches: " << m_batches;
+
   if (waiting > 0)
     buf << ", waiting: " << waiting;
 
@@ -330,27 +475,63 @@ void canlog::ClearFilter()
 
 void canlog::LogFrame(canbus* bus, CAN_log_type_t type, const CAN_frame_t* frame)
   {
-  if (!IsOpen() || !bus || !frame) return;
+  if (!bus || !frame) return;
+  m_producers++;
+  if (!m_producing || !IsOpen())
+    {
+    m_producers--;
+    return;
+    }
 
-  if (((m_filter == NULL)||(m_filter->IsFiltered(frame)))&&(m_queue))
+  if (((m_filter == NULL)||(m_filter->IsFiltered(frame)))&&(m_ring))
     {
-    CAN_log_message_t msg;
-    msg.type = type;
-    gettimeofday(&msg.timestamp,NULL);
-    memcpy(&msg.frame,frame,sizeof(CAN_frame_t));
-    msg.frame.origin = bus;
+    struct timeval timestamp;
+    gettimeofday(&timestamp,NULL);
+    bool notify = false;
+
+    portENTER_CRITICAL(&m_ringmux);
     m_msgcount++;
-    if (xQueueSend(m_queue, &msg, 0) != pdTRUE) m_dropcount++;
+    if (m_ringhead - m_ringtail > m_ringmask)
+      {
+      m_dropcount++;
+      }
+    else
+      {
+      CAN_log_record_t* rec = &m_ring[m_ringhead & m_ringmask];
+      rec->ts_sec = timestamp.tv_sec;
+      rec->ts_usec = timestamp.tv_usec;
+      rec->msgid = frame->MsgID;
+      rec->type = type;
+      rec->bus = bus->m_busnumber;
+      rec->fir = frame->FIR.U & 0xff;
+      memcpy(rec->data, frame->data.u8, 8);
+      m_ringhead++;
+      if (m_ringidle)
+        {
+        m_ringidle = false;
+        notify = true;
+        }
+      }
+    portEXIT_CRITICAL(&m_ringmux);
+
+    if (notify && m_task) xTaskNotifyGive(m_task);
     }
   else
     {
     m_filtercount++;
     }
+  m_producers--;
   }
 
 void canlog::LogStatus(canbus* bus, CAN_log_type_t type, const CAN_status_t* status)
   {
-  if (!IsOpen() || !bus) return;
+  if (!bus) return;
+  m_producers++;
+  if (!m_producing || !IsOpen())
+    {
+    m_producers--;
+    return;
+    }
 
   if (((m_filter == NULL)||(m_filter->IsFiltered(bus)))&&(m_queue))
     {
@@ -360,17 +541,27 @@ void canlog::LogStatus(canbus* bus, CAN_log_type_t type, const CAN_status_t* sta
     msg.origin = bus;
     memcpy(&msg.status,status,sizeof(CAN_status_t));
     m_msgcount++;
-    if (xQueueSend(m_queue, &msg, 0) != pdTRUE) m_dropcount++;
+    if (xQueueSend(m_queue, &msg, 0) != pdTRUE)
+      m_dropcount++;
+    else if (m_task)
+      xTaskNotifyGive(m_task);
     }
   else
     {
     m_filtercount++;
     }
+  m_producers--;
   }
 
 void canlog::LogInfo(canbus* bus, CAN_log_type_t type, const char* text)
   {
-  if (!IsOpen() || !text) return;
+  if (!text) return;
+  m_producers++;
+  if (!m_producing || !IsOpen())
+    {
+    m_producers--;
+    return;
+    }
 
   if (((m_filter == NULL)||(m_filter->IsFiltered(bus)))&&(m_queue))
     {
@@ -380,10 +571,17 @@ void canlog::LogInfo(canbus* bus, CAN_log_type_t type, const char* text)
     msg.origin = bus;
     msg.text = strdup(text);
     m_msgcount++;
-    if (xQueueSend(m_queue, &msg, 0) != pdTRUE) m_dropcount++;
+    if (xQueueSend(m_queue, &msg, 0) != pdTRUE)
+      {
+      free(msg.text);
+      m_dropcount++;
+      }
+    else if (m_task)
+      xTaskNotifyGive(m_task);
     }
   else
     {
     m_filtercount++;
     }
+  m_producers--;
   }
@@ -28,9 +28,28 @@
 #define __CANLOG_H__
 
 #include "freertos/semphr.h"
+#include <atomic>
 #include "can.h"
 #include "canformat.h"
 
+#define CANLOG_BATCH_SIZE       4096    // Output buffer size [bytes]
+#define CANLOG_BATCH_DELAY_MS   10      // Collect time before draining [ms]
+#define CANLOG_INFOQUEUE_SIZE   50      // Status & info message queue size
+#define CANLOG_BATCH_MAXMSGS    256     // Max messages per batch
+
+// Compact frame record for the logger ring buffer:
+typedef struct
+  {
+  uint32_t    ts_sec;
+  uint32_t    ts_usec;
+  uint32_t    msgid;
+  uint8_t     type;                     // CAN_log_type_t
+  uint8_t     bus;                      // bus number
+  uint8_t     fir;                      // FIR bits 0-7 (DLC, RTR, FF)
+  uint8_t     reserved;
+  uint8_t     data[8];
+  } CAN_log_record_t;
+
 /**
  * canlog is the general interface and base implementation for all can loggers.
  *  It provides standard methods to open files and configure message filters
@@ -44,6 +63,18 @@
  *  task for the logger, so logging doesn't affect CAN framework speed and
  *  a log can be written/streamed to a slow medium.
  *
+ * Frames are passed as compact records through a ring buffer, status and
+ *  info messages through a queue. The logger task drains both in batches:
+ *  OutputMsg() formats each message into the batch buffer, which is then
+ *  passed to OutputBatch() in one call (message boundaries in m_batchends).
+ *  Loggers that need to handle single messages (i.e. the monitor) override
+ *  OutputMsg() instead.
+ *
+ * Draining is serialized by m_outputmutex, so Close() implementations can
+ *  drain the remaining messages themselves. Sub class destructors need to
+ *  call Detach() first, to stop the producers and the logger task before
+ *  their state is destroyed.
+ *
  * Log entries can be frames, status or info messages (see CAN_LogEntry_t).
  * The timestamp of the original event is preserved.
  *
@@ -59,7 +90,7 @@ class canlog : public InternalRamAllocated
 
   public:
     static void RxTask(void* context);
-    void EventListener(std::string event, void* data);
+    void EventListener(const std::string& event, void* data);
 
   public:
     const char* GetType();
@@ -73,6 +104,14 @@ class canlog : public InternalRamAllocated
     virtual bool IsOpen() = 0;
     virtual std::string GetInfo();
     virtual void OutputMsg(CAN_log_message_t& msg);
+    virtual void OutputBatch(const char* data, size_t len, uint32_t count);
+
+  protected:
+    void Drain();
+    void FlushBatch();
+    void StopProducers();
+    void StartProducers();
+    void Detach();
 
   public:
     virtual void SetFilter(canfilter* filter);
@@ -92,7 +131,21 @@ class canlog : public InternalRamAllocated
 
   public:
     TaskHandle_t        m_task;
-    QueueHandle_t       m_queue;
+    QueueHandle_t       m_queue;          // status & info messages
+    CAN_log_record_t*   m_ring;           // frame records
+    uint32_t            m_ringmask;       // ring size - 1 (size is a power of 2)
+    volatile uint32_t   m_ringhead;       // producer index
+    volatile uint32_t   m_ringtail;       // consumer index
+    bool                m_ringidle;       // logger task waits for notification
+    portMUX_TYPE        m_ringmux;
+    OvmsMutex           m_outputmutex;    // Drain() & output: logger task vs. Close()
+    std::atomic<bool>   m_producing;      // Log*() calls accepted
+    std::atomic<int>    m_producers;      // Log*() calls running
+    char*               m_batch;
+    size_t              m_batchlen;
+    uint32_t            m_batchcount;     // messages in batch
+    uint16_t            m_batchends[CANLOG_BATCH_MAXMSGS];  // message end offsets in batch
+    uint32_t            m_batches;        // batches output
     uint32_t            m_msgcount;
     uint32_t            m_dropcount;
     uint32_t            m_filtercount;
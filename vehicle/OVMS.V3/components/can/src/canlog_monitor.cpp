@@ -79,6 +79,7 @@ canlog_monitor::canlog_monitor(std::string format)
 
 canlog_monitor::~canlog_monitor()
   {
+  Detach();
   }
 
 bool canlog_monitor::Open()
@@ -106,8 +107,9 @@ void canlog_monitor::OutputMsg(CAN_log_message_t& msg)
   {
   if (m_formatter == NULL) return;
 
-  std::string result = m_formatter->get(&msg);
-  if (result.length()>0)
+  char result[CANFORMAT_MAXLEN];
+  int len = m_formatter->getbuf(&msg, result, sizeof(result));
+  if (len>0)
     {
     switch (msg.type)
       {
@@ -115,16 +117,16 @@ void canlog_monitor::OutputMsg(CAN_log_message_t& msg)
       case CAN_LogFrame_TX:
       case CAN_LogFrame_TX_Queue:
       case CAN_LogFrame_TX_Fail:
-        ESP_LOGV(TAG,"%s",result.c_str());
+        ESP_LOGV(TAG,"%.*s",len,result);
         break;
       case CAN_LogStatus_Error:
-        ESP_LOGE(TAG,"%s",result.c_str());
+        ESP_LOGE(TAG,"%.*s",len,result);
         break;
       case CAN_LogStatus_Statistics:
       case CAN_LogInfo_Comment:
       case CAN_LogInfo_Config:
       case CAN_LogInfo_Event:
-        ESP_LOGD(TAG,"%s",result.c_str());
+        ESP_LOGD(TAG,"%.*s",len,result);
         break;
       default:
         break;
@@ -61,8 +61,8 @@ class OvmsCanLogTcpClientInit
   {
   public:
     OvmsCanLogTcpClientInit();
-    void NetManInit(std::string event, void* data);
-    void NetManStop(std::string event, void* data);
+    void NetManInit(const std::string& event, void* data);
+    void NetManStop(const std::string& event, void* data);
   } MyOvmsCanLogTcpClientInit  __attribute__ ((init_priority (4560)));
 
 OvmsCanLogTcpClientInit::OvmsCanLogTcpClientInit()
@@ -110,12 +110,12 @@ OvmsCanLogTcpClientInit::OvmsCanLogTcpClientInit()
   MyEvents.RegisterEvent(TAG, "network.mgr.stop", std::bind(&OvmsCanLogTcpClientInit::NetManStop, this, _1, _2));
   }
 
-void OvmsCanLogTcpClientInit::NetManInit(std::string event, void* data)
+void OvmsCanLogTcpClientInit::NetManInit(const std::string& event, void* data)
   {
   if (MyCanLogTcpClient) MyCanLogTcpClient->Open();
   }
 
-void OvmsCanLogTcpClientInit::NetManStop(std::string event, void* data)
+void OvmsCanLogTcpClientInit::NetManStop(const std::string& event, void* data)
   {
   if (MyCanLogTcpClient) MyCanLogTcpClient->Close();
   }
@@ -142,6 +142,7 @@ canlog_tcpclient::canlog_tcpclient(std::string path, std::string format, canform
 
 canlog_tcpclient::~canlog_tcpclient()
   {
+  Detach();
   Close();
   MyCanLogTcpClient = NULL;
   }
@@ -208,24 +209,18 @@ std::string canlog_tcpclient::GetInfo()
   return result;
   }
 
-void canlog_tcpclient::OutputMsg(CAN_log_message_t& msg)
+void canlog_tcpclient::OutputBatch(const char* data, size_t len, uint32_t count)
   {
-  if (m_formatter == NULL) return;
-
   if ((m_mgconn != NULL)&&(m_isopen))
     {
-    std::string result = m_formatter->get(&msg);
-    if (result.length()>0)
+    OvmsMutexLock lock(&m_mgmutex);
+    if (m_mgconn->send_mbuf.len < 4096)
       {
-      OvmsMutexLock lock(&m_mgmutex);
-      if (m_mgconn->send_mbuf.len < 4096)
-        {
-        mg_send(m_mgconn, (const char*)result.c_str(), result.length());
-        }
-      else
-        {
-        m_dropcount++;
-        }
+      mg_send(m_mgconn, data, len);
+      }
+    else
+      {
+      m_dropcount += count;
       }
     }
   }
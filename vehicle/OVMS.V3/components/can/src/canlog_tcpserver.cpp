@@ -64,8 +64,8 @@ class OvmsCanLogTcpServerInit
   {
   public:
     OvmsCanLogTcpServerInit();
-    void NetManInit(std::string event, void* data);
-    void NetManStop(std::string event, void* data);
+    void NetManInit(const std::string& event, void* data);
+    void NetManStop(const std::string& event, void* data);
   } MyOvmsCanLogTcpServerInit  __attribute__ ((init_priority (4560)));
 
 OvmsCanLogTcpServerInit::OvmsCanLogTcpServerInit()
@@ -114,12 +114,12 @@ OvmsCanLogTcpServerInit::OvmsCanLogTcpServerInit()
   MyEvents.RegisterEvent(TAG, "network.mgr.stop", std::bind(&OvmsCanLogTcpServerInit::NetManStop, this, _1, _2));
   }
 
-void OvmsCanLogTcpServerInit::NetManInit(std::string event, void* data)
+void OvmsCanLogTcpServerInit::NetManInit(const std::string& event, void* data)
   {
   if (MyCanLogTcpServer) MyCanLogTcpServer->Open();
   }
 
-void OvmsCanLogTcpServerInit::NetManStop(std::string event, void* data)
+void OvmsCanLogTcpServerInit::NetManStop(const std::string& event, void* data)
   {
   if (MyCanLogTcpServer) MyCanLogTcpServer->Close();
   }
@@ -163,6 +163,7 @@ canlog_tcpserver::canlog_tcpserver(std::string path, std::string format, canform
 
 canlog_tcpserver::~canlog_tcpserver()
   {
+  Detach();
   Close();
   MyCanLogTcpServer = NULL;
   }
@@ -234,26 +235,20 @@ std::string canlog_tcpserver::GetInfo()
   return result;
   }
 
-void canlog_tcpserver::OutputMsg(CAN_log_message_t& msg)
+void canlog_tcpserver::OutputBatch(const char* data, size_t len, uint32_t count)
   {
-  if (m_formatter == NULL) return;
-
-  std::string result = m_formatter->get(&msg);
-  if (result.length()>0)
+  OvmsMutexLock lock(&m_mgmutex);
+  for (ts_map_t::iterator it=m_smap.begin(); it!=m_smap.end(); ++it)
     {
-    OvmsMutexLock lock(&m_mgmutex);
-    for (ts_map_t::iterator it=m_smap.begin(); it!=m_smap.end(); ++it)
-      {
-      if (it->first->send_mbuf.len < 4096)
-        {
-        // Limit to 4KB queue on output buffer
-        mg_send(it->first, (const char*)result.c_str(), result.length());
-        }
-      else
-        {
-        m_dropcount++;
-        }
-      }
+    // Limit to 4KB queue on output buffer: send the messages starting below
+    // the limit, drop the rest
+    size_t queued = it->first->send_mbuf.len;
+    uint32_t n = 0;
+    while (n < count && queued + (n ? m_batchends[n-1] : 0) < 4096)
+      n++;
+    if (n > 0)
+      mg_send(it->first, data, (n == count) ? len : m_batchends[n-1]);
+    m_dropcount += count - n;
     }
   }
 
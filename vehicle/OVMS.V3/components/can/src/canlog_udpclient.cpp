@@ -61,8 +61,8 @@ class OvmsCanLogUdpClientInit
   {
   public:
     OvmsCanLogUdpClientInit();
-    void NetManInit(std::string event, void* data);
-    void NetManStop(std::string event, void* data);
+    void NetManInit(const std::string& event, void* data);
+    void NetManStop(const std::string& event, void* data);
   } MyOvmsCanLogUdpClientInit  __attribute__ ((init_priority (4560)));
 
 OvmsCanLogUdpClientInit::OvmsCanLogUdpClientInit()
@@ -95,12 +95,12 @@ OvmsCanLogUdpClientInit::OvmsCanLogUdpClientInit()
   MyEvents.RegisterEvent(TAG, "network.mgr.stop", std::bind(&OvmsCanLogUdpClientInit::NetManStop, this, _1, _2));
   }
 
-void OvmsCanLogUdpClientInit::NetManInit(std::string event, void* data)
+void OvmsCanLogUdpClientInit::NetManInit(const std::string& event, void* data)
   {
   if (MyCanLogUdpClient) MyCanLogUdpClient->Open();
   }
 
-void OvmsCanLogUdpClientInit::NetManStop(std::string event, void* data)
+void OvmsCanLogUdpClientInit::NetManStop(const std::string& event, void* data)
   {
   if (MyCanLogUdpClient) MyCanLogUdpClient->Close();
   }
@@ -122,6 +122,7 @@ canlog_udpclient::canlog_udpclient(std::string path, std::string format, canform
 
 canlog_udpclient::~canlog_udpclient()
   {
+  Detach();
   Close();
   MyCanLogUdpClient = NULL;
   }
@@ -190,24 +191,18 @@ std::string canlog_udpclient::GetInfo()
   return result;
   }
 
-void canlog_udpclient::OutputMsg(CAN_log_message_t& msg)
+void canlog_udpclient::OutputBatch(const char* data, size_t len, uint32_t count)
   {
-  if (m_formatter == NULL) return;
-
   if ((m_mgconn != NULL)&&(m_isopen))
     {
-    std::string result = m_formatter->get(&msg);
-    if (result.length()>0)
+    OvmsMutexLock lock(&m_mgmutex);
+    if (m_mgconn->send_mbuf.len < 4096)
       {
-      OvmsMutexLock lock(&m_mgmutex);
-      if (m_mgconn->send_mbuf.len < 4096)
-        {
-        mg_send(m_mgconn, (const char*)result.c_str(), result.length());
-        }
-      else
-        {
-        m_dropcount++;
-        }
+      mg_send(m_mgconn, data, len);
+      }
+    else
+      {
+      m_dropcount += count;
       }
     }
   }
@@ -45,7 +45,7 @@ class canlog_udpclient : public canlog
     virtual std::string GetInfo();
 
   public:
-    virtual void OutputMsg(CAN_log_message_t& msg);
+    virtual void OutputBatch(const char* data, size_t len, uint32_t count);
 
   public:
     void MongooseHandler(struct mg_connection *nc, int ev, void *p);
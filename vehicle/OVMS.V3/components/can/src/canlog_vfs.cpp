@@ -101,6 +101,7 @@ canlog_vfs::canlog_vfs(std::string path, std::string format)
 canlog_vfs::~canlog_vfs()
   {
   MyEvents.DeregisterEvent(IDTAG);
+  Detach();
 
   if (m_file != NULL)
     {
@@ -111,10 +112,8 @@ canlog_vfs::~canlog_vfs()
 bool canlog_vfs::Open()
   {
   if (m_file)
-    {
-    fclose(m_file);
-    m_file = NULL;
-    }
+    Close();
+  OvmsMutexLock lock(&m_outputmutex);
 
   if (MyConfig.ProtectedPath(m_path))
     {
@@ -143,13 +142,22 @@ bool canlog_vfs::Open()
   if (header.length()>0)
     fwrite(header.c_str(),header.length(),1,m_file);
 
+  StartProducers();
   return true;
   }
 
 void canlog_vfs::Close()
   {
+  // Stop logging, write out the messages logged so far, then finish the
+  // file from here while the logger task is locked out:
+  StopProducers();
+  OvmsMutexLock lock(&m_outputmutex);
   if (m_file)
     {
+    Drain();
+    std::string footer = m_formatter->getfooter();
+    if (footer.length()>0)
+      fwrite(footer.c_str(),footer.length(),1,m_file);
     fclose(m_file);
     m_file = NULL;
     ESP_LOGI(TAG, "Closed vfs log '%s': %s",
@@ -170,7 +178,7 @@ std::string canlog_vfs::GetInfo()
   return result;
   }
 
-void canlog_vfs::MountListener(std::string event, void* data)
+void canlog_vfs::MountListener(const std::string& event, void* data)
   {
   if (event == "sd.unmounting" && startsWith(m_path, "/sd"))
     Close();
@@ -178,12 +186,9 @@ void canlog_vfs::MountListener(std::string event, void* data)
     Open();
   }
 
-void canlog_vfs::OutputMsg(CAN_log_message_t& msg)
+void canlog_vfs::OutputBatch(const char* data, size_t len, uint32_t count)
   {
   if (m_file == NULL) return;
-  if (m_formatter == NULL) return;
 
-  std::string result = m_formatter->get(&msg);
-  if (result.length()>0)
-    fwrite(result.c_str(),result.length(),1,m_file);
+  fwrite(data,len,1,m_file);
   }
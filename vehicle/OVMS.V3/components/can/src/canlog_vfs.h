@@ -43,10 +43,10 @@ class canlog_vfs : public canlog
     virtual std::string GetInfo();
 
   public:
-    virtual void OutputMsg(CAN_log_message_t& msg);
+    virtual void OutputBatch(const char* data, size_t len, uint32_t count);
 
   public:
-    virtual void MountListener(std::string event, void* data);
+    virtual void MountListener(const std::string& event, void* data);
 
   public:
     std::string         m_path;
@@ -29,6 +29,7 @@ static const char *TAG = "canplay";
 
 #include "can.h"
 #include "canplay.h"
+#include "esp_timer.h"
 #include <sys/param.h>
 #include <ctype.h>
 #include <string.h>
@@ -182,7 +183,7 @@ OvmsCanPlayInit::OvmsCanPlayInit()
 
   OvmsCommand* cmd_canplay = cmd_can->RegisterCommand("play", "CAN play framework");
   cmd_canplay->RegisterCommand("stop", "Stop playing", can_play_stop,"[<id>]",0,1);
-  cmd_canplay->RegisterCommand("speed", "Set playback speed", can_play_speed,"<speed> [<id>]",1,2);
+  cmd_canplay->RegisterCommand("speed", "Set playback speed (0 = as fast as possible)", can_play_speed,"<speed> [<id>]",1,2);
   cmd_canplay->RegisterCommand("status", "Playing status", can_play_status,"[<id>]",0,1);
   cmd_canplay->RegisterCommand("list", "Playing list", can_play_list);
   cmd_canplay->RegisterCommand("start", "CAN play start framework");
@@ -201,17 +202,23 @@ canplay::canplay(const char* type, std::string format, canformat::canformat_serv
   m_filter = NULL;
   m_speed = 1;
 
+  m_task = NULL;
+  m_running = false;
+  m_stopped = xSemaphoreCreateBinary();
   m_msgcount = 0;
-  xTaskCreatePinnedToCore(PlayTask, "OVMS CanPlay", 4096, (void*)this, 10, &m_task, CORE(1));
+  m_skipcount = 0;
+  m_playcount = 0;
+  m_lag_max = 0;
+  m_sync_speed = 0;
+  m_sync_trace = 0;
+  m_sync_wall = 0;
+  m_burst = 0;
   }
 
 canplay::~canplay()
   {
-  if (m_task)
-    {
-    vTaskDelete(m_task);
-    m_task = NULL;
-    }
+  Stop();
+  vSemaphoreDelete(m_stopped);
 
   if (m_formatter)
     {
@@ -226,21 +233,151 @@ canplay::~canplay()
     }
   }
 
+bool canplay::Start()
+  {
+  if (m_task) return true;
+  m_running = true;
+  if (xTaskCreatePinnedToCore(PlayTask, "OVMS CanPlay", 4096, (void*)this, 10, &m_task, CORE(1)) != pdPASS)
+    {
+    ESP_LOGE(TAG, "Start: cannot create play task");
+    m_running = false;
+    m_task = NULL;
+    return false;
+    }
+  return true;
+  }
+
+void canplay::Stop()
+  {
+  if (!m_task) return;
+  m_running = false;
+  xTaskNotifyGive(m_task);
+  if (xSemaphoreTake(m_stopped, pdMS_TO_TICKS(5000)) != pdTRUE)
+    {
+    ESP_LOGW(TAG, "Stop: play task did not terminate, deleting it");
+    vTaskDelete(m_task);
+    }
+  m_task = NULL;
+  }
+
 void canplay::PlayTask(void *context)
   {
-//  canplay* me = (canplay*) context;
+  canplay* me = (canplay*) context;
+  me->PlayLoop();
+  xSemaphoreGive(me->m_stopped);
+  vTaskDelete(NULL);
+  }
+
+void canplay::PlayLoop()
+  {
+  CAN_log_message_t msg;
+
+  while (m_running)
+    {
+    bool open, ok;
+      {
+      OvmsMutexLock lock(&m_inputmutex);
+      open = IsOpen();
+      ok = open && InputMsg(&msg);
+      if (open && !ok)
+        {
+        // End of input:
+        m_playcount++;
+        Close();
+        }
+      }
+
+    if (!ok)
+      {
+      // Idle until stopped or reopened (i.e. after an SD remount):
+      m_sync_speed = 0;
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+      continue;
+      }
+
+    if ((msg.type != CAN_LogFrame_RX) || (msg.origin == NULL) ||
+        (m_filter && !m_filter->IsFiltered(&msg.frame)))
+      {
+      m_skipcount++;
+      }
+    else
+      {
+      int64_t trace_us = (int64_t)msg.timestamp.tv_sec * 1000000 + msg.timestamp.tv_usec;
+      if (!PlayWait(trace_us)) break;
+      PlayMsg(&msg);
+      }
+
+    // Let lower priority tasks run when playing back to back:
+    if (++m_burst >= CANPLAY_BURST)
+      {
+      m_burst = 0;
+      vTaskDelay(1);
+      }
+    }
+  }
+
+/**
+ * PlayWait: wait until the trace time is due at the current play speed
+ *  Returns false if the player has been stopped while waiting.
+ */
+bool canplay::PlayWait(int64_t trace_us)
+  {
+  while (m_running)
+    {
+    uint32_t speed = m_speed;
+    int64_t now = esp_timer_get_time();
 
-//  CAN_log_message_t msg;
-//  while (me->InputMsg(&msg))
-//    {
-//    vTaskDelay(pdMS_TO_TICKS(1000));
-//    }
+    if (speed == 0)
+      {
+      // As fast as possible:
+      m_sync_speed = 0;
+      return true;
+      }
+    if (m_sync_speed == 0 || trace_us < m_sync_trace)
+      {
+      // (Re)start timing base, also on timestamp discontinuities:
+      m_sync_speed = speed;
+      m_sync_trace = trace_us;
+      m_sync_wall = now;
+      return true;
+      }
+    if (speed != m_sync_speed)
+      {
+      // Speed change: rebase on current trace position
+      m_sync_trace += (now - m_sync_wall) * m_sync_speed;
+      m_sync_wall = now;
+      m_sync_speed = speed;
+      }
 
-//  me->Close();
-  while(1)
+    int64_t wait = m_sync_wall + (trace_us - m_sync_trace) / speed - now;
+    if (wait < 0)
+      {
+      if (-wait > m_lag_max) m_lag_max = -wait;
+      return true;
+      }
+    TickType_t ticks = wait / (1000 * portTICK_PERIOD_MS);
+    if (ticks == 0)
+      return true;
+    m_burst = 0;
+    ulTaskNotifyTake(pdTRUE, ticks);
+    }
+  return false;
+  }
+
+void canplay::PlayMsg(CAN_log_message_t* msg)
+  {
+  switch (m_formatter->GetServeMode())
     {
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    case canformat::Simulate:
+      MyCan.IncomingFrame(&msg->frame);
+      break;
+    case canformat::Transmit:
+      msg->frame.origin->Write(&msg->frame);
+      break;
+    default:
+      break;
     }
+  m_msgcount++;
   }
 
 const char* canplay::GetType()
@@ -256,6 +393,7 @@ const char* canplay::GetFormat()
 void canplay::SetSpeed(uint32_t speed)
   {
   m_speed = speed;
+  if (m_task) xTaskNotifyGive(m_task);
   }
 
 bool canplay::InputMsg(CAN_log_message_t* msg)
@@ -273,7 +411,10 @@ std::string canplay::GetInfo()
     buf << "(" << m_formatter->GetServeModeName() << ")";
     }
 
-  buf << " Speed:" << m_speed << "x";
+  if (m_speed)
+    buf << " Speed:" << m_speed << "x";
+  else
+    buf << " Speed:max";
 
   if (m_filter)
     {
@@ -291,7 +432,10 @@ std::string canplay::GetStats()
   {
   std::ostringstream buf;
 
-  buf << "total messages: " << m_msgcount;
+  buf << "total messages: " << m_msgcount
+      << " skipped: " << m_skipcount
+      << " plays: " << m_playcount
+      << " max lag: " << (m_lag_max / 1000) << " ms";
 
   return buf.str();
   }
@@ -30,9 +30,18 @@
 #include "freertos/semphr.h"
 #include "can.h"
 #include "canformat.h"
+#include "ovms_mutex.h"
+
+// Number of frames injected back to back before the player yields:
+#define CANPLAY_BURST         50
 
 /**
  * canplay is the general interface and base implementation for all can players.
+ *
+ * The play task reads messages via InputMsg() and injects them according to
+ * the formatter serve mode (simulate = incoming frame, transmit = bus write),
+ * reproducing the recorded inter-frame timing scaled by m_speed.
+ * Speed 0 replays as fast as possible.
  */
 class canplay : public InternalRamAllocated
   {
@@ -42,6 +51,13 @@ class canplay : public InternalRamAllocated
 
   public:
     static void PlayTask(void* context);
+    bool Start();
+    void Stop();
+
+  protected:
+    void PlayLoop();
+    bool PlayWait(int64_t trace_us);
+    void PlayMsg(CAN_log_message_t* msg);
 
   public:
     const char* GetType();
@@ -64,13 +80,25 @@ class canplay : public InternalRamAllocated
   public:
     const char*         m_type;
     std::string         m_format;
-    uint32_t            m_speed;
+    volatile uint32_t   m_speed;
     canformat*          m_formatter;
     canfilter*          m_filter;
 
   public:
     TaskHandle_t        m_task;
-    uint32_t            m_msgcount;
+    volatile bool       m_running;
+    SemaphoreHandle_t   m_stopped;
+    OvmsMutex           m_inputmutex;       // serializes InputMsg() and Open()/Close()
+    uint32_t            m_msgcount;         // frames injected
+    uint32_t            m_skipcount;        // frames skipped (filter, type, no bus)
+    uint32_t            m_playcount;        // completed playbacks
+    int64_t             m_lag_max;          // max injection delay behind schedule [us]
+
+  protected:
+    uint32_t            m_sync_speed;       // speed of current timing base, 0 = unsynced
+    int64_t             m_sync_trace;       // trace time of timing base [us]
+    int64_t             m_sync_wall;        // esp_timer time of timing base [us]
+    int                 m_burst;            // frames injected since last yield
   };
 
 #endif // __CANPLAY_H__
@@ -91,6 +91,7 @@ canplay_vfs::canplay_vfs(std::string path, std::string format)
   {
   m_file = NULL;
   m_path = path;
+  m_inpos = m_inlen = 0;
   using std::placeholders::_1;
   using std::placeholders::_2;
   MyEvents.RegisterEvent(IDTAG, "sd.mounted", std::bind(&canplay_vfs::MountListener, this, _1, _2));
@@ -99,6 +100,7 @@ canplay_vfs::canplay_vfs(std::string path, std::string format)
 
 canplay_vfs::~canplay_vfs()
   {
+  Stop();
   MyEvents.DeregisterEvent(IDTAG);
 
   if (m_file != NULL)
@@ -136,6 +138,9 @@ bool canplay_vfs::Open()
     return false;
     }
 
+  m_inpos = m_inlen = 0;
+  if (m_formatter) m_formatter->ResetStuffing();
+
   ESP_LOGI(TAG, "Now playing CAN messages from '%s'", m_path.c_str());
 
   return true;
@@ -165,8 +170,9 @@ std::string canplay_vfs::GetInfo()
   return result;
   }
 
-void canplay_vfs::MountListener(std::string event, void* data)
+void canplay_vfs::MountListener(const std::string& event, void* data)
   {
+  OvmsMutexLock lock(&m_inputmutex);
   if (event == "sd.unmounting" && startsWith(m_path, "/sd"))
     Close();
   else if (event == "sd.mounted" && startsWith(m_path, "/sd"))
@@ -178,5 +184,30 @@ bool canplay_vfs::InputMsg(CAN_log_message_t* msg)
   if (m_file == NULL) return false;
   if (m_formatter == NULL) return false;
 
-  return false;
+  while (true)
+    {
+    if (m_formatter->IsServeDiscarding())
+      {
+      ESP_LOGE(TAG, "Invalid %s input in '%s', stopping playback", m_format.c_str(), m_path.c_str());
+      return false;
+      }
+
+    if (m_inpos == m_inlen)
+      {
+      m_inpos = 0;
+      m_inlen = fread(m_inbuf, 1, sizeof(m_inbuf), m_file);
+      }
+
+    // Feed the parser, it returns at most one message per call:
+    size_t avail = m_inlen - m_inpos;
+    size_t stuffed = m_formatter->GetStuffedSize();
+    memset(msg, 0, sizeof(*msg));
+    m_inpos += m_formatter->put(msg, m_inbuf + m_inpos, avail);
+    if (msg->origin != NULL)
+      return true;
+
+    // End of file: input and parser buffer exhausted
+    if (avail == 0 && m_formatter->GetStuffedSize() == stuffed)
+      return false;
+    }
   }
@@ -30,6 +30,8 @@
 
 #include "canplay.h"
 
+#define CANPLAY_VFS_BUFSIZE   512
+
 class canplay_vfs : public canplay
   {
   public:
@@ -46,11 +48,14 @@ class canplay_vfs : public canplay
     virtual bool InputMsg(CAN_log_message_t* msg);
 
   public:
-    virtual void MountListener(std::string event, void* data);
+    virtual void MountListener(const std::string& event, void* data);
 
   public:
     std::string         m_path;
     FILE*               m_file;
+    uint8_t             m_inbuf[CANPLAY_VFS_BUFSIZE];
+    size_t              m_inpos;
+    size_t              m_inlen;
   };
 
 #endif // __CANPLAY_VFS_H__
@@ -76,6 +76,12 @@ CANopen::CANopen()
     cmd_canx->RegisterCommand("info", "Show node info", shell_info, "<nodeid> [timeout_ms=50]", 1, 2);
     cmd_canx->RegisterCommand("scan", "Scan nodes", shell_scan, "[[startid=1][-][endid=127]] [timeout_ms=50]", 0, 2);
     }
+
+#ifdef CONFIG_OVMS_COMP_CANOPEN_TESTSIM
+  OvmsCommand* cmd_test = MyCommandApp.RegisterCommand("test", "Test framework");
+  cmd_test->RegisterCommand("canopen", "Test CANopen SDO throughput using simulated nodes", shell_testsim,
+    "[<nodes>] [<size>] [<blksize>] [<count>]", 0, 4);
+#endif // CONFIG_OVMS_COMP_CANOPEN_TESTSIM
   }
 
 CANopen::~CANopen()
@@ -144,6 +150,7 @@ CANopenWorker* CANopen::Start(canbus* bus)
       CONFIG_OVMS_COMP_CANOPEN_RX_STACK, (void*)this, 15, &m_rxtask, CORE(0));
     MyCan.RegisterListener(m_rxqueue);
     }
+  MyCan.AddListenerBus(m_rxqueue, bus);
 
   // start worker:
   for (int i=0; i < CAN_INTERFACE_CNT; i++)
@@ -377,6 +384,7 @@ const std::string CANopen::GetResultString(const CANopenResult_t result)
     case COR_ERR_Timeout:               name = "Timeout"; break;
     case COR_ERR_SDO_Access:            name = "SDO access failed"; break;
     case COR_ERR_SDO_SegMismatch:       name = "SDO segment mismatch"; break;
+    case COR_ERR_SDO_CRC:               name = "SDO block CRC mismatch"; break;
 
     case COR_ERR_DeviceOffline:         name = "Device offline"; break;
     case COR_ERR_UnknownDevice:         name = "Unknown device"; break;
@@ -409,3 +417,19 @@ const std::string CANopen::GetResultString(const CANopenJob& job)
   else
     return GetResultString(job.result, 0);
   }
+
+
+/**
+ * CRC16: SDO block transfer checksum (CiA DS301: CCITT polynomial 0x1021, init 0)
+ *    - pass the previous result as crc to continue a checksum
+ */
+uint16_t CANopen::CRC16(const uint8_t* data, size_t len, uint16_t crc /*=0*/)
+  {
+  while (len--)
+    {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (int i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  return crc;
+  }
@@ -27,6 +27,7 @@
 #define __CANOPEN_H__
 
 #include <forward_list>
+#include <list>
 
 #include "can.h"
 
@@ -34,9 +35,13 @@
 #include "ovms_config.h"
 #include "ovms_metrics.h"
 #include "ovms_command.h"
+#include "ovms_mutex.h"
 
 #define CAN_INTERFACE_CNT         4
 
+#define CANopen_JobQueueSize      20          // jobs waiting per worker
+#define CANopen_SDOBlockSizeMax   127         // max segments per SDO block (CiA DS301)
+
 #define CANopen_GeneralError      0x08000000  // check for device specific error details
 #define CANopen_BusCollision      0xffffffff  // another master is active / non-CANopen frame received
 
@@ -57,6 +62,7 @@ typedef enum __attribute__ ((__packed__))
   COR_ERR_Timeout,
   COR_ERR_SDO_Access,
   COR_ERR_SDO_SegMismatch,
+  COR_ERR_SDO_CRC,
   
   // General purpose application level:
   COR_ERR_DeviceOffline = 0x80,
@@ -163,6 +169,8 @@ struct __attribute__ ((__packed__)) CANopenJob
       size_t                xfersize;       // byte count sent / received
       size_t                contsize;       // content size of SDO (if indicated by slave)
       uint32_t              error;          // CANopen general error code
+      uint8_t               blksize;        // block transfer: segments per block, 0=off
+      bool                  crc;            // block transfer: use CRC if supported by server
       } sdo;
     };
   
@@ -208,17 +216,77 @@ typedef union __attribute__ ((__packed__))
   } CANopenFrame_t;
 
 
+/**
+ * A CANopenChannel executes one CANopenJob at a time in its own task.
+ * 
+ * Each CANopenWorker runs a set of channels, so jobs for different nodes
+ * can be processed concurrently. Jobs addressing the same CAN IDs are
+ * never run in parallel and keep their submission order.
+ */
+
+class CANopenWorker;
+
+class CANopenChannel
+  {
+  public:
+    CANopenChannel(CANopenWorker* worker, int index);
+    ~CANopenChannel();
+  
+  public:
+    void ChannelTask();
+    void Start(const CANopenJob& job);
+    void IncomingFrame(CAN_frame_t* frame);
+    bool IsBusy() { return m_job.type != COJT_None; }
+    bool IsReceiving(uint32_t msgid);
+  
+  protected:
+    CANopenResult_t ProcessSendNMTJob();
+    CANopenResult_t ProcessReceiveHBJob();
+    CANopenResult_t ProcessReadSDOJob();
+    CANopenResult_t ProcessWriteSDOJob();
+    CANopenResult_t ReadSDOBlock();
+    CANopenResult_t WriteSDOBlock();
+  
+  private:
+    void SendSDORequest();
+    void AbortSDORequest(uint32_t reason);
+    CANopenResult_t ExecuteSDORequest();
+    bool ReceiveResponse(TickType_t maxwait);
+
+  public:
+    CANopenWorker*        m_worker;
+    canbus*               m_bus;
+    
+    char                  m_taskname[16];   // "OVMS COchN canX"
+    TaskHandle_t          m_task;           // channel task
+    QueueHandle_t         m_rxqueue;        // response frame queue
+    
+    CANopenJob            m_job;            // job currently processed
+
+  private:
+    portMUX_TYPE          m_rxlock;         // guards m_rxid
+    uint32_t              m_rxid;           // response ID routed to this channel, 0 = none
+
+    CANopenFrame_t        m_request;
+    CANopenFrame_t        m_response;
+  };
+
+
 /**
  * A CANopenWorker processes CANopenJobs on a specific bus.
  * 
  * CANopenClients create and submit Jobs to be processed to a CANopenWorker.
  * After finish/abort, the Worker sends the Job to the clients done queue.
  * 
+ * The worker task dispatches jobs to a set of CANopenChannels, allowing
+ * jobs for different nodes to be run concurrently.
+ * 
  * A CANopenWorker also monitors the bus for emergency and heartbeat
  * messages, and translates these into events and metrics updates.
  */
 
 typedef std::forward_list<CANopenAsyncClient*> CANopenClientList;
+typedef std::list<CANopenJob> CANopenJobList;
 
 class CANopenWorker
   {
@@ -237,40 +305,33 @@ class CANopenWorker
   
   public:
     CANopenResult_t SubmitJob(CANopenJob& job, TickType_t maxqueuewait=0);
+    void JobDone(CANopenJob& job);
   
   protected:
-    CANopenResult_t ProcessSendNMTJob();
-    CANopenResult_t ProcessReceiveHBJob();
-    CANopenResult_t ProcessReadSDOJob();
-    CANopenResult_t ProcessWriteSDOJob();
-  
-  private:
-    void SendSDORequest();
-    void AbortSDORequest(uint32_t reason);
-    CANopenResult_t ExecuteSDORequest();
+    bool IsRunnable(CANopenJobList::iterator job);
+    CANopenChannel* GetIdleChannel();
 
   public:
     canbus*               m_bus;            // max one worker per bus
     int                   m_clientcnt;
     CANopenClientList     m_clients;
     
-    char                  m_taskname[12];   // "COwrk canX"
-    TaskHandle_t          m_jobtask;        // worker task
+    char                  m_taskname[16];   // "OVMS COwrk canX"
+    TaskHandle_t          m_jobtask;        // worker (dispatcher) task
     QueueHandle_t         m_jobqueue;       // job rx queue
+    CANopenJobList        m_pending;        // jobs waiting for a channel
+    
+    CANopenChannel*       m_channel[CONFIG_OVMS_COMP_CANOPEN_WRK_CHANNELS];
+    volatile int          m_channelcnt;     // channels created on demand
     
     uint32_t              m_nmt_rxcnt;
     uint32_t              m_emcy_rxcnt;
     uint32_t              m_jobcnt;
     uint32_t              m_jobcnt_timeout;
     uint32_t              m_jobcnt_error;
-    
-    CANopenJob            m_job;            // job currently processed
+    OvmsMutex             m_statsmutex;
     
     CANopenNodeMetricsMap m_nodemetrics;    // map: nodeid → node metrics
-
-  private:
-    CANopenFrame_t        m_request;
-    CANopenFrame_t        m_response;
   };
 
 
@@ -318,6 +379,7 @@ class CANopenAsyncClient
       int resp_timeout_ms=100, int max_tries=3);
     virtual void InitWriteSDO(CANopenJob& job, uint8_t nodeid, uint16_t index, uint8_t subindex, uint8_t* buf, size_t bufsize,
       int resp_timeout_ms=100, int max_tries=3);
+    void SetSDOBlockTransfer(uint8_t blksize, bool crc=true);
   
   public:
     // Main API:
@@ -333,6 +395,8 @@ class CANopenAsyncClient
   public:
     CANopenWorker*        m_worker;
     QueueHandle_t         m_done_queue;
+    uint8_t               m_sdo_blksize;    // SDO block transfer: segments per block, 0=off
+    bool                  m_sdo_crc;        // SDO block transfer: use CRC
   };
 
 
@@ -399,6 +463,7 @@ class CANopen
     static const std::string GetResultString(const CANopenResult_t result);
     static const std::string GetResultString(const CANopenResult_t result, const uint32_t abortcode);
     static const std::string GetResultString(const CANopenJob& job);
+    static uint16_t CRC16(const uint8_t* data, size_t len, uint16_t crc=0);
     static int PrintNodeInfo(int capacity, OvmsWriter* writer, canbus* bus, int nodeid,
       int timeout_ms=100, bool brief=false, bool quiet=false);
 
@@ -411,6 +476,9 @@ class CANopen
     static void shell_writesdo(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
     static void shell_info(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
     static void shell_scan(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
+#ifdef CONFIG_OVMS_COMP_CANOPEN_TESTSIM
+    static void shell_testsim(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
+#endif // CONFIG_OVMS_COMP_CANOPEN_TESTSIM
 
   public:
     QueueHandle_t         m_rxqueue;    // CAN rx queue
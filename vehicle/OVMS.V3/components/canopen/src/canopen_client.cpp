@@ -26,6 +26,7 @@
 #include "ovms_log.h"
 static const char *TAG = "canopen";
 
+#include <algorithm>
 #include "canopen.h"
 
 
@@ -49,6 +50,9 @@ static const char *TAG = "canopen";
  * If you need another address scheme, create a sub class of CANopenClient
  *   and override the Init…() methods as necessary.
  * 
+ * SDO transfers use the expedited or segmented protocol by default. For
+ *   large objects, enable block transfers by SetSDOBlockTransfer().
+ * 
  * Hint: sub classes can also be used to add device specific methods, see
  *   Twizy implementation for a SEVCON Gen4 client example.
  */
@@ -58,6 +62,8 @@ CANopenAsyncClient::CANopenAsyncClient(CANopenWorker* worker, int queuesize /*=2
   m_worker = worker;
   m_worker->Open(this);
   m_done_queue = xQueueCreate(queuesize, sizeof(CANopenJob));
+  m_sdo_blksize = 0;
+  m_sdo_crc = true;
   }
 
 CANopenAsyncClient::CANopenAsyncClient(canbus *bus, int queuesize /*=20*/)
@@ -65,6 +71,8 @@ CANopenAsyncClient::CANopenAsyncClient(canbus *bus, int queuesize /*=20*/)
   m_worker = MyCANopen.Start(bus);
   m_worker->Open(this);
   m_done_queue = xQueueCreate(queuesize, sizeof(CANopenJob));
+  m_sdo_blksize = 0;
+  m_sdo_crc = true;
   }
 
 CANopenAsyncClient::~CANopenAsyncClient()
@@ -176,6 +184,8 @@ void CANopenAsyncClient::InitReadSDO(CANopenJob& job,
   job.sdo.subindex = subindex;
   job.sdo.buf = buf;
   job.sdo.bufsize = bufsize;
+  job.sdo.blksize = m_sdo_blksize;
+  job.sdo.crc = m_sdo_crc;
   
   job.txid = 0x600 + nodeid;
   job.rxid = 0x580 + nodeid;
@@ -199,6 +209,8 @@ void CANopenAsyncClient::InitWriteSDO(CANopenJob& job,
   job.sdo.subindex = subindex;
   job.sdo.buf = buf;
   job.sdo.bufsize = bufsize;
+  job.sdo.blksize = m_sdo_blksize;
+  job.sdo.crc = m_sdo_crc;
   
   job.txid = 0x600 + nodeid;
   job.rxid = 0x580 + nodeid;
@@ -207,6 +219,19 @@ void CANopenAsyncClient::InitWriteSDO(CANopenJob& job,
   }
 
 
+/**
+ * SetSDOBlockTransfer: configure SDO block transfers for subsequent Init…SDO() calls
+ *    - blksize: segments per block for uploads (1…127), 0 = off (default)
+ *    - crc: request CRC check if supported by the server (default)
+ *    - servers not supporting block transfers are accessed normally
+ */
+void CANopenAsyncClient::SetSDOBlockTransfer(uint8_t blksize, bool crc /*=true*/)
+  {
+  m_sdo_blksize = std::min((int)blksize, CANopen_SDOBlockSizeMax);
+  m_sdo_crc = crc;
+  }
+
+
 /**
  * [Main API]
  * SendNMT: send NMT request and optionally wait for NMT state change
@@ -0,0 +1,403 @@
+/**
+ * Project:      Open Vehicle Monitor System
+ * Module:       CANopen
+ * 
+ * (c) 2017  Michael Balzer <dexter@dexters-web.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "sdkconfig.h"
+#ifdef CONFIG_OVMS_COMP_CANOPEN_TESTSIM
+
+#include <algorithm>
+#include "esp_timer.h"
+#include "canopen.h"
+#include "ovms_malloc.h"
+#include "test_framework.h"
+
+
+/**
+ * test_cosim_bus: virtual CAN bus with simulated CANopen nodes 1…TEST_COSIM_NODES,
+ *  serving SDO expedited, segmented and block transfers on any object address.
+ *  All objects of a node share the same data, uploads return m_objsize bytes.
+ */
+
+#define TEST_COSIM_NODES    8
+#define TEST_COSIM_OBJSIZE  4096
+
+enum
+  {
+  TCS_Idle = 0,
+  TCS_Upload,
+  TCS_Download,
+  TCS_BlockUpload,
+  TCS_BlockUploadEnd,
+  TCS_BlockDownload,
+  TCS_BlockDownloadEnd
+  };
+
+typedef struct
+  {
+  int       state;
+  uint8_t   toggle;
+  uint8_t   blksize;
+  uint8_t   seqno;
+  bool      crc;
+  size_t    pos;
+  size_t    blkpos;
+  size_t    size;
+  uint8_t   mux[3];
+  uint8_t   data[TEST_COSIM_OBJSIZE + 8];
+  } test_cosim_node_t;
+
+class test_cosim_bus : public test_simbus
+  {
+  public:
+    test_cosim_bus();
+
+  public:
+    void SimFrame(const CAN_frame_t* frame);
+    void ProcessRequest(int nodeid, const uint8_t* req);
+    void SendUploadBlock(int nodeid);
+    void Respond(int nodeid, const uint8_t* rsp);
+    void Abort(int nodeid, uint32_t reason);
+
+  public:
+    size_t              m_objsize;      // upload object size
+    uint8_t             m_blksize;      // block size for downloads
+    test_cosim_node_t*  m_node;         // [0] unused
+  };
+
+test_cosim_bus::test_cosim_bus()
+  : test_simbus("cosim1", "OVMS COsim")
+  {
+  m_objsize = 4;
+  m_blksize = CANopen_SDOBlockSizeMax;
+  m_node = (test_cosim_node_t*) ExternalRamCalloc(TEST_COSIM_NODES+1, sizeof(test_cosim_node_t));
+  for (int nodeid = 1; nodeid <= TEST_COSIM_NODES; nodeid++)
+    {
+    for (int i = 0; i < TEST_COSIM_OBJSIZE; i++)
+      m_node[nodeid].data[i] = i * 7 + nodeid;
+    }
+  }
+
+void test_cosim_bus::SimFrame(const CAN_frame_t* frame)
+  {
+  if (frame->MsgID > 0x600 && frame->MsgID <= 0x600 + TEST_COSIM_NODES && frame->FIR.B.DLC == 8)
+    ProcessRequest(frame->MsgID - 0x600, frame->data.u8);
+  }
+
+void test_cosim_bus::Respond(int nodeid, const uint8_t* rsp)
+  {
+  SimRespond(0x580 + nodeid, rsp);
+  }
+
+void test_cosim_bus::Abort(int nodeid, uint32_t reason)
+  {
+  test_cosim_node_t& nd = m_node[nodeid];
+  uint8_t rsp[8] = { 0x80, nd.mux[0], nd.mux[1], nd.mux[2],
+    (uint8_t)reason, (uint8_t)(reason >> 8), (uint8_t)(reason >> 16), (uint8_t)(reason >> 24) };
+  nd.state = TCS_Idle;
+  Respond(nodeid, rsp);
+  }
+
+void test_cosim_bus::SendUploadBlock(int nodeid)
+  {
+  test_cosim_node_t& nd = m_node[nodeid];
+  uint8_t rsp[8];
+  size_t pos = nd.blkpos = nd.pos;
+  for (int seqno = 1; seqno <= nd.blksize && pos < nd.size; seqno++)
+    {
+    memset(rsp, 0, sizeof(rsp));
+    int n = std::min((size_t)7, nd.size - pos);
+    memcpy(rsp+1, nd.data + pos, n);
+    pos += n;
+    rsp[0] = seqno | ((pos == nd.size) ? 0x80 : 0);
+    Respond(nodeid, rsp);
+    }
+  }
+
+void test_cosim_bus::ProcessRequest(int nodeid, const uint8_t* req)
+  {
+  test_cosim_node_t& nd = m_node[nodeid];
+  uint8_t rsp[8] = {};
+  uint8_t cmd = req[0];
+  size_t n;
+
+  if (cmd == 0x80)
+    {
+    // abort:
+    nd.state = TCS_Idle;
+    return;
+    }
+
+  if (nd.state == TCS_BlockDownload)
+    {
+    // block download segment:
+    if ((cmd & 0x7f) == nd.seqno + 1)
+      {
+      nd.seqno++;
+      if (nd.pos < TEST_COSIM_OBJSIZE)
+        memcpy(nd.data + nd.pos, req+1, 7);
+      nd.pos += 7;
+      if (cmd & 0x80)
+        nd.state = TCS_BlockDownloadEnd;
+      }
+    if ((cmd & 0x80) || (cmd & 0x7f) >= nd.blksize)
+      {
+      rsp[0] = 0xa2;
+      rsp[1] = nd.seqno;
+      rsp[2] = nd.blksize = m_blksize;
+      nd.seqno = 0;
+      Respond(nodeid, rsp);
+      }
+    return;
+    }
+
+  switch (cmd & 0xe0)
+    {
+    case 0x40:  // init upload
+    init_upload:
+      memcpy(nd.mux, req+1, 3);
+      memcpy(rsp+1, req+1, 3);
+      nd.size = m_objsize;
+      if (nd.size <= 4)
+        {
+        rsp[0] = 0x43 | ((4 - nd.size) << 2);
+        memcpy(rsp+4, nd.data, nd.size);
+        nd.state = TCS_Idle;
+        }
+      else
+        {
+        rsp[0] = 0x41;
+        memcpy(rsp+4, &nd.size, 4);
+        nd.state = TCS_Upload;
+        nd.pos = 0;
+        nd.toggle = 0;
+        }
+      Respond(nodeid, rsp);
+      break;
+
+    case 0x60:  // upload segment
+      if (nd.state != TCS_Upload || (cmd & 0x10) != nd.toggle)
+        return Abort(nodeid, 0x05030000);
+      n = std::min((size_t)7, nd.size - nd.pos);
+      memcpy(rsp+1, nd.data + nd.pos, n);
+      nd.pos += n;
+      rsp[0] = nd.toggle | ((7 - n) << 1) | ((nd.pos == nd.size) ? 0x01 : 0);
+      nd.toggle ^= 0x10;
+      if (nd.pos == nd.size)
+        nd.state = TCS_Idle;
+      Respond(nodeid, rsp);
+      break;
+
+    case 0x20:  // init download
+      memcpy(nd.mux, req+1, 3);
+      memcpy(rsp+1, req+1, 3);
+      if (cmd & 0x02)
+        {
+        memcpy(nd.data, req+4, 4);
+        nd.state = TCS_Idle;
+        }
+      else
+        {
+        nd.state = TCS_Download;
+        nd.pos = 0;
+        nd.toggle = 0;
+        }
+      rsp[0] = 0x60;
+      Respond(nodeid, rsp);
+      break;
+
+    case 0x00:  // download segment
+      if (nd.state != TCS_Download || (cmd & 0x10) != nd.toggle)
+        return Abort(nodeid, 0x05030000);
+      n = 7 - ((cmd >> 1) & 0x07);
+      if (nd.pos + n <= TEST_COSIM_OBJSIZE)
+        memcpy(nd.data + nd.pos, req+1, n);
+      nd.pos += n;
+      rsp[0] = 0x20 | nd.toggle;
+      nd.toggle ^= 0x10;
+      if (cmd & 0x01)
+        nd.state = TCS_Idle;
+      Respond(nodeid, rsp);
+      break;
+
+    case 0xa0:  // block upload
+      switch (cmd & 0x03)
+        {
+        case 0:   // init
+          if (req[4] < 1 || req[4] > CANopen_SDOBlockSizeMax)
+            return Abort(nodeid, 0x05040002);
+          if (req[5] && m_objsize <= req[5])
+            goto init_upload;   // protocol switch
+          memcpy(nd.mux, req+1, 3);
+          memcpy(rsp+1, req+1, 3);
+          nd.blksize = req[4];
+          nd.crc = (cmd & 0x04);
+          nd.size = m_objsize;
+          nd.pos = 0;
+          nd.state = TCS_BlockUpload;
+          rsp[0] = 0xc6;
+          memcpy(rsp+4, &nd.size, 4);
+          Respond(nodeid, rsp);
+          break;
+        case 3:   // start
+          if (nd.state != TCS_BlockUpload)
+            return Abort(nodeid, 0x05040001);
+          SendUploadBlock(nodeid);
+          break;
+        case 2:   // block acknowledge
+          if (nd.state != TCS_BlockUpload)
+            return Abort(nodeid, 0x05040001);
+          if (req[2] < 1 || req[2] > CANopen_SDOBlockSizeMax)
+            return Abort(nodeid, 0x05040002);
+          nd.pos = std::min(nd.blkpos + req[1] * 7, nd.size);
+          nd.blksize = req[2];
+          if (nd.pos < nd.size)
+            SendUploadBlock(nodeid);
+          else
+            {
+            uint16_t crc = nd.crc ? CANopen::CRC16(nd.data, nd.size) : 0;
+            rsp[0] = 0xc1 | (((7 - nd.size % 7) % 7) << 2);
+            rsp[1] = crc & 0xff;
+            rsp[2] = crc >> 8;
+            nd.state = TCS_BlockUploadEnd;
+            Respond(nodeid, rsp);
+            }
+          break;
+        case 1:   // end
+          nd.state = TCS_Idle;
+          break;
+        }
+      break;
+
+    case 0xc0:  // block download
+      if (cmd & 0x01)
+        {
+        // end:
+        if (nd.state != TCS_BlockDownloadEnd)
+          return Abort(nodeid, 0x05040001);
+        nd.pos -= (cmd >> 2) & 0x07;
+        if (nd.crc && CANopen::CRC16(nd.data, nd.pos) != (req[1] | (req[2] << 8)))
+          return Abort(nodeid, 0x05040004);
+        rsp[0] = 0xa1;
+        nd.state = TCS_Idle;
+        Respond(nodeid, rsp);
+        }
+      else
+        {
+        // init:
+        memcpy(nd.mux, req+1, 3);
+        memcpy(rsp+1, req+1, 3);
+        nd.crc = (cmd & 0x04);
+        nd.blksize = m_blksize;
+        nd.seqno = 0;
+        nd.pos = 0;
+        nd.state = TCS_BlockDownload;
+        rsp[0] = 0xa4;
+        rsp[4] = nd.blksize;
+        Respond(nodeid, rsp);
+        }
+      break;
+
+    default:
+      Abort(nodeid, 0x05040001);
+      break;
+    }
+  }
+
+void CANopen::shell_testsim(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int nodes = (argc > 0) ? atoi(argv[0]) : 1;
+  int size = (argc > 1) ? atoi(argv[1]) : 4;
+  int blksize = (argc > 2) ? atoi(argv[2]) : 0;
+  int count = (argc > 3) ? atoi(argv[3]) : 100;
+  if (nodes < 1 || nodes > TEST_COSIM_NODES || size < 1 || size > TEST_COSIM_OBJSIZE
+    || blksize < 0 || blksize > CANopen_SDOBlockSizeMax || count < 1)
+    {
+    writer->printf("Error: nodes 1…%d, size 1…%d, blksize 0…%d\n",
+      TEST_COSIM_NODES, TEST_COSIM_OBJSIZE, CANopen_SDOBlockSizeMax);
+    return;
+    }
+
+  // the virtual bus stays allocated, as canbus instances cannot be removed:
+  static test_cosim_bus* simbus = NULL;
+  if (!simbus)
+    simbus = new test_cosim_bus();
+  simbus->Start(CAN_MODE_ACTIVE, CAN_SPEED_1000KBPS);
+  simbus->m_objsize = size;
+
+  CANopenAsyncClient* client = new CANopenAsyncClient(simbus, CANopen_JobQueueSize);
+  client->SetSDOBlockTransfer(blksize);
+  uint8_t* buf = (uint8_t*) ExternalRamMalloc(nodes * size);
+  CANopenJob job;
+
+  writer->printf("%d nodes, %d byte objects, %s, %d transfers each:\n", nodes, size,
+    blksize ? "block transfer" : "expedited/segmented", count);
+
+  for (int write = 0; write <= 1; write++)
+    {
+    int submitted = 0, done = 0, errors = 0;
+    size_t bytes = 0;
+    int64_t time_start_us = esp_timer_get_time();
+    while (done < count)
+      {
+      // keep the worker busy, but don't overflow our done queue:
+      while (submitted < count && submitted - done < CANopen_JobQueueSize)
+        {
+        int nodeid = 1 + submitted % nodes;
+        uint8_t* nodebuf = buf + (nodeid-1) * size;
+        if (write)
+          client->InitWriteSDO(job, nodeid, 0x2000, submitted & 0xff, nodebuf, size, 100, 3);
+        else
+          client->InitReadSDO(job, nodeid, 0x2000, submitted & 0xff, nodebuf, size, 100, 3);
+        client->SubmitJob(job, portMAX_DELAY);
+        submitted++;
+        }
+      if (client->ReceiveDone(job, portMAX_DELAY) != COR_OK)
+        {
+        if (errors++ == 0)
+          writer->printf("  first error: %s\n", CANopen::GetResultString(job).c_str());
+        }
+      else if (!write && memcmp(job.sdo.buf, simbus->m_node[job.sdo.nodeid].data, size) != 0)
+        {
+        if (errors++ == 0)
+          writer->puts("  first error: data mismatch");
+        }
+      else
+        bytes += job.sdo.xfersize;
+      done++;
+      }
+    int64_t time_us = esp_timer_get_time() - time_start_us;
+    writer->printf("  %s: %lld us = %d registers/s, %d bytes/s, %d errors\n",
+      write ? "write" : "read ", time_us,
+      time_us ? (int)(count * 1000000LL / time_us) : 0,
+      time_us ? (int)(bytes * 1000000LL / time_us) : 0,
+      errors);
+    }
+
+  free(buf);
+  delete client;
+  MyCANopen.Stop(simbus);
+  simbus->Stop();
+  }
+
+#endif // CONFIG_OVMS_COMP_CANOPEN_TESTSIM
@@ -26,6 +26,7 @@
 #include "ovms_log.h"
 static const char *TAG = "canopen";
 
+#include <algorithm>
 #include "ovms_metrics.h"
 #include "metrics_standard.h"
 #include "ovms_events.h"
@@ -55,14 +56,37 @@ static const char *TAG = "canopen";
 #define SDO_SegmentUnusedMask       0b00001110
 #define SDO_SegmentEnd              0b00000001
 
+#define SDO_BlockUploadRequest      0b10100000
+#define SDO_BlockUploadResponse     0b11000000
+#define SDO_BlockDownloadRequest    0b11000000
+#define SDO_BlockDownloadResponse   0b10100000
+
+#define SDO_BlockCRC                0b00000100
+#define SDO_BlockSizeIndicated      0b00000010
+#define SDO_BlockSubcommandMask     0b00000011
+#define SDO_BlockInit               0b00000000
+#define SDO_BlockEnd                0b00000001
+#define SDO_BlockAck                0b00000010
+#define SDO_BlockUploadStart        0b00000011
+#define SDO_BlockEndUnusedMask      0b00011100
+#define SDO_BlockLastSegment        0b10000000
+#define SDO_BlockSeqnoMask          0b01111111
+
+#define SDO_BlockProtocolSwitch     4     // block upload: server may switch to expedited upload up to this size
+
 // SDO abort reasons:
 
 #define SDO_Abort_SegMismatch       0x05030000
 #define SDO_Abort_Timeout           0x05040000
+#define SDO_Abort_InvalidCommand    0x05040001
+#define SDO_Abort_InvalidBlockSize  0x05040002
+#define SDO_Abort_InvalidSeqno      0x05040003
+#define SDO_Abort_CRCError          0x05040004
 #define SDO_Abort_OutOfMemory       0x05040005
 
 
 static void CANopenWorkerJobTask(void *pvParameters);
+static void CANopenChannelTask(void *pvParameters);
 
 
 /**
@@ -71,6 +95,9 @@ static void CANopenWorkerJobTask(void *pvParameters);
  * CANopenClients create and submit Jobs to be processed to a CANopenWorker.
  * After finish/abort, the Worker sends the Job to the clients done queue.
  * 
+ * The worker task dispatches jobs to a set of CANopenChannels, allowing
+ * jobs for different nodes to be run concurrently.
+ * 
  * A CANopenWorker also monitors the bus for emergency and heartbeat
  * messages, and translates these into events and metrics updates.
  */
@@ -88,22 +115,23 @@ CANopenWorker::CANopenWorker(canbus* bus)
   m_jobcnt_timeout = 0;
   m_jobcnt_error = 0;
   
-  m_jobqueue = xQueueCreate(20, sizeof(CANopenJob));
+  // further channels are created on demand, see GetIdleChannel():
+  memset(m_channel, 0, sizeof(m_channel));
+  m_channel[0] = new CANopenChannel(this, 0);
+  m_channelcnt = 1;
+  
+  m_jobqueue = xQueueCreate(CANopen_JobQueueSize, sizeof(CANopenJob));
   snprintf(m_taskname, sizeof(m_taskname), "OVMS COwrk %s", bus->GetName());
   xTaskCreatePinnedToCore(CANopenWorkerJobTask, m_taskname,
     CONFIG_OVMS_COMP_CANOPEN_WRK_STACK, (void*)this, 15, &m_jobtask, CORE(0));
-  
-  memset(&m_job, 0, sizeof(m_job));
-  m_job.type = COJT_None;
-  
-  memset(&m_request, 0, sizeof(m_request));
-  memset(&m_response, 0, sizeof(m_response));
   }
 
 CANopenWorker::~CANopenWorker()
   {
-  vQueueDelete(m_jobqueue);
   vTaskDelete(m_jobtask);
+  vQueueDelete(m_jobqueue);
+  for (int i=0; i < m_channelcnt; i++)
+    delete m_channel[i];
   }
 
 
@@ -132,10 +160,18 @@ bool CANopenWorker::IsClient(CANopenAsyncClient* client)
 
 void CANopenWorker::StatusReport(int verbosity, OvmsWriter* writer)
   {
+  int running = 0;
+  for (int i=0; i < m_channelcnt; i++)
+    {
+    if (m_channel[i]->IsBusy())
+      running++;
+    }
+  
   writer->printf(
     "  %s:\n"
     "    Active clients: %d\n"
     "    Jobs waiting  : %d\n"
+    "    Jobs running  : %d/%d (max %d)\n"
     "    Jobs processed: %d\n"
     "    - timeouts    : %d\n"
     "    - other errors: %d\n"
@@ -143,7 +179,10 @@ void CANopenWorker::StatusReport(int verbosity, OvmsWriter* writer)
     "    EMCY received : %d\n"
     , m_bus->GetName()
     , m_clientcnt
-    , (int)uxQueueMessagesWaiting(m_jobqueue)
+    , (int)uxQueueMessagesWaiting(m_jobqueue) + (int)m_pending.size()
+    , running
+    , m_channelcnt
+    , CONFIG_OVMS_COMP_CANOPEN_WRK_CHANNELS
     , m_jobcnt
     , m_jobcnt_timeout
     , m_jobcnt_error
@@ -192,13 +231,89 @@ CANopenResult_t CANopenWorker::SubmitJob(CANopenJob& job, TickType_t maxqueuewai
   if (xQueueSend(m_jobqueue, &job, maxqueuewait) != pdTRUE)
     job.result = COR_ERR_QueueFull;
   else
+    {
     job.result = COR_WAIT;
+    xTaskNotifyGive(m_jobtask);
+    }
   return job.result;
   }
 
 
 /**
- * JobTask: process CANopenJobs, send results back to clients
+ * JobDone: called by the channels to return a job result to the client
+ */
+void CANopenWorker::JobDone(CANopenJob& job)
+  {
+  // return job to client if still valid:
+  if (!IsClient(job.client))
+    {
+    ESP_LOGW(TAG, "Job result lost: Client vanished");
+    }
+  else
+    {
+    if (job.client->SubmitDoneCallback(job, 0) != COR_OK)
+      ESP_LOGW(TAG, "Job result lost: Client queue is full");
+    }
+  
+  // statistics:
+  OvmsMutexLock lock(&m_statsmutex);
+  m_jobcnt++;
+  if (job.result == COR_ERR_Timeout)
+    m_jobcnt_timeout++;
+  else if (job.result != COR_OK)
+    m_jobcnt_error++;
+  }
+
+
+/**
+ * IsRunnable: check if a pending job may be started now
+ *    - jobs sharing a CAN ID with a running job or an earlier pending job
+ *      need to wait, so responses can be assigned and the order is kept
+ */
+static bool CANopenJobConflict(const CANopenJob& a, const CANopenJob& b)
+  {
+  return (a.rxid && a.rxid == b.rxid) || (a.txid && a.txid == b.txid);
+  }
+
+bool CANopenWorker::IsRunnable(CANopenJobList::iterator job)
+  {
+  for (int i=0; i < m_channelcnt; i++)
+    {
+    if (m_channel[i]->IsBusy() && CANopenJobConflict(m_channel[i]->m_job, *job))
+      return false;
+    }
+  for (auto it = m_pending.begin(); it != job; ++it)
+    {
+    if (CANopenJobConflict(*it, *job))
+      return false;
+    }
+  return true;
+  }
+
+CANopenChannel* CANopenWorker::GetIdleChannel()
+  {
+  for (int i=0; i < m_channelcnt; i++)
+    {
+    if (!m_channel[i]->IsBusy())
+      return m_channel[i];
+    }
+  
+  // all busy: add a channel (i.e. another node is addressed concurrently)
+  if (m_channelcnt == CONFIG_OVMS_COMP_CANOPEN_WRK_CHANNELS)
+    return NULL;
+  int i = m_channelcnt;
+  m_channel[i] = new CANopenChannel(this, i);
+  ESP_LOGD(TAG, "%s: added channel %d", m_bus->GetName(), i);
+  // publish the channel to IncomingFrame() after construction:
+  __sync_synchronize();
+  m_channelcnt = i + 1;
+  return m_channel[i];
+  }
+
+
+/**
+ * JobTask: dispatch CANopenJobs to the channels
+ *    - woken by SubmitJob() and by channels finishing a job
  */
 
 static void CANopenWorkerJobTask(void *pvParameters)
@@ -209,90 +324,56 @@ static void CANopenWorkerJobTask(void *pvParameters)
 
 void CANopenWorker::JobTask()
   {
+  CANopenJob job;
+  CANopenChannel* channel;
+  
   while(1)
     {
-    // get next job:
-    if (xQueueReceive(m_jobqueue, &m_job, (portTickType)portMAX_DELAY) == pdTRUE)
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    
+    // fetch new jobs:
+    while (m_pending.size() < CANopen_JobQueueSize && xQueueReceive(m_jobqueue, &job, 0) == pdTRUE)
+      m_pending.push_back(job);
+    
+    // start runnable jobs on idle channels:
+    for (auto it = m_pending.begin(); it != m_pending.end(); )
       {
-        // check client:
-        if (!IsClient(m_job.client))
-          {
-          ESP_LOGW(TAG, "Job dropped: Client vanished");
-          continue;
-          }
-        
-        // process job:
-        switch (m_job.type)
-          {
-          case COJT_None:
-            m_job.result = COR_OK;
-            break;
-          case COJT_SendNMT:
-            ESP_LOGV(TAG, "SendNMT: %s node=%d, command=%d", m_bus->GetName(), m_job.nmt.nodeid, m_job.nmt.command);
-            m_job.result = ProcessSendNMTJob();
-            ESP_LOGV(TAG, "SendNMT result: %s", CANopen::GetResultString(m_job).c_str());
-            break;
-          case COJT_ReceiveHB:
-            ESP_LOGV(TAG, "ReceiveHB: %s node=%d", m_bus->GetName(), m_job.hb.nodeid);
-            m_job.result = ProcessReceiveHBJob();
-            ESP_LOGV(TAG, "ReceiveHB result: %s", CANopen::GetResultString(m_job).c_str());
-            break;
-          case COJT_ReadSDO:
-            ESP_LOGV(TAG, "ReadSDO: %s node=%d adr=%04x.%02x", m_bus->GetName(), m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex);
-            m_job.result = ProcessReadSDOJob();
-            ESP_LOGV(TAG, "ReadSDO result: %s", CANopen::GetResultString(m_job).c_str());
-            break;
-          case COJT_WriteSDO:
-            ESP_LOGV(TAG, "WriteSDO: %s node=%d adr=%04x.%02x", m_bus->GetName(), m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex);
-            m_job.result = ProcessWriteSDOJob();
-            ESP_LOGV(TAG, "WriteSDO result: %s", CANopen::GetResultString(m_job).c_str());
-            break;
-          default:
-            ESP_LOGW(TAG, "Unknown job type: %d", (int)m_job.type);
-            m_job.result = COR_ERR_UnknownJobType;
-          }
-        
-        // return job to client if still valid:
-        if (!IsClient(m_job.client))
-          {
-          ESP_LOGW(TAG, "Job result lost: Client vanished");
-          }
-        else
-          {
-          if (m_job.client->SubmitDoneCallback(m_job, 0) != COR_OK)
-            ESP_LOGW(TAG, "Job result lost: Client queue is full");
-          }
-        
-        // statistics:
-        m_jobcnt++;
-        if (m_job.result == COR_ERR_Timeout)
-          m_jobcnt_timeout++;
-        else if (m_job.result != COR_OK)
-          m_jobcnt_error++;
-        
-        m_job.type = COJT_None;
+      // check client:
+      if (!IsClient(it->client))
+        {
+        ESP_LOGW(TAG, "Job dropped: Client vanished");
+        it = m_pending.erase(it);
+        continue;
+        }
+      if (!IsRunnable(it))
+        {
+        ++it;
+        continue;
+        }
+      if ((channel = GetIdleChannel()) == NULL)
+        break;
+      channel->Start(*it);
+      it = m_pending.erase(it);
       }
     }
   }
 
 
 /**
- * IncomingFrame: process EMCY and Heartbeat messages, forward job frames to job task
+ * IncomingFrame: process EMCY and Heartbeat messages, forward job frames to channels
  */
 void CANopenWorker::IncomingFrame(CAN_frame_t* p_frame)
   {
-  // Message matching our current job?
-  if (m_job.type != COJT_None && p_frame->MsgID == m_job.rxid)
+  // Message matching a running job?
+  int channelcnt = m_channelcnt;
+  for (int i=0; i < channelcnt; i++)
     {
-    // copy payload into m_response:
-    int i;
-    for (i=0; i < p_frame->FIR.B.DLC; i++)
-      m_response.byte[i] = p_frame->data.u8[i];
-    for (; i < 8; i++)
-      m_response.byte[i] = 0;
-    
-    // signal job task:
-    xTaskNotifyGive(m_jobtask);
+    CANopenChannel* channel = m_channel[i];
+    if (channel->IsReceiving(p_frame->MsgID))
+      {
+      channel->IncomingFrame(p_frame);
+      break;
+      }
     }
   
   
@@ -349,6 +430,152 @@ void CANopenWorker::IncomingFrame(CAN_frame_t* p_frame)
   } // IncomingFrame()
 
 
+/**
+ * A CANopenChannel executes one CANopenJob at a time in its own task.
+ * 
+ * Response frames are queued, so SDO block uploads (multiple frames per
+ * request) can be received without loss.
+ */
+
+CANopenChannel::CANopenChannel(CANopenWorker* worker, int index)
+  {
+  m_worker = worker;
+  m_bus = worker->m_bus;
+  
+  memset(&m_job, 0, sizeof(m_job));
+  m_job.type = COJT_None;
+  
+  memset(&m_request, 0, sizeof(m_request));
+  memset(&m_response, 0, sizeof(m_response));
+  
+  vPortCPUInitializeMutex(&m_rxlock);
+  m_rxid = 0;
+  
+  m_rxqueue = xQueueCreate(CANopen_SDOBlockSizeMax, sizeof(CANopenFrame_t));
+  snprintf(m_taskname, sizeof(m_taskname), "OVMS COch%d %s", index, m_bus->GetName());
+  xTaskCreatePinnedToCore(CANopenChannelTask, m_taskname,
+    CONFIG_OVMS_COMP_CANOPEN_WRK_STACK, (void*)this, 15, &m_task, CORE(0));
+  }
+
+CANopenChannel::~CANopenChannel()
+  {
+  vTaskDelete(m_task);
+  vQueueDelete(m_rxqueue);
+  }
+
+
+/**
+ * Start: begin processing a job (called by the worker task)
+ *  The response ID is published after the job has been copied, so
+ *  IncomingFrame() (CAN RX task) never sees a partially copied job.
+ */
+void CANopenChannel::Start(const CANopenJob& job)
+  {
+  xQueueReset(m_rxqueue);
+  m_job = job;
+  portENTER_CRITICAL(&m_rxlock);
+  m_rxid = job.rxid;
+  portEXIT_CRITICAL(&m_rxlock);
+  xTaskNotifyGive(m_task);
+  }
+
+
+/**
+ * IsReceiving: check if a frame ID is a response to the running job
+ */
+bool CANopenChannel::IsReceiving(uint32_t msgid)
+  {
+  portENTER_CRITICAL(&m_rxlock);
+  bool match = (m_rxid != 0 && m_rxid == msgid);
+  portEXIT_CRITICAL(&m_rxlock);
+  return match;
+  }
+
+
+/**
+ * IncomingFrame: queue response frame for the job task
+ */
+void CANopenChannel::IncomingFrame(CAN_frame_t* p_frame)
+  {
+  CANopenFrame_t response;
+  int i;
+  for (i=0; i < p_frame->FIR.B.DLC; i++)
+    response.byte[i] = p_frame->data.u8[i];
+  for (; i < 8; i++)
+    response.byte[i] = 0;
+  xQueueSend(m_rxqueue, &response, 0);
+  }
+
+
+/**
+ * ReceiveResponse: wait for the next response frame from IncomingFrame()
+ */
+bool CANopenChannel::ReceiveResponse(TickType_t maxwait)
+  {
+  return (xQueueReceive(m_rxqueue, &m_response, maxwait) == pdTRUE);
+  }
+
+
+/**
+ * ChannelTask: process CANopenJobs, send results back to clients
+ */
+
+static void CANopenChannelTask(void *pvParameters)
+  {
+  CANopenChannel *me = (CANopenChannel*)pvParameters;
+  me->ChannelTask();
+  }
+
+void CANopenChannel::ChannelTask()
+  {
+  while(1)
+    {
+    // wait for next job:
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    
+    // process job:
+    switch (m_job.type)
+      {
+      case COJT_None:
+        m_job.result = COR_OK;
+        break;
+      case COJT_SendNMT:
+        ESP_LOGV(TAG, "SendNMT: %s node=%d, command=%d", m_bus->GetName(), m_job.nmt.nodeid, m_job.nmt.command);
+        m_job.result = ProcessSendNMTJob();
+        ESP_LOGV(TAG, "SendNMT result: %s", CANopen::GetResultString(m_job).c_str());
+        break;
+      case COJT_ReceiveHB:
+        ESP_LOGV(TAG, "ReceiveHB: %s node=%d", m_bus->GetName(), m_job.hb.nodeid);
+        m_job.result = ProcessReceiveHBJob();
+        ESP_LOGV(TAG, "ReceiveHB result: %s", CANopen::GetResultString(m_job).c_str());
+        break;
+      case COJT_ReadSDO:
+        ESP_LOGV(TAG, "ReadSDO: %s node=%d adr=%04x.%02x", m_bus->GetName(), m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex);
+        m_job.result = ProcessReadSDOJob();
+        ESP_LOGV(TAG, "ReadSDO result: %s", CANopen::GetResultString(m_job).c_str());
+        break;
+      case COJT_WriteSDO:
+        ESP_LOGV(TAG, "WriteSDO: %s node=%d adr=%04x.%02x", m_bus->GetName(), m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex);
+        m_job.result = ProcessWriteSDOJob();
+        ESP_LOGV(TAG, "WriteSDO result: %s", CANopen::GetResultString(m_job).c_str());
+        break;
+      default:
+        ESP_LOGW(TAG, "Unknown job type: %d", (int)m_job.type);
+        m_job.result = COR_ERR_UnknownJobType;
+      }
+    
+    // stop receiving, return result, free channel & wake up dispatcher:
+    portENTER_CRITICAL(&m_rxlock);
+    m_rxid = 0;
+    portEXIT_CRITICAL(&m_rxlock);
+    m_worker->JobDone(m_job);
+    m_job.rxid = 0;
+    m_job.type = COJT_None;
+    xTaskNotifyGive(m_worker->m_jobtask);
+    }
+  }
+
+
 /**
  * ProcessSendNMTJob: send NMT request and optionally wait for NMT state change
  *  a.k.a. heartbeat message.
@@ -359,7 +586,7 @@ void CANopenWorker::IncomingFrame(CAN_frame_t* p_frame)
  *  even though the state has in fact changed -- there's no way to know
  *  if the node doesn't tell.
  */
-CANopenResult_t CANopenWorker::ProcessSendNMTJob()
+CANopenResult_t CANopenChannel::ProcessSendNMTJob()
   {
   // check bus:
   if (m_bus->m_mode != CAN_MODE_ACTIVE)
@@ -392,8 +619,8 @@ CANopenResult_t CANopenWorker::ProcessSendNMTJob()
     if (m_job.rxid == 0)
       return COR_OK;
     
-    // wait for response signal from IncomingFrame():
-    if (ulTaskNotifyTake(pdTRUE, maxwait))
+    // wait for response from IncomingFrame():
+    if (ReceiveResponse(maxwait))
       {
       // expected response for command?
       if ( (m_job.nmt.command == CONC_Start      && m_response.hb.state >= 5)
@@ -421,7 +648,7 @@ CANopenResult_t CANopenWorker::ProcessSendNMTJob()
  * Use this to read the current state or synchronize to the heartbeat.
  * Note: heartbeats are optional in CANopen.
  */
-CANopenResult_t CANopenWorker::ProcessReceiveHBJob()
+CANopenResult_t CANopenChannel::ProcessReceiveHBJob()
   {
   // check parameters:
   if (m_job.hb.nodeid < 1 || m_job.hb.nodeid > 127)
@@ -433,8 +660,8 @@ CANopenResult_t CANopenWorker::ProcessReceiveHBJob()
     {
     m_job.trycnt++;
     
-    // wait for receive signal from IncomingFrame():
-    if (ulTaskNotifyTake(pdTRUE, maxwait))
+    // wait for heartbeat from IncomingFrame():
+    if (ReceiveResponse(maxwait))
       {
       // return state received:
       m_job.hb.state = (CANopenNMTState_t) m_response.hb.state;
@@ -456,7 +683,7 @@ CANopenResult_t CANopenWorker::ProcessReceiveHBJob()
 /**
  * SendSDORequest: asynchronous tx of prepared CANopen SDO request
  */
-void CANopenWorker::SendSDORequest()
+void CANopenChannel::SendSDORequest()
   {
   // init tx frame:
   CAN_frame_t txframe;
@@ -469,15 +696,15 @@ void CANopenWorker::SendSDORequest()
   txframe.MsgID = m_job.txid;
   memcpy(txframe.data.u8, m_request.byte, 8);
   
-  // send:
-  txframe.Write();
+  // send (block transfers may fill up the TX queue):
+  txframe.Write(NULL, pdMS_TO_TICKS(m_job.timeout_ms));
   }
 
 
 /**
  * AbortSDORequest: send SDO abort command
  */
-void CANopenWorker::AbortSDORequest(uint32_t reason)
+void CANopenChannel::AbortSDORequest(uint32_t reason)
   {
   // backup request:
   uint8_t control = m_request.ctl.control;
@@ -497,7 +724,7 @@ void CANopenWorker::AbortSDORequest(uint32_t reason)
 /**
  * ExecuteSDORequest: send SDO request and wait for response
  */
-CANopenResult_t CANopenWorker::ExecuteSDORequest()
+CANopenResult_t CANopenChannel::ExecuteSDORequest()
   {
   TickType_t maxwait = pdMS_TO_TICKS(m_job.timeout_ms);
   m_job.trycnt = 0;
@@ -506,10 +733,11 @@ CANopenResult_t CANopenWorker::ExecuteSDORequest()
     {
     // send request:
     m_job.trycnt++;
+    xQueueReset(m_rxqueue);
     SendSDORequest();
 
     // wait for reply:
-    if (ulTaskNotifyTake(pdTRUE, maxwait))
+    if (ReceiveResponse(maxwait))
       return COR_OK;
 
     // timeout:
@@ -530,12 +758,13 @@ CANopenResult_t CANopenWorker::ExecuteSDORequest()
  *   - remaining buffer space will be zeroed
  *   - on result COR_ERR_BufferTooSmall, the buffer has been filled up to m_job.sdo.bufsize
  *   - on abort, the CANopen error code will be written into m_job.sdo.error
+ *   - uses block upload if m_job.sdo.blksize > 0 (see ReadSDOBlock())
  * 
  * Note: result interpretation is up to caller (check device object dictionary for data types & sizes).
  *   As CANopen is little endian as ESP32, we don't need to check lengths on numerical results,
  *   i.e. anything from int8_t to uint32_t can simply be read into a uint32_t buffer.
  */
-CANopenResult_t CANopenWorker::ProcessReadSDOJob()
+CANopenResult_t CANopenChannel::ProcessReadSDOJob()
   {
   // check for CAN write access:
   if (m_bus->m_mode != CAN_MODE_ACTIVE)
@@ -558,11 +787,21 @@ CANopenResult_t CANopenWorker::ProcessReadSDOJob()
   memset(&m_request, 0, sizeof(m_request));
   m_request.exp.index = m_job.sdo.index;
   m_request.exp.subindex = m_job.sdo.subindex;
-  m_request.exp.control = SDO_InitUploadRequest;
-  if (ExecuteSDORequest() != COR_OK)
+  if (m_job.sdo.blksize)
     {
-    m_job.sdo.error = SDO_Abort_Timeout;
-    return COR_ERR_Timeout;
+    // block upload, continue here if the server switched to / only supports normal upload:
+    CANopenResult_t res = ReadSDOBlock();
+    if (res != COR_WAIT)
+      return res;
+    }
+  else
+    {
+    m_request.exp.control = SDO_InitUploadRequest;
+    if (ExecuteSDORequest() != COR_OK)
+      {
+      m_job.sdo.error = SDO_Abort_Timeout;
+      return COR_ERR_Timeout;
+      }
     }
 
   // check response:
@@ -661,12 +900,13 @@ CANopenResult_t CANopenWorker::ProcessReadSDOJob()
  *   - … or 4 bytes from m_job.sdo.buf if bufsize is 0 (use for integer SDOs of unknown type)
  *   - returns data length sent in m_job.sdo.xfersize
  *   - on abort, the CANopen error code will be written into m_job.sdo.error
+ *   - uses block download if m_job.sdo.blksize > 0 and bufsize > 4 (see WriteSDOBlock())
  * 
  * Note: the caller needs to know data type & size of the SDO register (check device object dictionary).
  *   As CANopen servers normally are intelligent, anything from int8_t to uint32_t can simply be
  *   sent as a uint32_t with bufsize=0, the server will know how to convert it.
  */
-CANopenResult_t CANopenWorker::ProcessWriteSDOJob()
+CANopenResult_t CANopenChannel::ProcessWriteSDOJob()
   {
   // check for CAN write access:
   if (m_bus->m_mode != CAN_MODE_ACTIVE)
@@ -684,6 +924,14 @@ CANopenResult_t CANopenWorker::ProcessWriteSDOJob()
   uint8_t *buf = m_job.sdo.buf;
   m_job.sdo.xfersize = 0;
   
+  // block download, continue here if the server only supports normal download:
+  if (m_job.sdo.blksize && m_job.sdo.bufsize > 4)
+    {
+    CANopenResult_t res = WriteSDOBlock();
+    if (res != COR_WAIT)
+      return res;
+    }
+  
   // request download:
   memset(&m_request, 0, sizeof(m_request));
   m_request.exp.index = m_job.sdo.index;
@@ -777,3 +1025,340 @@ CANopenResult_t CANopenWorker::ProcessWriteSDOJob()
   }
 
 
+
+
+/**
+ * ReadSDOBlock: read bytes from SDO server into buffer using block upload
+ *   - called by ProcessReadSDOJob() with m_request index & subindex set
+ *   - m_job.sdo.blksize = segments per block (1…127), m_job.sdo.crc = request CRC check
+ *   - returns COR_WAIT if the server answered with a normal upload response
+ *     (protocol switch on small objects or block transfer not supported),
+ *     m_response then holds the InitUpload response to continue with
+ *   - lost or out of order segments are requested again by the block acknowledge
+ */
+CANopenResult_t CANopenChannel::ReadSDOBlock()
+  {
+  TickType_t maxwait = pdMS_TO_TICKS(m_job.timeout_ms);
+  uint8_t *buf = m_job.sdo.buf;
+  size_t bufsize = m_job.sdo.bufsize;
+  size_t rxsize, size;
+  uint8_t blksize, seqno, n;
+  bool crc, last;
+
+  blksize = std::min((int)m_job.sdo.blksize, CANopen_SDOBlockSizeMax);
+
+  // request block upload:
+  m_request.exp.control = SDO_BlockUploadRequest | SDO_BlockInit | (m_job.sdo.crc ? SDO_BlockCRC : 0);
+  m_request.exp.data[0] = blksize;
+  m_request.exp.data[1] = SDO_BlockProtocolSwitch;
+  if (ExecuteSDORequest() != COR_OK)
+    {
+    m_job.sdo.error = SDO_Abort_Timeout;
+    return COR_ERR_Timeout;
+    }
+
+  // server switched to normal upload?
+  if ((m_response.exp.control & SDO_CommandMask) == SDO_InitUploadResponse)
+    return COR_WAIT;
+
+  // block transfer not supported? → fall back to normal upload:
+  if ((m_response.exp.control & SDO_CommandMask) == SDO_Abort && m_response.ctl.data == SDO_Abort_InvalidCommand)
+    {
+    ESP_LOGD(TAG, "ReadSDO #%d 0x%04x.%02x: block upload not supported, using normal upload",
+      m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex);
+    m_request.exp.control = SDO_InitUploadRequest;
+    m_request.ctl.data = 0;
+    if (ExecuteSDORequest() != COR_OK)
+      {
+      m_job.sdo.error = SDO_Abort_Timeout;
+      return COR_ERR_Timeout;
+      }
+    return COR_WAIT;
+    }
+
+  // check response:
+  if ((m_response.exp.control & (SDO_CommandMask|SDO_BlockSubcommandMask)) != (SDO_BlockUploadResponse|SDO_BlockInit)
+    || m_response.exp.index != m_request.exp.index
+    || m_response.exp.subindex != m_request.exp.subindex)
+    {
+    if ((m_response.exp.control & SDO_CommandMask) == SDO_Abort)
+      m_job.sdo.error = m_response.ctl.data;
+    else
+      m_job.sdo.error = CANopen_BusCollision;
+    ESP_LOGD(TAG, "ReadSDO #%d 0x%04x.%02x: InitBlockUpload failed, CANopen error code 0x%08x",
+      m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex, m_job.sdo.error);
+    return COR_ERR_SDO_Access;
+    }
+
+  crc = m_job.sdo.crc && (m_response.exp.control & SDO_BlockCRC);
+  if (m_response.exp.control & SDO_BlockSizeIndicated)
+    m_job.sdo.contsize = m_response.ctl.data;
+  else
+    m_job.sdo.contsize = 0; // unknown size
+
+  // start upload:
+  memset(&m_request, 0, sizeof(m_request));
+  m_request.seg.control = SDO_BlockUploadRequest | SDO_BlockUploadStart;
+  xQueueReset(m_rxqueue);
+  SendSDORequest();
+
+  rxsize = 0;
+  last = false;
+  do
+    {
+    // receive block:
+    seqno = 0;
+    do
+      {
+      if (!ReceiveResponse(maxwait))
+        {
+        AbortSDORequest(SDO_Abort_Timeout);
+        m_job.sdo.error = SDO_Abort_Timeout;
+        return COR_ERR_Timeout;
+        }
+      if (m_response.seg.control == SDO_Abort)
+        {
+        m_job.sdo.error = m_response.ctl.data;
+        ESP_LOGD(TAG, "ReadSDO #%d 0x%04x.%02x: block upload aborted, CANopen error code 0x%08x",
+          m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex, m_job.sdo.error);
+        return COR_ERR_SDO_Access;
+        }
+
+      n = m_response.seg.control & SDO_BlockSeqnoMask;
+      if (n == seqno + 1)
+        {
+        // in sequence, copy segment data to buffer:
+        seqno = n;
+        for (int i = 1; i < 8; i++, rxsize++)
+          {
+          if (rxsize < bufsize)
+            buf[rxsize] = m_response.byte[i];
+          }
+        last = (m_response.seg.control & SDO_BlockLastSegment);
+        if (!last && rxsize > bufsize)
+          {
+          ESP_LOGD(TAG, "ReadSDO #%d 0x%04x.%02x: buffer too small, readlen=%d",
+            m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex, bufsize);
+          AbortSDORequest(SDO_Abort_OutOfMemory);
+          m_job.sdo.xfersize = bufsize;
+          m_job.sdo.error = SDO_Abort_OutOfMemory;
+          return COR_ERR_BufferTooSmall;
+          }
+        }
+      // else: segment lost, skip rest of block, the server will repeat from seqno+1
+
+      } while (n < blksize && !(m_response.seg.control & SDO_BlockLastSegment));
+
+    // acknowledge block:
+    memset(&m_request, 0, sizeof(m_request));
+    m_request.seg.control = SDO_BlockUploadRequest | SDO_BlockAck;
+    m_request.seg.data[0] = seqno;
+    m_request.seg.data[1] = blksize;
+    xQueueReset(m_rxqueue);
+    SendSDORequest();
+
+    } while (!last);
+
+  // receive end of upload:
+  if (!ReceiveResponse(maxwait))
+    {
+    AbortSDORequest(SDO_Abort_Timeout);
+    m_job.sdo.error = SDO_Abort_Timeout;
+    return COR_ERR_Timeout;
+    }
+  if ((m_response.seg.control & (SDO_CommandMask|SDO_BlockSubcommandMask)) != (SDO_BlockUploadResponse|SDO_BlockEnd))
+    {
+    if (m_response.seg.control == SDO_Abort)
+      m_job.sdo.error = m_response.ctl.data;
+    else
+      {
+      AbortSDORequest(SDO_Abort_InvalidCommand);
+      m_job.sdo.error = SDO_Abort_InvalidCommand;
+      }
+    ESP_LOGD(TAG, "ReadSDO #%d 0x%04x.%02x: EndBlockUpload failed, CANopen error code 0x%08x",
+      m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex, m_job.sdo.error);
+    return COR_ERR_SDO_Access;
+    }
+
+  // remove unused bytes of last segment:
+  size = rxsize - ((m_response.seg.control & SDO_BlockEndUnusedMask) >> 2);
+  if (size > bufsize)
+    {
+    ESP_LOGD(TAG, "ReadSDO #%d 0x%04x.%02x: buffer too small, readlen=%d",
+      m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex, bufsize);
+    AbortSDORequest(SDO_Abort_OutOfMemory);
+    m_job.sdo.xfersize = bufsize;
+    m_job.sdo.error = SDO_Abort_OutOfMemory;
+    return COR_ERR_BufferTooSmall;
+    }
+  m_job.sdo.xfersize = size;
+  if (rxsize > size)
+    memset(buf + size, 0, std::min(rxsize, bufsize) - size);
+
+  // check CRC:
+  if (crc && CANopen::CRC16(buf, size) != (m_response.byte[1] | (m_response.byte[2] << 8)))
+    {
+    ESP_LOGD(TAG, "ReadSDO #%d 0x%04x.%02x: CRC mismatch, readlen=%d",
+      m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex, size);
+    AbortSDORequest(SDO_Abort_CRCError);
+    m_job.sdo.error = SDO_Abort_CRCError;
+    return COR_ERR_SDO_CRC;
+    }
+
+  // confirm end:
+  memset(&m_request, 0, sizeof(m_request));
+  m_request.seg.control = SDO_BlockUploadRequest | SDO_BlockEnd;
+  SendSDORequest();
+  return COR_OK;
+  }
+
+
+/**
+ * WriteSDOBlock: write bytes from buffer into SDO server using block download
+ *   - called by ProcessWriteSDOJob() for m_job.sdo.bufsize > 4
+ *   - the server defines the block size, m_job.sdo.crc = request CRC check
+ *   - returns COR_WAIT if the server does not support block transfers
+ *   - segments not acknowledged by the server are repeated in the next block
+ */
+CANopenResult_t CANopenChannel::WriteSDOBlock()
+  {
+  TickType_t maxwait = pdMS_TO_TICKS(m_job.timeout_ms);
+  uint8_t *buf = m_job.sdo.buf;
+  size_t bufsize = m_job.sdo.bufsize;
+  size_t pos, txpos;
+  uint8_t blksize, seqno, n;
+  int retries = 0;
+  bool crc;
+
+  // request block download:
+  memset(&m_request, 0, sizeof(m_request));
+  m_request.ctl.index = m_job.sdo.index;
+  m_request.ctl.subindex = m_job.sdo.subindex;
+  m_request.ctl.control = SDO_BlockDownloadRequest | SDO_BlockInit | SDO_BlockSizeIndicated
+    | (m_job.sdo.crc ? SDO_BlockCRC : 0);
+  m_request.ctl.data = bufsize;
+  if (ExecuteSDORequest() != COR_OK)
+    {
+    m_job.sdo.error = SDO_Abort_Timeout;
+    return COR_ERR_Timeout;
+    }
+
+  // block transfer not supported? → fall back to normal download:
+  if ((m_response.exp.control & SDO_CommandMask) == SDO_Abort && m_response.ctl.data == SDO_Abort_InvalidCommand)
+    {
+    ESP_LOGD(TAG, "WriteSDO #%d 0x%04x.%02x: block download not supported, using normal download",
+      m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex);
+    return COR_WAIT;
+    }
+
+  // check response:
+  if ((m_response.exp.control & (SDO_CommandMask|SDO_BlockSubcommandMask)) != (SDO_BlockDownloadResponse|SDO_BlockInit)
+    || m_response.exp.index != m_request.exp.index
+    || m_response.exp.subindex != m_request.exp.subindex)
+    {
+    if ((m_response.exp.control & SDO_CommandMask) == SDO_Abort)
+      m_job.sdo.error = m_response.ctl.data;
+    else
+      m_job.sdo.error = CANopen_BusCollision;
+    ESP_LOGD(TAG, "WriteSDO #%d 0x%04x.%02x: InitBlockDownload failed, CANopen error code 0x%08x",
+      m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex, m_job.sdo.error);
+    return COR_ERR_SDO_Access;
+    }
+
+  crc = m_job.sdo.crc && (m_response.exp.control & SDO_BlockCRC);
+  blksize = m_response.exp.data[0];
+
+  pos = 0;
+  do
+    {
+    if (blksize < 1 || blksize > CANopen_SDOBlockSizeMax)
+      {
+      AbortSDORequest(SDO_Abort_InvalidBlockSize);
+      m_job.sdo.error = SDO_Abort_InvalidBlockSize;
+      return COR_ERR_SDO_Access;
+      }
+
+    // send block:
+    xQueueReset(m_rxqueue);
+    txpos = pos;
+    for (seqno = 1; seqno <= blksize && txpos < bufsize; seqno++)
+      {
+      for (n = 0; n < 7 && txpos < bufsize; n++)
+        m_request.seg.data[n] = buf[txpos++];
+      for (; n < 7; n++)
+        m_request.seg.data[n] = 0;
+      m_request.seg.control = seqno | ((txpos == bufsize) ? SDO_BlockLastSegment : 0);
+      SendSDORequest();
+      }
+    seqno--;
+
+    // wait for acknowledge:
+    if (!ReceiveResponse(maxwait))
+      {
+      AbortSDORequest(SDO_Abort_Timeout);
+      m_job.sdo.error = SDO_Abort_Timeout;
+      return COR_ERR_Timeout;
+      }
+    if ((m_response.seg.control & (SDO_CommandMask|SDO_BlockSubcommandMask)) != (SDO_BlockDownloadResponse|SDO_BlockAck))
+      {
+      if (m_response.seg.control == SDO_Abort)
+        m_job.sdo.error = m_response.ctl.data;
+      else
+        {
+        AbortSDORequest(SDO_Abort_InvalidCommand);
+        m_job.sdo.error = SDO_Abort_InvalidCommand;
+        }
+      ESP_LOGD(TAG, "WriteSDO #%d 0x%04x.%02x: block download failed, CANopen error code 0x%08x",
+        m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex, m_job.sdo.error);
+      return COR_ERR_SDO_Access;
+      }
+
+    // continue after last segment acknowledged:
+    n = m_response.seg.data[0];
+    if (n > seqno)
+      {
+      AbortSDORequest(SDO_Abort_InvalidSeqno);
+      m_job.sdo.error = SDO_Abort_InvalidSeqno;
+      return COR_ERR_SDO_Access;
+      }
+    if (n > 0)
+      retries = 0;
+    else if (++retries >= m_job.maxtries)
+      {
+      AbortSDORequest(SDO_Abort_Timeout);
+      m_job.sdo.error = SDO_Abort_Timeout;
+      return COR_ERR_Timeout;
+      }
+    pos = std::min(pos + n * 7, bufsize);
+    m_job.sdo.xfersize = pos;
+    blksize = m_response.seg.data[1];
+
+    } while (pos < bufsize);
+
+  // end download:
+  memset(&m_request, 0, sizeof(m_request));
+  m_request.seg.control = SDO_BlockDownloadRequest | SDO_BlockEnd | (((7 - bufsize % 7) % 7) << 2);
+  if (crc)
+    {
+    uint16_t crcval = CANopen::CRC16(buf, bufsize);
+    m_request.seg.data[0] = crcval & 0xff;
+    m_request.seg.data[1] = crcval >> 8;
+    }
+  if (ExecuteSDORequest() != COR_OK)
+    {
+    m_job.sdo.error = SDO_Abort_Timeout;
+    return COR_ERR_Timeout;
+    }
+  if ((m_response.seg.control & (SDO_CommandMask|SDO_BlockSubcommandMask)) != (SDO_BlockDownloadResponse|SDO_BlockEnd))
+    {
+    if (m_response.seg.control == SDO_Abort)
+      m_job.sdo.error = m_response.ctl.data;
+    else
+      m_job.sdo.error = CANopen_BusCollision;
+    ESP_LOGD(TAG, "WriteSDO #%d 0x%04x.%02x: EndBlockDownload failed, CANopen error code 0x%08x",
+      m_job.sdo.nodeid, m_job.sdo.index, m_job.sdo.subindex, m_job.sdo.error);
+    return (m_job.sdo.error == SDO_Abort_CRCError) ? COR_ERR_SDO_CRC : COR_ERR_SDO_Access;
+    }
+
+  return COR_OK;
+  }
@@ -163,7 +163,7 @@ OvmsSSH::OvmsSSH()
   MyConfig.RegisterParam("ssh.keys", "SSH public key store", true, true);
   }
 
-void OvmsSSH::NetManInit(std::string event, void* data)
+void OvmsSSH::NetManInit(const std::string& event, void* data)
   {
   // Only initialise server for WIFI connections
   // TODO: Disabled as this introduces a network interface ordering issue. It
@@ -220,7 +220,7 @@ void OvmsSSH::NetManInit(std::string event, void* data)
     ESP_LOGE(tag, "Launching SSH Server failed");
   }
 
-void OvmsSSH::NetManStop(std::string event, void* data)
+void OvmsSSH::NetManStop(const std::string& event, void* data)
   {
   if (m_ctx)
     {
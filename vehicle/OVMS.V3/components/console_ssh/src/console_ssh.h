@@ -47,8 +47,8 @@ class OvmsSSH
 
   public:
     void EventHandler(struct mg_connection *nc, int ev, void *p);
-    void NetManInit(std::string event, void* data);
-    void NetManStop(std::string event, void* data);
+    void NetManInit(const std::string& event, void* data);
+    void NetManStop(const std::string& event, void* data);
     static int Authenticate(uint8_t type, WS_UserAuthData* data, void* ctx);
     WOLFSSH_CTX* ctx() { return m_ctx; }
 
@@ -114,7 +114,7 @@ OvmsTelnet::OvmsTelnet()
   MyEvents.RegisterEvent(tag,"network.mgr.stop", std::bind(&OvmsTelnet::NetManStop, this, _1, _2));
   }
 
-void OvmsTelnet::NetManInit(std::string event, void* data)
+void OvmsTelnet::NetManInit(const std::string& event, void* data)
   {
   // Only initialise server for WIFI connections
   // TODO: Disabled as this introduces a network interface ordering issue. It
@@ -135,7 +135,7 @@ void OvmsTelnet::NetManInit(std::string event, void* data)
     ESP_LOGE(tag, "Launching Telnet Server failed");
   }
 
-void OvmsTelnet::NetManStop(std::string event, void* data)
+void OvmsTelnet::NetManStop(const std::string& event, void* data)
   {
   if (m_running)
     {
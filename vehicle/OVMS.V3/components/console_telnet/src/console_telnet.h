@@ -41,8 +41,8 @@ class OvmsTelnet
     OvmsTelnet();
 
   public:
-    void NetManInit(std::string event, void* data);
-    void NetManStop(std::string event, void* data);
+    void NetManInit(const std::string& event, void* data);
+    void NetManStop(const std::string& event, void* data);
     void EventHandler(struct mg_connection *nc, int ev, void *p);
 
   public:
@@ -38,10 +38,15 @@ static const char *TAG = "dbc";
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "dbc.h"
+#include "crypt_md5.h"
+#include "ovms_malloc.h"
 #include "dbc_tokeniser.hpp"
 #include "dbc_parser.hpp"
 #ifdef CONFIG_OVMS
+#include "ovms.h"
 #include "ovms_config.h"
 #endif // #ifdef CONFIG_OVMS
 
@@ -578,15 +583,23 @@ void dbcValueTableTable::WriteFile(dbcOutputCallback callback, void* param)
 
 dbcSignal::dbcSignal()
   {
+  m_mux.multiplexed = DBC_MUX_NONE;
+  m_mux.switchvalue = 0;
   m_start_bit = 0;
   m_signal_size = 0;
+  m_byte_order = DBC_BYTEORDER_LITTLE_ENDIAN;
+  m_value_type = DBC_VALUETYPE_UNSIGNED;
   m_metric = NULL;
   }
 
 dbcSignal::dbcSignal(std::string name)
   {
+  m_mux.multiplexed = DBC_MUX_NONE;
+  m_mux.switchvalue = 0;
   m_start_bit = 0;
   m_signal_size = 0;
+  m_byte_order = DBC_BYTEORDER_LITTLE_ENDIAN;
+  m_value_type = DBC_VALUETYPE_UNSIGNED;
   m_name = name;
   m_metric = MyMetrics.Find(name.c_str());
   }
@@ -954,6 +967,7 @@ dbcMessage::dbcMessage(uint32_t id)
 
 dbcMessage::~dbcMessage()
   {
+  RemoveAllSignals(true);
   }
 
 void dbcMessage::AddComment(const std::string& comment)
@@ -1260,12 +1274,497 @@ void dbcMessageTable::WriteSummary(dbcOutputCallback callback, void* param)
     itt->second->WriteFile(callback, param);
   }
 
+////////////////////////////////////////////////////////////////////////
+// dbcDecoder
+//
+// The decoder compiles the message table into flat tables of precomputed
+// shifts, masks and float scales, so decoding a frame needs no map lookups,
+// no dbcNumber arithmetic and no bitwise extraction loops. The payload is
+// loaded once as a 64 bit word per byte order, signals are then extracted
+// by a shift and mask. Signals are only decoded if their payload bytes
+// changed, unchanged values get refreshed once per second to keep the
+// metrics from getting stale. As a DBC file can be attached to multiple
+// buses, the change detection state is kept per bus (frame origin).
+//
+// The plan keeps no references to the message table, it needs to be
+// recompiled after changes (see dbcfile::InvalidateDecoder()).
+
+dbcDecoder::dbcDecoder()
+  {
+  }
+
+dbcDecoder::~dbcDecoder()
+  {
+  Clear();
+  }
+
+void dbcDecoder::Clear()
+  {
+  m_messages.clear();
+  m_signals.clear();
+  m_stdindex.clear();
+  m_state.clear();
+  }
+
+int dbcDecoder::GetMessageCount()
+  {
+  return m_messages.size();
+  }
+
+int dbcDecoder::GetSignalCount()
+  {
+  return m_signals.size();
+  }
+
+bool dbcDecoder::CompileSignal(dbcSignal* signal, bool multiplexor)
+  {
+  dbcDecodeSignal_t ds;
+  int start = signal->GetStartBit();
+  int size = signal->GetSignalSize();
+  int lsb;
+
+  memset(&ds, 0, sizeof(ds));
+  if (signal->GetByteOrder() == DBC_BYTEORDER_BIG_ENDIAN)
+    {
+    // Start bit = MSB, byte 0 is the most significant byte of the payload word:
+    ds.flags |= DBC_DECODE_BIGENDIAN;
+    lsb = (7 - start/8)*8 + (start%8) - (size-1);
+    }
+  else
+    {
+    // Start bit = LSB, byte 0 is the least significant byte of the payload word:
+    lsb = start;
+    }
+  if (size < 1 || size > 64 || lsb < 0 || lsb + size > 64)
+    {
+    ESP_LOGW(TAG, "Signal %s: invalid bit position %d|%d, skipped", signal->GetName().c_str(), start, size);
+    return false;
+    }
+
+  ds.shift = lsb;
+  ds.size = size;
+  ds.mask = (size == 64) ? ~0ULL : ((1ULL << size) - 1);
+  for (int pos = lsb; pos < lsb + size; pos += 8 - (pos % 8))
+    {
+    int byte = pos / 8;
+    ds.bytes |= 1 << ((ds.flags & DBC_DECODE_BIGENDIAN) ? (7 - byte) : byte);
+    }
+  if (signal->GetValueType() == DBC_VALUETYPE_SIGNED)
+    ds.flags |= DBC_DECODE_SIGNED;
+  if (!(signal->GetFactor() == 1) || !(signal->GetOffset() == 0))
+    {
+    ds.flags |= DBC_DECODE_SCALED;
+    ds.factor = signal->GetFactor().GetDouble();
+    ds.offset = signal->GetOffset().GetDouble();
+    }
+  if (!multiplexor && signal->IsMultiplexSwitch())
+    {
+    ds.flags |= DBC_DECODE_MUXED;
+    ds.muxvalue = signal->GetMultiplexSwitchvalue();
+    }
+  ds.metric = signal->GetMetric();
+
+  m_signals.push_back(ds);
+  return true;
+  }
+
+void dbcDecoder::Compile(dbcMessageTable* messages)
+  {
+  Clear();
+
+  // Note: the message map is sorted by ID, extended IDs (bit 31 set) last
+  for (auto it = messages->m_entrymap.begin(); it != messages->m_entrymap.end(); it++)
+    {
+    dbcMessage* msg = it->second;
+    dbcDecodeMessage_t dm;
+    memset(&dm, 0, sizeof(dm));
+    dm.id = msg->GetID();
+    dm.first = m_signals.size();
+    dm.mux = -1;
+
+    int metrics = 0;
+    dbcSignal* muxsig = msg->GetMultiplexorSignal();
+    if (muxsig && CompileSignal(muxsig, true))
+      {
+      dm.mux = m_signals.size() - 1;
+      if (muxsig->GetMetric()) metrics++;
+      }
+    for (dbcSignal* sig : msg->m_signals)
+      {
+      if (sig == muxsig || sig->GetMetric() == NULL)
+        continue;
+      if (CompileSignal(sig, false))
+        metrics++;
+      }
+
+    if (metrics == 0)
+      {
+      // Nothing to decode for this message:
+      m_signals.resize(dm.first);
+      continue;
+      }
+    dm.count = m_signals.size() - dm.first;
+    m_messages.push_back(dm);
+
+    if ((dm.id & 0x80000000) == 0 && dm.id < 2048)
+      {
+      if (m_stdindex.empty())
+        m_stdindex.resize(2048, 0);
+      m_stdindex[dm.id] = m_messages.size();
+      }
+    }
+
+  ESP_LOGD(TAG, "Decoder compiled: %d messages, %d signals", m_messages.size(), m_signals.size());
+  }
+
+int dbcDecoder::FindMessage(CAN_frame_t* frame)
+  {
+  if (frame->FIR.B.FF == CAN_frame_std)
+    {
+    uint32_t id = frame->MsgID & 0x7FFFFFFF;
+    if (id >= m_stdindex.size())
+      return -1;
+    return (int)m_stdindex[id] - 1;
+    }
+
+  uint32_t id = frame->MsgID | 0x80000000;
+  auto it = std::lower_bound(m_messages.begin(), m_messages.end(), id,
+    [](const dbcDecodeMessage_t& m, uint32_t id) { return m.id < id; });
+  if (it == m_messages.end() || it->id != id)
+    return -1;
+  return it - m_messages.begin();
+  }
+
+dbcDecodeStateTable_t& dbcDecoder::GetState(canbus* bus)
+  {
+  // Few buses per DBC, a linear scan is fastest:
+  for (auto& it : m_state)
+    {
+    if (it.first == bus)
+      return it.second;
+    }
+  m_state.push_back(std::make_pair(bus, dbcDecodeStateTable_t(m_messages.size())));
+  return m_state.back().second;
+  }
+
+bool dbcDecoder::Decode(CAN_frame_t* frame)
+  {
+  int index = FindMessage(frame);
+  if (index < 0)
+    return false;
+  dbcDecodeMessage_t* msg = &m_messages[index];
+  dbcDecodeState_t* state = &GetState(frame->origin)[index];
+
+  const uint8_t* data = frame->data.u8;
+
+  // Determine the payload bytes changed since the last frame:
+  uint8_t changed = 0xff;
+#ifdef CONFIG_OVMS
+  uint32_t now = monotonictime;
+#else
+  uint32_t now = state->refreshed + 1;
+#endif // #ifdef CONFIG_OVMS
+  if (state->seen && state->refreshed == now)
+    {
+    changed = 0;
+    for (int i = 0; i < 8; i++)
+      {
+      if (data[i] != state->data[i])
+        changed |= 1 << i;
+      }
+    if (changed == 0)
+      return true;
+    }
+  else
+    {
+    state->refreshed = now;
+    }
+  memcpy(state->data, data, 8);
+  state->seen = true;
+
+  // Load the payload in both byte orders:
+  uint64_t le = 0;
+  for (int i = 7; i >= 0; i--)
+    le = (le << 8) | data[i];
+  uint64_t be = __builtin_bswap64(le);
+
+  const dbcDecodeSignal_t* sig = &m_signals[msg->first];
+  const dbcDecodeSignal_t* end = sig + msg->count;
+
+  // Get multiplexor value, decode all signals on a change:
+  uint32_t muxvalue = 0;
+  if (msg->mux >= 0)
+    {
+    const dbcDecodeSignal_t* mux = &m_signals[msg->mux];
+    muxvalue = (((mux->flags & DBC_DECODE_BIGENDIAN) ? be : le) >> mux->shift) & mux->mask;
+    if (muxvalue != state->muxvalue)
+      changed = 0xff;
+    state->muxvalue = muxvalue;
+    }
+
+  for (; sig < end; sig++)
+    {
+    if ((sig->bytes & changed) == 0 || sig->metric == NULL)
+      continue;
+    if ((sig->flags & DBC_DECODE_MUXED) && sig->muxvalue != muxvalue)
+      continue;
+
+    uint64_t raw = (((sig->flags & DBC_DECODE_BIGENDIAN) ? be : le) >> sig->shift) & sig->mask;
+    bool negative = (sig->flags & DBC_DECODE_SIGNED) && ((raw >> (sig->size - 1)) & 1);
+    if (negative)
+      raw |= ~sig->mask;  // sign extension
+
+    if (sig->flags & DBC_DECODE_SCALED)
+      {
+      float value = negative ? (float)(int64_t)raw : (float)raw;
+      dbcNumber result((double)(value * sig->factor + sig->offset));
+      sig->metric->SetValue(result);
+      }
+    else if (sig->size > 32)
+      {
+      // dbcNumber integers are 32 bit, pass wider values as double:
+      dbcNumber result(negative ? (double)(int64_t)raw : (double)raw);
+      sig->metric->SetValue(result);
+      }
+    else if (sig->flags & DBC_DECODE_SIGNED)
+      {
+      dbcNumber result((int32_t)raw);
+      sig->metric->SetValue(result);
+      }
+    else
+      {
+      dbcNumber result((uint32_t)raw);
+      sig->metric->SetValue(result);
+      }
+    }
+
+  return true;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Binary cache
+//
+// The cache is a flat serialization of the parsed tables, written next
+// to the source file (path + DBC_CACHE_SUFFIX). Strings and counts are
+// stored with LEB128 lengths, numbers with their type. Loading reads the
+// file in one go and deserializes from that buffer, bypassing the lexer
+// and parser. The cache is validated by the MD5 digest of the source.
+//
+// Header (DBC_CACHE_HDRSIZE bytes, little endian):
+//    uint32  magic, uint8 version, uint8 flags, 2 bytes reserved
+//    uint8   source digest[16]
+//    uint32  length of the following data
+
+static bool dbc_hash_file(const char* path, uint8_t* digest)
+  {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  OVMS_MD5_CTX md5;
+  OVMS_MD5_Init(&md5);
+  uint8_t buf[512];
+  while (size_t n = fread(buf, 1, sizeof(buf), f))
+    OVMS_MD5_Update(&md5, buf, n);
+  OVMS_MD5_Final(digest, &md5);
+  fclose(f);
+  return true;
+  }
+
+class dbcCacheWriter
+  {
+  public:
+    void u8(uint8_t v);
+    void u32(uint32_t v);
+    void var(uint32_t v);
+    void str(const std::string& v);
+    void num(dbcNumber v);
+    void comments(dbcCommentTable* table, bool strip);
+
+  public:
+    std::string m_buf;
+  };
+
+void dbcCacheWriter::u8(uint8_t v)
+  {
+  m_buf.push_back((char)v);
+  }
+
+void dbcCacheWriter::u32(uint32_t v)
+  {
+  for (int i = 0; i < 4; i++, v >>= 8)
+    u8(v & 0xff);
+  }
+
+void dbcCacheWriter::var(uint32_t v)
+  {
+  while (v >= 0x80)
+    {
+    u8((v & 0x7f) | 0x80);
+    v >>= 7;
+    }
+  u8(v);
+  }
+
+void dbcCacheWriter::str(const std::string& v)
+  {
+  var(v.size());
+  m_buf.append(v);
+  }
+
+void dbcCacheWriter::num(dbcNumber v)
+  {
+  if (v.IsSignedInteger())
+    {
+    u8(DBC_NUMBER_INTEGER_SIGNED);
+    u32(v.GetSignedInteger());
+    }
+  else if (v.IsUnsignedInteger())
+    {
+    u8(DBC_NUMBER_INTEGER_UNSIGNED);
+    u32(v.GetUnsignedInteger());
+    }
+  else if (v.IsDouble())
+    {
+    double d = v.GetDouble();
+    u8(DBC_NUMBER_DOUBLE);
+    m_buf.append((const char*)&d, sizeof(d));
+    }
+  else
+    {
+    u8(DBC_NUMBER_NONE);
+    }
+  }
+
+void dbcCacheWriter::comments(dbcCommentTable* table, bool strip)
+  {
+  if (strip)
+    {
+    var(0);
+    return;
+    }
+  var(table->m_entrymap.size());
+  for (const std::string& comment : table->m_entrymap)
+    str(comment);
+  }
+
+class dbcCacheReader
+  {
+  public:
+    dbcCacheReader(const uint8_t* data, size_t size);
+
+  public:
+    uint8_t u8();
+    uint32_t u32();
+    uint32_t var();
+    std::string str();
+    dbcNumber num();
+    void comments(dbcCommentTable* table);
+    bool ok();
+
+  protected:
+    const uint8_t* m_pos;
+    const uint8_t* m_end;
+    bool m_ok;
+  };
+
+dbcCacheReader::dbcCacheReader(const uint8_t* data, size_t size)
+  {
+  m_pos = data;
+  m_end = data + size;
+  m_ok = (data != NULL);
+  }
+
+uint8_t dbcCacheReader::u8()
+  {
+  if (m_pos >= m_end)
+    {
+    m_ok = false;
+    return 0;
+    }
+  return *m_pos++;
+  }
+
+uint32_t dbcCacheReader::u32()
+  {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; i++)
+    v |= (uint32_t)u8() << (i*8);
+  return v;
+  }
+
+uint32_t dbcCacheReader::var()
+  {
+  uint32_t v = 0;
+  for (int shift = 0; shift < 35; shift += 7)
+    {
+    uint8_t b = u8();
+    v |= (uint32_t)(b & 0x7f) << shift;
+    if ((b & 0x80) == 0)
+      return v;
+    }
+  m_ok = false;
+  return 0;
+  }
+
+std::string dbcCacheReader::str()
+  {
+  uint32_t len = var();
+  if (!m_ok || len > (size_t)(m_end - m_pos))
+    {
+    m_ok = false;
+    return std::string();
+    }
+  std::string v((const char*)m_pos, len);
+  m_pos += len;
+  return v;
+  }
+
+dbcNumber dbcCacheReader::num()
+  {
+  switch (u8())
+    {
+    case DBC_NUMBER_INTEGER_SIGNED:
+      return dbcNumber((int32_t)u32());
+    case DBC_NUMBER_INTEGER_UNSIGNED:
+      return dbcNumber((uint32_t)u32());
+    case DBC_NUMBER_DOUBLE:
+      {
+      double d = 0;
+      if (m_end - m_pos < (ptrdiff_t)sizeof(d))
+        m_ok = false;
+      else
+        {
+        memcpy(&d, m_pos, sizeof(d));
+        m_pos += sizeof(d);
+        }
+      return dbcNumber(d);
+      }
+    case DBC_NUMBER_NONE:
+      return dbcNumber();
+    default:
+      m_ok = false;
+      return dbcNumber();
+    }
+  }
+
+void dbcCacheReader::comments(dbcCommentTable* table)
+  {
+  for (uint32_t n = var(); n > 0 && m_ok; n--)
+    table->AddComment(str());
+  }
+
+bool dbcCacheReader::ok()
+  {
+  return m_ok;
+  }
+
 ////////////////////////////////////////////////////////////////////////
 // dbcfile
 
 dbcfile::dbcfile()
   {
   m_locks = 0;
+  m_cached = false;
+  m_decoder_valid = false;
   }
 
 dbcfile::~dbcfile()
@@ -1282,6 +1781,9 @@ void dbcfile::FreeAllocations()
   m_values.EmptyContent();
   m_messages.EmptyContent();
   m_comments.EmptyContent();
+  m_cached = false;
+  m_decoder.Clear();
+  m_decoder_valid = false;
   }
 
 bool dbcfile::LoadFile(const char* name, const char* path, FILE* fd)
@@ -1302,6 +1804,14 @@ bool dbcfile::LoadFile(const char* name, const char* path, FILE* fd)
   bool result;
   m_path = path;
 
+#ifdef CONFIG_OVMS
+  // Use the binary cache if available, unless we've been given a file:
+  bool cache = (fd == NULL) && MyConfig.GetParamValueBool("dbc", "cache", true);
+  bool strip = MyConfig.GetParamValueBool("dbc", "cache.strip", false);
+  if (cache && LoadCache(name, path, strip))
+    return true;
+#endif // #ifdef CONFIG_OVMS
+
   if (fd == NULL)
     {
     fd = fopen(path, "r");
@@ -1324,6 +1834,15 @@ bool dbcfile::LoadFile(const char* name, const char* path, FILE* fd)
     fseek(fd,0,SEEK_SET);
     }
 
+  if (result)
+    {
+#ifdef CONFIG_OVMS
+    if (strip) Strip();
+    if (cache) SaveCache(strip);
+#endif // #ifdef CONFIG_OVMS
+    m_decoder.Compile(&m_messages);
+    m_decoder_valid = true;
+    }
   return result;
   }
 
@@ -1339,6 +1858,11 @@ bool dbcfile::LoadString(const char* name, const char* source, size_t length)
   bool result = (yyparse (this) == 0);
   yy_delete_buffer(buffer);
 
+  if (result)
+    {
+    m_decoder.Compile(&m_messages);
+    m_decoder_valid = true;
+    }
   return result;
   }
 
@@ -1391,6 +1915,16 @@ std::string dbcfile::Status()
     ss << (int)(covered*100)/bits;
     ss << "% coverage";
     }
+  if (m_decoder_valid)
+    {
+    ss << ", ";
+    ss << m_decoder.GetSignalCount();
+    ss << " decoded";
+    }
+  if (m_cached)
+    {
+    ss << ", cached";
+    }
   ss << ", ";
   ss << m_locks;
   ss << " lock(s)";
@@ -1413,6 +1947,310 @@ std::string dbcfile::GetVersion()
   return m_version;
   }
 
+/**
+ * LoadCache: load the binary cache of a DBC source file
+ *  Fails if the cache is missing, outdated (source digest mismatch),
+ *  corrupt or has not been written with the requested strip mode.
+ */
+bool dbcfile::LoadCache(const char* name, const char* path, bool strip)
+  {
+  FreeAllocations();
+  m_name = std::string(name);
+  m_path = path;
+
+  uint8_t digest[16];
+  if (!dbc_hash_file(path, digest))
+    return false;
+
+  std::string cpath = m_path + DBC_CACHE_SUFFIX;
+  struct stat st;
+  if (stat(cpath.c_str(), &st) != 0 || st.st_size < DBC_CACHE_HDRSIZE)
+    return false;
+  FILE* f = fopen(cpath.c_str(), "r");
+  if (!f)
+    return false;
+  size_t size = st.st_size;
+  uint8_t* buf = (uint8_t*)ExternalRamMalloc(size);
+  if (buf && fread(buf, 1, size, f) != size)
+    {
+    free(buf);
+    buf = NULL;
+    }
+  fclose(f);
+  if (!buf)
+    return false;
+
+  dbcCacheReader r(buf, size);
+  bool valid = (r.u32() == DBC_CACHE_MAGIC);
+  valid = valid && (r.u8() == DBC_CACHE_VERSION);
+  valid = valid && (r.u8() == (strip ? DBC_CACHE_STRIPPED : 0));
+  r.u8(); r.u8();
+  for (int i = 0; i < 16; i++)
+    valid = valid && (r.u8() == digest[i]);
+  valid = valid && (r.u32() == size - DBC_CACHE_HDRSIZE);
+  if (!valid)
+    {
+    ESP_LOGD(TAG, "Cache %s outdated", cpath.c_str());
+    free(buf);
+    return false;
+    }
+
+  m_version = r.str();
+  for (uint32_t n = r.var(); n > 0 && r.ok(); n--)
+    m_newsymbols.AddSymbol(r.str());
+  uint32_t baud = r.u32(), btr1 = r.u32(), btr2 = r.u32();
+  m_bittiming.SetBaud(baud, btr1, btr2);
+
+  for (uint32_t n = r.var(); n > 0 && r.ok(); n--)
+    {
+    dbcNode* node = new dbcNode(r.str());
+    r.comments(&node->m_comments);
+    m_nodes.AddNode(node);
+    }
+
+  for (uint32_t n = r.var(); n > 0 && r.ok(); n--)
+    {
+    std::string vtname = r.str();
+    dbcValueTable* vt = new dbcValueTable(vtname);
+    for (uint32_t k = r.var(); k > 0 && r.ok(); k--)
+      {
+      uint32_t id = r.u32();
+      vt->AddValue(id, r.str());
+      }
+    m_values.AddValueTable(vtname, vt);
+    }
+
+  for (uint32_t n = r.var(); n > 0 && r.ok(); n--)
+    {
+    uint32_t id = r.u32();
+    dbcMessage* msg = new dbcMessage(id);
+    msg->SetName(r.str());
+    msg->SetSize(r.var());
+    msg->SetTransmitterNode(r.str());
+    r.comments(&msg->m_comments);
+    uint32_t muxindex = r.var();
+    uint32_t index = 1;
+    for (uint32_t k = r.var(); k > 0 && r.ok(); k--, index++)
+      {
+      dbcSignal* sig = new dbcSignal();
+      sig->SetName(r.str());    // maps the name to the metric like the parser
+      uint8_t mux = r.u8();
+      uint32_t switchvalue = r.var();
+      if (mux == DBC_MUX_MULTIPLEXOR)
+        sig->SetMultiplexor();
+      else if (mux == DBC_MUX_MULTIPLEXED)
+        sig->SetMultiplexed(switchvalue);
+      int startbit = r.u8();
+      int signalsize = r.u8();
+      sig->SetStartSize(startbit, signalsize);
+      sig->SetByteOrder((dbcByteOrder_t)r.u8());
+      sig->SetValueType((dbcValueType_t)r.u8());
+      dbcNumber factor = r.num(), offset = r.num();
+      sig->SetFactorOffset(factor, offset);
+      dbcNumber minimum = r.num(), maximum = r.num();
+      sig->SetMinMax(minimum, maximum);
+      sig->SetUnit(r.str());
+      for (uint32_t j = r.var(); j > 0 && r.ok(); j--)
+        sig->AddReceiver(r.str());
+      r.comments(&sig->m_comments);
+      for (uint32_t j = r.var(); j > 0 && r.ok(); j--)
+        {
+        uint32_t value = r.u32();
+        sig->AddValue(value, r.str());
+        }
+      msg->AddSignal(sig);
+      if (index == muxindex)
+        msg->SetMultiplexorSignal(sig);
+      }
+    m_messages.AddMessage(id, msg);
+    }
+
+  r.comments(&m_comments);
+  free(buf);
+
+  if (!r.ok())
+    {
+    ESP_LOGW(TAG, "Cache %s is corrupt", cpath.c_str());
+    FreeAllocations();
+    return false;
+    }
+
+  ESP_LOGD(TAG, "Loaded %s from cache (%d bytes)", m_name.c_str(), size);
+  m_cached = true;
+  m_decoder.Compile(&m_messages);
+  m_decoder_valid = true;
+  return true;
+  }
+
+/**
+ * SaveCache: write the binary cache for the source file
+ *  With strip=true, comments and value tables are left out.
+ */
+bool dbcfile::SaveCache(bool strip)
+  {
+  uint8_t digest[16];
+  if (m_path.empty() || !dbc_hash_file(m_path.c_str(), digest))
+    return false;
+
+  dbcCacheWriter w;
+  w.u32(DBC_CACHE_MAGIC);
+  w.u8(DBC_CACHE_VERSION);
+  w.u8(strip ? DBC_CACHE_STRIPPED : 0);
+  w.u8(0); w.u8(0);
+  for (int i = 0; i < 16; i++)
+    w.u8(digest[i]);
+  w.u32(0);     // data length, filled in below
+
+  w.str(m_version);
+  w.var(m_newsymbols.m_entrymap.size());
+  for (const std::string& symbol : m_newsymbols.m_entrymap)
+    w.str(symbol);
+  w.u32(m_bittiming.GetBaudRate());
+  w.u32(m_bittiming.GetBTR1());
+  w.u32(m_bittiming.GetBTR2());
+
+  w.var(m_nodes.m_entrymap.size());
+  for (auto& it : m_nodes.m_entrymap)
+    {
+    w.str(it.second->GetName());
+    w.comments(&it.second->m_comments, strip);
+    }
+
+  if (strip)
+    w.var(0);
+  else
+    {
+    w.var(m_values.m_entrymap.size());
+    for (auto& it : m_values.m_entrymap)
+      {
+      w.str(it.second->GetName());
+      w.var(it.second->m_entrymap.size());
+      for (auto& value : it.second->m_entrymap)
+        {
+        w.u32(value.first);
+        w.str(value.second);
+        }
+      }
+    }
+
+  w.var(m_messages.m_entrymap.size());
+  for (auto& it : m_messages.m_entrymap)
+    {
+    dbcMessage* msg = it.second;
+    w.u32(msg->GetID());
+    w.str(msg->GetName());
+    w.var(msg->GetSize());
+    w.str(msg->GetTransmitterNode());
+    w.comments(&msg->m_comments, strip);
+    uint32_t muxindex = 0, index = 1;
+    for (dbcSignal* sig : msg->m_signals)
+      {
+      if (sig == msg->GetMultiplexorSignal())
+        muxindex = index;
+      index++;
+      }
+    w.var(muxindex);
+    w.var(msg->m_signals.size());
+    for (dbcSignal* sig : msg->m_signals)
+      {
+      w.str(sig->GetName());
+      w.u8(sig->IsMultiplexor() ? DBC_MUX_MULTIPLEXOR
+        : sig->IsMultiplexSwitch() ? DBC_MUX_MULTIPLEXED : DBC_MUX_NONE);
+      w.var(sig->GetMultiplexSwitchvalue());
+      w.u8(sig->GetStartBit());
+      w.u8(sig->GetSignalSize());
+      w.u8(sig->GetByteOrder());
+      w.u8(sig->GetValueType());
+      w.num(sig->GetFactor());
+      w.num(sig->GetOffset());
+      w.num(sig->GetMinimum());
+      w.num(sig->GetMaximum());
+      w.str(sig->GetUnit());
+      w.var(sig->m_receivers.size());
+      for (const std::string& receiver : sig->m_receivers)
+        w.str(receiver);
+      w.comments(&sig->m_comments, strip);
+      w.var(sig->m_values.m_entrymap.size());
+      for (auto& value : sig->m_values.m_entrymap)
+        {
+        w.u32(value.first);
+        w.str(value.second);
+        }
+      }
+    }
+
+  w.comments(&m_comments, strip);
+
+  uint32_t len = w.m_buf.size() - DBC_CACHE_HDRSIZE;
+  for (int i = 0; i < 4; i++)
+    w.m_buf[DBC_CACHE_HDRSIZE-4+i] = (len >> (i*8)) & 0xff;
+
+  std::string cpath = m_path + DBC_CACHE_SUFFIX;
+  FILE* f = fopen(cpath.c_str(), "w");
+  if (!f)
+    {
+    ESP_LOGD(TAG, "Could not open %s for writing", cpath.c_str());
+    return false;
+    }
+  bool ok = (fwrite(w.m_buf.data(), 1, w.m_buf.size(), f) == w.m_buf.size());
+  fclose(f);
+  if (!ok)
+    {
+    ESP_LOGW(TAG, "Could not write %s", cpath.c_str());
+    unlink(cpath.c_str());
+    return false;
+    }
+  ESP_LOGD(TAG, "Cache %s written (%d bytes)", cpath.c_str(), w.m_buf.size());
+  return true;
+  }
+
+/**
+ * Strip: drop all comments and value tables to save memory
+ *  Signal value descriptions are kept.
+ */
+void dbcfile::Strip()
+  {
+  m_comments.EmptyContent();
+  m_values.EmptyContent();
+  for (auto& it : m_nodes.m_entrymap)
+    it.second->m_comments.EmptyContent();
+  for (auto& it : m_messages.m_entrymap)
+    {
+    it.second->m_comments.EmptyContent();
+    for (dbcSignal* sig : it.second->m_signals)
+      sig->m_comments.EmptyContent();
+    }
+  }
+
+bool dbcfile::IsCached()
+  {
+  return m_cached;
+  }
+
+/**
+ * DecodeFrame: decode a frame into the metrics mapped to its signals
+ *  Uses the precompiled decoder, which is rebuilt here after changes
+ *  to the message table (i.e. from the decoding task).
+ *  Returns false if the frame is not decoded by this DBC file.
+ */
+bool dbcfile::DecodeFrame(CAN_frame_t* frame)
+  {
+  if (!m_decoder_valid)
+    {
+    m_decoder.Compile(&m_messages);
+    m_decoder_valid = true;
+    }
+  return m_decoder.Decode(frame);
+  }
+
+/**
+ * InvalidateDecoder: schedule a decoder recompilation after message table changes
+ */
+void dbcfile::InvalidateDecoder()
+  {
+  m_decoder_valid = false;
+  }
+
 void dbcfile::LockFile()
   {
   m_locks++;
@@ -34,6 +34,7 @@
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
 #include <functional>
 #include <iostream>
 #include "dbc_number.h"
@@ -412,6 +413,77 @@ class dbcMessageTable
     dbcMessageEntry_t m_entrymap;
   };
 
+// Precompiled decode plan (see dbcDecoder)
+
+#define DBC_DECODE_BIGENDIAN    0x01
+#define DBC_DECODE_SIGNED       0x02
+#define DBC_DECODE_SCALED       0x04    // apply factor & offset (float result)
+#define DBC_DECODE_MUXED        0x08    // only decode with matching multiplexor value
+
+typedef struct
+  {
+  uint64_t mask;                        // value mask (after shift)
+  uint8_t shift;                        // LSB position in the 64 bit payload word
+  uint8_t size;                         // signal size [bits]
+  uint8_t bytes;                        // payload bytes covered (bit mask)
+  uint8_t flags;                        // DBC_DECODE_…
+  uint32_t muxvalue;                    // multiplexor value (DBC_DECODE_MUXED)
+  float factor;
+  float offset;
+  OvmsMetric* metric;                   // NULL for an unmapped multiplexor
+  } dbcDecodeSignal_t;
+
+typedef struct
+  {
+  uint32_t id;                          // message ID (bit 31 set = extended)
+  uint16_t first;                       // first signal in the signal table
+  uint16_t count;                       // number of signals
+  int16_t mux;                          // multiplexor signal (table index), -1 = none
+  } dbcDecodeMessage_t;
+
+typedef struct
+  {
+  bool seen;                            // last payload valid
+  uint8_t data[8];                      // last payload
+  uint32_t muxvalue;                    // last multiplexor value
+  uint32_t refreshed;                   // last full decode (monotonic time)
+  } dbcDecodeState_t;
+
+typedef std::vector<dbcDecodeState_t> dbcDecodeStateTable_t;   // per message
+
+class dbcDecoder
+  {
+  public:
+    dbcDecoder();
+    ~dbcDecoder();
+
+  public:
+    void Compile(dbcMessageTable* messages);
+    void Clear();
+    bool Decode(CAN_frame_t* frame);
+    int GetMessageCount();
+    int GetSignalCount();
+
+  protected:
+    bool CompileSignal(dbcSignal* signal, bool multiplexor);
+    int FindMessage(CAN_frame_t* frame);
+    dbcDecodeStateTable_t& GetState(canbus* bus);
+
+  protected:
+    std::vector<dbcDecodeMessage_t> m_messages;   // sorted by ID
+    std::vector<dbcDecodeSignal_t> m_signals;
+    std::vector<uint16_t> m_stdindex;             // standard ID → message index + 1, 0 = none
+    std::vector< std::pair<canbus*, dbcDecodeStateTable_t> > m_state;   // change detection per bus
+  };
+
+// Binary cache of a parsed DBC file (see dbcfile::SaveCache)
+
+#define DBC_CACHE_SUFFIX        ".cache"
+#define DBC_CACHE_MAGIC         0x43434244    // "DBCC"
+#define DBC_CACHE_VERSION       1
+#define DBC_CACHE_HDRSIZE       28
+#define DBC_CACHE_STRIPPED      0x01          // comments & value tables dropped
+
 class dbcfile
   {
   public:
@@ -431,6 +503,16 @@ class dbcfile
     std::string GetPath();
     std::string GetVersion();
 
+  public:
+    bool LoadCache(const char* name, const char* path, bool strip=false);
+    bool SaveCache(bool strip=false);
+    void Strip();
+    bool IsCached();
+
+  public:
+    bool DecodeFrame(CAN_frame_t* frame);
+    void InvalidateDecoder();
+
   public:
     void LockFile();
     void UnlockFile();
@@ -450,6 +532,9 @@ class dbcfile
   private:
     dbcMessage* m_lastmsg;
     int m_locks;
+    bool m_cached;
+    dbcDecoder m_decoder;
+    volatile bool m_decoder_valid;
   };
 
 #endif //#ifndef __DBC_H__
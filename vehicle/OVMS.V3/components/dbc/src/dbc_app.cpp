@@ -195,7 +195,7 @@ void dbc_autoload(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
   MyDBC.LoadAutoExtras(false);
   }
 
-void dbc_sdmounted(std::string event, void* data)
+void dbc_sdmounted(const std::string& event, void* data)
   {
   if (MyConfig.GetParamValueBool("auto", "dbc", false))
     MyDBC.LoadAutoExtras(true);
@@ -310,6 +310,7 @@ void dbc_message_clear(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int
     }
 
   MyDBC.m_selected->m_messages.EmptyContent();
+  MyDBC.m_selected->InvalidateDecoder();
   writer->puts("DBC: Message table cleared");
   }
 
@@ -333,6 +334,7 @@ void dbc_message_add(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int ar
   msg->SetSize(atoi(argv[2]));
   msg->SetTransmitterNode(argv[3]);
   MyDBC.m_selected->m_messages.AddMessage(msgid,msg);
+  MyDBC.m_selected->InvalidateDecoder();
   writer->printf("DBC: Added message %s\n",argv[0]);
   }
 
@@ -349,6 +351,7 @@ void dbc_message_remove(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int
   if (msg != NULL)
     {
     MyDBC.m_selected->m_messages.RemoveMessage(msg->GetID(),true);
+    MyDBC.m_selected->InvalidateDecoder();
     writer->printf("DBC: Message %s removed\n",argv[0]);
     }
   else
@@ -376,6 +379,7 @@ void dbc_message_set_mux(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, in
   if (argc == 1)
     {
     msg->SetMultiplexorSignal(NULL);
+    MyDBC.m_selected->InvalidateDecoder();
     writer->printf("DBC: Cleared mux for %s\n",argv[0]);
     return;
     }
@@ -388,6 +392,7 @@ void dbc_message_set_mux(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, in
     }
 
   msg->SetMultiplexorSignal(signal);
+  MyDBC.m_selected->InvalidateDecoder();
   writer->printf("DBC: Set mux for message %s to %s\n",argv[0],argv[1]);
   }
 
@@ -410,6 +415,7 @@ void dbc_signal_clear(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int a
     {
     msg->RemoveAllSignals(true);
     msg->SetMultiplexorSignal(NULL);
+    MyDBC.m_selected->InvalidateDecoder();
     writer->printf("DBC: Cleared all signals for %s\n",argv[0]);
     }
   }
@@ -449,6 +455,7 @@ void dbc_signal_add(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int arg
   signal->SetUnit(argv[10]);
   signal->AddReceiver(argv[11]);
   msg->AddSignal(signal);
+  MyDBC.m_selected->InvalidateDecoder();
   writer->printf("DBC: Added signal %s on message %s\n",argv[1],argv[0]);
   }
 
@@ -477,6 +484,7 @@ void dbc_signal_remove(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int
   else
     {
     msg->RemoveSignal(signal, true);
+    MyDBC.m_selected->InvalidateDecoder();
     writer->printf("DBC: Removed signal %s on message %s\n",argv[1],argv[0]);
     }
   }
@@ -507,11 +515,13 @@ void dbc_signal_set_mux(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int
   if (argc > 2)
     {
     signal->SetMultiplexed(atoi(argv[2]));
+    MyDBC.m_selected->InvalidateDecoder();
     writer->printf("DBC: Set mux %s for signal %s on message %s\n",argv[2],argv[1],argv[0]);
     }
   else
     {
     signal->ClearMultiplexed();
+    MyDBC.m_selected->InvalidateDecoder();
     writer->printf("DBC: Cleared mux for signal %s on message %s\n",argv[1],argv[0]);
     }
   }
@@ -557,6 +567,8 @@ dbc::dbc()
   MyConfig.RegisterParam("dbc", "DBC Configuration", true, true);
   // Our instances:
   //   'autodirs': Space separated list of directories to auto load DBC files from
+  //   'cache': Load DBC files from binary caches written next to them (default yes)
+  //   'cache.strip': Drop comments & value tables on load to save memory (default no)
 
   #undef bind  // Kludgy, but works
   using std::placeholders::_1;
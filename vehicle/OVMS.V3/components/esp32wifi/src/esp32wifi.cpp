@@ -991,7 +991,7 @@ void esp32wifi::UpdateNetMetrics()
     }
   }
 
-void esp32wifi::EventWifiGotIp(std::string event, void* data)
+void esp32wifi::EventWifiGotIp(const std::string& event, void* data)
   {
   system_event_info_t *info = (system_event_info_t*)data;
   m_ip_info_sta = info->got_ip.ip_info;
@@ -1002,7 +1002,7 @@ void esp32wifi::EventWifiGotIp(std::string event, void* data)
     IP2STR(&m_ip_info_sta.ip), IP2STR(&m_ip_info_sta.netmask), IP2STR(&m_ip_info_sta.gw));
   }
 
-void esp32wifi::EventWifiLostIp(std::string event, void* data)
+void esp32wifi::EventWifiLostIp(const std::string& event, void* data)
   {
   memset(&m_ip_info_sta,0,sizeof(m_ip_info_sta));
   UpdateNetMetrics();
@@ -1010,7 +1010,7 @@ void esp32wifi::EventWifiLostIp(std::string event, void* data)
     m_wifi_sta_cfg.sta.ssid, MAC2STR(m_sta_ap_info.bssid));
   }
 
-void esp32wifi::EventWifiStaConnected(std::string event, void* data)
+void esp32wifi::EventWifiStaConnected(const std::string& event, void* data)
   {
   system_event_sta_connected_t& conn = ((system_event_info_t*)data)->connected;
 
@@ -1027,7 +1027,7 @@ void esp32wifi::EventWifiStaConnected(std::string event, void* data)
     conn.authmode == WIFI_AUTH_WPA_WPA2_PSK ? "WPA/WPA2" : "Unknown");
   }
 
-void esp32wifi::EventWifiStaDisconnected(std::string event, void* data)
+void esp32wifi::EventWifiStaDisconnected(const std::string& event, void* data)
   {
   system_event_info_t *info = (system_event_info_t*)data;
 
@@ -1056,7 +1056,7 @@ void esp32wifi::AdjustTaskPriority()
 #endif
   }
 
-void esp32wifi::EventWifiStaState(std::string event, void* data)
+void esp32wifi::EventWifiStaState(const std::string& event, void* data)
   {
   if (event == "system.wifi.sta.start")
     {
@@ -1077,7 +1077,7 @@ void esp32wifi::EventWifiStaState(std::string event, void* data)
     }
   }
 
-void esp32wifi::EventWifiApState(std::string event, void* data)
+void esp32wifi::EventWifiApState(const std::string& event, void* data)
   {
   if (event == "system.wifi.ap.start")
     {
@@ -1120,7 +1120,7 @@ void esp32wifi::EventWifiApState(std::string event, void* data)
     }
   }
 
-void esp32wifi::EventWifiApUpdate(std::string event, void* data)
+void esp32wifi::EventWifiApUpdate(const std::string& event, void* data)
   {
   system_event_info_t *info = (system_event_info_t*)data;
   if (event == "system.wifi.ap.sta.connected")
@@ -1131,7 +1131,7 @@ void esp32wifi::EventWifiApUpdate(std::string event, void* data)
       info->sta_connected.aid, MAC2STR(info->sta_connected.mac));
   }
 
-void esp32wifi::EventTimer1(std::string event, void* data)
+void esp32wifi::EventTimer1(const std::string& event, void* data)
   {
   UpdateNetMetrics();
 
@@ -1168,7 +1168,7 @@ void esp32wifi::StartConnect()
   m_sta_reconnect = monotonictime + 10;
   }
 
-void esp32wifi::EventWifiScanDone(std::string event, void* data)
+void esp32wifi::EventWifiScanDone(const std::string& event, void* data)
   {
   uint16_t apCount = 0;
   esp_err_t res;
@@ -1267,7 +1267,7 @@ void esp32wifi::EventWifiScanDone(std::string event, void* data)
     free(list);
   }
 
-void esp32wifi::EventSystemShuttingDown(std::string event, void* data)
+void esp32wifi::EventSystemShuttingDown(const std::string& event, void* data)
   {
   PowerDown();
   }
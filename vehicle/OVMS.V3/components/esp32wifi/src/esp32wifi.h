@@ -81,16 +81,16 @@ class esp32wifi : public pcp, public InternalRamAllocated
     void SetAPWifiBW();
 
   public:
-    void EventWifiStaState(std::string event, void* data);
-    void EventWifiGotIp(std::string event, void* data);
-    void EventWifiLostIp(std::string event, void* data);
-    void EventWifiStaConnected(std::string event, void* data);
-    void EventWifiStaDisconnected(std::string event, void* data);
-    void EventWifiApState(std::string event, void* data);
-    void EventWifiApUpdate(std::string event, void* data);
-    void EventTimer1(std::string event, void* data);
-    void EventWifiScanDone(std::string event, void* data);
-    void EventSystemShuttingDown(std::string event, void* data);
+    void EventWifiStaState(const std::string& event, void* data);
+    void EventWifiGotIp(const std::string& event, void* data);
+    void EventWifiLostIp(const std::string& event, void* data);
+    void EventWifiStaConnected(const std::string& event, void* data);
+    void EventWifiStaDisconnected(const std::string& event, void* data);
+    void EventWifiApState(const std::string& event, void* data);
+    void EventWifiApUpdate(const std::string& event, void* data);
+    void EventTimer1(const std::string& event, void* data);
+    void EventWifiScanDone(const std::string& event, void* data);
+    void EventSystemShuttingDown(const std::string& event, void* data);
     void OutputStatus(int verbosity, OvmsWriter* writer);
 
   protected:
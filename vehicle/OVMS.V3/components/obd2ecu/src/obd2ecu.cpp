@@ -173,6 +173,10 @@ obd2ecu::obd2ecu(const char* name, canbus* can)
   xTaskCreatePinnedToCore(OBD2ECU_task, "OVMS OBDII ECU", 6144, (void*)this, 5, &m_task, CORE(1));
 
   MyCan.RegisterListener(m_rxqueue);
+  MyCan.AddListenerRange(m_rxqueue, m_can, CAN_frame_std, REQUEST_PID, REQUEST_PID);
+  MyCan.AddListenerRange(m_rxqueue, m_can, CAN_frame_std, FLOWCONTROL_PID, FLOWCONTROL_PID);
+  MyCan.AddListenerRange(m_rxqueue, m_can, CAN_frame_ext, REQUEST_EXT_PID, REQUEST_EXT_PID);
+  MyCan.AddListenerRange(m_rxqueue, m_can, CAN_frame_ext, FLOWCONTROL_EXT_PID, FLOWCONTROL_EXT_PID);
   }
 
 obd2ecu::~obd2ecu()
@@ -878,7 +878,7 @@ void OvmsLocations::CheckTheft()
     }
   }
 
-void OvmsLocations::UpdatedConfig(std::string event, void* data)
+void OvmsLocations::UpdatedConfig(const std::string& event, void* data)
   {
   if (event.compare("config.changed")==0)
     {
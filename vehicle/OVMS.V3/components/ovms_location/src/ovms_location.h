@@ -115,7 +115,7 @@ class OvmsLocations
     void UpdatedLatitude(OvmsMetric* metric);
     void UpdatedLongitude(OvmsMetric* metric);
     void UpdatedVehicleOn(OvmsMetric* metric);
-    void UpdatedConfig(std::string event, void* data);
+    void UpdatedConfig(const std::string& event, void* data);
   };
 
 extern OvmsLocations MyLocations;
@@ -39,19 +39,19 @@ static const char *TAG = "ovms-mdns";
 
 OvmsMDNS MyMDNS __attribute__ ((init_priority (8100)));
 
-void OvmsMDNS::SystemEvent(std::string event, void* data)
+void OvmsMDNS::SystemEvent(const std::string& event, void* data)
   {
   system_event_t *ev = (system_event_t *)data;
   if (m_mdns) mdns_handle_system_event(NULL, ev);
   }
 
-void OvmsMDNS::SystemStart(std::string event, void* data)
+void OvmsMDNS::SystemStart(const std::string& event, void* data)
   {
   ESP_LOGI(TAG, "Starting MDNS");
   StartMDNS();
   }
 
-void OvmsMDNS::EventSystemShuttingDown(std::string event, void* data)
+void OvmsMDNS::EventSystemShuttingDown(const std::string& event, void* data)
   {
   StopMDNS();
   }
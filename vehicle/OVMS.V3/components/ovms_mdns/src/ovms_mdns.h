@@ -41,9 +41,9 @@ class OvmsMDNS
     virtual ~OvmsMDNS();
 
   public:
-    void SystemEvent(std::string event, void* data);
-    void SystemStart(std::string event, void* data);
-    void EventSystemShuttingDown(std::string event, void* data);
+    void SystemEvent(const std::string& event, void* data);
+    void SystemStart(const std::string& event, void* data);
+    void EventSystemShuttingDown(const std::string& event, void* data);
     void StartMDNS();
     void StopMDNS();
 
@@ -425,7 +425,7 @@ void ota_boot(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, con
   }
 
 #ifdef CONFIG_OVMS_COMP_SDCARD
-void OvmsOTA::AutoFlashSD(std::string event, void* data)
+void OvmsOTA::AutoFlashSD(const std::string& event, void* data)
   {
   FILE* f = fopen("/sd/ovms3.bin", "r");
   if (f == NULL) return;
@@ -632,7 +632,7 @@ void OvmsOTA::GetStatus(ota_info& info, bool check_update /*=true*/)
     }
   }
 
-void OvmsOTA::Ticker600(std::string event, void* data)
+void OvmsOTA::Ticker600(const std::string& event, void* data)
   {
   if (MyConfig.GetParamValueBool("auto", "ota", true) == false)
     return;
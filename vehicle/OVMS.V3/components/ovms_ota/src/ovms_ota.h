@@ -58,7 +58,7 @@ class OvmsOTA
   public:
     void LaunchAutoFlash(bool force=false);
     bool AutoFlash(bool force=false);
-    void Ticker600(std::string event, void* data);
+    void Ticker600(const std::string& event, void* data);
 
   public:
     OvmsMutex m_flashing;
@@ -68,7 +68,7 @@ class OvmsOTA
 
 #ifdef CONFIG_OVMS_COMP_SDCARD
   protected:
-    void AutoFlashSD(std::string event, void* data);
+    void AutoFlashSD(const std::string& event, void* data);
 #endif // #ifdef CONFIG_OVMS_COMP_SDCARD
   };
 
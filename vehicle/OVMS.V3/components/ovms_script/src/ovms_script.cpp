@@ -1913,6 +1913,7 @@ void DuktapeVFSSave::Save()
   else
     {
     m_error = "";
+    MyEvents.SignalEvent("system.vfs.file.changed", (void*)m_path.c_str(), m_path.size()+1);
     RequestCallback("done");
     }
   }
@@ -2502,7 +2503,6 @@ void OvmsScripts::AllScripts(std::string path)
   {
   DIR *dir;
   struct dirent *dp;
-  FILE *sf;
   std::set<std::string> files;
 
   // read dir, sort scripts by name:
@@ -2518,10 +2518,15 @@ void OvmsScripts::AllScripts(std::string path)
     closedir(dir);
     }
 
-  // execute scripts:
-  for (auto it = files.begin(); it != files.end(); it++)
+  RunScripts(EventScriptList(files.begin(), files.end()));
+  }
+
+void OvmsScripts::RunScripts(const EventScriptList& scripts)
+  {
+  FILE *sf;
+  for (auto it = scripts.begin(); it != scripts.end(); it++)
     {
-    std::string fpath = *it;
+    const std::string& fpath = *it;
     sf = fopen(fpath.c_str(), "r");
     if (sf)
       {
@@ -2532,10 +2537,99 @@ void OvmsScripts::AllScripts(std::string path)
     }
   }
 
-void OvmsScripts::EventScript(std::string event, void* data)
+/**
+ * Event script index:
+ *  Event scripts are looked up in an in-memory index of the event directories,
+ *  so events without scripts (i.e. most tickers & clock events) need no file I/O.
+ *  An events root is scanned on first use after an invalidation. The index is
+ *  invalidated by "system.vfs.file.changed" and SD card mount state changes.
+ */
+
+static const char* const event_script_roots[] =
   {
-  std::string path;
+#ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
+  "/sd/events",
+#endif // #ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
+  "/store/events",
+  };
+
+void OvmsScripts::LoadEventScripts(const std::string& root, EventScriptDir& index)
+  {
+  DIR *dir, *subdir;
+  struct dirent *dp, *sp;
+
+  index.clear();
+  if ((dir = opendir(root.c_str())) == NULL)
+    return;
+
+  while ((dp = readdir(dir)) != NULL)
+    {
+    std::string path = root;
+    path.append("/");
+    path.append(dp->d_name);
+    if ((subdir = opendir(path.c_str())) == NULL)
+      continue;
+    std::set<std::string> files;
+    while ((sp = readdir(subdir)) != NULL)
+      {
+      std::string fpath = path;
+      fpath.append("/");
+      fpath.append(sp->d_name);
+      files.insert(fpath);
+      }
+    closedir(subdir);
+    if (!files.empty())
+      index[dp->d_name].assign(files.begin(), files.end());
+    }
+  closedir(dir);
 
+  m_evscript_loads++;
+  ESP_LOGD(TAG, "Event script index: %s has %d event directories", root.c_str(), index.size());
+  }
+
+bool OvmsScripts::FindEventScripts(const std::string& event, EventScriptList& scripts)
+  {
+  OvmsMutexLock lock(&m_evscript_mutex);
+  scripts.clear();
+  for (const char* root : event_script_roots)
+    {
+    auto ri = m_evscript_index.find(root);
+    if (ri == m_evscript_index.end())
+      {
+      ri = m_evscript_index.insert(std::make_pair(std::string(root), EventScriptDir())).first;
+      LoadEventScripts(ri->first, ri->second);
+      }
+    auto ei = ri->second.find(event);
+    if (ei != ri->second.end())
+      scripts.insert(scripts.end(), ei->second.begin(), ei->second.end());
+    }
+  return !scripts.empty();
+  }
+
+void OvmsScripts::EventScriptsChanged(const std::string& path)
+  {
+  OvmsMutexLock lock(&m_evscript_mutex);
+  for (auto it = m_evscript_index.begin(); it != m_evscript_index.end(); )
+    {
+    const std::string& root = it->first;
+    // invalidate on changes in, below or above the root:
+    if (path == root || startsWith(path, root + "/") || startsWith(root, path))
+      it = m_evscript_index.erase(it);
+    else
+      ++it;
+    }
+  }
+
+void OvmsScripts::EventListener(const std::string& event, void* data)
+  {
+  if (event == "system.vfs.file.changed")
+    EventScriptsChanged(data ? (const char*)data : "");
+  else if (event == "sd.mounted" || event == "sd.unmounted")
+    EventScriptsChanged("/sd");
+  }
+
+void OvmsScripts::EventScript(const std::string& event, void* data)
+  {
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
   // dispatch event to PubSub component:
   duktape_queue_t dmsg;
@@ -2549,17 +2643,10 @@ void OvmsScripts::EventScript(std::string event, void* data)
     }
 #endif // #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
 
-#ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
-  // run event scripts on external storage:
-  path=std::string("/sd/events/");
-  path.append(event);
-  AllScripts(path);
-#endif // #ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
-
-  // run event scripts on internal storage:
-  path=std::string("/store/events/");
-  path.append(event);
-  AllScripts(path);
+  // run event scripts (external storage first, then internal):
+  EventScriptList scripts;
+  if (FindEventScripts(event, scripts))
+    RunScripts(scripts);
 
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
   if (event == "ticker.60")
@@ -2573,6 +2660,7 @@ void OvmsScripts::EventScript(std::string event, void* data)
 OvmsScripts::OvmsScripts()
   {
   ESP_LOGI(TAG, "Initialising SCRIPTS (1600)");
+  m_evscript_loads = 0;
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
   m_dukctx = NULL;
   m_duktaskid = NULL;
@@ -2639,6 +2727,12 @@ OvmsScripts::OvmsScripts()
   cmd_script->RegisterCommand("compact","Compact javascript heap",script_compact);
 #endif // #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
   MyCommandApp.RegisterCommand(".","Run a script",script_run,"<path>",1,1);
+
+  using std::placeholders::_1;
+  using std::placeholders::_2;
+  MyEvents.RegisterEvent(TAG, "system.vfs.file.changed", std::bind(&OvmsScripts::EventListener, this, _1, _2));
+  MyEvents.RegisterEvent(TAG, "sd.mounted", std::bind(&OvmsScripts::EventListener, this, _1, _2));
+  MyEvents.RegisterEvent(TAG, "sd.unmounted", std::bind(&OvmsScripts::EventListener, this, _1, _2));
   }
 
 OvmsScripts::~OvmsScripts()
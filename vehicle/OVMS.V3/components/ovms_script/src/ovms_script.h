@@ -31,8 +31,11 @@
 #ifndef __SCRIPT_H__
 #define __SCRIPT_H__
 
+#include <map>
+#include <vector>
 #include "ovms_command.h"
 #include "ovms_utils.h"
+#include "ovms_mutex.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -323,9 +326,29 @@ class OvmsScripts
     ~OvmsScripts();
 
   public:
-    void EventScript(std::string event, void* data);
+    void EventScript(const std::string& event, void* data);
     void AllScripts(std::string path);
 
+  public:
+    typedef std::vector<std::string> EventScriptList;       // sorted script paths
+    typedef std::map<std::string, EventScriptList> EventScriptDir; // event name → scripts
+    typedef std::map<std::string, EventScriptDir> EventScriptIndex; // events root → dirs
+
+    bool FindEventScripts(const std::string& event, EventScriptList& scripts);
+    void EventScriptsChanged(const std::string& path);
+
+  protected:
+    void EventListener(const std::string& event, void* data);
+    void LoadEventScripts(const std::string& root, EventScriptDir& dir);
+    void RunScripts(const EventScriptList& scripts);
+
+  protected:
+    OvmsMutex m_evscript_mutex;
+    EventScriptIndex m_evscript_index;              // loaded roots only
+
+  public:
+    uint32_t m_evscript_loads;                      // root directory scans done
+
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
   public:
     void RegisterDuktapeFunction(duk_c_function func, duk_idx_t nargs, const char* name);
@@ -1747,7 +1747,7 @@ bool OvmsServerV2::IncomingNotification(OvmsNotifyType* type, OvmsNotifyEntry* e
 /**
  * EventListener:
  */
-void OvmsServerV2::EventListener(std::string event, void* data)
+void OvmsServerV2::EventListener(const std::string& event, void* data)
   {
   if (event == "system.modem.received.ussd")
     {
@@ -1777,7 +1777,7 @@ void OvmsServerV2::ConfigChanged(OvmsConfigParam* param)
   m_updatetime_idle = MyConfig.GetParamValueInt("server.v2", "updatetime.idle", 600);
   }
 
-void OvmsServerV2::NetUp(std::string event, void* data)
+void OvmsServerV2::NetUp(const std::string& event, void* data)
   {
   // workaround for wifi AP mode startup (manager up before interface)
   if ( (m_mgconn == NULL) && MyNetManager.MongooseRunning() )
@@ -1787,18 +1787,18 @@ void OvmsServerV2::NetUp(std::string event, void* data)
     }
   }
 
-void OvmsServerV2::NetDown(std::string event, void* data)
+void OvmsServerV2::NetDown(const std::string& event, void* data)
   {
   }
 
-void OvmsServerV2::NetReconfigured(std::string event, void* data)
+void OvmsServerV2::NetReconfigured(const std::string& event, void* data)
   {
   ESP_LOGI(TAG, "Network was reconfigured: disconnect, and reconnect in 10 seconds");
   SetStatus("Network was reconfigured: disconnect, and reconnect in 10 seconds", false, ConnectWait);
   Reconnect(10);
   }
 
-void OvmsServerV2::NetmanInit(std::string event, void* data)
+void OvmsServerV2::NetmanInit(const std::string& event, void* data)
   {
   if ((m_mgconn == NULL)&&(MyNetManager.m_connected_any))
     {
@@ -1807,7 +1807,7 @@ void OvmsServerV2::NetmanInit(std::string event, void* data)
     }
   }
 
-void OvmsServerV2::NetmanStop(std::string event, void* data)
+void OvmsServerV2::NetmanStop(const std::string& event, void* data)
   {
   if (m_mgconn)
     {
@@ -1816,7 +1816,7 @@ void OvmsServerV2::NetmanStop(std::string event, void* data)
     }
   }
 
-void OvmsServerV2::Ticker1(std::string event, void* data)
+void OvmsServerV2::Ticker1(const std::string& event, void* data)
   {
   if (m_connretry > 0)
     {
@@ -86,14 +86,14 @@ class OvmsServerV2 : public OvmsServer
     void MetricModified(OvmsMetric* metric);
     bool NotificationFilter(OvmsNotifyType* type, const char* subtype);
     bool IncomingNotification(OvmsNotifyType* type, OvmsNotifyEntry* entry);
-    void EventListener(std::string event, void* data);
+    void EventListener(const std::string& event, void* data);
     void ConfigChanged(OvmsConfigParam* param);
-    void NetUp(std::string event, void* data);
-    void NetDown(std::string event, void* data);
-    void NetReconfigured(std::string event, void* data);
-    void NetmanInit(std::string event, void* data);
-    void NetmanStop(std::string event, void* data);
-    void Ticker1(std::string event, void* data);
+    void NetUp(const std::string& event, void* data);
+    void NetDown(const std::string& event, void* data);
+    void NetReconfigured(const std::string& event, void* data);
+    void NetmanInit(const std::string& event, void* data);
+    void NetmanStop(const std::string& event, void* data);
+    void Ticker1(const std::string& event, void* data);
 
   public:
     enum State
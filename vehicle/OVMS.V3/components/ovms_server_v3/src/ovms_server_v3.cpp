@@ -186,6 +186,7 @@ OvmsServerV3::OvmsServerV3(const char* name)
     MyOvmsServerV3Modifier = MyMetrics.RegisterModifier();
     ESP_LOGI(TAG, "OVMS Server V3 registered metric modifier is #%d",MyOvmsServerV3Modifier);
     }
+  m_journal = MyMetrics.RegisterJournal(MyOvmsServerV3Modifier);
 
   SetStatus("Server has been started", false, WaitNetwork);
   m_connretry = 0;
@@ -251,6 +252,7 @@ OvmsServerV3::OvmsServerV3(const char* name)
 OvmsServerV3::~OvmsServerV3()
   {
   MyMetrics.DeregisterListener(TAG);
+  MyMetrics.DeregisterJournal(MyOvmsServerV3Modifier);
   MyEvents.DeregisterEvent(TAG);
   MyNotify.ClearReader(MyOvmsServerV3Reader);
   Disconnect();
@@ -263,16 +265,15 @@ void OvmsServerV3::TransmitAllMetrics()
   if (!m_mgconn)
     return;
 
-  OvmsMetric* metric = MyMetrics.m_first;
-  while (metric != NULL)
+  MyMetrics.ForEach([this](OvmsMetric* metric) -> bool
     {
     metric->ClearModified(MyOvmsServerV3Modifier);
     if (!metric->AsString().empty())
       {
       TransmitMetric(metric);
       }
-    metric = metric->m_next;
-    }
+    return true;
+    });
   }
 
 void OvmsServerV3::TransmitModifiedMetrics()
@@ -281,15 +282,23 @@ void OvmsServerV3::TransmitModifiedMetrics()
   if (!m_mgconn)
     return;
 
-  OvmsMetric* metric = MyMetrics.m_first;
-  while (metric != NULL)
+  OvmsMetric* metric;
+  if (m_journal)
+    {
+    // only visit the metrics changed since the last pass:
+    while ((metric = m_journal->Next()) != NULL)
+      TransmitMetric(metric);
+    return;
+    }
+
+  MyMetrics.ForEach([this](OvmsMetric* metric) -> bool
     {
     if (metric->IsModifiedAndClear(MyOvmsServerV3Modifier))
       {
       TransmitMetric(metric);
       }
-    metric = metric->m_next;
-    }
+    return true;
+    });
   }
 
 void OvmsServerV3::TransmitMetric(OvmsMetric* metric)
@@ -305,7 +314,7 @@ void OvmsServerV3::TransmitMetric(OvmsMetric* metric)
         topic[i] = '/';
     }
 
-  std::string val = metric->AsString();
+  std::string val = metric->AsCachedString();
 
   mg_mqtt_publish(m_mgconn, topic.c_str(), m_msgid++,
     MG_MQTT_QOS(0) | MG_MQTT_RETAIN, val.c_str(), val.length());
@@ -522,7 +531,7 @@ void OvmsServerV3::IncomingPubRec(int id)
     }
   }
 
-void OvmsServerV3::IncomingEvent(std::string event, void* data)
+void OvmsServerV3::IncomingEvent(const std::string& event, void* data)
   {
   // Publish the event, if we are connected...
   if (m_mgconn == NULL) return;
@@ -802,7 +811,7 @@ bool OvmsServerV3::IncomingNotification(OvmsNotifyType* type, OvmsNotifyEntry* e
     return true; // Mark it read, as no interest to us
   }
 
-void OvmsServerV3::EventListener(std::string event, void* data)
+void OvmsServerV3::EventListener(const std::string& event, void* data)
   {
   if (event == "config.changed" || event == "config.mounted")
     {
@@ -825,7 +834,7 @@ void OvmsServerV3::ConfigChanged(OvmsConfigParam* param)
   m_updatetime_sendall = MyConfig.GetParamValueInt("server.v3", "updatetime.sendall", 0);
   }
 
-void OvmsServerV3::NetUp(std::string event, void* data)
+void OvmsServerV3::NetUp(const std::string& event, void* data)
   {
   // workaround for wifi AP mode startup (manager up before interface)
   if ( (m_mgconn == NULL) && MyNetManager.MongooseRunning() )
@@ -835,7 +844,7 @@ void OvmsServerV3::NetUp(std::string event, void* data)
     }
   }
 
-void OvmsServerV3::NetDown(std::string event, void* data)
+void OvmsServerV3::NetDown(const std::string& event, void* data)
   {
   if (m_mgconn)
     {
@@ -844,14 +853,14 @@ void OvmsServerV3::NetDown(std::string event, void* data)
     }
   }
 
-void OvmsServerV3::NetReconfigured(std::string event, void* data)
+void OvmsServerV3::NetReconfigured(const std::string& event, void* data)
   {
   ESP_LOGI(TAG, "Network was reconfigured: disconnect, and reconnect in 10 seconds");
   Disconnect();
   m_connretry = 10;
   }
 
-void OvmsServerV3::NetmanInit(std::string event, void* data)
+void OvmsServerV3::NetmanInit(const std::string& event, void* data)
   {
   if ((m_mgconn == NULL)&&(MyNetManager.m_connected_any))
     {
@@ -860,7 +869,7 @@ void OvmsServerV3::NetmanInit(std::string event, void* data)
     }
   }
 
-void OvmsServerV3::NetmanStop(std::string event, void* data)
+void OvmsServerV3::NetmanStop(const std::string& event, void* data)
   {
   if (m_mgconn)
     {
@@ -869,7 +878,7 @@ void OvmsServerV3::NetmanStop(std::string event, void* data)
     }
   }
 
-void OvmsServerV3::Ticker1(std::string event, void* data)
+void OvmsServerV3::Ticker1(const std::string& event, void* data)
   {
   if (m_connretry > 0)
     {
@@ -938,7 +947,7 @@ void OvmsServerV3::Ticker1(std::string event, void* data)
     }
   }
 
-void OvmsServerV3::Ticker60(std::string event, void* data)
+void OvmsServerV3::Ticker60(const std::string& event, void* data)
   {
   CountClients();
   }
@@ -1049,7 +1058,7 @@ void OvmsServerV3Init::AutoInit()
     MyOvmsServerV3 = new OvmsServerV3("oscv3");
   }
 
-void OvmsServerV3Init::EventListener(std::string event, void* data)
+void OvmsServerV3Init::EventListener(const std::string& event, void* data)
   {
   if (event.compare(0,7,"ticker.") == 0) return; // Skip ticker.* events
   if (event.compare("system.event") == 0) return; // Skip event
@@ -54,15 +54,15 @@ class OvmsServerV3 : public OvmsServer
     void MetricModified(OvmsMetric* metric);
     bool NotificationFilter(OvmsNotifyType* type, const char* subtype);
     bool IncomingNotification(OvmsNotifyType* type, OvmsNotifyEntry* entry);
-    void EventListener(std::string event, void* data);
+    void EventListener(const std::string& event, void* data);
     void ConfigChanged(OvmsConfigParam* param);
-    void NetUp(std::string event, void* data);
-    void NetDown(std::string event, void* data);
-    void NetReconfigured(std::string event, void* data);
-    void NetmanInit(std::string event, void* data);
-    void NetmanStop(std::string event, void* data);
-    void Ticker1(std::string event, void* data);
-    void Ticker60(std::string event, void* data);
+    void NetUp(const std::string& event, void* data);
+    void NetDown(const std::string& event, void* data);
+    void NetReconfigured(const std::string& event, void* data);
+    void NetmanInit(const std::string& event, void* data);
+    void NetmanStop(const std::string& event, void* data);
+    void Ticker1(const std::string& event, void* data);
+    void Ticker60(const std::string& event, void* data);
 
   public:
     enum State
@@ -92,6 +92,7 @@ class OvmsServerV3 : public OvmsServer
     std::string m_conn_topic[MQTT_CONN_NTOPICS];
     struct mg_connection *m_mgconn;
     OvmsMutex m_mgconn_mutex;
+    OvmsMetricJournal* m_journal;
     int m_connretry;
     bool m_sendall;
     int m_msgid;
@@ -132,7 +133,7 @@ class OvmsServerV3 : public OvmsServer
     void TransmitPendingNotificationsData();
     void IncomingMsg(std::string topic, std::string payload);
     void IncomingPubRec(int id);
-    void IncomingEvent(std::string event, void* data);
+    void IncomingEvent(const std::string& event, void* data);
     void RunCommand(std::string client, std::string id, std::string command);
     void AddClient(std::string id);
     void RemoveClient(std::string id);
@@ -149,7 +150,7 @@ class OvmsServerV3Init
     void AutoInit();
 
   public:
-    void EventListener(std::string event, void* data);
+    void EventListener(const std::string& event, void* data);
   };
 
 extern OvmsServerV3Init MyOvmsServerV3Init;
@@ -126,7 +126,7 @@ OvmsTLS::~OvmsTLS()
   Clear();
   }
 
-void OvmsTLS::UpdatedConfig(std::string event, void* data)
+void OvmsTLS::UpdatedConfig(const std::string& event, void* data)
   {
   Reload();
   }
@@ -66,7 +66,7 @@ class OvmsTLS
   protected:
     void BuildTrustedRaw();
     void ClearTrustedRaw();
-    void UpdatedConfig(std::string event, void* data);
+    void UpdatedConfig(const std::string& event, void* data);
 
   public:
     TrustedCert_t m_trustlist;
@@ -98,6 +98,7 @@ OvmsWebServer::OvmsWebServer()
   // register standard API calls:
   RegisterPage("/api/execute", "Execute command", HandleCommand, PageMenu_None, PageAuth_Cookie);
   RegisterPage("/api/file", "Load/Save file", HandleFile, PageMenu_None, PageAuth_Cookie);
+  RegisterPage("/api/bms/history", "BMS cell history", HandleBmsCellHistory, PageMenu_None, PageAuth_Cookie);
 
   // register standard public pages:
   RegisterPage("/dashboard", "Dashboard", HandleDashboard, PageMenu_Main, PageAuth_None);
@@ -142,7 +143,7 @@ OvmsWebServer::~OvmsWebServer()
 }
 
 
-void OvmsWebServer::NetManInit(std::string event, void* data)
+void OvmsWebServer::NetManInit(const std::string& event, void* data)
 {
   m_running = true;
   ESP_LOGI(TAG,"Launching Web Server");
@@ -183,7 +184,7 @@ void OvmsWebServer::NetManInit(std::string event, void* data)
   }
 }
 
-void OvmsWebServer::NetManStop(std::string event, void* data)
+void OvmsWebServer::NetManStop(const std::string& event, void* data)
 {
   if (m_running) {
     ESP_LOGI(TAG,"Stopping Web Server");
@@ -195,7 +196,7 @@ void OvmsWebServer::NetManStop(std::string event, void* data)
 /**
  * ConfigChanged: read & apply configuration updates
  */
-void OvmsWebServer::ConfigChanged(std::string event, void* data)
+void OvmsWebServer::ConfigChanged(const std::string& event, void* data)
 {
   m_configured = true;
   OvmsConfigParam* param = (OvmsConfigParam*) data;
@@ -412,6 +412,7 @@ class WebSocketHandler : public MgHandler, public OvmsWriter
   public:
     size_t                    m_slot = 0;
     size_t                    m_modifier = 0;         // "our" metrics modifier
+    OvmsMetricJournal*        m_journal = NULL;       // "our" metrics change journal
     size_t                    m_reader = 0;           // "our" notification reader id
     QueueHandle_t             m_jobqueue = NULL;
     uint32_t                  m_jobqueue_overflow_status = 0;
@@ -421,6 +422,9 @@ class WebSocketHandler : public MgHandler, public OvmsWriter
     WebSocketTxJob            m_job = {};
     int                       m_sent = 0;
     int                       m_ack = 0;
+    size_t                    m_cursor = 0;           // metrics job: registry index of the next metric to send
+    uint32_t                  m_cursor_gen = 0;       // metrics job: registry generation of m_cursor
+    int64_t                   m_job_started = 0;      // metrics job: start time [us]
     std::set<std::string>     m_subscriptions;
 };
 
@@ -483,13 +487,13 @@ class OvmsWebServer : public ExternalRamAllocated
 
   public:
     static void EventHandler(mg_connection *nc, int ev, void *p);
-    void NetManInit(std::string event, void* data);
-    void NetManStop(std::string event, void* data);
-    void ConfigChanged(std::string event, void* data);
+    void NetManInit(const std::string& event, void* data);
+    void NetManStop(const std::string& event, void* data);
+    void ConfigChanged(const std::string& event, void* data);
     void UpdateGlobalAuthFile();
     static const std::string MakeDigestAuth(const char* realm, const char* username, const char* password);
     static const std::string ExecuteCommand(const std::string command, int verbosity=COMMAND_RESULT_NORMAL);
-    void EventListener(std::string event, void* data);
+    void EventListener(const std::string& event, void* data);
     static void UpdateTicker(TimerHandle_t timer);
     static bool NotificationFilter(int client, OvmsNotifyType* type, const char* subtype);
     static bool IncomingNotification(int client, OvmsNotifyType* type, OvmsNotifyEntry* entry);
@@ -538,6 +542,7 @@ class OvmsWebServer : public ExternalRamAllocated
     static void HandleShell(PageEntry_t& p, PageContext_t& c);
     static void HandleDashboard(PageEntry_t& p, PageContext_t& c);
     static void HandleBmsCellMonitor(PageEntry_t& p, PageContext_t& c);
+    static void HandleBmsCellHistory(PageEntry_t& p, PageContext_t& c);
     static void HandleCfgBrakelight(PageEntry_t& p, PageContext_t& c);
     static void HandleEditor(PageEntry_t& p, PageContext_t& c);
     static void HandleCfgPassword(PageEntry_t& p, PageContext_t& c);
@@ -35,6 +35,7 @@ static const char *TAG = "websocket";
 
 #include <string.h>
 #include <stdio.h>
+#include "esp_timer.h"
 #include "ovms_webserver.h"
 #include "ovms_config.h"
 #include "ovms_metrics.h"
@@ -64,6 +65,7 @@ WebSocketHandler::WebSocketHandler(mg_connection* nc, size_t slot, size_t modifi
   
   m_slot = slot;
   m_modifier = modifier;
+  m_journal = MyMetrics.RegisterJournal(modifier);
   m_reader = reader;
   m_jobqueue = xQueueCreate(50, sizeof(WebSocketTxJob));
   m_jobqueue_overflow_status = 0;
@@ -81,6 +83,7 @@ WebSocketHandler::WebSocketHandler(mg_connection* nc, size_t slot, size_t modifi
 WebSocketHandler::~WebSocketHandler()
 {
   MyCommandApp.DeregisterConsole(this);
+  MyMetrics.DeregisterJournal(m_modifier);
   if (m_jobqueue) {
     while (xQueueReceive(m_jobqueue, &m_job, 0) == pdTRUE)
       ClearTxJob(m_job);
@@ -113,33 +116,81 @@ void WebSocketHandler::ProcessTxJob()
       break;
     }
     
-    case WSTX_MetricsAll:
     case WSTX_MetricsUpdate:
+    if (m_journal)
     {
-      // Note: this loops over the metrics by index, keeping the checked count
-      //  in m_sent. It will not detect new metrics added between polls if they are
-      //  inserted before m_sent, so new metrics may not be sent until first changed.
+      // build msg from the metrics changed since the last update:
+      OvmsMetric* m = NULL;
+      int i;
+      std::string msg;
+      msg.reserve(2*XFER_CHUNK_SIZE+128);
+      msg = "{\"metrics\":{";
+      for (i=0; msg.size() < XFER_CHUNK_SIZE && (m = m_journal->Next()) != NULL; i++) {
+        if (i) msg += ',';
+        msg += '\"';
+        msg += m->m_name;
+        msg += "\":";
+        m->AppendCachedJSON(msg);
+      }
+      
+      // send msg:
+      if (i) {
+        msg += "}}";
+        ESP_EARLY_LOGV(TAG, "WebSocket msg: %s", msg.c_str());
+        mg_send_websocket_frame(m_nc, WEBSOCKET_OP_TEXT, msg.data(), msg.size());
+        m_sent += i;
+      }
+      
+      // done?
+      if (!m && m_ack == m_sent) {
+        if (m_sent)
+          ESP_EARLY_LOGV(TAG, "WebSocketHandler[%p]: ProcessTxJob type=%d done, sent=%d metrics", m_nc, m_job.type, m_sent);
+        ClearTxJob(m_job);
+      }
+      
+      break;
+    }
+    // else fall through: no journal available, do a full scan
+    
+    case WSTX_MetricsAll:
+    {
+      // Note: this keeps the registry index of the next metric to send, so each
+      //  chunk continues in O(1). If the metrics registry has changed since the
+      //  last chunk, the index may have moved and we fall back to the number of
+      //  metrics sent (m_sent). New metrics inserted before that position
+      //  may then not be sent until first changed.
       //  The Metrics set normally is static, so this should be no problem.
       
       // find start:
-      int i;
-      OvmsMetric* m;
-      for (i=0, m=MyMetrics.m_first; i < m_sent && m != NULL; m=m->m_next, i++);
+      int i = 0;
+      size_t start;
+      if (m_sent == 0 || m_cursor_gen != MyMetrics.Generation()) {
+        if (m_sent == 0)
+          m_job_started = esp_timer_get_time();
+        start = m_sent;
+        m_cursor_gen = MyMetrics.Generation();
+      } else {
+        start = m_cursor;
+      }
       
       // build msg:
       std::string msg;
       msg.reserve(2*XFER_CHUNK_SIZE+128);
       msg = "{\"metrics\":{";
-      for (i=0; m && msg.size() < XFER_CHUNK_SIZE; m=m->m_next) {
+      m_cursor = MyMetrics.ForEach([this, &msg, &i](OvmsMetric* m) -> bool {
+        if (msg.size() >= XFER_CHUNK_SIZE)
+          return false;
         if (m->IsModifiedAndClear(m_modifier) || m_job.type == WSTX_MetricsAll) {
           if (i) msg += ',';
           msg += '\"';
           msg += m->m_name;
           msg += "\":";
-          msg += m->AsJSON();
+          m->AppendCachedJSON(msg);
           i++;
         }
-      }
+        return true;
+      }, start);
+      bool done = (m_cursor >= MyMetrics.Count());
       
       // send msg:
       if (i) {
@@ -148,11 +199,13 @@ void WebSocketHandler::ProcessTxJob()
         mg_send_websocket_frame(m_nc, WEBSOCKET_OP_TEXT, msg.data(), msg.size());
         m_sent += i;
       }
-      
       // done?
-      if (!m && m_ack == m_sent) {
+      if (done && m_ack == m_sent) {
         if (m_sent)
           ESP_EARLY_LOGV(TAG, "WebSocketHandler[%p]: ProcessTxJob type=%d done, sent=%d metrics", m_nc, m_job.type, m_sent);
+        if (m_job.type == WSTX_MetricsAll)
+          ESP_LOGD(TAG, "WebSocketHandler[%p]: all %d metrics sent in %d ms, %d clients active", m_nc, m_sent,
+            (int)((esp_timer_get_time() - m_job_started) / 1000), MyWebServer.m_client_cnt);
         ClearTxJob(m_job);
       }
       
@@ -301,6 +354,7 @@ bool WebSocketHandler::GetNextTxJob()
   if (xQueueReceive(m_jobqueue, &m_job, 0) == pdTRUE) {
     // init new job state:
     m_sent = m_ack = 0;
+    m_cursor = 0;
     return true;
   } else {
     return false;
@@ -519,7 +573,7 @@ bool OvmsWebServer::AddToBacklog(int client, WebSocketTxJob job)
 /**
  * EventListener:
  */
-void OvmsWebServer::EventListener(std::string event, void* data)
+void OvmsWebServer::EventListener(const std::string& event, void* data)
 {
   // shutdown delay to finish command output transmissions:
   if (event == "system.shuttingdown") {
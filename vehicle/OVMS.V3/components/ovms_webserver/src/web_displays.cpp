@@ -42,6 +42,7 @@
 #include "vehicle.h"
 #include "ovms_housekeeping.h"
 #include "ovms_peripherals.h"
+#include "string_writer.h"
 
 #define _attr(text) (c.encode_html(text).c_str())
 #define _html(text) (c.encode_html(text).c_str())
@@ -1174,6 +1175,58 @@ void OvmsWebServer::HandleBmsCellMonitor(PageEntry_t& p, PageContext_t& c)
   c.done();
 }
 
+/**
+ * HandleBmsCellHistory: cell voltage history API (JSON)
+ *
+ * Parameters:
+ *  tier      ram (default) / minute / hour
+ *  cells     cell selection, e.g. "1,5,9-12" (default: all)
+ *  from, to  UTC timestamp, "now" or relative time "-<n>[smhd]" (default: -1h, now)
+ *  max       row limit (default: 1000)
+ *
+ * Result: {"tier", "from", "to", "cells": [numbers], "fields": [names],
+ *   "rows": [[time, cell1.field1, cell1.field2, …, cell2.field1, …], …], "truncated"}
+ */
+void OvmsWebServer::HandleBmsCellHistory(PageEntry_t& p, PageContext_t& c)
+{
+  OvmsVehicle* vehicle = MyVehicleFactory.ActiveVehicle();
+  bms_hist_tier_t tier = BmsHist_RAM;
+  std::vector<int> cells;
+  time_t now = time(NULL), from, to;
+  std::string arg;
+  int maxrows;
+
+  arg = c.getvar("tier");
+  if (!arg.empty() && !OvmsBmsCellHistory::ParseTier(arg.c_str(), &tier)) {
+    c.error(400, "Invalid tier");
+    return;
+  }
+  if (!OvmsBmsCellHistory::ParseCells(c.getvar("cells", 1000).c_str(), cells)) {
+    c.error(400, "Invalid cell selection");
+    return;
+  }
+  arg = c.getvar("from");
+  if (!OvmsBmsCellHistory::ParseTime(arg.empty() ? "-1h" : arg.c_str(), now, &from) ||
+      !OvmsBmsCellHistory::ParseTime(c.getvar("to").c_str(), now, &to)) {
+    c.error(400, "Invalid time range");
+    return;
+  }
+  arg = c.getvar("max");
+  maxrows = arg.empty() ? 1000 : atoi(arg.c_str());
+  if (!vehicle) {
+    c.error(404, "No vehicle module selected");
+    return;
+  }
+
+  ExtRamStringWriter buf(4096);
+  vehicle->BmsGetCellHistory()->Query(&buf, tier, from, to, cells, LIMIT_MIN(maxrows, 1), true);
+  c.head(200,
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Cache-Control: no-cache");
+  c.print(buf);
+  c.done();
+}
+
 /**
  * HandleCfgBrakelight: configure vehicle brake light control
  * 
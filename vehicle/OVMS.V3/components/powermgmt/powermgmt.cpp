@@ -69,7 +69,7 @@ powermgmt::~powermgmt()
 #endif  
  }
 
-void powermgmt::ConfigChanged(std::string event, void* data)
+void powermgmt::ConfigChanged(const std::string& event, void* data)
   {
   OvmsConfigParam* param = (OvmsConfigParam*) data;
 
@@ -83,7 +83,7 @@ void powermgmt::ConfigChanged(std::string event, void* data)
     }
   }
 
-void powermgmt::Ticker1(std::string event, void* data)
+void powermgmt::Ticker1(const std::string& event, void* data)
   {
   if (!m_charging)
     m_notcharging_timer++;
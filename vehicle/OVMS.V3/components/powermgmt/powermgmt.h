@@ -51,8 +51,8 @@ class powermgmt
     virtual ~powermgmt();
 
   public:
-    void Ticker1(std::string event, void* data);
-    void ConfigChanged(std::string event, void* data);
+    void Ticker1(const std::string& event, void* data);
+    void ConfigChanged(const std::string& event, void* data);
 
   private:
     bool m_enabled;
@@ -191,7 +191,7 @@ bool Pushover::IncomingNotification(OvmsNotifyType* type, OvmsNotifyEntry* entry
   }
 
 
-void Pushover::EventListener(std::string event, void* data)
+void Pushover::EventListener(const std::string& event, void* data)
   {
   std::string name, setting, pri, msg, sound;
   if ( (event == "ticker.1") || (event == "ticker.10") )
@@ -56,7 +56,7 @@ class Pushover : public InternalRamAllocated
     bool sendReplyNotification;
 
   protected:
-    void EventListener(std::string event, void* data);
+    void EventListener(const std::string& event, void* data);
 
   private:
     size_t reader;
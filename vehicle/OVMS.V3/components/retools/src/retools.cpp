@@ -32,6 +32,8 @@
 static const char *TAG = "re";
 
 #include <string.h>
+#include <math.h>
+#include <algorithm>
 #include "retools.h"
 #include "dbc_app.h"
 #include "ovms.h"
@@ -39,6 +41,7 @@ static const char *TAG = "re";
 #include "ovms_events.h"
 #include "ovms_utils.h"
 #include "ovms_notify.h"
+#include "metrics_standard.h"
 
 re *MyRE = NULL;
 
@@ -128,23 +131,384 @@ void re::Task()
     }
   }
 
+////////////////////////////////////////////////////////////////////////
+// re_record_table
+
+re_record_table::re_record_table()
+  {
+  m_records = NULL;
+  m_capacity = 0;
+  m_count = 0;
+  }
+
+re_record_table::~re_record_table()
+  {
+  Clear();
+  }
+
+size_t re_record_table::Slot(uint64_t key)
+  {
+  // Fibonacci hashing, m_capacity is a power of 2:
+  return (size_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & (m_capacity-1);
+  }
+
+re_record_t* re_record_table::Find(uint64_t key)
+  {
+  if (m_count == 0)
+    return NULL;
+  for (size_t slot = Slot(key); ; slot = (slot+1) & (m_capacity-1))
+    {
+    re_record_t* r = &m_records[slot];
+    if (r->key == key)
+      return r;
+    if (r->key == RE_KEY_EMPTY)
+      return NULL;
+    }
+  }
+
+/**
+ * Insert: add a new (zeroed) record for key, which must not exist yet
+ *  Returns NULL if out of memory. Pointers to records get invalid
+ *  on inserts, as the table may need to grow.
+ */
+re_record_t* re_record_table::Insert(uint64_t key)
+  {
+  if ((m_count+1)*4 > m_capacity*3 && !Grow())
+    return NULL;
+  size_t slot = Slot(key);
+  while (m_records[slot].key != RE_KEY_EMPTY)
+    slot = (slot+1) & (m_capacity-1);
+  re_record_t* r = &m_records[slot];
+  memset(r, 0, sizeof(re_record_t));
+  r->key = key;
+  m_count++;
+  return r;
+  }
+
+bool re_record_table::Grow()
+  {
+  size_t capacity = m_capacity ? m_capacity*2 : 256;
+  re_record_t* records = (re_record_t*)ExternalRamMalloc(capacity * sizeof(re_record_t));
+  if (records == NULL)
+    {
+    ESP_LOGE(TAG, "Out of memory for %d records", capacity);
+    return false;
+    }
+  for (size_t k = 0; k < capacity; k++)
+    records[k].key = RE_KEY_EMPTY;
+
+  re_record_t* old = m_records;
+  size_t oldcapacity = m_capacity;
+  m_records = records;
+  m_capacity = capacity;
+  for (size_t k = 0; k < oldcapacity; k++)
+    {
+    if (old[k].key == RE_KEY_EMPTY) continue;
+    size_t slot = Slot(old[k].key);
+    while (m_records[slot].key != RE_KEY_EMPTY)
+      slot = (slot+1) & (m_capacity-1);
+    memcpy(&m_records[slot], &old[k], sizeof(re_record_t));
+    }
+  if (old) free(old);
+  return true;
+  }
+
+void re_record_table::Clear()
+  {
+  for (size_t k = 0; k < m_capacity; k++)
+    {
+    if (m_records[k].key != RE_KEY_EMPTY && m_records[k].stats)
+      free(m_records[k].stats);
+    }
+  if (m_records) free(m_records);
+  m_records = NULL;
+  m_capacity = 0;
+  m_count = 0;
+  }
+
+size_t re_record_table::size()
+  {
+  return m_count;
+  }
+
+size_t re_record_table::capacity()
+  {
+  return m_capacity;
+  }
+
+re_record_t* re_record_table::at(size_t slot)
+  {
+  if (slot >= m_capacity || m_records[slot].key == RE_KEY_EMPTY)
+    return NULL;
+  return &m_records[slot];
+  }
+
+////////////////////////////////////////////////////////////////////////
+// re
+
+////////////////////////////////////////////////////////////////////////
+// Signal discovery statistics
+//
+// For every ID, the RE task counts bit flips and tracks min/max and
+// increments/decrements of the candidate fields below. Once per second
+// per ID, the fields are sampled together with the selected metrics to
+// compute correlation coefficients and linear fits. Memory per ID is
+// fixed (sizeof(re_stats_t), about 2 kB).
+
+typedef struct
+  {
+  uint8_t offset;                   // byte offset
+  uint8_t size;                     // bits
+  bool bigendian;
+  } re_field_t;
+
+static const re_field_t re_fields[RE_STATS_FIELDS] =
+  {
+  { 0, 8, false }, { 1, 8, false }, { 2, 8, false }, { 3, 8, false },
+  { 4, 8, false }, { 5, 8, false }, { 6, 8, false }, { 7, 8, false },
+  { 0, 12, false }, { 1, 12, false }, { 2, 12, false }, { 3, 12, false },
+  { 4, 12, false }, { 5, 12, false }, { 6, 12, false },
+  { 0, 12, true }, { 1, 12, true }, { 2, 12, true }, { 3, 12, true },
+  { 4, 12, true }, { 5, 12, true }, { 6, 12, true },
+  { 0, 16, false }, { 1, 16, false }, { 2, 16, false }, { 3, 16, false },
+  { 4, 16, false }, { 5, 16, false }, { 6, 16, false },
+  { 0, 16, true }, { 1, 16, true }, { 2, 16, true }, { 3, 16, true },
+  { 4, 16, true }, { 5, 16, true }, { 6, 16, true },
+  };
+
+static inline uint16_t re_field_value(const re_field_t* f, const uint8_t* data)
+  {
+  if (f->size == 8)
+    return data[f->offset];
+  uint16_t v = f->bigendian
+    ? ((uint16_t)data[f->offset] << 8) | data[f->offset+1]
+    : ((uint16_t)data[f->offset+1] << 8) | data[f->offset];
+  return (f->size == 12) ? (v & 0xfff) : v;
+  }
+
+static inline uint8_t re_field_bytes(const re_field_t* f)
+  {
+  return ((f->size == 8) ? 1 : 3) << f->offset;
+  }
+
+/**
+ * re_field_name: e.g. "16BE@2" = 16 bit big endian field at byte 2
+ */
+static std::string re_field_name(int field)
+  {
+  const re_field_t* f = &re_fields[field];
+  char buf[16];
+  if (f->size == 8)
+    sprintf(buf, "8@%d", f->offset);
+  else
+    sprintf(buf, "%d%s@%d", f->size, f->bigendian ? "BE" : "LE", f->offset);
+  return std::string(buf);
+  }
+
+/**
+ * re_field_startbit: DBC start bit of a field (MSB for big endian)
+ */
+static int re_field_startbit(int field)
+  {
+  const re_field_t* f = &re_fields[field];
+  if (!f->bigendian)
+    return f->offset * 8;
+  return f->offset * 8 + ((f->size == 16) ? 7 : 3);
+  }
+
+void re::DoStats(re_record_t* r, CAN_frame_t* frame, bool first)
+  {
+  re_stats_t* st = r->stats;
+  if (st == NULL)
+    {
+    st = (re_stats_t*)ExternalRamCalloc(1, sizeof(re_stats_t));
+    if (st == NULL) return;
+    for (int k = 0; k < RE_STATS_FIELDS; k++)
+      st->field[k].min = 0xffff;
+    r->stats = st;
+    }
+
+  const uint8_t* data = frame->data.u8;
+  int dlc = LIMIT_MAX(frame->FIR.B.DLC, 8);
+
+  // Count bit flips:
+  if (!first)
+    {
+    int prevdlc = LIMIT_MAX(r->last.FIR.B.DLC, 8);
+    for (int i = 0; i < dlc && i < prevdlc; i++)
+      {
+      uint8_t flipped = data[i] ^ r->last.data.u8[i];
+      while (flipped)
+        {
+        int bit = i*8 + __builtin_ctz(flipped);
+        if (st->flips[bit] < 0xffff) st->flips[bit]++;
+        flipped &= flipped - 1;
+        }
+      }
+    }
+
+  // Sample the metrics once per second, if all are defined:
+  double y[RE_STATS_METRICS];
+  bool sample = (m_stats_metriccount > 0 && st->sampled != monotonictime);
+  for (int m = 0; sample && m < m_stats_metriccount; m++)
+    {
+    if (!m_stats_metrics[m]->IsDefined())
+      sample = false;
+    else
+      y[m] = m_stats_metrics[m]->AsFloat();
+    }
+  if (sample)
+    {
+    st->sampled = monotonictime;
+    st->samples++;
+    for (int m = 0; m < m_stats_metriccount; m++)
+      {
+      st->sy[m] += y[m];
+      st->syy[m] += y[m] * y[m];
+      }
+    }
+
+  // Update the candidate fields:
+  for (int k = 0; k < RE_STATS_FIELDS; k++)
+    {
+    const re_field_t* f = &re_fields[k];
+    if (f->offset + ((f->size == 8) ? 1 : 2) > dlc)
+      continue;
+    uint16_t v = re_field_value(f, data);
+    re_field_stats_t* fs = &st->field[k];
+    if (fs->min <= fs->max)
+      {
+      if (v > fs->last && fs->up < 0xffff) fs->up++;
+      else if (v < fs->last && fs->down < 0xffff) fs->down++;
+      }
+    if (v < fs->min) fs->min = v;
+    if (v > fs->max) fs->max = v;
+    fs->last = v;
+    if (sample)
+      {
+      fs->sx += v;
+      fs->sxx += (double)v * v;
+      for (int m = 0; m < m_stats_metriccount; m++)
+        fs->sxy[m] += v * y[m];
+      }
+    }
+  }
+
+/**
+ * GetCandidates: find the best signal candidates of a record
+ *  Candidates need to be correlated to a metric or monotonic (counters),
+ *  overlapping candidates with lower scores are dropped.
+ *  Returns the number of candidates stored in list (up to max).
+ */
+int re::GetCandidates(re_record_t* r, re_candidate_t* list, int max)
+  {
+  re_stats_t* st = r->stats;
+  if (st == NULL) return 0;
+
+  re_candidate_t found[RE_STATS_FIELDS];
+  int count = 0;
+  for (int k = 0; k < RE_STATS_FIELDS; k++)
+    {
+    re_field_stats_t* fs = &st->field[k];
+    int changes = fs->up + fs->down;
+    if (fs->min >= fs->max || changes < RE_STATS_MINCHANGES)
+      continue;
+
+    re_candidate_t c;
+    c.field = k;
+    c.mono = (float)(fs->up - fs->down) / changes;
+    c.corr = 0;
+    c.metric = -1;
+    c.factor = 1;
+    c.offset = 0;
+    if (st->samples >= RE_STATS_MINSAMPLES)
+      {
+      double n = st->samples;
+      double mx = fs->sx / n;
+      double vx = fs->sxx / n - mx*mx;
+      for (int m = 0; m < m_stats_metriccount && vx > 0; m++)
+        {
+        double my = st->sy[m] / n;
+        double vy = st->syy[m] / n - my*my;
+        if (vy <= 0) continue;
+        double cov = fs->sxy[m] / n - mx*my;
+        double corr = cov / sqrt(vx*vy);
+        if (fabs(corr) > fabs(c.corr))
+          {
+          c.corr = corr;
+          c.metric = m;
+          c.factor = cov / vx;
+          c.offset = my - c.factor * mx;
+          }
+        }
+      }
+    if (fabs(c.corr) < RE_STATS_MINCORR && fabs(c.mono) < RE_STATS_MINMONO)
+      continue;
+    c.score = std::max((double)fabs(c.corr), fabs(c.mono) * RE_STATS_MINCORR);
+    found[count++] = c;
+    }
+
+  std::sort(found, found+count,
+    [](const re_candidate_t& a, const re_candidate_t& b) { return a.score > b.score; });
+  int stored = 0;
+  uint8_t used = 0;
+  for (int k = 0; k < count && stored < max; k++)
+    {
+    uint8_t bytes = re_field_bytes(&re_fields[found[k].field]);
+    if (bytes & used) continue;
+    used |= bytes;
+    list[stored++] = found[k];
+    }
+  return stored;
+  }
+
+/**
+ * StartStats: start collecting statistics, correlating with the given metrics
+ *  Returns false if a metric is unknown.
+ */
+bool re::StartStats(int count, const char* const* metrics)
+  {
+  OvmsMutexLock lock(&m_mutex);
+  OvmsMetric* found[RE_STATS_METRICS];
+  count = LIMIT_MAX(count, RE_STATS_METRICS);
+  for (int m = 0; m < count; m++)
+    {
+    found[m] = MyMetrics.Find(metrics[m]);
+    if (found[m] == NULL) return false;
+    }
+
+  // Changing the metrics invalidates the correlation sums:
+  for (size_t k = 0; k < m_rmap.capacity(); k++)
+    {
+    re_record_t* r = m_rmap.at(k);
+    if (r && r->stats)
+      {
+      free(r->stats);
+      r->stats = NULL;
+      }
+    }
+  for (int m = 0; m < count; m++)
+    m_stats_metrics[m] = found[m];
+  m_stats_metriccount = count;
+  m_stats = true;
+  return true;
+  }
+
 void re::DoAnalyse(CAN_frame_t* frame)
   {
   char vbuf[256];
 
   OvmsMutexLock lock(&m_mutex);
-  std::string key = GetKey(frame);
-  auto k = m_rmap.find(key);
-  re_record_t* r;
+  uint64_t key = GetKey(frame);
+  re_record_t* r = m_rmap.Find(key);
   if (m_rmap.size() == 0) m_started = monotonictime;
-  if (k == m_rmap.end())
+  if (r == NULL)
     {
-    r = k->second;
-    r = new re_record_t;
-    memset(r,0,sizeof(re_record_t));
+    r = m_rmap.Insert(key);
+    if (r == NULL) return;
     r->attr.b.Changed = 1; // Mark the whole ID as changed
     r->attr.dc = 0xff;
-    switch (MyRE->m_mode)
+    switch (m_mode)
       {
       case Analyse:
         break;
@@ -153,15 +517,13 @@ void re::DoAnalyse(CAN_frame_t* frame)
         r->attr.dd = 0xff;
         HighlightDump(vbuf, (const char*)frame->data.u8, frame->FIR.B.DLC, r->attr.dc, r->attr.dd);
         ESP_LOGV(TAG, "Discovered new %s%s%s %s",
-          re_green[0][0], key.c_str(), re_green[0][1], vbuf);
+          re_green[0][0], GetKeyName(key).c_str(), re_green[0][1], vbuf);
         break;
       }
-    m_rmap[key] = r;
     }
   else
     {
-    r = k->second;
-    switch (MyRE->m_mode)
+    switch (m_mode)
       {
       case Analyse:
         for (int k=0;k<r->last.FIR.B.DLC;k++)
@@ -187,31 +549,25 @@ void re::DoAnalyse(CAN_frame_t* frame)
         if (found)
           {
           HighlightDump(vbuf, (const char*)frame->data.u8, frame->FIR.B.DLC, r->attr.dc, r->attr.dd);
-          ESP_LOGV(TAG, "Discovered change %s %s", k->first.c_str(), vbuf);
+          ESP_LOGV(TAG, "Discovered change %s %s", GetKeyName(key).c_str(), vbuf);
           }
         break;
         }
       }
     }
+  if (m_stats) DoStats(r, frame, (r->rxcount == 0));
   memcpy(&r->last,frame,sizeof(CAN_frame_t));
   r->rxcount++;
+  m_analysed++;
   }
 
-std::string re::GetKey(CAN_frame_t* frame)
+uint64_t re::GetKey(CAN_frame_t* frame)
   {
-  std::string key;
+  uint64_t key = (uint64_t)(frame->MsgID & 0x1fffffff) << RE_KEY_ID_SHIFT;
   if (frame->origin != NULL)
-    key = std::string(frame->origin->GetName());
-  else
-    key = std::string("can?");
-  key.append("/");
-
-  char id[9];
-  if (frame->FIR.B.FF == CAN_frame_std)
-    sprintf(id,"%03x",frame->MsgID);
-  else
-    sprintf(id,"%08x",frame->MsgID);
-  key.append(id);
+    key |= (uint64_t)(frame->origin->m_busnumber + 1) << RE_KEY_BUS_SHIFT;
+  if (frame->FIR.B.FF == CAN_frame_ext)
+    key |= RE_KEY_EXTENDED;
 
   if (((m_obdii_std_min>0) &&
        (frame->FIR.B.FF == CAN_frame_std) &&
@@ -230,25 +586,14 @@ std::string re::GetKey(CAN_frame_t* frame)
       return key;
       }
     uint8_t mode = frame->data.u8[1];
-    char req[16];
-    if (mode > 0x4a)
-      {
-      sprintf(req,":O2Pm%d:%d",mode-0x40,((int)frame->data.u8[2]<<8)+frame->data.u8[3]);
-      }
-    else if (mode > 0x40)
-      {
-      sprintf(req,":O2Pm%d:%d",mode-0x40,(int)frame->data.u8[2]);
-      }
-    else if (mode > 0x0a)
-      {
-      sprintf(req,":O2Qm%d:%d",mode,((int)frame->data.u8[2]<<8)+frame->data.u8[3]);
-      }
+    uint32_t pid = (mode > 0x4a || (mode > 0x0a && mode <= 0x40))
+      ? ((uint32_t)frame->data.u8[2]<<8) + frame->data.u8[3]
+      : frame->data.u8[2];
+    if (mode > 0x40)
+      key |= (uint64_t)RE_KEYTYPE_OBDP << RE_KEY_TYPE_SHIFT;
     else
-      {
-      sprintf(req,":O2Qm%d:%d",mode,(int)frame->data.u8[2]);
-      }
-    key.append(req);
-    return key;
+      key |= (uint64_t)RE_KEYTYPE_OBDQ << RE_KEY_TYPE_SHIFT;
+    return key | ((uint32_t)mode << 16) | pid;
     }
 
   // Check for, and process, multiplexed signal
@@ -264,9 +609,7 @@ std::string re::GetKey(CAN_frame_t* frame)
         dbcSignal* s = m->GetMultiplexorSignal();
         dbcNumber muxn = s->Decode(frame);
         uint32_t mux = muxn.GetUnsignedInteger();
-        char b[8];
-        sprintf(b,":%04x",mux);
-        key.append(b);
+        key |= ((uint64_t)RE_KEYTYPE_MUX << RE_KEY_TYPE_SHIFT) | (mux & RE_KEY_DATA_MASK);
         }
       }
     }
@@ -274,6 +617,61 @@ std::string re::GetKey(CAN_frame_t* frame)
   return key;
   }
 
+/**
+ * GetKeyName: format a record key for display, e.g. "can1/7e8:O2Pm1:12"
+ */
+std::string re::GetKeyName(uint64_t key)
+  {
+  char buf[48];
+  char* s = buf;
+  int bus = key >> RE_KEY_BUS_SHIFT;
+  uint32_t id = (key >> RE_KEY_ID_SHIFT) & 0x1fffffff;
+  uint32_t data = key & RE_KEY_DATA_MASK;
+  uint8_t mode = data >> 16;
+  uint32_t pid = data & 0xffff;
+
+  if (bus > 0)
+    s += sprintf(s, "can%d/", bus);
+  else
+    s += sprintf(s, "can?/");
+  if (key & RE_KEY_EXTENDED)
+    s += sprintf(s, "%08x", id);
+  else
+    s += sprintf(s, "%03x", id);
+
+  switch ((key >> RE_KEY_TYPE_SHIFT) & 3)
+    {
+    case RE_KEYTYPE_OBDQ:
+      sprintf(s, ":O2Qm%d:%d", mode, pid);
+      break;
+    case RE_KEYTYPE_OBDP:
+      sprintf(s, ":O2Pm%d:%d", mode-0x40, pid);
+      break;
+    case RE_KEYTYPE_MUX:
+      sprintf(s, ":%04x", data);
+      break;
+    default:
+      break;
+    }
+  return std::string(buf);
+  }
+
+/**
+ * GetSortedRecords: get all records in key order (call with m_mutex held)
+ */
+void re::GetSortedRecords(re_record_list_t& list)
+  {
+  list.clear();
+  list.reserve(m_rmap.size());
+  for (size_t k = 0; k < m_rmap.capacity(); k++)
+    {
+    re_record_t* r = m_rmap.at(k);
+    if (r) list.push_back(r);
+    }
+  std::sort(list.begin(), list.end(),
+    [](const re_record_t* a, const re_record_t* b) { return a->key < b->key; });
+  }
+
 re::re(const char* name, canfilter* filter)
   : pcp(name)
   {
@@ -285,6 +683,11 @@ re::re(const char* name, canfilter* filter)
   m_started = monotonictime;
   m_finished = monotonictime;
   m_mode = Analyse;
+  m_analysed = 0;
+  m_analysed_last = 0;
+  m_rate = 0;
+  m_stats = false;
+  m_stats_metriccount = 0;
   m_rxqueue = xQueueCreate(20,sizeof(CAN_frame_t));
   xTaskCreatePinnedToCore(RE_task, "OVMS RE", 4096, (void*)this, 5, &m_task, CORE(1));
   MyCan.RegisterListener(m_rxqueue, true);
@@ -325,11 +728,7 @@ void re::SetPowerMode(PowerMode powermode)
 void re::Clear()
   {
   OvmsMutexLock lock(&m_mutex);
-  for (re_record_map_t::iterator it=m_rmap.begin(); it!=m_rmap.end(); ++it)
-    {
-    delete it->second;
-    }
-  m_rmap.clear();
+  m_rmap.Clear();
   m_started = monotonictime;
   m_finished = monotonictime;
   }
@@ -390,15 +789,18 @@ void re_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, cons
 
   OvmsMutexLock lock(&MyRE->m_mutex);
   writer->printf("%-20.20s %10s %6s %s\n","key","records","ms","last");
-  for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+  re_record_list_t list;
+  MyRE->GetSortedRecords(list);
+  for (re_record_t* r : list)
     {
-    if ((argc==0)||(strstr(it->first.c_str(),argv[0])))
+    std::string key = MyRE->GetKeyName(r->key);
+    if ((argc==0)||(strstr(key.c_str(),argv[0])))
       {
       char vbuf[48];
       char *s = vbuf;
-      FormatHexDump(&s, (const char*)it->second->last.data.u8, it->second->last.FIR.B.DLC, 8);
+      FormatHexDump(&s, (const char*)r->last.data.u8, r->last.FIR.B.DLC, 8);
       writer->printf("%-20s %10d %6d %s\n",
-        it->first.c_str(),it->second->rxcount,(tdiff/it->second->rxcount),vbuf);
+        key.c_str(),r->rxcount,(tdiff/r->rxcount),vbuf);
       }
     }
   }
@@ -417,17 +819,20 @@ void re_stream_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int arg
   OvmsMutexLock lock(&MyRE->m_mutex);
   writer->printf("[");
   int cnt = 0;
-  for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+  re_record_list_t list;
+  MyRE->GetSortedRecords(list);
+  for (re_record_t* r : list)
     {
-    if ((argc==0)||(strstr(it->first.c_str(),argv[0])))
+    std::string key = MyRE->GetKeyName(r->key);
+    if ((argc==0)||(strstr(key.c_str(),argv[0])))
       {
       char vbuf[48];
       char *s = vbuf;
-      FormatHexDump(&s, (const char*)it->second->last.data.u8, it->second->last.FIR.B.DLC, 8);
+      FormatHexDump(&s, (const char*)r->last.data.u8, r->last.FIR.B.DLC, 8);
       vbuf[24] = 0;
       writer->printf("%s[\"%s\",%d,%d,\"%s\",\"%s\"]\n",
         cnt ? "," : "",
-        json_encode(it->first).c_str(), it->second->rxcount, (tdiff/it->second->rxcount),
+        json_encode(key).c_str(), r->rxcount, (tdiff/r->rxcount),
         json_encode(std::string(vbuf)).c_str(),
         json_encode(std::string(vbuf+25)).c_str());
       cnt++;
@@ -449,22 +854,25 @@ void re_dbc_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
 
   OvmsMutexLock lock(&MyRE->m_mutex);
   writer->printf("%-20.20s %10s %6s %s\n","key","records","ms","last");
-  for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+  re_record_list_t list;
+  MyRE->GetSortedRecords(list);
+  for (re_record_t* r : list)
     {
-    if ((argc==0)||(strstr(it->first.c_str(),argv[0])))
+    std::string key = MyRE->GetKeyName(r->key);
+    if ((argc==0)||(strstr(key.c_str(),argv[0])))
       {
       char vbuf[48];
       char *s = vbuf;
-      FormatHexDump(&s, (const char*)it->second->last.data.u8, it->second->last.FIR.B.DLC, 8);
+      FormatHexDump(&s, (const char*)r->last.data.u8, r->last.FIR.B.DLC, 8);
       writer->printf("%-20s %10d %6d %s\n",
-        it->first.c_str(),it->second->rxcount,(tdiff/it->second->rxcount),vbuf);
-      if (it->second->last.origin)
+        key.c_str(),r->rxcount,(tdiff/r->rxcount),vbuf);
+      if (r->last.origin)
         {
-        dbcfile* dbc = it->second->last.origin->GetDBC();
+        dbcfile* dbc = r->last.origin->GetDBC();
         if (dbc)
           {
           // We have a DBC attached.
-          dbcMessage* msg = dbc->m_messages.FindMessage(it->second->last.FIR.B.FF, it->second->last.MsgID);
+          dbcMessage* msg = dbc->m_messages.FindMessage(r->last.FIR.B.FF, r->last.MsgID);
           if (msg)
             {
             // Let's look for signals...
@@ -472,13 +880,13 @@ void re_dbc_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
             uint32_t muxval;
             if (mux)
               {
-              dbcNumber r = mux->Decode(&it->second->last);
-              muxval = r.GetSignedInteger();
+              dbcNumber v = mux->Decode(&r->last);
+              muxval = v.GetSignedInteger();
               std::ostringstream ss;
               ss << "  dbc/mux/";
               ss << mux->GetName();
               ss << ": ";
-              ss << r;
+              ss << v;
               ss << " ";
               ss << mux->GetUnit();
               writer->puts(ss.str().c_str());
@@ -487,12 +895,12 @@ void re_dbc_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
               {
               if ((mux==NULL)||(sig->GetMultiplexSwitchvalue() == muxval))
                 {
-                dbcNumber r = sig->Decode(&it->second->last);
+                dbcNumber v = sig->Decode(&r->last);
                 std::ostringstream ss;
                 ss << "  dbc/";
                 ss << sig->GetName();
                 ss << ": ";
-                ss << r;
+                ss << v;
                 ss << " ";
                 ss << sig->GetUnit();
                 writer->puts(ss.str().c_str());
@@ -530,6 +938,8 @@ void re_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, co
 
   OvmsMutexLock lock(&MyRE->m_mutex);
   writer->printf("Key Map: %d entries\n",MyRE->m_rmap.size());
+  writer->printf("Rate:    %u frames/s analysed, %u total\n",MyRE->m_rate,MyRE->m_analysed);
+  writer->printf("Stats:   %s\n",MyRE->m_stats ? "collecting" : "off");
   if (MyRE->m_rmap.size() > 0)
     {
     int nignored = 0;
@@ -537,9 +947,10 @@ void re_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, co
     int bchanged = 0;
     int ndiscovered = 0;
     int bdiscovered = 0;
-    for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+    for (size_t k=0; k<MyRE->m_rmap.capacity(); k++)
       {
-      re_record_t *r = it->second;
+      re_record_t *r = MyRE->m_rmap.at(k);
+      if (r == NULL) continue;
       if (r->attr.b.Ignore) nignored++;
       if (r->attr.b.Changed) nchanged++;
       if (r->attr.b.Discovered) ndiscovered++;
@@ -608,10 +1019,12 @@ void re_mode_discover(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int a
     }
 
   OvmsMutexLock lock(&MyRE->m_mutex);
-  for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+  for (size_t k=0; k<MyRE->m_rmap.capacity(); k++)
     {
-    it->second->attr.b.Discovered = 0;
-    it->second->attr.dd = 0;
+    re_record_t* r = MyRE->m_rmap.at(k);
+    if (r == NULL) continue;
+    r->attr.b.Discovered = 0;
+    r->attr.dd = 0;
     }
 
   MyRE->m_mode = Discover;
@@ -628,10 +1041,12 @@ void re_clear_changed(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int a
     }
 
   OvmsMutexLock lock(&MyRE->m_mutex);
-  for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+  for (size_t k=0; k<MyRE->m_rmap.capacity(); k++)
     {
-    it->second->attr.b.Changed = 0;
-    it->second->attr.dc = 0;
+    re_record_t* r = MyRE->m_rmap.at(k);
+    if (r == NULL) continue;
+    r->attr.b.Changed = 0;
+    r->attr.dc = 0;
     }
 
   writer->puts("Cleared all change flags");
@@ -647,10 +1062,12 @@ void re_clear_discovered(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, in
     }
 
   OvmsMutexLock lock(&MyRE->m_mutex);
-  for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+  for (size_t k=0; k<MyRE->m_rmap.capacity(); k++)
     {
-    it->second->attr.b.Discovered = 0;
-    it->second->attr.dd = 0;
+    re_record_t* r = MyRE->m_rmap.at(k);
+    if (r == NULL) continue;
+    r->attr.b.Discovered = 0;
+    r->attr.dd = 0;
     }
 
   writer->puts("Cleared all discover flags");
@@ -671,16 +1088,19 @@ void re_list_changed(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int ar
 
   OvmsMutexLock lock(&MyRE->m_mutex);
   writer->printf("%-20.20s %10s %6s %s\n","key","records","ms","last");
-  for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+  re_record_list_t list;
+  MyRE->GetSortedRecords(list);
+  for (re_record_t* r : list)
     {
-    if ((it->second->attr.b.Changed)||(it->second->attr.dc))
+    if ((r->attr.b.Changed)||(r->attr.dc))
       {
-      HighlightDump(vbuf, (const char*)it->second->last.data.u8,
-        it->second->last.FIR.B.DLC, it->second->attr.dc, it->second->attr.dd);
-      if ((argc==0)||(strstr(it->first.c_str(),argv[0])))
+      HighlightDump(vbuf, (const char*)r->last.data.u8,
+        r->last.FIR.B.DLC, r->attr.dc, r->attr.dd);
+      std::string key = MyRE->GetKeyName(r->key);
+      if ((argc==0)||(strstr(key.c_str(),argv[0])))
         {
         writer->printf("%-20s %10d %6d %s\n",
-          it->first.c_str(),it->second->rxcount,(tdiff/it->second->rxcount),vbuf);
+          key.c_str(),r->rxcount,(tdiff/r->rxcount),vbuf);
         }
       }
     }
@@ -701,19 +1121,22 @@ void re_stream_changed(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int
   OvmsMutexLock lock(&MyRE->m_mutex);
   writer->printf("[");
   int cnt = 0;
-  for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+  re_record_list_t list;
+  MyRE->GetSortedRecords(list);
+  for (re_record_t* r : list)
     {
-    if ((it->second->attr.b.Changed)||(it->second->attr.dc))
+    if ((r->attr.b.Changed)||(r->attr.dc))
       {
-      HighlightDump(vbuf, (const char*)it->second->last.data.u8,
-        it->second->last.FIR.B.DLC, it->second->attr.dc, it->second->attr.dd, 1);
-      if ((argc==0)||(strstr(it->first.c_str(),argv[0])))
+      HighlightDump(vbuf, (const char*)r->last.data.u8,
+        r->last.FIR.B.DLC, r->attr.dc, r->attr.dd, 1);
+      std::string key = MyRE->GetKeyName(r->key);
+      if ((argc==0)||(strstr(key.c_str(),argv[0])))
         {
         char *asc = strchr(vbuf, '|');
         *asc = 0;
         writer->printf("%s[\"%s\",%d,%d,\"%s\",\"%s\"]\n",
           cnt ? "," : "",
-          json_encode(it->first).c_str(), it->second->rxcount, (tdiff/it->second->rxcount),
+          json_encode(key).c_str(), r->rxcount, (tdiff/r->rxcount),
           json_encode(std::string(vbuf)).c_str(),
           json_encode(std::string(asc+2)).c_str());
         cnt++;
@@ -737,30 +1160,217 @@ void re_list_discovered(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int
 
   OvmsMutexLock lock(&MyRE->m_mutex);
   writer->printf("%-20.20s %10s %6s %s\n","key","records","ms","last");
-  for (re_record_map_t::iterator it=MyRE->m_rmap.begin(); it!=MyRE->m_rmap.end(); ++it)
+  re_record_list_t list;
+  MyRE->GetSortedRecords(list);
+  for (re_record_t* r : list)
     {
-    if ((it->second->attr.b.Discovered)||(it->second->attr.dd))
+    if ((r->attr.b.Discovered)||(r->attr.dd))
       {
-      HighlightDump(vbuf, (const char*)it->second->last.data.u8,
-        it->second->last.FIR.B.DLC, it->second->attr.dc, it->second->attr.dd);
-      if ((argc==0)||(strstr(it->first.c_str(),argv[0])))
+      HighlightDump(vbuf, (const char*)r->last.data.u8,
+        r->last.FIR.B.DLC, r->attr.dc, r->attr.dd);
+      std::string key = MyRE->GetKeyName(r->key);
+      if ((argc==0)||(strstr(key.c_str(),argv[0])))
         {
         writer->printf("%-20s %10d %6d %s\n",
-          it->first.c_str(),it->second->rxcount,(tdiff/it->second->rxcount),vbuf);
+          key.c_str(),r->rxcount,(tdiff/r->rxcount),vbuf);
         }
       }
     }
   }
 
+static void re_dbc_write_writer(void* param, const char* buffer)
+  {
+  OvmsWriter* writer = (OvmsWriter*)param;
+  writer->write(buffer,strlen(buffer));
+  }
+
+static void re_dbc_write_file(void* param, const char* buffer)
+  {
+  FILE* fd = (FILE*)param;
+  fwrite(buffer,strlen(buffer),1,fd);
+  }
+
+void re_stats_start(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (!MyRE)
+    {
+    writer->puts("Error: RE tools not running");
+    return;
+    }
+
+  static const char* const defaults[] = { MS_V_POS_SPEED, MS_V_BAT_SOC, MS_V_BAT_CURRENT };
+  bool ok = (argc > 0) ? MyRE->StartStats(argc, argv) : MyRE->StartStats(3, defaults);
+  if (!ok)
+    {
+    writer->puts("Error: unknown metric");
+    return;
+    }
+
+  writer->printf("Collecting signal statistics, correlating with:");
+  for (int m = 0; m < MyRE->m_stats_metriccount; m++)
+    writer->printf(" %s", MyRE->m_stats_metrics[m]->m_name);
+  writer->puts("");
+  }
+
+void re_stats_stop(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (!MyRE)
+    {
+    writer->puts("Error: RE tools not running");
+    return;
+    }
+
+  MyRE->m_stats = false;
+  writer->puts("Stopped collecting signal statistics");
+  }
+
+void re_stats_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (!MyRE)
+    {
+    writer->puts("Error: RE tools not running");
+    return;
+    }
+
+  OvmsMutexLock lock(&MyRE->m_mutex);
+  writer->printf("%-20.20s %10s %s\n","key","records","bit flips (log2, byte 0-7, bit 7-0)");
+  re_record_list_t list;
+  MyRE->GetSortedRecords(list);
+  for (re_record_t* r : list)
+    {
+    std::string key = MyRE->GetKeyName(r->key);
+    if (r->stats == NULL || ((argc>0)&&(!strstr(key.c_str(),argv[0]))))
+      continue;
+
+    char flips[72];
+    char* s = flips;
+    for (int i=0;i<8;i++)
+      {
+      for (int j=7;j>=0;j--)
+        {
+        uint16_t n = r->stats->flips[i*8+j];
+        *s++ = (n == 0) ? '.' : '0' + LIMIT_MAX(32 - __builtin_clz(n), 9);
+        }
+      *s++ = ' ';
+      }
+    s[-1] = 0;
+    writer->printf("%-20s %10d %s\n", key.c_str(), r->rxcount, flips);
+
+    re_candidate_t cand[8];
+    int count = MyRE->GetCandidates(r, cand, 8);
+    for (int k=0;k<count;k++)
+      {
+      re_field_stats_t* fs = &r->stats->field[cand[k].field];
+      writer->printf("  %-7s %5u..%-5u  mono %+4d%%",
+        re_field_name(cand[k].field).c_str(), fs->min, fs->max, (int)(cand[k].mono*100));
+      if (cand[k].metric >= 0)
+        writer->printf("  r=%+.2f %s = %g*x%+g",
+          cand[k].corr, MyRE->m_stats_metrics[cand[k].metric]->m_name, cand[k].factor, cand[k].offset);
+      writer->puts("");
+      }
+    }
+  }
+
+void re_stats_dbc(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (!MyRE)
+    {
+    writer->puts("Error: RE tools not running");
+    return;
+    }
+
+  // Build a DBC from the candidates of all plain IDs:
+  dbcfile dbc;
+  dbc.m_version = "retools";
+  OvmsMutexLock lock(&MyRE->m_mutex);
+  re_record_list_t list;
+  MyRE->GetSortedRecords(list);
+  for (re_record_t* r : list)
+    {
+    if (r->stats == NULL || ((r->key >> RE_KEY_TYPE_SHIFT) & 3) != RE_KEYTYPE_PLAIN)
+      continue;
+    re_candidate_t cand[8];
+    int count = MyRE->GetCandidates(r, cand, 8);
+    if (count == 0)
+      continue;
+
+    uint32_t id = (r->key >> RE_KEY_ID_SHIFT) & 0x1fffffff;
+    char name[32];
+    sprintf(name, (r->key & RE_KEY_EXTENDED) ? "RE_%08X" : "RE_%03X", id);
+    if (r->key & RE_KEY_EXTENDED) id |= 0x80000000;
+    if (dbc.m_messages.FindMessage(id))
+      continue;   // already defined from another bus
+    dbcMessage* msg = new dbcMessage(id);
+    msg->SetName(name);
+    msg->SetSize(LIMIT_MAX(r->last.FIR.B.DLC, 8));
+    msg->SetTransmitterNode("Vector__XXX");
+
+    for (int k=0;k<count;k++)
+      {
+      const re_field_t* f = &re_fields[cand[k].field];
+      re_field_stats_t* fs = &r->stats->field[cand[k].field];
+      sprintf(name, "F%d%s_%d", f->size, (f->size == 8) ? "" : (f->bigendian ? "BE" : "LE"), f->offset);
+      dbcSignal* sig = new dbcSignal(name);
+      sig->SetStartSize(re_field_startbit(cand[k].field), f->size);
+      sig->SetByteOrder(f->bigendian ? DBC_BYTEORDER_BIG_ENDIAN : DBC_BYTEORDER_LITTLE_ENDIAN);
+      sig->SetValueType(DBC_VALUETYPE_UNSIGNED);
+      std::ostringstream comment;
+      if (cand[k].metric >= 0 && fabs(cand[k].corr) >= RE_STATS_MINCORR)
+        {
+        OvmsMetric* metric = MyRE->m_stats_metrics[cand[k].metric];
+        double v1 = fs->min * cand[k].factor + cand[k].offset;
+        double v2 = fs->max * cand[k].factor + cand[k].offset;
+        sig->SetFactorOffset(cand[k].factor, cand[k].offset);
+        sig->SetMinMax(std::min(v1, v2), std::max(v1, v2));
+        sig->SetUnit(OvmsMetricUnitLabel(metric->GetUnits()));
+        comment << "Correlates with " << metric->m_name << " (r=" << cand[k].corr << ")";
+        }
+      else
+        {
+        sig->SetFactorOffset(dbcNumber((uint32_t)1), dbcNumber((uint32_t)0));
+        sig->SetMinMax(dbcNumber((uint32_t)fs->min), dbcNumber((uint32_t)fs->max));
+        comment << "Counter (monotonicity " << (int)(cand[k].mono*100) << "%)";
+        }
+      sig->AddReceiver("Vector__XXX");
+      sig->AddComment(comment.str());
+      msg->AddSignal(sig);
+      }
+    dbc.m_messages.AddMessage(id, msg);
+    }
+
+  using std::placeholders::_1;
+  using std::placeholders::_2;
+  if (argc == 0)
+    {
+    dbc.WriteFile(std::bind(re_dbc_write_writer,_1,_2), writer);
+    return;
+    }
+  FILE* fd = fopen(argv[0], "w");
+  if (fd == NULL)
+    {
+    writer->printf("Error: Could not open file '%s' for writing\n",argv[0]);
+    return;
+    }
+  dbc.WriteFile(std::bind(re_dbc_write_file,_1,_2), fd);
+  fclose(fd);
+  writer->printf("Saved to: %s\n",argv[0]);
+  }
+
 class REInit
   {
   public:
     REInit();
-    void Ticker1(std::string event, void* data);
+    void Ticker1(const std::string& event, void* data);
 } REInit  __attribute__ ((init_priority (8800)));
 
-void REInit::Ticker1(std::string event, void* data)
+void REInit::Ticker1(const std::string& event, void* data)
   {
+  if (MyRE)
+    {
+    uint32_t analysed = MyRE->m_analysed;
+    MyRE->m_rate = analysed - MyRE->m_analysed_last;
+    MyRE->m_analysed_last = analysed;
+    }
   if (MyRE && MyNotify.HasReader("stream", "retools.status"))
     {
     StringWriter buf;
@@ -810,6 +1420,16 @@ REInit::REInit()
   cmd_discover_clear->RegisterCommand("changed","Clear changed flags",re_clear_changed);
   cmd_discover_clear->RegisterCommand("discovered","Clear discovered flags",re_clear_discovered);
 
+  OvmsCommand* cmd_stats = cmd_re->RegisterCommand("stats","RE signal discovery statistics");
+  cmd_stats->RegisterCommand("start","Start collecting statistics",re_stats_start,
+    "[<metric1> [<metric2> [<metric3>]]]\n"
+    "Metrics to correlate fields with, default: v.p.speed v.b.soc v.b.current\n"
+    "Note: needs about 2 kB of memory per ID",
+    0, RE_STATS_METRICS);
+  cmd_stats->RegisterCommand("stop","Stop collecting statistics",re_stats_stop);
+  cmd_stats->RegisterCommand("list","List bit flips and signal candidates",re_stats_list, "[<filter>]", 0, 1);
+  cmd_stats->RegisterCommand("dbc","Output signal candidates as DBC",re_stats_dbc, "[<path>]", 0, 1);
+
   OvmsCommand* cmd_stream = cmd_re->RegisterCommand("stream","RE JSON streaming");
   cmd_stream->RegisterCommand("list","Output array of all RE records",re_stream_list, "[<filter>]", 0, 1);
   cmd_stream->RegisterCommand("changed","Output array of changed RE records",re_stream_changed, "[<filter>]", 0, 1);
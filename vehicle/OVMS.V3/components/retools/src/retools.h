@@ -36,6 +36,7 @@
 #include "freertos/queue.h"
 #include <string>
 #include <map>
+#include <vector>
 #include "can.h"
 #include "canformat.h"
 #include "dbc.h"
@@ -44,8 +45,49 @@
 #include "ovms_mutex.h"
 #include "ovms_netmanager.h"
 
+// Signal discovery statistics (see re::DoStats):
+#define RE_STATS_METRICS      3           // metrics to correlate fields with
+#define RE_STATS_FIELDS       36          // candidate fields per ID
+#define RE_STATS_MINCHANGES   8           // min value changes of a candidate
+#define RE_STATS_MINSAMPLES   10          // min correlation samples
+#define RE_STATS_MINCORR      0.7         // min correlation coefficient
+#define RE_STATS_MINMONO      0.9         // min monotonicity (counters)
+
+typedef struct
+  {
+  uint16_t min;
+  uint16_t max;
+  uint16_t last;
+  uint16_t up;                      // value increments
+  uint16_t down;                    // value decrements
+  double sx, sxx;                   // correlation sums
+  double sxy[RE_STATS_METRICS];
+  } re_field_stats_t;
+
+typedef struct
+  {
+  uint16_t flips[64];               // bit flip counters, index = byte*8 + bit
+  uint32_t samples;                 // correlation samples (1 per second)
+  uint32_t sampled;                 // monotonictime of last sample
+  double sy[RE_STATS_METRICS];
+  double syy[RE_STATS_METRICS];
+  re_field_stats_t field[RE_STATS_FIELDS];
+  } re_stats_t;
+
 typedef struct
   {
+  int field;                        // candidate field index
+  float score;
+  float mono;                       // monotonicity -1…1
+  float corr;                       // best correlation coefficient
+  int metric;                       // best correlated metric, -1 = none
+  double factor;                    // linear fit to the metric
+  double offset;
+  } re_candidate_t;
+
+typedef struct
+  {
+  uint64_t key;             // see RE_KEY_*, RE_KEY_EMPTY = unused slot
   CAN_frame_t last;
   uint32_t rxcount;
   struct __attribute__((__packed__))
@@ -64,9 +106,52 @@ typedef struct
     uint8_t dd;             // Data bytes discovered
     uint8_t spare;
     } attr;
+  re_stats_t* stats;        // signal discovery statistics, if enabled
   } re_record_t;
 
-typedef std::map<std::string, re_record_t*> re_record_map_t;
+// Record keys are packed into 64 bits, sorting by bus, ID and type:
+#define RE_KEY_EMPTY          0xffffffffffffffffULL
+#define RE_KEY_BUS_SHIFT      60          // 4 bits: bus number + 1, 0 = unknown
+#define RE_KEY_EXTENDED       (1ULL<<59)
+#define RE_KEY_ID_SHIFT       30          // 29 bits: CAN ID
+#define RE_KEY_TYPE_SHIFT     24          // 2 bits: RE_KEYTYPE_*
+#define RE_KEY_DATA_MASK      0xffffff    // OBDII mode << 16 | PID, or mux value
+
+#define RE_KEYTYPE_PLAIN      0
+#define RE_KEYTYPE_OBDQ       1           // OBDII request
+#define RE_KEYTYPE_OBDP       2           // OBDII response
+#define RE_KEYTYPE_MUX        3           // DBC multiplexed message
+
+/**
+ * re_record_table: open addressing hash table of records
+ *  Records are stored contiguously in external RAM and only move when
+ *  the table grows (at 75% load), lookups of known keys don't allocate.
+ */
+class re_record_table
+  {
+  public:
+    re_record_table();
+    ~re_record_table();
+
+  public:
+    re_record_t* Find(uint64_t key);
+    re_record_t* Insert(uint64_t key);
+    void Clear();
+    size_t size();
+    size_t capacity();
+    re_record_t* at(size_t slot);   // NULL if the slot is unused
+
+  protected:
+    size_t Slot(uint64_t key);
+    bool Grow();
+
+  protected:
+    re_record_t* m_records;
+    size_t m_capacity;              // power of 2
+    size_t m_count;
+  };
+
+typedef std::vector<re_record_t*> re_record_list_t;
 
 enum REMode { Analyse, Discover };
 
@@ -82,10 +167,13 @@ class re : public pcp, public ExternalRamAllocated
   public:
     void Task();
     void Clear();
-    std::string GetKey(CAN_frame_t* frame);
-
-  protected:
+    uint64_t GetKey(CAN_frame_t* frame);
+    std::string GetKeyName(uint64_t key);
+    void GetSortedRecords(re_record_list_t& list);
     void DoAnalyse(CAN_frame_t* frame);
+    void DoStats(re_record_t* r, CAN_frame_t* frame, bool first);
+    int GetCandidates(re_record_t* r, re_candidate_t* list, int max);
+    bool StartStats(int count, const char* const* metrics);
 
   protected:
     TaskHandle_t m_task;
@@ -95,13 +183,19 @@ class re : public pcp, public ExternalRamAllocated
     OvmsMutex m_mutex;
     canfilter* m_filter;
     REMode m_mode;
-    re_record_map_t m_rmap;
+    re_record_table m_rmap;
     uint32_t m_obdii_std_min;
     uint32_t m_obdii_std_max;
     uint32_t m_obdii_ext_min;
     uint32_t m_obdii_ext_max;
     uint32_t m_started;
     uint32_t m_finished;
+    uint32_t m_analysed;            // frames analysed in total
+    uint32_t m_analysed_last;
+    uint32_t m_rate;                // frames analysed per second
+    bool m_stats;                   // collect signal discovery statistics
+    int m_stats_metriccount;
+    OvmsMetric* m_stats_metrics[RE_STATS_METRICS];
   };
 
 #endif //#ifndef __RETOOLS_H__
@@ -312,6 +312,7 @@ OvmsReToolsPidScanner::OvmsReToolsPidScanner(
         &OvmsReToolsPidScanner::Task, "OVMS RE PID", 4096, this, 5, &m_task, CORE(1)
     );
     MyCan.RegisterListener(m_rxqueue, true);
+    MyCan.AddListenerRange(m_rxqueue, m_bus, CAN_frame_std, m_rxid_low, m_rxid_high);
     m_currentPid = m_startPid - m_pidStep;
     MyEvents.RegisterEvent(
         TAG, "ticker.1",
@@ -58,7 +58,7 @@ class OvmsReToolsPidScanner
     void Output(OvmsWriter* writer) const;
 
   private:
-    void Ticker1(std::string event, void* data);
+    void Ticker1(const std::string& event, void* data);
 
     void FrameCallback(const CAN_frame_t* frame, bool success);
 
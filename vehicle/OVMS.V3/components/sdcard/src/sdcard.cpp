@@ -47,7 +47,7 @@ static const char *TAG = "sdcard";
 static int insertcount = 0;
 static int mountcount = 0;
 
-void sdcard::Ticker1(std::string event, void* data)
+void sdcard::Ticker1(const std::string& event, void* data)
   {
   if (insertcount > 0)
     {
@@ -74,7 +74,7 @@ void sdcard::Ticker1(std::string event, void* data)
     }
   }
 
-void sdcard::EventSystemShutDown(std::string event, void* data)
+void sdcard::EventSystemShutDown(const std::string& event, void* data)
   {
   if (m_mounted && event == "system.shuttingdown")
     {
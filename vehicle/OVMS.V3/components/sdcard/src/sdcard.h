@@ -56,8 +56,8 @@ class sdcard : public pcp, public InternalRamAllocated
     bool isinserted();
 
   public:
-    void Ticker1(std::string event, void* data);
-    void EventSystemShutDown(std::string event, void* data);
+    void Ticker1(const std::string& event, void* data);
+    void EventSystemShutDown(const std::string& event, void* data);
 
   public:
     sdmmc_host_t m_host;
@@ -373,7 +373,7 @@ void simcom::SetPowerMode(PowerMode powermode)
     }
   }
 
-void simcom::Ticker(std::string event, void* data)
+void simcom::Ticker(const std::string& event, void* data)
   {
   m_state1_ticker++;
   SimcomState1 newstate = State1Ticker1();
@@ -392,7 +392,7 @@ void simcom::Ticker(std::string event, void* data)
     }
   }
 
-void simcom::EventListener(std::string event, void* data)
+void simcom::EventListener(const std::string& event, void* data)
   {
   if (event == "system.shuttingdown")
     {
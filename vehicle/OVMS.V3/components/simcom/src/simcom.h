@@ -154,8 +154,8 @@ class simcom : public pcp, public InternalRamAllocated
     void StartTask();
     void StopTask();
     void Task();
-    void Ticker(std::string event, void* data);
-    void EventListener(std::string event, void* data);
+    void Ticker(const std::string& event, void* data);
+    void EventListener(const std::string& event, void* data);
     void IncomingMuxData(GsmMuxChannel* channel);
     void SendSetState1(SimcomState1 newstate);
     bool IsStarted();
@@ -65,7 +65,7 @@ swcan::~swcan()
   MyEvents.DeregisterEvent(TAG);  
   }
 
-void swcan::ModemEvent(std::string event, void* data)
+void swcan::ModemEvent(const std::string& event, void* data)
   {
   ESP_LOGD(TAG, "Modem event: %s", event.c_str());
   // Ignore modem states if we are anyway connected to server via WiFi
@@ -83,21 +83,21 @@ void swcan::ModemEvent(std::string event, void* data)
 
   }
 
-void swcan::ServerConnected(std::string event, void* data)
+void swcan::ServerConnected(const std::string& event, void* data)
   {
   ESP_LOGI(TAG, "Server connected");
   m_status_led->Set(true);
   m_status_led->SetDefaultState(true);
   }
 
-void swcan::ServerDisconnected(std::string event, void* data)
+void swcan::ServerDisconnected(const std::string& event, void* data)
   {
   ESP_LOGW(TAG, "Server disconnected");
   m_status_led->Blink(250,250,-1);
   m_status_led->SetDefaultState(false);
   }
 
-void swcan::SystemUp(std::string event, void* data)
+void swcan::SystemUp(const std::string& event, void* data)
   {
   // flash all LEDS three times
   m_status_led->Blink(200,200,3);
@@ -53,10 +53,10 @@ class swcan : public mcp2515
     ovms_led * m_status_led, * m_tx_led, * m_rx_led;
 
   private:
-    void SystemUp(std::string event, void* data);
-    void ServerConnected(std::string event, void* data);
-    void ServerDisconnected(std::string event, void* data);
-    void ModemEvent(std::string event, void* data);
+    void SystemUp(const std::string& event, void* data);
+    void ServerConnected(const std::string& event, void* data);
+    void ServerDisconnected(const std::string& event, void* data);
+    void ModemEvent(const std::string& event, void* data);
 
     void DoSetTransceiverMode(bool mode0, bool mode1);
   	TransceiverMode m_tmode;
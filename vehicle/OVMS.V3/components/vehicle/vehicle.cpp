@@ -63,6 +63,16 @@ OvmsVehicleFactory::OvmsVehicleFactory()
   cmd_vehicle->RegisterCommand("module","Set (or clear) vehicle module",vehicle_module,"<type>",0,1,true,vehicle_validate);
   cmd_vehicle->RegisterCommand("list","Show list of available vehicle modules",vehicle_list);
   cmd_vehicle->RegisterCommand("status","Show vehicle module status",vehicle_status);
+  OvmsCommand* cmd_poller = cmd_vehicle->RegisterCommand("poller","Vehicle OBD/UDS poller");
+  OvmsCommand* cmd_timing = cmd_poller->RegisterCommand("timing","Show poll schedule timing statistics",vehicle_poller_timing);
+  cmd_timing->RegisterCommand("reset","Reset poll schedule timing statistics",vehicle_poller_timing);
+  OvmsCommand* cmd_stats = cmd_poller->RegisterCommand("stats","Show poll latency, error & throughput statistics",vehicle_poller_stats);
+  cmd_stats->RegisterCommand("reset","Reset poll statistics",vehicle_poller_stats);
+#ifdef CONFIG_OVMS_VEHICLE_POLLER_TESTSIM
+  OvmsCommand* cmd_test = MyCommandApp.RegisterCommand("test","Test framework");
+  cmd_test->RegisterCommand("poller","Test vehicle poller cycle time serial vs. concurrent using simulated ECUs",
+    vehicle_poller_testsim,"[<ecus>] [<pids>] [<size>] [<delay_ms>]",0,4);
+#endif // CONFIG_OVMS_VEHICLE_POLLER_TESTSIM
 
   MyCommandApp.RegisterCommand("wakeup","Wake up vehicle",vehicle_wakeup);
   MyCommandApp.RegisterCommand("homelink","Activate specified homelink button",vehicle_homelink,"<homelink> [<duration=1000ms>]",1,2);
@@ -91,6 +101,16 @@ OvmsVehicleFactory::OvmsVehicleFactory()
   cmd_bms->RegisterCommand("status","Show BMS status",bms_status);
   cmd_bms->RegisterCommand("reset","Reset BMS statistics",bms_reset);
   cmd_bms->RegisterCommand("alerts","Show BMS alerts",bms_alerts);
+  OvmsCommand* cmd_bmshist = cmd_bms->RegisterCommand("history","BMS cell voltage history");
+  cmd_bmshist->RegisterCommand("status","Show cell history status",bms_history_status);
+  cmd_bmshist->RegisterCommand("query","Output cell voltage history",bms_history_query,
+    "<tier> [<cells>] [<from>] [<to>] [<maxrows>]\n"
+    "<tier>: ram (all series), minute, hour (avg/min/max aggregates)\n"
+    "<cells>: cell selection, e.g. '1,5,9-12' (default: all)\n"
+    "<from>, <to>: UTC timestamp, 'now' or relative time '-<n>[smhd]' (default: -1h, now)\n"
+    "<maxrows>: row limit (default: 100)",
+    1, 5);
+  cmd_bmshist->RegisterCommand("flush","Write pending aggregates to SD",bms_history_flush);
 
   OvmsCommand* cmd_obdii = MyCommandApp.RegisterCommand("obdii", "OBDII framework");
   for (int k=1; k <= 4; k++)
@@ -184,7 +204,10 @@ void OvmsVehicleFactory::SetVehicle(const char* type)
     m_currentvehicle = NULL;
     m_currentvehicletype.clear();
     }
+  // sort the vehicle metrics in one pass after the module init:
+  MyMetrics.BeginBulkRegistration();
   m_currentvehicle = NewVehicle(type);
+  MyMetrics.EndBulkRegistration();
   if (m_currentvehicle)
   {
   	m_currentvehicle->m_ready = true;
@@ -270,6 +293,23 @@ OvmsVehicle::OvmsVehicle()
   m_poll_sequence_max = 1;
   m_poll_sequence_cnt = 0;
   m_poll_fc_septime = 25;       // response default timing: 25 milliseconds
+  m_poll_fc_blocksize = 0;      // response default block size: all frames
+  m_poll_fc_adaptive = false;
+  memset(m_poll_fc, 0, sizeof(m_poll_fc));
+  m_poll_concurrency = 0;
+  m_poll_ecu_interval = 0;
+  vPortCPUInitializeMutex(&m_poll_rxfilter_lock);
+  PollerResetSessions();
+  m_poll_timebase = 0;
+  m_poll_timer = NULL;
+  m_poll_tickpending = false;
+  m_poll_txtimer = NULL;
+  m_poll_txsession = NULL;
+  m_poll_cycle_start = 0;
+  m_poll_cycle_sent = 0;
+  m_poll_bustime = 0;
+  m_poll_metrics_time = esp_log_timestamp();
+  PollerResetStats();
 
   m_bms_voltages = NULL;
   m_bms_vmins = NULL;
@@ -309,9 +349,14 @@ OvmsVehicle::OvmsVehicle()
   m_bms_defthr_valert     = BMS_DEFTHR_VALERT;
   m_bms_defthr_twarn      = BMS_DEFTHR_TWARN;
   m_bms_defthr_talert     = BMS_DEFTHR_TALERT;
+  m_bms_vminmax_lo = 0;
+  m_bms_vminmax_hi = -1;
+  m_bms_tminmax_lo = 0;
+  m_bms_tminmax_hi = -1;
 
   m_bms_vlog_last = 0;
   m_bms_tlog_last = 0;
+  m_bms_benchmark = false;
 
   m_minsoc = 0;
   m_minsoc_triggered = 0;
@@ -404,6 +449,19 @@ OvmsVehicle::~OvmsVehicle()
     m_bms_talerts = NULL;
     }
 
+  if (m_poll_timer)
+    {
+    xTimerStop(m_poll_timer, portMAX_DELAY);
+    xTimerDelete(m_poll_timer, portMAX_DELAY);
+    m_poll_timer = NULL;
+    }
+  if (m_poll_txtimer)
+    {
+    xTimerStop(m_poll_txtimer, portMAX_DELAY);
+    xTimerDelete(m_poll_txtimer, portMAX_DELAY);
+    m_poll_txtimer = NULL;
+    }
+
   if (m_registeredlistener)
     {
     MyCan.DeregisterListener(m_rxqueue);
@@ -415,6 +473,9 @@ OvmsVehicle::~OvmsVehicle()
 
   MyEvents.DeregisterEvent(TAG);
   MyMetrics.DeregisterListener(TAG);
+
+  // Close running cell history intervals & write pending aggregates:
+  m_bms_history.Close(time(NULL));
   }
 
 const char* OvmsVehicle::VehicleShortName()
@@ -435,22 +496,29 @@ void OvmsVehicle::RxTask()
     {
     if (xQueueReceive(m_rxqueue, &frame, (portTickType)portMAX_DELAY)==pdTRUE)
       {
-      if (!m_ready)
-        continue;
-      if (m_poll_wait && frame.origin == m_poll_bus && m_poll_plist)
+      if (frame.origin == NULL)
         {
-        // This is a quick filter check to see if the frame is possibly intended for our poller.
-        // The filter will be checked again in PollerReceive() after locking the mutex.
-        // ESP_LOGI(TAG, "Poller Rx candidate ID=%03x (expecting %03x-%03x)",frame.MsgID,m_poll_moduleid_low,m_poll_moduleid_high);
-        uint32_t msgid;
-        if (m_poll_protocol == ISOTP_EXTADR)
-          msgid = frame.MsgID << 8 | frame.data.u8[0];
+        if (frame.MsgID == VEHICLE_POLL_MSG_TXPACE)
+          {
+          // Multi frame request consecutive frame due:
+          if (m_ready) PollerTxPace();
+          }
         else
-          msgid = frame.MsgID;
-        if (msgid >= m_poll_moduleid_low && msgid <= m_poll_moduleid_high)
           {
-          PollerReceive(&frame, msgid);
+          // Poll timer tick, see PollSetTimeBase():
+          m_poll_tickpending = false;
+          if (m_ready) PollerTick();
           }
+        continue;
+        }
+      if (!m_ready)
+        continue;
+      // This is a quick filter check to see if the frame is possibly intended for our poller.
+      // The filter will be checked again in PollerReceive() after locking the mutex.
+      uint32_t msgid;
+      if (PollerRxFilter(&frame, &msgid))
+        {
+        PollerReceive(&frame, msgid);
         }
       if (m_can1 == frame.origin) IncomingFrameCan1(&frame);
       else if (m_can2 == frame.origin) IncomingFrameCan2(&frame);
@@ -514,6 +582,13 @@ void OvmsVehicle::RegisterCanBus(int bus, CAN_mode_t mode, CAN_speed_t speed, db
     m_registeredlistener = true;
     MyCan.RegisterListener(m_rxqueue);
     }
+
+  // Only route frames from our buses to the vehicle task:
+  canbus* rxbus = (bus == 1) ? m_can1 : (bus == 2) ? m_can2 : (bus == 3) ? m_can3 : (bus == 4) ? m_can4 : NULL;
+  if (rxbus)
+    MyCan.AddListenerBus(m_rxqueue, rxbus);
+  if (m_poll_bus_default)
+    MyCan.AddListenerBus(m_rxqueue, m_poll_bus_default);
   }
 
 bool OvmsVehicle::PinCheck(char* pin)
@@ -524,7 +599,7 @@ bool OvmsVehicle::PinCheck(char* pin)
   return (strcmp(vpin.c_str(),pin)==0);
   }
 
-void OvmsVehicle::VehicleTicker1(std::string event, void* data)
+void OvmsVehicle::VehicleTicker1(const std::string& event, void* data)
   {
   if (!m_ready)
     return;
@@ -594,13 +669,13 @@ void OvmsVehicle::VehicleTicker1(std::string event, void* data)
     if (!alert_on && volt > 0 && vref > 0 && vref-volt > alert_threshold)
       {
       StandardMetrics.ms_v_bat_12v_voltage_alert->SetValue(true);
-      MyEvents.SignalEvent("vehicle.alert.12v.on", NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.alert.12v.on"), NULL);
       if (m_autonotifications) Notify12vCritical();
       }
     else if (alert_on && volt > 0 && vref > 0 && vref-volt < alert_threshold*0.6)
       {
       StandardMetrics.ms_v_bat_12v_voltage_alert->SetValue(false);
-      MyEvents.SignalEvent("vehicle.alert.12v.off", NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.alert.12v.off"), NULL);
       if (m_autonotifications) Notify12vRecovered();
       }
     }
@@ -647,7 +722,7 @@ void OvmsVehicle::VehicleTicker1(std::string event, void* data)
       }
     if (notify)
       {
-      MyEvents.SignalEvent("vehicle.alert.tpms", NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.alert.tpms"), NULL);
       if (m_autonotifications && MyConfig.GetParamValueBool("vehicle", "tpms.alerts.enabled", true))
         NotifyTpmsAlerts();
       }
@@ -1026,7 +1101,7 @@ OvmsVehicle::vehicle_command_t OvmsVehicle::CommandStat(int verbosity, OvmsWrite
   return Success;
   }
 
-void OvmsVehicle::VehicleConfigChanged(std::string event, void* data)
+void OvmsVehicle::VehicleConfigChanged(const std::string& event, void* data)
   {
   OvmsConfigParam* param = (OvmsConfigParam*) data;
 
@@ -1052,6 +1127,10 @@ void OvmsVehicle::VehicleConfigChanged(std::string event, void* data)
     m_brakelight_basepwr = MyConfig.GetParamValueFloat("vehicle", "brakelight.basepwr", 0);
     m_brakelight_ignftbrk = MyConfig.GetParamValueBool("vehicle", "brakelight.ignftbrk", false);
     m_brakelight_start = 0;
+
+    // BMS deviation thresholds & cell history:
+    BmsLoadThresholds();
+    BmsConfigureHistory();
     }
 
   // read vehicle specific config:
@@ -1068,7 +1147,7 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_env_on->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.on",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.on"),NULL);
       NotifiedVehicleOn();
       }
     else
@@ -1079,7 +1158,7 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
         m_brakelight_start = 0;
         StdMetrics.ms_v_env_regenbrake->SetValue(false);
         }
-      MyEvents.SignalEvent("vehicle.off",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.off"),NULL);
       if (m_autonotifications)
         {
         m_vehicleoff_ticker = GetNotifyVehicleStateDelay("off");
@@ -1092,12 +1171,12 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_env_awake->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.awake",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.awake"),NULL);
       NotifiedVehicleAwake();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.asleep",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.asleep"),NULL);
       NotifiedVehicleAsleep();
       }
     }
@@ -1105,12 +1184,12 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_charge_inprogress->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.charge.start",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.start"),NULL);
       NotifiedVehicleChargeStart();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.charge.stop",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.stop"),NULL);
       NotifiedVehicleChargeStop();
       }
     }
@@ -1118,12 +1197,12 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_door_chargeport->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.charge.prepare",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.prepare"),NULL);
       NotifiedVehicleChargePrepare();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.charge.finish",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.finish"),NULL);
       NotifiedVehicleChargeFinish();
       }
     }
@@ -1131,12 +1210,12 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_charge_pilot->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.charge.pilot.on",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.pilot.on"),NULL);
       NotifiedVehicleChargePilotOn();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.charge.pilot.off",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.pilot.off"),NULL);
       NotifiedVehicleChargePilotOff();
       }
     }
@@ -1144,12 +1223,12 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_charge_timermode->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.charge.timermode.on",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.timermode.on"),NULL);
       NotifiedVehicleChargeTimermodeOn();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.charge.timermode.off",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.timermode.off"),NULL);
       NotifiedVehicleChargeTimermodeOff();
       }
     }
@@ -1157,12 +1236,12 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_env_aux12v->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.aux.12v.on", NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.aux.12v.on"), NULL);
       NotifiedVehicleAux12vOn();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.aux.12v.off", NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.aux.12v.off"), NULL);
       NotifiedVehicleAux12vOff();
       }
     }
@@ -1172,12 +1251,12 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
       {
       if (m_12v_ticker < 30)
         m_12v_ticker = 30; // min calmdown time
-      MyEvents.SignalEvent("vehicle.charge.12v.start",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.12v.start"),NULL);
       NotifiedVehicleCharge12vStart();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.charge.12v.stop",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.charge.12v.stop"),NULL);
       NotifiedVehicleCharge12vStop();
       }
     }
@@ -1185,12 +1264,12 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_env_locked->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.locked",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.locked"),NULL);
       NotifiedVehicleLocked();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.unlocked",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.unlocked"),NULL);
       NotifiedVehicleUnlocked();
       }
     }
@@ -1198,13 +1277,13 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_env_valet->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.valet.on",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.valet.on"),NULL);
       if (m_autonotifications) NotifyValetEnabled();
       NotifiedVehicleValetOn();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.valet.off",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.valet.off"),NULL);
       if (m_autonotifications) NotifyValetDisabled();
       NotifiedVehicleValetOff();
       }
@@ -1213,12 +1292,12 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_env_headlights->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.headlights.on",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.headlights.on"),NULL);
       NotifiedVehicleHeadlightsOn();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.headlights.off",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.headlights.off"),NULL);
       NotifiedVehicleHeadlightsOff();
       }
     }
@@ -1242,13 +1321,13 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     if (StandardMetrics.ms_v_env_alarm->AsBool())
       {
-      MyEvents.SignalEvent("vehicle.alarm.on",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.alarm.on"),NULL);
       if (m_autonotifications) NotifyAlarmSounding();
       NotifiedVehicleAlarmOn();
       }
     else
       {
-      MyEvents.SignalEvent("vehicle.alarm.off",NULL);
+      MyEvents.SignalEvent(EVENT_ID("vehicle.alarm.off"),NULL);
       if (m_autonotifications) NotifyAlarmStopped();
       NotifiedVehicleAlarmOff();
       }
@@ -1257,14 +1336,14 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
     {
     std::string m = metric->AsString();
     const char* mc = m.c_str();
-    MyEvents.SignalEvent("vehicle.charge.mode",(void*)mc, strlen(mc)+1);
+    MyEvents.SignalEvent(EVENT_ID("vehicle.charge.mode"),(void*)mc, strlen(mc)+1);
     NotifiedVehicleChargeMode(mc);
     }
   else if (metric == StandardMetrics.ms_v_charge_state)
     {
     std::string m = metric->AsString();
     const char* mc = m.c_str();
-    MyEvents.SignalEvent("vehicle.charge.state",(void*)mc, strlen(mc)+1);
+    MyEvents.SignalEvent(EVENT_ID("vehicle.charge.state"),(void*)mc, strlen(mc)+1);
     if (m == "done")
       {
       StandardMetrics.ms_v_charge_duration_full->SetValue(0);
@@ -1281,7 +1360,7 @@ void OvmsVehicle::MetricModified(OvmsMetric* metric)
   else if (metric == StandardMetrics.ms_v_gen_state)
     {
     std::string state = metric->AsString();
-    MyEvents.SignalEvent("vehicle.gen.state", (void*)state.c_str(), state.size()+1);
+    MyEvents.SignalEvent(EVENT_ID("vehicle.gen.state"), (void*)state.c_str(), state.size()+1);
     if (m_autonotifications)
       NotifyGenState();
     }
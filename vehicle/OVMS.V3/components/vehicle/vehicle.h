@@ -34,6 +34,7 @@
 #include <map>
 #include <vector>
 #include <string>
+#include "freertos/timers.h"
 #include "can.h"
 #include "ovms_events.h"
 #include "ovms_config.h"
@@ -42,6 +43,7 @@
 #include "metrics_standard.h"
 #include "ovms_mutex.h"
 #include "ovms_semaphore.h"
+#include "vehicle_bms_history.h"
 
 using namespace std;
 struct DashboardConfig;
@@ -55,6 +57,11 @@ struct DashboardConfig;
 #define ISOTP_FT_CONSECUTIVE            2
 #define ISOTP_FT_FLOWCTRL               3
 
+// Flow control status:
+#define ISOTP_FC_CTS                    0     // continue to send
+#define ISOTP_FC_WAIT                   1
+#define ISOTP_FC_OVERFLOW               2     // abort
+
 // Protocol variant:
 #define ISOTP_STD                       0     // standard addressing (11 bit IDs)
 #define ISOTP_EXTADR                    1     // extended addressing (19 bit IDs)
@@ -135,6 +142,27 @@ struct DashboardConfig;
 // Number of polling states supported
 #define VEHICLE_POLL_NSTATES            4
 
+// Number of ISO-TP sessions (ECUs) the poller can track
+#define VEHICLE_POLL_MAXSESSIONS        8
+
+// Poller control messages to the vehicle task (frame origin NULL, MsgID)
+#define VEHICLE_POLL_MSG_TICK           0     // poll timer tick, see PollSetTimeBase()
+#define VEHICLE_POLL_MSG_TXPACE         1     // multi frame request: send next consecutive frame
+
+// Response timeout per wait count in time base mode (see PollSetTimeBase()) [ms]
+//  (the second ticker times out wait = 2 after 1-2 seconds)
+#define VEHICLE_POLL_WAIT_MS            750
+
+// Number of poller round trip time histogram bins (see vehicle_poller.cpp)
+#define VEHICLE_POLL_HISTBINS           8
+
+// Number of ECUs with individual ISO-TP flow control parameters / request intervals
+//  (see PollSetFlowControl(), PollSetEcuInterval())
+#define VEHICLE_POLL_MAXFLOWCTRL        8
+
+// poll_fc_t.interval: use the default ECU request interval (see PollSetConcurrency())
+#define VEHICLE_POLL_DEFINTERVAL        0xffff
+
 // Macro for poll_pid_t termination
 #define POLL_LIST_END                   { 0, 0, 0x00, 0x00, { 0, 0, 0 }, 0, 0 }
 
@@ -208,10 +236,14 @@ class OvmsVehicle : public InternalRamAllocated
     canbus* m_can4;
 
   private:
-    void VehicleTicker1(std::string event, void* data);
-    void VehicleConfigChanged(std::string event, void* data);
+    void VehicleTicker1(const std::string& event, void* data);
+    void VehicleConfigChanged(const std::string& event, void* data);
     void PollerSend(bool fromTicker);
     void PollerReceive(CAN_frame_t* frame, uint32_t msgid);
+    void PollerTick();
+    void PollerTxPace();
+    static void PollerTimerCallback(TimerHandle_t timer);
+    static void PollerTxTimerCallback(TimerHandle_t timer);
 
   protected:
     virtual void IncomingFrameCan1(CAN_frame_t* p_frame);
@@ -412,10 +444,86 @@ class OvmsVehicle : public InternalRamAllocated
           } args;
         };
       uint16_t polltime[VEHICLE_POLL_NSTATES];  // poll intervals in seconds for used poll states
+                                                //  (milliseconds if PollSetTimeBase() is enabled)
       uint8_t  pollbus;                         // 0 = default CAN bus from PollSetPidList(), 1…4 = specific
       uint8_t  protocol;                        // ISOTP_STD / ISOTP_EXTADR
       } poll_pid_t;
 
+    typedef struct
+      {
+      canbus*           bus;                    // Bus the session is running on
+      const poll_pid_t* entry;                  // Poll list entry of the request
+      uint8_t           protocol;               // ISOTP_STD / ISOTP_EXTADR
+      uint32_t          moduleid_sent;          // ModuleID sent
+      uint32_t          moduleid_low;           // Expected response moduleid low mark
+      uint32_t          moduleid_high;          // Expected response moduleid high mark
+      uint32_t          txmsgid;                // Request CAN ID (frame MsgID)
+      uint16_t          type;                   // Expected type
+      uint16_t          pid;                    // Expected PID
+      uint16_t          ml_remain;              // Bytes remaining for ML poll
+      uint16_t          ml_offset;              // Offset of ML poll
+      uint16_t          ml_frame;               // Frame number for ML poll
+      uint8_t           wait;                   // Wait counter (see m_poll_wait), 0 = idle
+      uint32_t          lastsent;               // Time of last request sent [ms]
+      uint32_t          waitstart;              // Time the wait counter was last set [ms] (time base mode)
+      uint32_t          fc_txid;                // Flow control destination ID of the current response
+      uint8_t           fc_blocksize;           // Block size (BS) requested for the current response
+      uint8_t           fc_septime;             // Separation time (STmin) requested for the current response
+      uint8_t           ml_block;               // Consecutive frames remaining in the current block
+      uint32_t          ml_start;               // Time of first frame received [µs]
+      uint16_t          tx_offset;              // Multi frame request: bytes sent
+      uint8_t           tx_frame;               // Multi frame request: next consecutive frame index
+      uint8_t           tx_block;               // Multi frame request: frames remaining in block, 0 = all
+      uint8_t           tx_septime;             // Multi frame request: separation time (STmin) requested
+      } poll_session_t;
+
+    typedef struct
+      {
+      uint32_t          txid;                   // ECU request ID (moduleid), 0 = unused
+      uint8_t           blocksize;              // Block size (BS) to request, 0 = all frames
+      uint8_t           septime;                // Separation time (STmin) to request
+      uint8_t           adaptive;               // Adaptive STmin: 0 = off, 1 = probing, 2 = settled
+      uint8_t           st_stable;              // Adaptive: fastest STmin with complete responses
+      uint32_t          rate;                   // Last multi frame response rate [bytes/s]
+      uint32_t          rate_stable;            // Adaptive: rate achieved with st_stable [bytes/s]
+      uint32_t          responses;              // Multi frame responses received
+      uint32_t          failures;               // Multi frame responses lost (timeout / sequence error)
+      uint16_t          interval;               // Minimum time between requests [ms], see PollSetEcuInterval()
+      } poll_fc_t;
+
+    typedef struct
+      {
+      canbus*           bus;                    // Bus the session is running on
+      uint32_t          moduleid_low;           // Expected response moduleid low mark
+      uint32_t          moduleid_high;          // Expected response moduleid high mark
+      uint8_t           protocol;               // ISOTP_STD / ISOTP_EXTADR
+      } poll_rxfilter_t;
+
+    typedef struct
+      {
+      uint32_t          due;                    // Next due time [ms]
+      uint32_t          count;                  // Requests sent
+      uint32_t          missed;                 // Intervals skipped due to overrun
+      uint32_t          lag_sum;                // Sum of send delays [ms]
+      uint32_t          lag_max;                // Maximum send delay [ms]
+      } poll_timing_t;
+
+    typedef struct
+      {
+      uint32_t          requests;               // Requests sent
+      uint32_t          responses;              // Complete responses received
+      uint32_t          errors;                 // Negative responses (NRC)
+      uint32_t          timeouts;               // Response timeouts
+      uint32_t          txfails;                // Request transmission failures
+      uint32_t          frames;                 // CAN frames transferred (incl. flow control)
+      uint32_t          bytes;                  // Response payload bytes
+      uint32_t          size_max;               // Maximum response size [bytes]
+      uint32_t          rtt_sum;                // Sum of round trip times [ms]
+      uint32_t          rtt_max;                // Maximum round trip time [ms]
+      uint32_t          rtt_hist[VEHICLE_POLL_HISTBINS]; // Round trip time histogram
+      } poll_stats_t;
+    typedef std::vector<poll_stats_t, ExtRamAllocator<poll_stats_t>> poll_stats_vector_t;
+
   protected:
     OvmsRecMutex      m_poll_mutex;           // Concurrency protection for recursive calls
     uint8_t           m_poll_state;           // Current poll state
@@ -436,22 +544,61 @@ class OvmsVehicle : public InternalRamAllocated
     uint8_t           m_poll_wait;            // Wait counter for a reply from a sent poll or bytes remaining.
                                               // Gets set = 2 when a poll is sent OR when bytes are remaining after receiving.
                                               // Gets set = 0 when a poll is received.
-                                              // Gets decremented with every second/tick in PollerSend().
-                                              // PollerSend() aborts when > 0.
+                                              // Gets decremented with every second/tick in PollerSend(),
+                                              //  in time base mode counts VEHICLE_POLL_WAIT_MS from setting instead.
                                               // Why set = 2: When a poll gets send just before the next ticker occurs
                                               //              PollerSend() decrements to 1 and doesn't send the next poll.
                                               //              Only when the reply doesn't get in until the next ticker occurs
                                               //              PollserSend() decrements to 0 and abandons the outstanding reply (=timeout)
+                                              // Note: the m_poll_… request members above reflect the session currently
+                                              //  processed, the poller keeps one session per ECU (see PollSetConcurrency()).
 
   private:
     uint8_t           m_poll_sequence_max;    // Polls allowed to be sent in sequence per time tick (second), default 1, 0 = no limit
     uint8_t           m_poll_sequence_cnt;    // Polls already sent in the current time tick (second)
     uint8_t           m_poll_fc_septime;      // Flow control separation time for multi frame responses
+    uint8_t           m_poll_fc_blocksize;    // Flow control block size for multi frame responses, 0 = all frames
+    bool              m_poll_fc_adaptive;     // Adaptive separation time for all ECUs
+    poll_fc_t         m_poll_fc[VEHICLE_POLL_MAXFLOWCTRL]; // Flow control parameters & request intervals by ECU
+    uint8_t           m_poll_concurrency;     // Requests allowed in parallel per bus, 0 = serial (default)
+    uint16_t          m_poll_ecu_interval;    // Default minimum time between requests to the same ECU [ms]
+
+  private:
+    poll_session_t    m_poll_session[VEHICLE_POLL_MAXSESSIONS]; // ISO-TP sessions by ECU
+    uint8_t           m_poll_busy;            // Number of sessions waiting for a response
+    portMUX_TYPE      m_poll_rxfilter_lock;   // Response filter snapshot protection
+    poll_rxfilter_t   m_poll_rxfilter[VEHICLE_POLL_MAXSESSIONS]; // Response filter snapshot for the RX task
+    uint8_t           m_poll_rxfilter_cnt;    // … number of active filters
+    std::vector<bool> m_poll_done;            // Poll list entries sent out of order in the current cycle
+
+  private:
+    uint16_t          m_poll_timebase;        // Poll timer period [ms], 0 = second ticker (default)
+    TimerHandle_t     m_poll_timer;           // Poll timer for millisecond scheduling
+    volatile bool     m_poll_tickpending;     // Poll timer tick queued to the vehicle task
+    TimerHandle_t     m_poll_txtimer;         // Multi frame request: consecutive frame pacing timer
+    poll_session_t*   m_poll_txsession;       // Multi frame request: session sending consecutive frames
+    std::vector<poll_timing_t> m_poll_timing; // Millisecond schedule & jitter statistics per poll list entry
+    std::vector<uint16_t> m_poll_duelist;     // Due entries, sorted by deadline
+
+  private:
+    poll_stats_vector_t m_poll_stats;         // Statistics per poll list entry
+    poll_stats_t      m_poll_total;           // Statistics of all requests (incl. single requests)
+    uint32_t          m_poll_stats_since;     // Statistics reset time [ms]
+    uint32_t          m_poll_cycle_start;     // Current poll cycle start time [ms]
+    uint32_t          m_poll_cycle_sent;      // Requests sent in the current poll cycle
+    uint32_t          m_poll_cycle_count;     // Poll cycles completed
+    uint32_t          m_poll_cycle_last;      // Last poll cycle duration [ms]
+    uint32_t          m_poll_cycle_max;       // Maximum poll cycle duration [ms]
+    uint32_t          m_poll_cycle_sum;       // Sum of poll cycle durations [ms]
+    uint32_t          m_poll_bustime;         // Bus time used since last metrics update [µs]
+    uint32_t          m_poll_metrics_time;    // Last metrics update [ms]
+    uint32_t          m_poll_metrics_resp;    // Responses counted at last metrics update
 
   private:
     OvmsRecMutex      m_poll_single_mutex;    // PollSingleRequest() concurrency protection
     std::string*      m_poll_single_rxbuf;    // … response buffer
     int               m_poll_single_rxerr;    // … response error code (NRC) / TX failure code
+    std::string       m_poll_single_txreq;    // … multi frame request (empty = single frame)
     OvmsSemaphore     m_poll_single_rxdone;   // … response done (ok/error)
 
   protected:
@@ -459,6 +606,10 @@ class OvmsVehicle : public InternalRamAllocated
     void PollSetState(uint8_t state);
     void PollSetThrottling(uint8_t sequence_max);
     void PollSetResponseSeparationTime(uint8_t septime);
+    bool PollSetFlowControl(uint32_t txid, uint8_t blocksize, uint8_t septime, bool adaptive=false);
+    void PollSetConcurrency(uint8_t sessions, uint16_t ecu_interval_ms=0);
+    bool PollSetEcuInterval(uint32_t txid, uint16_t interval_ms);
+    void PollSetTimeBase(uint16_t tick_ms);
     int PollSingleRequest(canbus* bus, uint32_t txid, uint32_t rxid,
                       std::string request, std::string& response,
                       int timeout_ms=100, uint8_t protocol=ISOTP_STD);
@@ -472,8 +623,32 @@ class OvmsVehicle : public InternalRamAllocated
 
   private:
     void PollerTxCallback(const CAN_frame_t* frame, bool success);
+    void PollerResetSessions();
+    void PollerExpireSession(poll_session_t* session);
+    void PollerResetSchedule();
+    bool PollerStartRequest(const poll_pid_t* entry, bool fromTicker);
+    void PollerSendScheduled();
+    poll_stats_t* PollerGetStats(const poll_pid_t* entry);
+    void PollerCountFrame(canbus* bus, poll_stats_t* stats);
+    void PollerUpdateMetrics();
+    void PollerResetStats();
+    poll_session_t* PollerFindSession(const CAN_frame_t* frame, uint32_t* msgid);
+    void PollerUpdateRxFilter();
+    bool PollerRxFilter(const CAN_frame_t* frame, uint32_t* msgid);
+    poll_session_t* PollerGetSession(canbus* bus, uint32_t txid, uint32_t rxlow, uint32_t rxhigh);
+    void PollerLoadSession(poll_session_t* session);
+    void PollerSaveSession(poll_session_t* session);
+    void PollerProcessResponse(poll_session_t* session, CAN_frame_t* frame, uint32_t msgid);
+    poll_fc_t* PollerGetFlowControl(uint32_t txid, bool create);
+    void PollerSendFlowControl(poll_session_t* session, canbus* bus);
+    void PollerFlowControlResult(poll_session_t* session, bool success, uint32_t size);
+    void PollerSendConsecutiveFrames(poll_session_t* session, uint8_t blocksize, uint8_t septime);
+    void PollerSendConsecutiveFrame(poll_session_t* session);
   protected:
     virtual void IncomingPollTxCallback(canbus* bus, uint32_t txid, uint16_t type, uint16_t pid, bool success);
+  public:
+    void PollerTimingStatus(int verbosity, OvmsWriter* writer, bool reset);
+    void PollerStatsStatus(int verbosity, OvmsWriter* writer, bool reset);
 
 
   // BMS helpers
@@ -512,8 +687,20 @@ class OvmsVehicle : public InternalRamAllocated
     float m_bms_defthr_valert;                // Default voltage deviation alert threshold [V]
     float m_bms_defthr_twarn;                 // Default temperature deviation warn threshold [°C]
     float m_bms_defthr_talert;                // Default temperature deviation alert threshold [°C]
+    float m_bms_thr_vmaxgrad;                 // Voltage deviation max valid gradient [V] (config cache)
+    float m_bms_thr_vmaxsddev;                // Voltage deviation max valid stddev deviation [V] (config cache)
+    float m_bms_thr_vwarn;                    // Voltage deviation warn threshold [V] (config cache)
+    float m_bms_thr_valert;                   // Voltage deviation alert threshold [V] (config cache)
+    float m_bms_thr_twarn;                    // Temperature deviation warn threshold [°C] (config cache)
+    float m_bms_thr_talert;                   // Temperature deviation alert threshold [°C] (config cache)
+    int m_bms_vminmax_lo;                     // Range of cell voltage min/max entries changed…
+    int m_bms_vminmax_hi;                     // …since last publication
+    int m_bms_tminmax_lo;                     // Range of cell temperature min/max entries changed…
+    int m_bms_tminmax_hi;                     // …since last publication
     uint32_t m_bms_vlog_last;                 // Last log time for voltages
     uint32_t m_bms_tlog_last;                 // Last log time for temperatures
+    OvmsBmsCellHistory m_bms_history;         // Cell voltage history store
+    bool m_bms_benchmark;                     // Benchmark running, don't record history
 
   protected:
     void BmsSetCellArrangementVoltage(int readings, int readingspermodule);
@@ -529,6 +716,8 @@ class OvmsVehicle : public InternalRamAllocated
     void BmsRestartCellVoltages();
     void BmsRestartCellTemperatures();
     void BmsTicker();
+    void BmsLoadThresholds();
+    void BmsConfigureHistory();
     virtual void NotifyBmsAlerts();
 
   public:
@@ -537,6 +726,8 @@ class OvmsVehicle : public InternalRamAllocated
     void BmsGetCellDefaultThresholdsVoltage(float* warn, float* alert, float* maxgrad=NULL, float* maxsddev=NULL);
     void BmsGetCellDefaultThresholdsTemperature(float* warn, float* alert);
     void BmsResetCellStats();
+    void BmsBenchmark(OvmsWriter* writer, int readings, int series);
+    OvmsBmsCellHistory* BmsGetCellHistory() { return &m_bms_history; }
     virtual void BmsStatus(int verbosity, OvmsWriter* writer);
     virtual bool FormatBmsAlerts(int verbosity, OvmsWriter* writer, bool show_warnings);
   };
@@ -606,6 +797,14 @@ class OvmsVehicleFactory
     static void bms_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
     static void bms_reset(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
     static void bms_alerts(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
+    static void bms_history_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
+    static void bms_history_query(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
+    static void bms_history_flush(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
+    static void vehicle_poller_timing(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
+    static void vehicle_poller_stats(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
+#ifdef CONFIG_OVMS_VEHICLE_POLLER_TESTSIM
+    static void vehicle_poller_testsim(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
+#endif // CONFIG_OVMS_VEHICLE_POLLER_TESTSIM
     static void obdii_request(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
 
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
@@ -43,6 +43,7 @@ static const char *TAG = "vehicle";
 #endif // #ifdef CONFIG_OVMS_COMP_WEBSERVER
 #include <ovms_peripherals.h>
 #include <string_writer.h>
+#include "esp_timer.h"
 #include "vehicle.h"
 
 // Voltage stddev running average sample count:
@@ -51,15 +52,15 @@ static const char *TAG = "vehicle";
 
 void OvmsVehicle::BmsSetCellArrangementVoltage(int readings, int readingspermodule)
   {
-  if (m_bms_voltages != NULL) delete m_bms_voltages;
+  if (m_bms_voltages != NULL) delete [] m_bms_voltages;
   m_bms_voltages = new float[readings];
-  if (m_bms_vmins != NULL) delete m_bms_vmins;
+  if (m_bms_vmins != NULL) delete [] m_bms_vmins;
   m_bms_vmins = new float[readings];
-  if (m_bms_vmaxs != NULL) delete m_bms_vmaxs;
+  if (m_bms_vmaxs != NULL) delete [] m_bms_vmaxs;
   m_bms_vmaxs = new float[readings];
-  if (m_bms_vdevmaxs != NULL) delete m_bms_vdevmaxs;
+  if (m_bms_vdevmaxs != NULL) delete [] m_bms_vdevmaxs;
   m_bms_vdevmaxs = new float[readings];
-  if (m_bms_valerts != NULL) delete m_bms_valerts;
+  if (m_bms_valerts != NULL) delete [] m_bms_valerts;
   m_bms_valerts = new short[readings];
   m_bms_valerts_new = 0;
 
@@ -74,15 +75,15 @@ void OvmsVehicle::BmsSetCellArrangementVoltage(int readings, int readingspermodu
 
 void OvmsVehicle::BmsSetCellArrangementTemperature(int readings, int readingspermodule)
   {
-  if (m_bms_temperatures != NULL) delete m_bms_temperatures;
+  if (m_bms_temperatures != NULL) delete [] m_bms_temperatures;
   m_bms_temperatures = new float[readings];
-  if (m_bms_tmins != NULL) delete m_bms_tmins;
+  if (m_bms_tmins != NULL) delete [] m_bms_tmins;
   m_bms_tmins = new float[readings];
-  if (m_bms_tmaxs != NULL) delete m_bms_tmaxs;
+  if (m_bms_tmaxs != NULL) delete [] m_bms_tmaxs;
   m_bms_tmaxs = new float[readings];
-  if (m_bms_tdevmaxs != NULL) delete m_bms_tdevmaxs;
+  if (m_bms_tdevmaxs != NULL) delete [] m_bms_tdevmaxs;
   m_bms_tdevmaxs = new float[readings];
-  if (m_bms_talerts != NULL) delete m_bms_talerts;
+  if (m_bms_talerts != NULL) delete [] m_bms_talerts;
   m_bms_talerts = new short[readings];
   m_bms_talerts_new = 0;
 
@@ -116,6 +117,7 @@ void OvmsVehicle::BmsSetCellDefaultThresholdsVoltage(float warn, float alert,
   m_bms_defthr_valert = alert;
   m_bms_defthr_vmaxgrad = (maxgrad < 0) ? BMS_DEFTHR_VMAXGRAD : maxgrad;
   m_bms_defthr_vmaxsddev = (maxsddev < 0) ? BMS_DEFTHR_VMAXSDDEV : maxsddev;
+  BmsLoadThresholds();
   }
 
 void OvmsVehicle::BmsGetCellDefaultThresholdsVoltage(float* warn, float* alert,
@@ -131,6 +133,7 @@ void OvmsVehicle::BmsSetCellDefaultThresholdsTemperature(float warn, float alert
   {
   m_bms_defthr_twarn = warn;
   m_bms_defthr_talert = alert;
+  BmsLoadThresholds();
   }
 
 void OvmsVehicle::BmsGetCellDefaultThresholdsTemperature(float* warn, float* alert)
@@ -151,6 +154,39 @@ void OvmsVehicle::BmsSetCellLimitsTemperature(float min, float max)
   m_bms_limit_tmax = max;
   }
 
+/**
+ * BmsPublishCells: publish the changed index range [lo..hi] of a cell vector
+ *  (or the full vector if the metric has been cleared since the last update)
+ */
+template <typename ElemType>
+static void BmsPublishCells(OvmsMetricVector<ElemType>* metric, int readings,
+  const ElemType* values, int lo, int hi)
+  {
+  if (metric->GetSize() < (uint32_t)readings)
+    metric->SetElemValues(0, readings, values);
+  else if (hi >= lo)
+    metric->SetElemValues(lo, hi-lo+1, values+lo);
+  }
+
+void OvmsVehicle::BmsLoadThresholds()
+  {
+  m_bms_thr_vmaxgrad  = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.maxgrad",  m_bms_defthr_vmaxgrad);
+  m_bms_thr_vmaxsddev = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.maxsddev", m_bms_defthr_vmaxsddev);
+  m_bms_thr_vwarn     = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.warn",     m_bms_defthr_vwarn);
+  m_bms_thr_valert    = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.alert",    m_bms_defthr_valert);
+  m_bms_thr_twarn     = MyConfig.GetParamValueFloat("vehicle", "bms.dev.temp.warn",        m_bms_defthr_twarn);
+  m_bms_thr_talert    = MyConfig.GetParamValueFloat("vehicle", "bms.dev.temp.alert",       m_bms_defthr_talert);
+  }
+
+void OvmsVehicle::BmsConfigureHistory()
+  {
+  m_bms_history.Configure(
+    MyConfig.GetParamValueBool("vehicle", "bms.history.enabled", false),
+    MyConfig.GetParamValueInt("vehicle", "bms.history.ramsize", BMSHIST_DEF_RAMSIZE),
+    MyConfig.GetParamValue("vehicle", "bms.history.path", BMSHIST_DEF_PATH),
+    MyConfig.GetParamValueInt("vehicle", "bms.history.flush", BMSHIST_DEF_FLUSH));
+  }
+
 void OvmsVehicle::BmsSetCellVoltage(int index, float value)
   {
   // ESP_LOGV(TAG,"BmsSetCellVoltage(%d,%f) c=%d", index, value, m_bms_bitset_cv);
@@ -158,6 +194,7 @@ void OvmsVehicle::BmsSetCellVoltage(int index, float value)
   if ((value<m_bms_limit_vmin)||(value>m_bms_limit_vmax)) return;
   m_bms_voltages[index] = value;
 
+  bool minmax_changed = true;
   if (! m_bms_has_voltages)
     {
     m_bms_vmins[index] = value;
@@ -167,39 +204,40 @@ void OvmsVehicle::BmsSetCellVoltage(int index, float value)
     m_bms_vmins[index] = value;
   else if (m_bms_vmaxs[index] < value)
     m_bms_vmaxs[index] = value;
+  else
+    minmax_changed = false;
+  if (minmax_changed)
+    {
+    if (index < m_bms_vminmax_lo) m_bms_vminmax_lo = index;
+    if (index > m_bms_vminmax_hi) m_bms_vminmax_hi = index;
+    }
 
   if (m_bms_bitset_v[index] == false) m_bms_bitset_cv++;
   if (m_bms_bitset_cv == m_bms_readings_v)
     {
     // Series complete, all cell voltages acquired
-    float thr_maxgrad  = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.maxgrad",  m_bms_defthr_vmaxgrad);
-    float thr_maxsddev = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.maxsddev", m_bms_defthr_vmaxsddev);
-    float thr_warn     = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.warn",     m_bms_defthr_vwarn);
-    float thr_alert    = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.alert",    m_bms_defthr_valert);
-
-    // Get min, max, avg & standard deviation:
-    double sum=0, sqrsum=0, avg, stddev=0;
-    float min=0, max=0;
-    for (int i=0; i<m_bms_readings_v; i++)
-      {
-      sum += m_bms_voltages[i];
-      sqrsum += SQR(m_bms_voltages[i]);
-      if (min==0 || m_bms_voltages[i]<min)
-        min = m_bms_voltages[i];
-      if (max==0 || m_bms_voltages[i]>max)
-        max = m_bms_voltages[i];
-      }
-    avg = sum / m_bms_readings_v;
-    stddev = sqrt(LIMIT_MIN((sqrsum / m_bms_readings_v) - SQR(avg), 0));
-
-    // Get gradient:
-    double sumn = 0, sumd = 0;
-    for (int i=0; i<m_bms_readings_v; i++)
+    int n = m_bms_readings_v;
+
+    // Get min, max, avg, standard deviation & gradient in one pass
+    //  (gradient = linear regression slope over the cell index, centered at c):
+    double sum=0, sqrsum=0, xsum=0, xvsum=0, xsqrsum=0, avg, stddev=0;
+    double c = n / 2 - 0.5;
+    float min = m_bms_voltages[0], max = m_bms_voltages[0];
+    for (int i=0; i<n; i++)
       {
-      sumn += (i - (m_bms_readings_v / 2 - 0.5)) * (m_bms_voltages[i] - avg);
-      sumd += SQR(i - (m_bms_readings_v / 2 - 0.5));
+      float v = m_bms_voltages[i];
+      double x = i - c;
+      sum += v;
+      sqrsum += SQR(v);
+      xsum += x;
+      xvsum += x * v;
+      xsqrsum += SQR(x);
+      if (v < min) min = v;
+      if (v > max) max = v;
       }
-    float grad = (sumn / sumd) * m_bms_readings_v;
+    avg = sum / n;
+    stddev = sqrt(LIMIT_MIN((sqrsum / n) - SQR(avg), 0));
+    float grad = ((xvsum - avg * xsum) / xsqrsum) * n;
 
     // …publish to metrics:
     StandardMetrics.ms_v_bat_pack_vmin->SetValue(min);
@@ -207,15 +245,17 @@ void OvmsVehicle::BmsSetCellVoltage(int index, float value)
     StandardMetrics.ms_v_bat_pack_vavg->SetValue(ROUNDPREC(avg, 5));
     StandardMetrics.ms_v_bat_pack_vstddev->SetValue(ROUNDPREC(stddev, 5));
     StandardMetrics.ms_v_bat_pack_vgrad->SetValue(ROUNDPREC(grad, 5));
-    StandardMetrics.ms_v_bat_cell_voltage->SetElemValues(0, m_bms_readings_v, m_bms_voltages);
-    StandardMetrics.ms_v_bat_cell_vmin->SetElemValues(0, m_bms_readings_v, m_bms_vmins);
-    StandardMetrics.ms_v_bat_cell_vmax->SetElemValues(0, m_bms_readings_v, m_bms_vmaxs);
+    StandardMetrics.ms_v_bat_cell_voltage->SetElemValues(0, n, m_bms_voltages);
+    BmsPublishCells(StandardMetrics.ms_v_bat_cell_vmin, n, m_bms_vmins, m_bms_vminmax_lo, m_bms_vminmax_hi);
+    BmsPublishCells(StandardMetrics.ms_v_bat_cell_vmax, n, m_bms_vmaxs, m_bms_vminmax_lo, m_bms_vminmax_hi);
+    m_bms_vminmax_lo = n;
+    m_bms_vminmax_hi = -1;
 
     // Voltages are very volatile and may respond to a load change within the sensor query loop.
     // To detect an inconsistent series, we check for a too high gradient and/or a too high
     // offset of the momentary stddev level from the previously observed average:
     bool series_valid;
-    if (ABS(grad) > thr_maxgrad)
+    if (ABS(grad) > m_bms_thr_vmaxgrad)
       {
       series_valid = false;
       }
@@ -226,7 +266,7 @@ void OvmsVehicle::BmsSetCellVoltage(int index, float value)
       m_bms_vstddev_avg = ((m_bms_vstddev_cnt-1) * m_bms_vstddev_avg + stddev) / m_bms_vstddev_cnt;
       series_valid = false;
       }
-    else if (stddev - m_bms_vstddev_avg > thr_maxsddev)
+    else if (stddev - m_bms_vstddev_avg > m_bms_thr_vmaxsddev)
       {
       series_valid = false;
       }
@@ -236,31 +276,50 @@ void OvmsVehicle::BmsSetCellVoltage(int index, float value)
       series_valid = true;
       }
 
-    // Check cell deviations only if the series appears to be consistent:
+    // Check cell deviations only if the series appears to be consistent
+    //  (needs the series average, so cannot be folded into the pass above):
     if (series_valid)
       {
       float dev;
-      for (int i=0; i<m_bms_readings_v; i++)
+      int lo = n, hi = -1;
+      for (int i=0; i<n; i++)
         {
         dev = ROUNDPREC(m_bms_voltages[i] - avg, 5);
+        bool changed = false;
         if (ABS(dev) > ABS(m_bms_vdevmaxs[i]))
+          {
           m_bms_vdevmaxs[i] = dev;
-        if (ABS(dev) >= stddev + thr_alert && m_bms_valerts[i] < 2)
+          changed = true;
+          }
+        if (ABS(dev) >= stddev + m_bms_thr_valert && m_bms_valerts[i] < 2)
           {
           m_bms_valerts[i] = 2;
           m_bms_valerts_new++; // trigger notification
+          changed = true;
           }
-        else if (ABS(dev) >= stddev + thr_warn && m_bms_valerts[i] < 1)
+        else if (ABS(dev) >= stddev + m_bms_thr_vwarn && m_bms_valerts[i] < 1)
+          {
           m_bms_valerts[i] = 1;
+          changed = true;
+          }
+        if (changed)
+          {
+          if (i < lo) lo = i;
+          hi = i;
+          }
         }
 
       // Publish deviation maximums & alerts:
       if (stddev > StandardMetrics.ms_v_bat_pack_vstddev_max->AsFloat())
         StandardMetrics.ms_v_bat_pack_vstddev_max->SetValue(stddev);
-      StandardMetrics.ms_v_bat_cell_vdevmax->SetElemValues(0, m_bms_readings_v, m_bms_vdevmaxs);
-      StandardMetrics.ms_v_bat_cell_valert->SetElemValues(0, m_bms_readings_v, m_bms_valerts);
+      BmsPublishCells(StandardMetrics.ms_v_bat_cell_vdevmax, n, m_bms_vdevmaxs, lo, hi);
+      BmsPublishCells(StandardMetrics.ms_v_bat_cell_valert, n, m_bms_valerts, lo, hi);
       }
 
+    // Record to cell history:
+    if (!m_bms_benchmark)
+      m_bms_history.AddSeries(m_bms_voltages, n, time(NULL));
+
     // complete:
     m_bms_has_voltages = true;
     m_bms_bitset_v.clear();
@@ -280,6 +339,7 @@ void OvmsVehicle::BmsSetCellTemperature(int index, float value)
   if ((value<m_bms_limit_tmin)||(value>m_bms_limit_tmax)) return;
   m_bms_temperatures[index] = value;
 
+  bool minmax_changed = true;
   if (! m_bms_has_temperatures)
     {
     m_bms_tmins[index] = value;
@@ -289,43 +349,62 @@ void OvmsVehicle::BmsSetCellTemperature(int index, float value)
     m_bms_tmins[index] = value;
   else if (m_bms_tmaxs[index] < value)
     m_bms_tmaxs[index] = value;
+  else
+    minmax_changed = false;
+  if (minmax_changed)
+    {
+    if (index < m_bms_tminmax_lo) m_bms_tminmax_lo = index;
+    if (index > m_bms_tminmax_hi) m_bms_tminmax_hi = index;
+    }
 
   if (m_bms_bitset_t[index] == false) m_bms_bitset_ct++;
   if (m_bms_bitset_ct == m_bms_readings_t)
     {
     // Series complete, all cell temperatures acquired
-    float thr_warn  = MyConfig.GetParamValueFloat("vehicle", "bms.dev.temp.warn", m_bms_defthr_twarn);
-    float thr_alert = MyConfig.GetParamValueFloat("vehicle", "bms.dev.temp.alert", m_bms_defthr_talert);
+    int n = m_bms_readings_t;
 
     // get min, max, avg & standard deviation:
     double sum=0, sqrsum=0, avg, stddev=0;
-    float min=0, max=0;
-    for (int i=0; i<m_bms_readings_t; i++)
+    float min = m_bms_temperatures[0], max = m_bms_temperatures[0];
+    for (int i=0; i<n; i++)
       {
-      sum += m_bms_temperatures[i];
-      sqrsum += SQR(m_bms_temperatures[i]);
-      if (min==0 || m_bms_temperatures[i]<min)
-        min = m_bms_temperatures[i];
-      if (max==0 || m_bms_temperatures[i]>max)
-        max = m_bms_temperatures[i];
+      float t = m_bms_temperatures[i];
+      sum += t;
+      sqrsum += SQR(t);
+      if (t < min) min = t;
+      if (t > max) max = t;
       }
-    avg = sum / m_bms_readings_t;
-    stddev = sqrt(LIMIT_MIN((sqrsum / m_bms_readings_t) - SQR(avg), 0));
+    avg = sum / n;
+    stddev = sqrt(LIMIT_MIN((sqrsum / n) - SQR(avg), 0));
 
     // check cell deviations:
     float dev;
-    for (int i=0; i<m_bms_readings_t; i++)
+    int lo = n, hi = -1;
+    for (int i=0; i<n; i++)
       {
       dev = ROUNDPREC(m_bms_temperatures[i] - avg, 2);
+      bool changed = false;
       if (ABS(dev) > ABS(m_bms_tdevmaxs[i]))
+        {
         m_bms_tdevmaxs[i] = dev;
-      if (ABS(dev) >= stddev + thr_alert && m_bms_talerts[i] < 2)
+        changed = true;
+        }
+      if (ABS(dev) >= stddev + m_bms_thr_talert && m_bms_talerts[i] < 2)
         {
         m_bms_talerts[i] = 2;
         m_bms_talerts_new++; // trigger notification
+        changed = true;
         }
-      else if (ABS(dev) >= stddev + thr_warn && m_bms_valerts[i] < 1)
+      else if (ABS(dev) >= stddev + m_bms_thr_twarn && m_bms_talerts[i] < 1)
+        {
         m_bms_talerts[i] = 1;
+        changed = true;
+        }
+      if (changed)
+        {
+        if (i < lo) lo = i;
+        hi = i;
+        }
       }
 
     // publish to metrics:
@@ -337,11 +416,13 @@ void OvmsVehicle::BmsSetCellTemperature(int index, float value)
     StandardMetrics.ms_v_bat_pack_tstddev->SetValue(stddev);
     if (stddev > StandardMetrics.ms_v_bat_pack_tstddev_max->AsFloat())
       StandardMetrics.ms_v_bat_pack_tstddev_max->SetValue(stddev);
-    StandardMetrics.ms_v_bat_cell_temp->SetElemValues(0, m_bms_readings_t, m_bms_temperatures);
-    StandardMetrics.ms_v_bat_cell_tmin->SetElemValues(0, m_bms_readings_t, m_bms_tmins);
-    StandardMetrics.ms_v_bat_cell_tmax->SetElemValues(0, m_bms_readings_t, m_bms_tmaxs);
-    StandardMetrics.ms_v_bat_cell_tdevmax->SetElemValues(0, m_bms_readings_t, m_bms_tdevmaxs);
-    StandardMetrics.ms_v_bat_cell_talert->SetElemValues(0, m_bms_readings_t, m_bms_talerts);
+    StandardMetrics.ms_v_bat_cell_temp->SetElemValues(0, n, m_bms_temperatures);
+    BmsPublishCells(StandardMetrics.ms_v_bat_cell_tmin, n, m_bms_tmins, m_bms_tminmax_lo, m_bms_tminmax_hi);
+    BmsPublishCells(StandardMetrics.ms_v_bat_cell_tmax, n, m_bms_tmaxs, m_bms_tminmax_lo, m_bms_tminmax_hi);
+    BmsPublishCells(StandardMetrics.ms_v_bat_cell_tdevmax, n, m_bms_tdevmaxs, lo, hi);
+    BmsPublishCells(StandardMetrics.ms_v_bat_cell_talert, n, m_bms_talerts, lo, hi);
+    m_bms_tminmax_lo = n;
+    m_bms_tminmax_hi = -1;
 
     // complete:
     m_bms_has_temperatures = true;
@@ -355,6 +436,49 @@ void OvmsVehicle::BmsSetCellTemperature(int index, float value)
     }
   }
 
+/**
+ * BmsBenchmark: measure voltage series processing time on synthetic readings
+ *  Note: reallocates the cell arrays and publishes the synthetic series, so this
+ *  must not be called on a vehicle feeding cell voltages (see "test bms", which
+ *  runs it on a separate instance while no vehicle module is loaded).
+ */
+void OvmsVehicle::BmsBenchmark(OvmsWriter* writer, int readings, int series)
+  {
+  int save_readings = m_bms_readings_v, save_readingspermodule = m_bms_readingspermodule_v;
+  float save_vmin = m_bms_limit_vmin, save_vmax = m_bms_limit_vmax;
+
+  m_bms_benchmark = true;
+  BmsSetCellArrangementVoltage(readings, 12);
+  BmsSetCellLimitsVoltage(0, 1000);
+
+  // Deterministic pseudo random cell voltages around 3.7 V:
+  uint32_t seed = 1;
+  int64_t time_start_us = esp_timer_get_time();
+  for (int k = 0; k < series; k++)
+    {
+    for (int i = 0; i < readings; i++)
+      {
+      seed = seed * 1103515245 + 12345;
+      BmsSetCellVoltage(i, 3.7 + ((int)((seed >> 16) & 0xff) - 128) * 0.0001);
+      }
+    }
+  int64_t elapsed = esp_timer_get_time() - time_start_us;
+
+  writer->printf("%3d cells: %d series in %lld us = %d us/series, %d ns/reading\n",
+    readings, series, elapsed, (int)(elapsed / series), (int)(elapsed * 1000 / series / readings));
+
+  // Restore, don't leave the synthetic series looking current:
+  BmsResetCellVoltages(true);
+  BmsSetCellArrangementVoltage(save_readings, save_readingspermodule);
+  BmsSetCellLimitsVoltage(save_vmin, save_vmax);
+  StandardMetrics.ms_v_bat_pack_vmin->SetStale(true);
+  StandardMetrics.ms_v_bat_pack_vmax->SetStale(true);
+  StandardMetrics.ms_v_bat_pack_vavg->SetStale(true);
+  StandardMetrics.ms_v_bat_pack_vstddev->SetStale(true);
+  StandardMetrics.ms_v_bat_pack_vgrad->SetStale(true);
+  m_bms_benchmark = false;
+  }
+
 void OvmsVehicle::BmsRestartCellVoltages()
   {
   m_bms_bitset_v.clear();
@@ -387,6 +511,8 @@ void OvmsVehicle::BmsResetCellVoltages(bool full /*=false*/)
     m_bms_valerts_new = 0;
     m_bms_vstddev_cnt = 0;
     m_bms_vstddev_avg = 0;
+    m_bms_vminmax_lo = m_bms_readings_v;
+    m_bms_vminmax_hi = -1;
     if (full) StandardMetrics.ms_v_bat_cell_voltage->ClearValue();
     StandardMetrics.ms_v_bat_cell_vmin->ClearValue();
     StandardMetrics.ms_v_bat_cell_vmax->ClearValue();
@@ -412,6 +538,8 @@ void OvmsVehicle::BmsResetCellTemperatures(bool full /*=false*/)
       m_bms_talerts[k] = 0;
       }
     m_bms_talerts_new = 0;
+    m_bms_tminmax_lo = m_bms_readings_t;
+    m_bms_tminmax_hi = -1;
     if (full) StandardMetrics.ms_v_bat_cell_temp->ClearValue();
     StandardMetrics.ms_v_bat_cell_tmin->ClearValue();
     StandardMetrics.ms_v_bat_cell_tmax->ClearValue();
@@ -615,4 +743,7 @@ void OvmsVehicle::BmsTicker()
       StdMetrics.ms_v_bat_pack_tstddev_max->AsFloat(),
       StdMetrics.ms_v_bat_cell_temp->AsString("", Native, 1).c_str());
     }
+
+  // Cell history aggregation & SD flush:
+  m_bms_history.Ticker(time(NULL));
   }
@@ -0,0 +1,778 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Date:          14th March 2017
+;
+;    Changes:
+;    1.0  Initial release
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2017  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+#include "ovms_log.h"
+static const char *TAG = "bms-history";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <algorithm>
+#include <ovms_utils.h>
+#include <ovms_peripherals.h>
+#include "vehicle_bms_history.h"
+
+static const char* const tier_names[] = { "ram", "minute", "hour" };
+
+static inline void put_varint(std::vector<uint8_t>& buf, uint32_t val)
+  {
+  while (val >= 0x80)
+    {
+    buf.push_back((val & 0x7f) | 0x80);
+    val >>= 7;
+    }
+  buf.push_back(val);
+  }
+
+static inline uint32_t zigzag_encode(int32_t val)
+  {
+  return ((uint32_t)val << 1) ^ (uint32_t)(val >> 31);
+  }
+
+static inline int32_t zigzag_decode(uint32_t val)
+  {
+  return (int32_t)(val >> 1) ^ -(int32_t)(val & 1);
+  }
+
+
+OvmsBmsCellHistory::OvmsBmsCellHistory()
+  {
+  m_enabled = false;
+  m_path = BMSHIST_DEF_PATH;
+  m_flush_interval = BMSHIST_DEF_FLUSH;
+  m_cells = 0;
+
+  m_ring = NULL;
+  m_ringsize = 0;
+  m_tail = 0;
+  m_used = 0;
+  m_records = 0;
+  m_basetime = 0;
+  m_lasttime = 0;
+
+  m_agg_minute.interval = 60;
+  m_agg_hour.interval = 3600;
+  AggReset(m_agg_minute);
+  AggReset(m_agg_hour);
+  m_pending_size = 0;
+  m_last_flush = 0;
+
+  m_stat_hour = 0;
+  m_series_total = 0;
+  m_sd_writes_hour = m_sd_writes_lasthour = m_sd_writes_total = 0;
+  m_sd_bytes_hour = m_sd_bytes_lasthour = m_sd_bytes_total = 0;
+  m_sd_errors = 0;
+  m_dropped = 0;
+  }
+
+OvmsBmsCellHistory::~OvmsBmsCellHistory()
+  {
+  FreeRing();
+  }
+
+/**
+ * Configure: enable/disable & (re)allocate the RAM ring
+ *  Note: changing the RAM size discards the RAM tier, aggregates are kept.
+ */
+void OvmsBmsCellHistory::Configure(bool enabled, size_t ramsize, const std::string& path, int flush_interval)
+  {
+  OvmsMutexLock lock(&m_mutex);
+  m_path = path.empty() ? BMSHIST_DEF_PATH : path;
+  m_flush_interval = LIMIT_MIN(flush_interval, 1);
+
+  if (!enabled)
+    {
+    if (m_enabled)
+      {
+      // close intervals, pending records will be flushed by the next ticker:
+      AggClose(m_agg_minute, BmsHist_Minute);
+      AggClose(m_agg_hour, BmsHist_Hour);
+      FreeRing();
+      ESP_LOGI(TAG, "Disabled");
+      }
+    m_enabled = false;
+    return;
+    }
+
+  if (m_ring == NULL || ramsize != m_ringsize)
+    {
+    FreeRing();
+    m_ring = (uint8_t*) ExternalRamMalloc(ramsize);
+    if (!m_ring)
+      {
+      ESP_LOGE(TAG, "Cannot allocate %u bytes for RAM ring", ramsize);
+      m_enabled = false;
+      return;
+      }
+    m_ringsize = ramsize;
+    Reset(m_cells);
+    }
+
+  if (!m_enabled)
+    ESP_LOGI(TAG, "Enabled: RAM ring %u bytes, SD path '%s', flush interval %d min",
+      m_ringsize, m_path.c_str(), m_flush_interval);
+  m_enabled = true;
+  }
+
+void OvmsBmsCellHistory::FreeRing()
+  {
+  if (m_ring)
+    {
+    free(m_ring);
+    m_ring = NULL;
+    }
+  m_ringsize = 0;
+  m_tail = 0;
+  m_used = 0;
+  m_records = 0;
+  }
+
+/**
+ * Reset: clear RAM tier & running aggregates for a new cell arrangement
+ */
+void OvmsBmsCellHistory::Reset(int cells)
+  {
+  AggClose(m_agg_minute, BmsHist_Minute);
+  AggClose(m_agg_hour, BmsHist_Hour);
+  m_cells = cells;
+  m_tail = 0;
+  m_used = 0;
+  m_records = 0;
+  m_base.assign(cells, 0);
+  m_basetime = 0;
+  m_last.assign(cells, 0);
+  m_lasttime = 0;
+  m_values.resize(cells);
+  m_enc.reserve(5 + 3*cells);
+  AggReset(m_agg_minute);
+  AggReset(m_agg_hour);
+  }
+
+/**
+ * AddSeries: record a completed cell voltage series
+ */
+void OvmsBmsCellHistory::AddSeries(const float* voltages, int cells, time_t now)
+  {
+  if (!m_enabled || cells <= 0 || now < BMSHIST_TIME_VALID)
+    return;
+  OvmsMutexLock lock(&m_mutex);
+  if (!m_enabled)
+    return;
+  if (cells != m_cells)
+    Reset(cells);
+
+  for (int i = 0; i < cells; i++)
+    {
+    int mv = voltages[i] * 1000 + 0.5;
+    m_values[i] = (mv < 0) ? 0 : (mv > 0xffff) ? 0xffff : mv;
+    }
+
+  // Encode time & cell deltas to the previous series:
+  m_enc.clear();
+  put_varint(m_enc, zigzag_encode(now - m_lasttime));
+  for (int i = 0; i < cells; i++)
+    put_varint(m_enc, zigzag_encode((int32_t)m_values[i] - m_last[i]));
+
+  if (RingAppend(m_enc.data(), m_enc.size()))
+    {
+    m_last = m_values;
+    m_lasttime = now;
+    }
+
+  AggAdd(m_agg_minute, now, m_values);
+  AggAdd(m_agg_hour, now, m_values);
+  m_series_total++;
+  }
+
+/**
+ * RingAppend: add a record, evict old records as necessary
+ */
+bool OvmsBmsCellHistory::RingAppend(const uint8_t* data, size_t len)
+  {
+  if (!m_ring || len > m_ringsize)
+    return false;
+
+  // Evict oldest records into the base vector:
+  while (m_ringsize - m_used < len)
+    {
+    size_t reclen = RingDecode(m_tail, &m_basetime, m_base);
+    m_tail = (m_tail + reclen) % m_ringsize;
+    m_used -= reclen;
+    m_records--;
+    }
+
+  size_t head = (m_tail + m_used) % m_ringsize;
+  size_t part = std::min(len, m_ringsize - head);
+  memcpy(m_ring + head, data, part);
+  if (part < len)
+    memcpy(m_ring, data + part, len - part);
+  m_used += len;
+  m_records++;
+  return true;
+  }
+
+/**
+ * RingDecode: apply the record at pos to time & values, return record length
+ */
+size_t OvmsBmsCellHistory::RingDecode(size_t pos, time_t* time, std::vector<uint16_t>& values)
+  {
+  size_t len = 0;
+  auto get_varint = [&]() -> uint32_t
+    {
+    uint32_t val = 0;
+    int shift = 0;
+    uint8_t b;
+    do
+      {
+      b = m_ring[(pos + len++) % m_ringsize];
+      val |= (uint32_t)(b & 0x7f) << shift;
+      shift += 7;
+      } while ((b & 0x80) && shift < 35);
+    return val;
+    };
+
+  *time += zigzag_decode(get_varint());
+  for (int i = 0; i < m_cells; i++)
+    values[i] += zigzag_decode(get_varint());
+  return len;
+  }
+
+void OvmsBmsCellHistory::AggReset(Aggregate& agg)
+  {
+  agg.start = 0;
+  agg.samples = 0;
+  agg.min.assign(m_cells, 0xffff);
+  agg.max.assign(m_cells, 0);
+  agg.sum.assign(m_cells, 0);
+  }
+
+void OvmsBmsCellHistory::AggAdd(Aggregate& agg, time_t now, const std::vector<uint16_t>& values)
+  {
+  time_t start = now - (now % agg.interval);
+  if (agg.samples && agg.start != start)
+    AggClose(agg, (agg.interval == 60) ? BmsHist_Minute : BmsHist_Hour);
+  agg.start = start;
+  for (int i = 0; i < m_cells; i++)
+    {
+    if (values[i] < agg.min[i]) agg.min[i] = values[i];
+    if (values[i] > agg.max[i]) agg.max[i] = values[i];
+    agg.sum[i] += values[i];
+    }
+  agg.samples++;
+  }
+
+/**
+ * AggClose: queue the aggregate record for the SD & restart the aggregation
+ */
+void OvmsBmsCellHistory::AggClose(Aggregate& agg, bms_hist_tier_t tier)
+  {
+  if (agg.samples == 0)
+    return;
+
+  size_t reclen = sizeof(bms_hist_aggrec_t) + m_cells * sizeof(bms_hist_cellagg_t);
+  if (m_pending_size + reclen > 2 * 61 * reclen)
+    {
+    m_dropped++;
+    }
+  else
+    {
+    bms_hist_buffer_t& buf = m_pending[FileName(m_path, tier, agg.start)];
+    size_t pos = buf.size();
+    buf.resize(pos + reclen);
+    bms_hist_aggrec_t* rec = (bms_hist_aggrec_t*) &buf[pos];
+    rec->time = agg.start;
+    rec->cells = m_cells;
+    rec->samples = LIMIT_MAX(agg.samples, 0xffff);
+    bms_hist_cellagg_t* cell = (bms_hist_cellagg_t*) (rec + 1);
+    for (int i = 0; i < m_cells; i++)
+      {
+      cell[i].min = agg.min[i];
+      cell[i].max = agg.max[i];
+      cell[i].avg = (agg.sum[i] + agg.samples/2) / agg.samples;
+      }
+    m_pending_size += reclen;
+    }
+
+  AggReset(agg);
+  }
+
+std::string OvmsBmsCellHistory::FileName(const std::string& path, bms_hist_tier_t tier, time_t time)
+  {
+  struct tm tm;
+  char name[32];
+  gmtime_r(&time, &tm);
+  if (tier == BmsHist_Hour)
+    snprintf(name, sizeof(name), "/%04d%02d.bhh", tm.tm_year+1900, tm.tm_mon+1);
+  else
+    snprintf(name, sizeof(name), "/%04d%02d%02d.bhm", tm.tm_year+1900, tm.tm_mon+1, tm.tm_mday);
+  return path + name;
+  }
+
+/**
+ * Ticker: close finished intervals, flush pending records when due
+ *  (called once per second from the vehicle ticker)
+ */
+void OvmsBmsCellHistory::Ticker(time_t now)
+  {
+  bool flush;
+  if (!m_mutex.Lock(0))
+    return;
+  if (now >= BMSHIST_TIME_VALID)
+    {
+    time_t hour = now - (now % 3600);
+    if (hour != m_stat_hour)
+      {
+      m_stat_hour = hour;
+      m_sd_writes_lasthour = m_sd_writes_hour;
+      m_sd_bytes_lasthour = m_sd_bytes_hour;
+      m_sd_writes_hour = 0;
+      m_sd_bytes_hour = 0;
+      }
+    if (m_enabled)
+      {
+      if (m_agg_minute.samples && now >= m_agg_minute.start + m_agg_minute.interval)
+        AggClose(m_agg_minute, BmsHist_Minute);
+      if (m_agg_hour.samples && now >= m_agg_hour.start + m_agg_hour.interval)
+        AggClose(m_agg_hour, BmsHist_Hour);
+      }
+    }
+  flush = !m_pending.empty() && (!m_enabled || now >= m_last_flush + m_flush_interval * 60);
+  m_mutex.Unlock();
+
+  if (flush)
+    Flush(now);
+  }
+
+/**
+ * Close: close the running intervals and write all pending records
+ *  (called on shutdown, as the intervals would be lost otherwise)
+ */
+void OvmsBmsCellHistory::Close(time_t now)
+  {
+  m_mutex.Lock();
+  if (m_enabled)
+    {
+    AggClose(m_agg_minute, BmsHist_Minute);
+    AggClose(m_agg_hour, BmsHist_Hour);
+    }
+  m_mutex.Unlock();
+  Flush(now);
+  }
+
+/**
+ * Flush: append pending aggregate records to their files
+ *  Records are kept for the next flush if the SD is not available.
+ */
+void OvmsBmsCellHistory::Flush(time_t now)
+  {
+  std::map<std::string, bms_hist_buffer_t> pending;
+  std::string path;
+
+  m_mutex.Lock();
+  m_last_flush = now;
+  pending.swap(m_pending);
+  m_pending_size = 0;
+  path = m_path;
+  m_mutex.Unlock();
+
+  if (pending.empty())
+    return;
+
+  bool available = true;
+#ifdef CONFIG_OVMS_COMP_SDCARD
+  if (startsWith(path, "/sd") && (!MyPeripherals || !MyPeripherals->m_sdcard || !MyPeripherals->m_sdcard->isavailable()))
+    available = false;
+#endif // #ifdef CONFIG_OVMS_COMP_SDCARD
+  if (available && !path_exists(path) && mkpath(path) != 0)
+    {
+    ESP_LOGE(TAG, "Cannot create directory '%s'", path.c_str());
+    available = false;
+    }
+
+  uint32_t writes = 0, bytes = 0, errors = 0;
+  for (auto it = pending.begin(); available && it != pending.end(); )
+    {
+    FILE* fp = fopen(it->first.c_str(), "a");
+    if (!fp || fwrite(it->second.data(), it->second.size(), 1, fp) != 1)
+      {
+      ESP_LOGE(TAG, "Write to '%s' failed", it->first.c_str());
+      errors++;
+      if (fp) fclose(fp);
+      break;
+      }
+    fclose(fp);
+    writes++;
+    bytes += it->second.size();
+    it = pending.erase(it);
+    }
+
+  m_mutex.Lock();
+  m_sd_writes_hour += writes;
+  m_sd_writes_total += writes;
+  m_sd_bytes_hour += bytes;
+  m_sd_bytes_total += bytes;
+  m_sd_errors += errors;
+  // Requeue unwritten records in front of newer ones:
+  for (auto& p : pending)
+    {
+    bms_hist_buffer_t& buf = m_pending[p.first];
+    buf.insert(buf.begin(), p.second.begin(), p.second.end());
+    m_pending_size += p.second.size();
+    }
+  m_mutex.Unlock();
+  }
+
+void OvmsBmsCellHistory::Status(OvmsWriter* writer)
+  {
+  OvmsMutexLock lock(&m_mutex);
+  char from[24] = "-", to[24] = "-";
+  struct tm tm;
+
+  writer->printf("BMS cell history: %s\n", m_enabled ? "enabled" : "disabled");
+  if (!m_enabled && m_pending.empty())
+    return;
+
+  size_t cellsize = m_cells * (4 * sizeof(uint16_t) + 2 * (2 * sizeof(uint16_t) + sizeof(uint32_t)));
+  writer->printf("  Cells: %d\n", m_cells);
+  if (m_records > 0)
+    {
+    time_t t = m_basetime;
+    std::vector<uint16_t> values(m_base);
+    RingDecode(m_tail, &t, values);
+    gmtime_r(&t, &tm);
+    strftime(from, sizeof(from), "%Y-%m-%d %H:%M:%S", &tm);
+    gmtime_r(&m_lasttime, &tm);
+    strftime(to, sizeof(to), "%Y-%m-%d %H:%M:%S", &tm);
+    }
+  writer->printf("  RAM tier: %d series, %u/%u bytes (%u bytes/series), %s .. %s UTC\n",
+    m_records, m_used, m_ringsize, m_records ? m_used / m_records : 0, from, to);
+  writer->printf("  Memory: %u bytes (ring %u, cell buffers %u, pending %u)\n",
+    m_ringsize + cellsize + m_enc.capacity() + m_pending_size,
+    m_ringsize, cellsize + m_enc.capacity(), m_pending_size);
+  writer->printf("  Series recorded: %u, aggregates dropped: %u\n", m_series_total, m_dropped);
+
+  size_t reclen = sizeof(bms_hist_aggrec_t) + m_cells * sizeof(bms_hist_cellagg_t);
+  writer->printf("  SD path: %s, flush every %d min, %u bytes in %u files pending\n",
+    m_path.c_str(), m_flush_interval, m_pending_size, m_pending.size());
+  writer->printf("  SD writes: %u appends / %u bytes this hour, %u / %u last hour, %u / %u total, %u errors\n",
+    m_sd_writes_hour, m_sd_bytes_hour, m_sd_writes_lasthour, m_sd_bytes_lasthour,
+    m_sd_writes_total, m_sd_bytes_total, m_sd_errors);
+  writer->printf("  SD write bound: %d appends / %u bytes per hour\n",
+    (60 + m_flush_interval - 1) / m_flush_interval + 2, 61 * reclen);
+  }
+
+/**
+ * Query: output a time range of selected cells (empty = all) as text or JSON
+ *  RAM tier rows contain the cell voltages, aggregate rows avg/min/max per cell.
+ *  Voltages are output in V, missing cells as null / "-".
+ */
+bool OvmsBmsCellHistory::Query(OvmsWriter* writer, bms_hist_tier_t tier, time_t from, time_t to,
+    const std::vector<int>& cells, int maxrows, bool json)
+  {
+  std::vector<int> sel;
+  std::vector<uint32_t, ExtRamAllocator<uint32_t>> times;
+  std::vector<uint16_t, ExtRamAllocator<uint16_t>> values;
+  std::map<std::string, bms_hist_buffer_t> pending;
+  std::string path;
+  int fields = (tier == BmsHist_RAM) ? 1 : 3;
+  bool truncated = false;
+
+  // Nothing is recorded before the clock has been set:
+  if (from < BMSHIST_TIME_VALID)
+    from = BMSHIST_TIME_VALID;
+
+  m_mutex.Lock();
+  if (!m_enabled)
+    {
+    m_mutex.Unlock();
+    if (json)
+      writer->puts("{\"error\":\"BMS cell history disabled\"}");
+    else
+      writer->puts("ERROR: BMS cell history disabled");
+    return false;
+    }
+  for (int c : cells)
+    {
+    if (c >= 0 && c < m_cells)
+      sel.push_back(c);
+    }
+  if (cells.empty())
+    {
+    for (int c = 0; c < m_cells; c++)
+      sel.push_back(c);
+    }
+  int stride = sel.size() * fields;
+  if (stride && maxrows > BMSHIST_MAX_VALUES / stride)
+    maxrows = BMSHIST_MAX_VALUES / stride;
+
+  if (tier == BmsHist_RAM)
+    {
+    // Decode the ring:
+    time_t t = m_basetime;
+    std::vector<uint16_t> cur(m_base);
+    size_t pos = m_tail;
+    for (int r = 0; r < m_records; r++)
+      {
+      pos = (pos + RingDecode(pos, &t, cur)) % m_ringsize;
+      if (t < from) continue;
+      if (t > to) break;
+      if ((int)times.size() >= maxrows) { truncated = true; break; }
+      times.push_back(t);
+      for (int c : sel)
+        values.push_back(cur[c]);
+      }
+    }
+  else
+    {
+    // Copy pending records, files are read unlocked:
+    pending = m_pending;
+    path = m_path;
+    }
+  m_mutex.Unlock();
+
+  if (tier != BmsHist_RAM)
+    {
+    std::vector<uint8_t> rec;
+    auto add_row = [&](const bms_hist_aggrec_t* hdr, const bms_hist_cellagg_t* agg) -> bool
+      {
+      if ((time_t)hdr->time < from || (time_t)hdr->time > to)
+        return true;
+      if ((int)times.size() >= maxrows)
+        {
+        truncated = true;
+        return false;
+        }
+      times.push_back(hdr->time);
+      for (int c : sel)
+        {
+        if (c < hdr->cells)
+          {
+          values.push_back(agg[c].avg);
+          values.push_back(agg[c].min);
+          values.push_back(agg[c].max);
+          }
+        else
+          values.insert(values.end(), 3, 0);
+        }
+      return true;
+      };
+
+    // Collect the existing & pending files in the time range. The names sort
+    //  in time order, so the range check can compare names:
+    std::string first = FileName(path, tier, from), last = FileName(path, tier, to);
+    const char* suffix = (tier == BmsHist_Hour) ? ".bhh" : ".bhm";
+    std::set<std::string> files;
+    DIR* dir = opendir(path.c_str());
+    if (dir)
+      {
+      struct dirent* dp;
+      while ((dp = readdir(dir)) != NULL)
+        {
+        std::string fn = path + "/" + dp->d_name;
+        if (endsWith(fn, suffix) && fn >= first && fn <= last)
+          files.insert(fn);
+        }
+      closedir(dir);
+      }
+    for (auto& it : pending)
+      {
+      if (it.first >= first && it.first <= last)
+        files.insert(it.first);
+      }
+
+    int filecnt = 0;
+    for (auto fit = files.begin(); fit != files.end() && !truncated; ++fit)
+      {
+      const std::string& fn = *fit;
+      if (++filecnt > BMSHIST_MAX_DAYS)
+        {
+        truncated = true;
+        break;
+        }
+
+      FILE* fp = fopen(fn.c_str(), "r");
+      bms_hist_aggrec_t hdr;
+      while (fp && fread(&hdr, sizeof(hdr), 1, fp) == 1)
+        {
+        rec.resize(hdr.cells * sizeof(bms_hist_cellagg_t));
+        if (hdr.cells && fread(rec.data(), rec.size(), 1, fp) != 1)
+          break;
+        if (!add_row(&hdr, (const bms_hist_cellagg_t*) rec.data()))
+          break;
+        if ((time_t)hdr.time > to)
+          break;
+        }
+      if (fp) fclose(fp);
+
+      auto it = pending.find(fn);
+      if (it == pending.end()) continue;
+      const uint8_t* p = it->second.data();
+      const uint8_t* end = p + it->second.size();
+      while (p + sizeof(bms_hist_aggrec_t) <= end)
+        {
+        const bms_hist_aggrec_t* ph = (const bms_hist_aggrec_t*) p;
+        p += sizeof(bms_hist_aggrec_t) + ph->cells * sizeof(bms_hist_cellagg_t);
+        if (p > end || !add_row(ph, (const bms_hist_cellagg_t*) (ph + 1)))
+          break;
+        }
+      }
+    }
+
+  // Output:
+  char ts[24];
+  struct tm tm;
+  if (json)
+    {
+    writer->printf("{\"tier\":\"%s\",\"from\":%ld,\"to\":%ld,\"cells\":[", tier_names[tier], (long)from, (long)to);
+    for (int i = 0; i < (int)sel.size(); i++)
+      writer->printf("%s%d", i ? "," : "", sel[i]+1);
+    writer->printf("],\"fields\":%s,\"rows\":[",
+      (tier == BmsHist_RAM) ? "[\"v\"]" : "[\"avg\",\"min\",\"max\"]");
+    for (int r = 0; r < (int)times.size(); r++)
+      {
+      writer->printf("%s\n[%u", r ? "," : "", times[r]);
+      for (int k = 0; k < stride; k++)
+        {
+        uint16_t mv = values[r*stride + k];
+        if (mv)
+          writer->printf(",%d.%03d", mv / 1000, mv % 1000);
+        else
+          writer->printf(",null");
+        }
+      writer->printf("]");
+      }
+    writer->printf("],\"truncated\":%s}\n", truncated ? "true" : "false");
+    }
+  else
+    {
+    writer->printf("Tier %s, %u rows, %s [V]:\nTime (UTC)         ", tier_names[tier], times.size(),
+      (tier == BmsHist_RAM) ? "cell voltages" : "cell avg/min/max");
+    for (int c : sel)
+      writer->printf(" %*d", (fields == 1) ? 5 : 17, c+1);
+    writer->puts("");
+    for (int r = 0; r < (int)times.size(); r++)
+      {
+      time_t t = times[r];
+      gmtime_r(&t, &tm);
+      strftime(ts, sizeof(ts), "%Y-%m-%d %H:%M:%S", &tm);
+      writer->printf("%s", ts);
+      for (int k = 0; k < stride; k++)
+        {
+        uint16_t mv = values[r*stride + k];
+        const char* sep = (fields == 1 || k % 3 == 0) ? " " : "/";
+        if (mv)
+          writer->printf("%s%d.%03d", sep, mv / 1000, mv % 1000);
+        else
+          writer->printf("%s%5s", sep, "-");
+        }
+      writer->puts("");
+      }
+    if (truncated)
+      writer->puts("[truncated, narrow time range or cell selection]");
+    }
+
+  return true;
+  }
+
+bool OvmsBmsCellHistory::ParseTier(const char* spec, bms_hist_tier_t* tier)
+  {
+  for (int i = 0; i < 3; i++)
+    {
+    if (*spec && strncmp(spec, tier_names[i], strlen(spec)) == 0)
+      {
+      *tier = (bms_hist_tier_t) i;
+      return true;
+      }
+    }
+  return false;
+  }
+
+/**
+ * ParseCells: parse a cell selection like "1,4,7-12" (1 based) or "all"
+ */
+bool OvmsBmsCellHistory::ParseCells(const char* spec, std::vector<int>& cells)
+  {
+  cells.clear();
+  if (!spec || !*spec || strcmp(spec, "all") == 0)
+    return true;
+  const char* p = spec;
+  while (*p)
+    {
+    char* end;
+    long lo = strtol(p, &end, 10), hi = lo;
+    if (end == p || lo < 1) return false;
+    p = end;
+    if (*p == '-')
+      {
+      hi = strtol(++p, &end, 10);
+      if (end == p || hi < lo || hi - lo > 1000) return false;
+      p = end;
+      }
+    for (long c = lo; c <= hi; c++)
+      cells.push_back(c - 1);
+    if (*p == ',') p++;
+    else if (*p) return false;
+    }
+  return true;
+  }
+
+/**
+ * ParseTime: parse "now", a relative time "-<n>[smhd]" or a UTC timestamp
+ */
+bool OvmsBmsCellHistory::ParseTime(const char* spec, time_t now, time_t* result)
+  {
+  char* end;
+  if (!spec || !*spec || strcmp(spec, "now") == 0)
+    {
+    *result = now;
+    return true;
+    }
+  long val = strtol(spec, &end, 10);
+  if (end == spec)
+    return false;
+  if (spec[0] != '-')
+    {
+    if (*end) return false;
+    *result = val;
+    return true;
+    }
+  switch (*end)
+    {
+    case 0:
+    case 's': break;
+    case 'm': val *= 60; break;
+    case 'h': val *= 3600; break;
+    case 'd': val *= 86400; break;
+    default: return false;
+    }
+  *result = now + val;
+  return true;
+  }
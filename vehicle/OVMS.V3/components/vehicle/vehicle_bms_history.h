@@ -0,0 +1,168 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Date:          14th March 2017
+;
+;    Changes:
+;    1.0  Initial release
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2017  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+#ifndef __VEHICLE_BMS_HISTORY_H__
+#define __VEHICLE_BMS_HISTORY_H__
+
+#include <time.h>
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+#include "ovms.h"
+#include "ovms_command.h"
+#include "ovms_mutex.h"
+
+/**
+ * OvmsBmsCellHistory: cell voltage history store
+ *
+ * Tiers:
+ *  - RAM: every completed series, delta encoded (per cell against the previous
+ *    series, zigzag varints in mV) in a fixed size ring. Evicted records are
+ *    folded into a base vector, so the ring can always be decoded from the tail.
+ *  - Minute / hour: per cell min/max/avg aggregates, buffered in RAM and appended
+ *    to daily (minute) / monthly (hour) files in the configured directory every
+ *    flush interval.
+ *
+ * SD writes per hour are bounded by (60 / flush interval) + 2 file appends
+ * of 61 × (8 + 6 × cells) bytes in total. Pending records are kept while the
+ * SD is unavailable, up to two hours worth, newer records are dropped then.
+ */
+
+#define BMSHIST_TIME_VALID        1500000000  // Don't record before the clock has been set
+#define BMSHIST_DEF_RAMSIZE       32768       // Default RAM ring size [bytes]
+#define BMSHIST_DEF_FLUSH         10          // Default SD flush interval [minutes]
+#define BMSHIST_DEF_PATH          "/sd/bmshist"
+#define BMSHIST_MAX_VALUES        16000       // Query result size limit [cell values]
+#define BMSHIST_MAX_DAYS          400         // Query file scan limit [files]
+
+typedef enum
+  {
+  BmsHist_RAM = 0,                          // Full series, RAM ring
+  BmsHist_Minute,                           // Per minute aggregates, SD
+  BmsHist_Hour,                             // Per hour aggregates, SD
+  } bms_hist_tier_t;
+
+// Aggregate file record: header followed by cells × bms_hist_cellagg_t
+typedef struct __attribute__ ((__packed__))
+  {
+  uint32_t time;                            // Interval start [UTC]
+  uint16_t cells;                           // Cell count
+  uint16_t samples;                         // Series aggregated
+  } bms_hist_aggrec_t;
+
+typedef struct __attribute__ ((__packed__))
+  {
+  uint16_t min;                             // [mV]
+  uint16_t max;                             // [mV]
+  uint16_t avg;                             // [mV]
+  } bms_hist_cellagg_t;
+
+typedef std::vector<uint8_t, ExtRamAllocator<uint8_t>> bms_hist_buffer_t;
+
+class OvmsBmsCellHistory
+  {
+  public:
+    OvmsBmsCellHistory();
+    ~OvmsBmsCellHistory();
+
+  public:
+    void Configure(bool enabled, size_t ramsize, const std::string& path, int flush_interval);
+    bool IsEnabled() { return m_enabled; }
+    void AddSeries(const float* voltages, int cells, time_t now);
+    void Ticker(time_t now);
+    void Flush(time_t now);
+    void Close(time_t now);
+    void Status(OvmsWriter* writer);
+    bool Query(OvmsWriter* writer, bms_hist_tier_t tier, time_t from, time_t to,
+               const std::vector<int>& cells, int maxrows, bool json);
+
+  public:
+    static bool ParseTier(const char* spec, bms_hist_tier_t* tier);
+    static bool ParseCells(const char* spec, std::vector<int>& cells);
+    static bool ParseTime(const char* spec, time_t now, time_t* result);
+
+  protected:
+    struct Aggregate
+      {
+      int interval;                         // [seconds]
+      time_t start;
+      int samples;
+      std::vector<uint16_t> min, max;
+      std::vector<uint32_t> sum;
+      };
+
+  protected:
+    void Reset(int cells);
+    void FreeRing();
+    bool RingAppend(const uint8_t* data, size_t len);
+    size_t RingDecode(size_t pos, time_t* time, std::vector<uint16_t>& values);
+    void AggReset(Aggregate& agg);
+    void AggAdd(Aggregate& agg, time_t now, const std::vector<uint16_t>& values);
+    void AggClose(Aggregate& agg, bms_hist_tier_t tier);
+    static std::string FileName(const std::string& path, bms_hist_tier_t tier, time_t time);
+
+  protected:
+    OvmsMutex m_mutex;
+    bool m_enabled;
+    std::string m_path;
+    int m_flush_interval;                   // [minutes]
+    int m_cells;
+
+    // RAM tier:
+    uint8_t* m_ring;
+    size_t m_ringsize;
+    size_t m_tail;                          // Oldest record position
+    size_t m_used;                          // Bytes used
+    int m_records;
+    std::vector<uint16_t> m_base;           // Values before the oldest record [mV]
+    time_t m_basetime;
+    std::vector<uint16_t> m_last;           // Values of the newest record [mV]
+    time_t m_lasttime;
+    std::vector<uint16_t> m_values;         // Conversion buffer [mV]
+    std::vector<uint8_t> m_enc;             // Encoding buffer
+
+    // Aggregate tiers:
+    Aggregate m_agg_minute;
+    Aggregate m_agg_hour;
+    std::map<std::string, bms_hist_buffer_t> m_pending;   // Pending SD records by file
+    size_t m_pending_size;
+    time_t m_last_flush;
+
+    // Statistics:
+    time_t m_stat_hour;
+    uint32_t m_series_total;
+    uint32_t m_sd_writes_hour, m_sd_writes_lasthour, m_sd_writes_total;
+    uint32_t m_sd_bytes_hour, m_sd_bytes_lasthour, m_sd_bytes_total;
+    uint32_t m_sd_errors;
+    uint32_t m_dropped;
+  };
+
+#endif //#ifndef __VEHICLE_BMS_HISTORY_H__
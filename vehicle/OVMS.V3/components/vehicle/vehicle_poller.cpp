@@ -33,6 +33,8 @@ static const char *TAG = "vehicle";
 
 #include <stdio.h>
 #include <algorithm>
+#include "esp_timer.h"
+#include "rom/ets_sys.h"
 #include <ovms_command.h>
 #include <ovms_script.h>
 #include <ovms_metrics.h>
@@ -84,6 +86,10 @@ void OvmsVehicle::PollerStateTicker()
  *    Byte position of this frame's payload part in the response, 0 = first frame
  *  @member m_poll_plcur
  *    Pointer to the currently processed poll entry
+ *  
+ *  With concurrent polling (see PollSetConcurrency()), responses from different ECUs
+ *  may interleave. The members above then reflect the request the frame belongs to,
+ *  use m_poll_moduleid_low to tell the responding ECU apart.
  */
 void OvmsVehicle::IncomingPollReply(canbus* bus, uint16_t type, uint16_t pid, uint8_t* data, uint8_t length, uint16_t mlremain)
   {
@@ -156,80 +162,1111 @@ void OvmsVehicle::PollSetPidList(canbus* bus, const poll_pid_t* plist)
   OvmsRecMutexLock lock(&m_poll_mutex);
   m_poll_bus = bus;
   m_poll_bus_default = bus;
+  bool newlist = (plist != m_poll_plist);
   m_poll_plist = plist;
+  if (bus && m_registeredlistener)
+    MyCan.AddListenerBus(m_rxqueue, bus);
   m_poll_ticker = 0;
   m_poll_sequence_cnt = 0;
   m_poll_wait = 0;
   m_poll_plcur = NULL;
   m_poll_txmsgid = 0;
+  size_t cnt = 0;
+  if (plist)
+    {
+    while (plist[cnt].txmoduleid != 0) cnt++;
+    }
+  m_poll_done.assign(cnt, false);
+  if (newlist || m_poll_timing.size() != cnt)
+    {
+    poll_timing_t init = {};
+    m_poll_timing.assign(cnt, init);
+    }
+  if (newlist || m_poll_stats.size() != cnt)
+    {
+    poll_stats_t init = {};
+    m_poll_stats.assign(cnt, init);
+    }
+  m_poll_cycle_sent = 0;
+  PollerResetSessions();
+  PollerResetSchedule();
+  }
+
+
+/**
+ * PollSetState: set the polling state
+ *  Call this to change the polling state and restart the current polling list.
+ *  This won't do anything if the state is already active. The state is changed without
+ *  waiting for pending responses to finish (except PollSingleRequests).
+ *  
+ *  @param state
+ *    The polling state to activate (0 … VEHICLE_POLL_NSTATES)
+ */
+void OvmsVehicle::PollSetState(uint8_t state)
+  {
+  if ((state < VEHICLE_POLL_NSTATES)&&(state != m_poll_state))
+    {
+    OvmsRecMutexLock slock(&m_poll_single_mutex);
+    OvmsRecMutexLock lock(&m_poll_mutex);
+    m_poll_state = state;
+    m_poll_ticker = 0;
+    m_poll_sequence_cnt = 0;
+    m_poll_wait = 0;
+    m_poll_plcur = NULL;
+    m_poll_txmsgid = 0;
+    m_poll_done.assign(m_poll_done.size(), false);
+    PollerResetSessions();
+    PollerResetSchedule();
+    }
+  }
+
+
+/**
+ * PollSetThrottling: configure polling speed / niceness
+ *  If multiple requests are due at the same poll tick (second), this controls how many of
+ *  them will be sent in series without a delay, i.e. as soon as the response/timeout for
+ *  the previous request occurred.
+ *  
+ *  @param sequence_max
+ *    Polls allowed to be sent in sequence per time tick (second), default 1, 0 = no limit.
+ *  
+ *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ */
+void OvmsVehicle::PollSetThrottling(uint8_t sequence_max)
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+  m_poll_sequence_max = sequence_max;
+  }
+
+
+/**
+ * PollSetResponseSeparationTime: configure ISO TP multi frame response timing
+ *  See: https://en.wikipedia.org/wiki/ISO_15765-2
+ *  
+ *  @param septime
+ *    Separation Time (ST), the minimum delay time between frames. Default: 25 milliseconds
+ *    ST values up to 127 (0x7F) specify the minimum number of milliseconds to delay between frames,
+ *    while values in the range 241 (0xF1) to 249 (0xF9) specify delays increasing from
+ *    100 to 900 microseconds.
+ *  
+ *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ */
+void OvmsVehicle::PollSetResponseSeparationTime(uint8_t septime)
+  {
+  assert (septime <= 127 || (septime >= 241 && septime <= 249));
+  OvmsRecMutexLock lock(&m_poll_mutex);
+  m_poll_fc_septime = septime;
+  }
+
+
+/**
+ * PollSetFlowControl: configure ISO TP flow control for multi frame responses per ECU
+ *  Long responses (e.g. cell voltage blocks or ECU dumps) transfer faster with a short
+ *  separation time, but not all ECUs can handle that. This sets the flow control
+ *  parameters for a specific ECU, or the defaults for all ECUs without own parameters.
+ *  
+ *  In adaptive mode, the poller starts with the given separation time and shortens it
+ *  step by step (halving, then 500 µs and 0) as long as complete responses are received
+ *  and the transfer rate (bytes/s) increases. On a lost or incomplete response, it returns
+ *  to the last stable value (or increases the value if that fails as well) and keeps it.
+ *  Responses need at least 4 consecutive frames to be evaluated.
+ *  
+ *  Use "vehicle poller stats" to check the resulting timings and transfer rates.
+ *  
+ *  @param txid
+ *    ECU request ID (moduleid) or 0 to set the defaults. With adaptive default
+ *    timing, ECUs get added automatically on their first multi frame response.
+ *  @param blocksize
+ *    Block Size (BS), the number of consecutive frames to receive before sending the next
+ *    flow control frame. Default: 0 = all frames
+ *  @param septime
+ *    Separation Time (ST), see PollSetResponseSeparationTime()
+ *  @param adaptive
+ *    true = find the shortest stable separation time, starting at septime
+ *  
+ *  @return             false if no slot for another ECU is available
+ *                      (see VEHICLE_POLL_MAXFLOWCTRL)
+ *  
+ *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ */
+bool OvmsVehicle::PollSetFlowControl(uint32_t txid, uint8_t blocksize, uint8_t septime, bool adaptive /*=false*/)
+  {
+  assert (septime <= 127 || (septime >= 241 && septime <= 249));
+  OvmsRecMutexLock lock(&m_poll_mutex);
+  if (txid == 0)
+    {
+    m_poll_fc_blocksize = blocksize;
+    m_poll_fc_septime = septime;
+    m_poll_fc_adaptive = adaptive;
+    return true;
+    }
+  poll_fc_t* fc = PollerGetFlowControl(txid, true);
+  if (!fc)
+    return false;
+  fc->blocksize = blocksize;
+  fc->septime = septime;
+  fc->st_stable = septime;
+  fc->rate_stable = 0;
+  fc->adaptive = adaptive ? 1 : 0;
+  return true;
+  }
+
+
+/**
+ * PollSetConcurrency: configure parallel polling of multiple ECUs
+ *  By default, the poller processes one request at a time. With concurrency enabled,
+ *  requests to different ECUs (TX/RX ID pairs) are sent without waiting for outstanding
+ *  responses of other ECUs, so a poll cycle covering multiple ECUs completes faster.
+ *  Requests to the same ECU are still serialized, as are requests with overlapping
+ *  response ID ranges (e.g. broadcasts). Poll entries may then complete out of list order.
+ *  
+ *  Only enable this if your IncomingPollReply() handler can cope with interleaved
+ *  responses, i.e. does not assemble multi frame responses in a single shared buffer.
+ *  
+ *  Throttling (PollSetThrottling()) still limits the total number of requests per tick,
+ *  set it to 0 to let concurrency and the ECU interval control the load.
+ *  
+ *  @param sessions
+ *    Requests allowed in parallel per bus, 0 = serial polling (default),
+ *    at most VEHICLE_POLL_MAXSESSIONS ECUs are tracked in total.
+ *  @param ecu_interval_ms
+ *    Default minimum time between two requests to the same ECU in milliseconds,
+ *    0 = no limit. Use PollSetEcuInterval() to set individual ECU intervals.
+ *  
+ *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ */
+void OvmsVehicle::PollSetConcurrency(uint8_t sessions, uint16_t ecu_interval_ms /*=0*/)
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+  m_poll_concurrency = LIMIT_MAX(sessions, VEHICLE_POLL_MAXSESSIONS);
+  m_poll_ecu_interval = ecu_interval_ms;
+  }
+
+
+/**
+ * PollSetEcuInterval: set the minimum time between two requests to an ECU
+ *  Use this to protect ECUs that cannot handle requests in quick succession,
+ *  while polling other ECUs at full speed. The interval applies to poll list
+ *  requests with concurrency enabled (see PollSetConcurrency()).
+ *  
+ *  @param txid
+ *    ECU request ID (moduleid) or 0 to set the default interval for all ECUs
+ *  @param interval_ms
+ *    Minimum time between two requests in milliseconds, 0 = no limit,
+ *    VEHICLE_POLL_DEFINTERVAL = use the default interval
+ *  
+ *  @return             false if no slot for another ECU is available
+ *                      (see VEHICLE_POLL_MAXFLOWCTRL)
+ *  
+ *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ */
+bool OvmsVehicle::PollSetEcuInterval(uint32_t txid, uint16_t interval_ms)
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+  if (txid == 0)
+    {
+    m_poll_ecu_interval = (interval_ms == VEHICLE_POLL_DEFINTERVAL) ? 0 : interval_ms;
+    return true;
+    }
+  poll_fc_t* fc = PollerGetFlowControl(txid, true);
+  if (!fc)
+    return false;
+  fc->interval = interval_ms;
+  return true;
+  }
+
+
+/**
+ * PollSetTimeBase: configure millisecond poll scheduling
+ *  By default, poll intervals (poll_pid_t.polltime) are given in seconds and the poll list
+ *  is processed once per second. With a time base set, the intervals are interpreted
+ *  as milliseconds (max 65535) and the poller is driven by a dedicated timer, so values
+ *  can be sampled faster than 1 Hz. Due entries are sent earliest deadline first,
+ *  throttling (PollSetThrottling()) then applies per timer tick.
+ *  
+ *  The time base defines the scheduling resolution, intervals should be multiples of it.
+ *  Response timeouts are then checked on every timer tick, measured from the request
+ *  or the last response frame (see VEHICLE_POLL_WAIT_MS). Use "vehicle poller timing"
+ *  to check the resulting send delays (jitter).
+ *  
+ *  Note: the poll list needs to be set by PollSetPidList() for this mode.
+ *  
+ *  @param tick_ms
+ *    Poll timer period in milliseconds, 0 = second based polling (default).
+ *  
+ *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ */
+void OvmsVehicle::PollSetTimeBase(uint16_t tick_ms)
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+  m_poll_timebase = tick_ms;
+  if (tick_ms)
+    {
+    TickType_t ticks = pdMS_TO_TICKS(tick_ms);
+    if (ticks == 0) ticks = 1;
+    if (!m_poll_timer)
+      {
+      m_poll_timer = xTimerCreate("Vehicle poller", ticks, pdTRUE, this, PollerTimerCallback);
+      xTimerStart(m_poll_timer, 0);
+      }
+    else
+      {
+      xTimerChangePeriod(m_poll_timer, ticks, 0);
+      }
+    }
+  else if (m_poll_timer)
+    {
+    xTimerStop(m_poll_timer, 0);
+    }
+  PollerResetSchedule();
+  }
+
+
+/**
+ * PollerResetSchedule: internal: make all entries due for the millisecond scheduler
+ */
+void OvmsVehicle::PollerResetSchedule()
+  {
+  uint32_t now = esp_log_timestamp();
+  for (poll_timing_t& t : m_poll_timing)
+    t.due = now;
+  }
+
+
+/**
+ * PollerTimingStatus: output millisecond schedule timing statistics
+ */
+void OvmsVehicle::PollerTimingStatus(int verbosity, OvmsWriter* writer, bool reset)
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+
+  if (reset)
+    {
+    for (poll_timing_t& t : m_poll_timing)
+      {
+      t.count = t.missed = t.lag_sum = t.lag_max = 0;
+      }
+    writer->puts("Poll timing statistics have been reset.");
+    return;
+    }
+
+  if (!m_poll_timebase)
+    {
+    writer->puts("Poll scheduling: second based (no millisecond time base set)");
+    return;
+    }
+  writer->printf("Poll scheduling: time base %u ms, state %u\n", m_poll_timebase, m_poll_state);
+  if (!m_poll_plist || m_poll_timing.empty())
+    {
+    writer->puts("No poll list");
+    return;
+    }
+
+  writer->puts("  #  TXID    Type PID   Interval      Count   Missed  Lag avg   max");
+  for (size_t i = 0; i < m_poll_timing.size(); i++)
+    {
+    const poll_pid_t* entry = &m_poll_plist[i];
+    const poll_timing_t* t = &m_poll_timing[i];
+    if (entry->polltime[m_poll_state] == 0 && verbosity < COMMAND_RESULT_NORMAL)
+      continue;
+    writer->printf("%3u  %-7x %02X   %-5X %6u ms %10u %8u %6.1f %5u ms\n",
+      (unsigned)i, entry->txmoduleid, entry->type, entry->pid, entry->polltime[m_poll_state],
+      t->count, t->missed, t->count ? (float)t->lag_sum / t->count : 0.0f, t->lag_max);
+    }
+  }
+
+
+/**
+ * ISO TP separation time (STmin) utilities
+ */
+static uint32_t poll_septime_us(uint8_t st)
+  {
+  if (st <= 0x7f)
+    return st * 1000;
+  else if (st >= 0xf1 && st <= 0xf9)
+    return (st - 0xf0) * 100;
+  else
+    return 127000; // reserved values: use maximum
+  }
+
+static uint8_t poll_septime_faster(uint8_t st)
+  {
+  if (st >= 2 && st <= 0x7f)
+    return st / 2;
+  else if (st == 1)
+    return 0xf5; // 500 µs
+  else if (st >= 0xf1 && st <= 0xf9)
+    return 0;
+  else if (st == 0)
+    return 0;
+  else
+    return 0x7f;
+  }
+
+static uint8_t poll_septime_slower(uint8_t st)
+  {
+  if (st == 0)
+    return 0xf5;
+  else if (st >= 0xf1 && st <= 0xf9)
+    return 1;
+  else if (st < 0x40)
+    return st * 2;
+  else
+    return 0x7f;
+  }
+
+static void poll_format_septime(char* buf, size_t size, uint8_t st)
+  {
+  uint32_t us = poll_septime_us(st);
+  if (us < 1000 && us > 0)
+    snprintf(buf, size, "%u us", us);
+  else
+    snprintf(buf, size, "%u ms", us / 1000);
+  }
+
+static TickType_t poll_septime_ticks(uint8_t st)
+  {
+  // at least one tick, as STmin is a minimum:
+  uint32_t ms = (poll_septime_us(st) + 999) / 1000;
+  TickType_t ticks = pdMS_TO_TICKS(ms);
+  return (ticks < 1) ? 1 : ticks;
+  }
+
+
+/**
+ * Round trip time histogram bin upper bounds [ms], the last bin collects all slower responses
+ */
+static const uint16_t poll_rtt_bins[VEHICLE_POLL_HISTBINS-1] = { 10, 20, 50, 100, 200, 500, 1000 };
+
+
+/**
+ * PollerGetStats: internal: get the statistics record of a poll list entry
+ *  
+ *  @return             Statistics or NULL if the entry is not part of the current list
+ *                      (e.g. a single request)
+ */
+OvmsVehicle::poll_stats_t* OvmsVehicle::PollerGetStats(const poll_pid_t* entry)
+  {
+  if (!entry || !m_poll_plist || entry < m_poll_plist || entry >= m_poll_plist + m_poll_stats.size())
+    return NULL;
+  return &m_poll_stats[entry - m_poll_plist];
+  }
+
+
+/**
+ * PollerCountFrame: internal: count a poll request/response frame
+ *  The bus time is estimated for an 8 byte standard frame including stuffing
+ *  (~130 bit times), which is sufficient to give a load indication.
+ */
+void OvmsVehicle::PollerCountFrame(canbus* bus, poll_stats_t* stats)
+  {
+  m_poll_total.frames++;
+  if (stats) stats->frames++;
+  uint32_t speed = bus ? MAP_CAN_SPEED(bus->m_speed) : 0;
+  if (speed)
+    m_poll_bustime += 130000000UL / speed;
+  }
+
+
+/**
+ * PollerUpdateMetrics: internal: update the poller metrics (called once per second)
+ */
+void OvmsVehicle::PollerUpdateMetrics()
+  {
+  uint32_t now = esp_log_timestamp();
+  uint32_t elapsed = now - m_poll_metrics_time;
+  if (elapsed < 1000)
+    return;
+  StandardMetrics.ms_m_poll_rate->SetValue(
+    (float)(m_poll_total.responses - m_poll_metrics_resp) * 1000 / elapsed);
+  StandardMetrics.ms_m_poll_busload->SetValue((float)m_poll_bustime / elapsed / 10);
+  StandardMetrics.ms_m_poll_timeouts->SetValue(m_poll_total.timeouts);
+  StandardMetrics.ms_m_poll_errors->SetValue(m_poll_total.errors);
+  m_poll_metrics_time = now;
+  m_poll_metrics_resp = m_poll_total.responses;
+  m_poll_bustime = 0;
+  }
+
+
+/**
+ * PollerResetStats: internal: clear all poller statistics
+ */
+void OvmsVehicle::PollerResetStats()
+  {
+  poll_stats_t init = {};
+  m_poll_stats.assign(m_poll_stats.size(), init);
+  m_poll_total = init;
+  m_poll_stats_since = esp_log_timestamp();
+  m_poll_cycle_count = m_poll_cycle_last = m_poll_cycle_max = m_poll_cycle_sum = 0;
+  m_poll_metrics_resp = 0;
+  for (int i = 0; i < VEHICLE_POLL_MAXFLOWCTRL; i++)
+    m_poll_fc[i].responses = m_poll_fc[i].failures = 0;
+  }
+
+
+/**
+ * PollerStatsStatus: output poller latency, error & throughput statistics
+ */
+void OvmsVehicle::PollerStatsStatus(int verbosity, OvmsWriter* writer, bool reset)
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+
+  if (reset)
+    {
+    PollerResetStats();
+    writer->puts("Poller statistics have been reset.");
+    return;
+    }
+
+  const poll_stats_t* t = &m_poll_total;
+  char st[16], st_stable[16];
+  writer->printf("Poller statistics for the last %u seconds:\n",
+    (esp_log_timestamp() - m_poll_stats_since) / 1000);
+  writer->printf("  Requests: %u, responses: %u, errors (NRC): %u, timeouts: %u, TX failures: %u\n",
+    t->requests, t->responses, t->errors, t->timeouts, t->txfails);
+  writer->printf("  Frames: %u, payload: %u bytes, max response size: %u bytes\n",
+    t->frames, t->bytes, t->size_max);
+  writer->printf("  Round trip: avg %.1f ms, max %u ms\n",
+    t->responses ? (float)t->rtt_sum / t->responses : 0.0f, t->rtt_max);
+  if (m_poll_cycle_count)
+    {
+    writer->printf("  Poll cycles: %u, duration last %u ms, avg %.1f ms, max %u ms\n",
+      m_poll_cycle_count, m_poll_cycle_last, (float)m_poll_cycle_sum / m_poll_cycle_count,
+      m_poll_cycle_max);
+    }
+
+  writer->puts("\nRound trip time histogram:");
+  for (int i = 0; i < VEHICLE_POLL_HISTBINS; i++)
+    {
+    if (i < VEHICLE_POLL_HISTBINS-1)
+      writer->printf("  < %4u ms: %8u\n", poll_rtt_bins[i], t->rtt_hist[i]);
+    else
+      writer->printf(" >= %4u ms: %8u\n", poll_rtt_bins[i-1], t->rtt_hist[i]);
+    }
+
+  bool fc_header = false;
+  for (int i = 0; i < VEHICLE_POLL_MAXFLOWCTRL; i++)
+    {
+    const poll_fc_t* fc = &m_poll_fc[i];
+    if (!fc->txid)
+      continue;
+    if (!fc_header)
+      {
+      writer->puts("\nFlow control:\n  TXID    BS  STmin    Mode      Stable   Rate B/s  Responses  Failures  Interval");
+      fc_header = true;
+      }
+    poll_format_septime(st, sizeof(st), fc->septime);
+    poll_format_septime(st_stable, sizeof(st_stable), fc->st_stable);
+    writer->printf("  %-7x %3u %-8s %-8s %-8s %8u %10u %9u  %u ms\n",
+      fc->txid, fc->blocksize, st,
+      (fc->adaptive == 0) ? "fixed" : (fc->adaptive == 1) ? "probing" : "settled",
+      fc->adaptive ? st_stable : "-", fc->rate, fc->responses, fc->failures,
+      (fc->interval == VEHICLE_POLL_DEFINTERVAL) ? m_poll_ecu_interval : fc->interval);
+    }
+
+  if (!m_poll_plist || m_poll_stats.empty() || verbosity < COMMAND_RESULT_NORMAL)
+    return;
+
+  writer->puts("\n  #  TXID    Type PID     Requests  Resp   Err   T/O  Size max  RTT avg   max");
+  for (size_t i = 0; i < m_poll_stats.size(); i++)
+    {
+    const poll_pid_t* entry = &m_poll_plist[i];
+    const poll_stats_t* s = &m_poll_stats[i];
+    if (s->requests == 0 && verbosity < COMMAND_RESULT_VERBOSE)
+      continue;
+    writer->printf("%3u  %-7x %02X   %-5X %10u %5u %5u %5u %9u %6.1f %5u ms\n",
+      (unsigned)i, entry->txmoduleid, entry->type, entry->pid,
+      s->requests, s->responses, s->errors, s->timeouts, s->size_max,
+      s->responses ? (float)s->rtt_sum / s->responses : 0.0f, s->rtt_max);
+    }
+  }
+
+
+/**
+ * PollerResetSessions: internal: abandon all outstanding requests
+ */
+void OvmsVehicle::PollerResetSessions()
+  {
+  memset(m_poll_session, 0, sizeof(m_poll_session));
+  m_poll_busy = 0;
+  m_poll_txsession = NULL;
+  PollerUpdateRxFilter();
+  }
+
+
+/**
+ * PollerUpdateRxFilter: internal: publish the response ID ranges of the active sessions
+ *  The RX task checks incoming frames against this snapshot without taking the poller
+ *  mutex (see PollerRxFilter()). Call with the poller mutex held after changing
+ *  the waiting state or response IDs of a session.
+ */
+void OvmsVehicle::PollerUpdateRxFilter()
+  {
+  poll_rxfilter_t filter[VEHICLE_POLL_MAXSESSIONS];
+  int cnt = 0;
+  for (int i = 0; i < VEHICLE_POLL_MAXSESSIONS; i++)
+    {
+    poll_session_t* s = &m_poll_session[i];
+    if (!s->wait || !s->bus)
+      continue;
+    filter[cnt].bus = s->bus;
+    filter[cnt].moduleid_low = s->moduleid_low;
+    filter[cnt].moduleid_high = s->moduleid_high;
+    filter[cnt].protocol = s->protocol;
+    cnt++;
+    }
+  portENTER_CRITICAL(&m_poll_rxfilter_lock);
+  memcpy(m_poll_rxfilter, filter, cnt * sizeof(poll_rxfilter_t));
+  m_poll_rxfilter_cnt = cnt;
+  portEXIT_CRITICAL(&m_poll_rxfilter_lock);
+  }
+
+
+/**
+ * PollerRxFilter: internal: quick check if a received frame may be a poll response
+ *  
+ *  @param frame        Received CAN frame
+ *  @param msgid        Output: response ID (including the extended address byte)
+ *  @return             true if the frame matches an active session
+ */
+bool OvmsVehicle::PollerRxFilter(const CAN_frame_t* frame, uint32_t* msgid)
+  {
+  bool match = false;
+  portENTER_CRITICAL(&m_poll_rxfilter_lock);
+  for (int i = 0; i < m_poll_rxfilter_cnt; i++)
+    {
+    const poll_rxfilter_t* f = &m_poll_rxfilter[i];
+    if (f->bus != frame->origin)
+      continue;
+    uint32_t id = (f->protocol == ISOTP_EXTADR)
+      ? (frame->MsgID << 8 | frame->data.u8[0])
+      : frame->MsgID;
+    if (id >= f->moduleid_low && id <= f->moduleid_high)
+      {
+      *msgid = id;
+      match = true;
+      break;
+      }
+    }
+  portEXIT_CRITICAL(&m_poll_rxfilter_lock);
+  return match;
+  }
+
+
+/**
+ * PollerFindSession: internal: find the active session a received frame belongs to
+ *  
+ *  @param frame        Received CAN frame
+ *  @param msgid        Output: response ID (including the extended address byte)
+ *  @return             Session or NULL if the frame is no poll response
+ */
+OvmsVehicle::poll_session_t* OvmsVehicle::PollerFindSession(const CAN_frame_t* frame, uint32_t* msgid)
+  {
+  for (int i = 0; i < VEHICLE_POLL_MAXSESSIONS; i++)
+    {
+    poll_session_t* s = &m_poll_session[i];
+    if (!s->wait || s->bus != frame->origin)
+      continue;
+    uint32_t id = (s->protocol == ISOTP_EXTADR)
+      ? (frame->MsgID << 8 | frame->data.u8[0])
+      : frame->MsgID;
+    if (id >= s->moduleid_low && id <= s->moduleid_high)
+      {
+      *msgid = id;
+      return s;
+      }
+    }
+  return NULL;
+  }
+
+
+/**
+ * PollerGetSession: internal: get a session for a new request
+ *  Sessions are kept per ECU after completion to apply the ECU request interval,
+ *  if all are in use, the least recently used idle session is taken over.
+ *  
+ *  @return             Session or NULL if the request cannot be sent now
+ */
+OvmsVehicle::poll_session_t* OvmsVehicle::PollerGetSession(canbus* bus, uint32_t txid, uint32_t rxlow, uint32_t rxhigh)
+  {
+  poll_session_t* ecu = NULL;
+  poll_session_t* lru = NULL;
+  uint32_t now = esp_log_timestamp();
+  int busy = 0;
+
+  for (int i = 0; i < VEHICLE_POLL_MAXSESSIONS; i++)
+    {
+    poll_session_t* s = &m_poll_session[i];
+    if (s->wait)
+      {
+      if (s->bus != bus)
+        continue;
+      // ECU busy or response IDs overlapping:
+      if (s->moduleid_sent == txid || (rxlow <= s->moduleid_high && rxhigh >= s->moduleid_low))
+        return NULL;
+      busy++;
+      }
+    else if (s->bus == bus && s->moduleid_sent == txid)
+      ecu = s;
+    else if (!lru || (now - s->lastsent) > (now - lru->lastsent))
+      lru = s;
+    }
+
+  if (m_poll_concurrency && busy >= m_poll_concurrency)
+    return NULL;
+  if (ecu)
+    {
+    poll_fc_t* fc = PollerGetFlowControl(txid, false);
+    uint16_t interval = (fc && fc->interval != VEHICLE_POLL_DEFINTERVAL) ? fc->interval : m_poll_ecu_interval;
+    if (interval && (now - ecu->lastsent) < interval)
+      return NULL;
+    }
+  return ecu ? ecu : lru;
+  }
+
+
+/**
+ * PollerLoadSession: internal: make a session the current poll context
+ *  The m_poll_… members reflect the request being processed for the application.
+ */
+void OvmsVehicle::PollerLoadSession(poll_session_t* session)
+  {
+  m_poll_bus = session->bus;
+  m_poll_protocol = session->protocol;
+  m_poll_moduleid_sent = session->moduleid_sent;
+  m_poll_moduleid_low = session->moduleid_low;
+  m_poll_moduleid_high = session->moduleid_high;
+  m_poll_txmsgid = session->txmsgid;
+  m_poll_type = session->type;
+  m_poll_pid = session->pid;
+  m_poll_ml_remain = session->ml_remain;
+  m_poll_ml_offset = session->ml_offset;
+  m_poll_ml_frame = session->ml_frame;
+  m_poll_wait = session->wait;
+  }
+
+
+/**
+ * PollerSaveSession: internal: store the current poll context in its session
+ */
+void OvmsVehicle::PollerSaveSession(poll_session_t* session)
+  {
+  if (session->wait && !m_poll_wait)
+    m_poll_busy--;
+  else if (!session->wait && m_poll_wait)
+    m_poll_busy++;
+  session->moduleid_low = m_poll_moduleid_low;
+  session->moduleid_high = m_poll_moduleid_high;
+  session->ml_remain = m_poll_ml_remain;
+  session->ml_offset = m_poll_ml_offset;
+  session->ml_frame = m_poll_ml_frame;
+  if (m_poll_wait)
+    session->waitstart = esp_log_timestamp();
+  session->wait = m_poll_wait;
+  PollerUpdateRxFilter();
+  }
+
+
+/**
+ * PollerGetFlowControl: internal: get the flow control parameters for an ECU
+ *  
+ *  @param txid         ECU request ID (moduleid)
+ *  @param create       true = add the ECU with the default parameters if unknown
+ *  @return             Parameters or NULL if unknown / no slot available
+ */
+OvmsVehicle::poll_fc_t* OvmsVehicle::PollerGetFlowControl(uint32_t txid, bool create)
+  {
+  poll_fc_t* slot = NULL;
+  for (int i = 0; i < VEHICLE_POLL_MAXFLOWCTRL; i++)
+    {
+    if (m_poll_fc[i].txid == txid)
+      return &m_poll_fc[i];
+    else if (!slot && m_poll_fc[i].txid == 0)
+      slot = &m_poll_fc[i];
+    }
+  if (!create || !slot)
+    return NULL;
+  memset(slot, 0, sizeof(*slot));
+  slot->txid = txid;
+  slot->blocksize = m_poll_fc_blocksize;
+  slot->septime = m_poll_fc_septime;
+  slot->st_stable = m_poll_fc_septime;
+  slot->adaptive = m_poll_fc_adaptive ? 1 : 0;
+  slot->interval = VEHICLE_POLL_DEFINTERVAL;
+  return slot;
+  }
+
+
+/**
+ * PollerSendFlowControl: internal: request (next block of) consecutive frames
+ */
+void OvmsVehicle::PollerSendFlowControl(poll_session_t* session, canbus* bus)
+  {
+  CAN_frame_t txframe;
+  uint8_t* txdata;
+  memset(&txframe,0,sizeof(txframe));
+  txframe.origin = bus;
+  txframe.FIR.B.FF = CAN_frame_std;
+  txframe.FIR.B.DLC = 8;
+
+  if (session->protocol == ISOTP_EXTADR)
+    {
+    txframe.MsgID = session->fc_txid >> 8;
+    txframe.data.u8[0] = session->fc_txid & 0xff;
+    txdata = &txframe.data.u8[1];
+    }
+  else
+    {
+    txframe.MsgID = session->fc_txid;
+    txdata = &txframe.data.u8[0];
+    }
+
+  txdata[0] = (ISOTP_FT_FLOWCTRL << 4) | ISOTP_FC_CTS;
+  txdata[1] = session->fc_blocksize;  // frames until next flow control, 0 = all
+  txdata[2] = session->fc_septime;    // separation time
+  txframe.Write();
+  PollerCountFrame(bus, PollerGetStats(session->entry));
+  }
+
+
+/**
+ * PollerFlowControlResult: internal: evaluate a multi frame response for adaptive timing
+ *  
+ *  @param session      Session of the response
+ *  @param success      true = response complete, false = frames lost
+ *  @param size         Response payload size
+ */
+void OvmsVehicle::PollerFlowControlResult(poll_session_t* session, bool success, uint32_t size)
+  {
+  poll_fc_t* fc = PollerGetFlowControl(session->fc_txid, false);
+  if (!fc)
+    return;
+
+  if (!success)
+    {
+    fc->failures++;
+    if (fc->adaptive == 0)
+      return;
+    if (poll_septime_us(session->fc_septime) < poll_septime_us(fc->st_stable))
+      {
+      // Probe failed, return to the last stable timing:
+      fc->septime = fc->st_stable;
+      }
+    else
+      {
+      // Stable timing failed, back off:
+      fc->septime = fc->st_stable = poll_septime_slower(session->fc_septime);
+      fc->rate_stable = 0;
+      }
+    fc->adaptive = 2;
+    ESP_LOGD(TAG, "PollerFlowControl[%03X]: response lost, STmin now %02X", fc->txid, fc->septime);
+    return;
+    }
+
+  fc->responses++;
+  uint32_t us = (uint32_t)esp_timer_get_time() - session->ml_start;
+  fc->rate = (uint64_t)size * 1000000 / (us ? us : 1);
+
+  // Adaptive probing: only evaluate responses using the current probe timing
+  //  with enough frames to give a significant transfer rate
+  if (fc->adaptive != 1 || session->fc_septime != fc->septime || m_poll_ml_frame < 4)
+    return;
+  if (fc->rate_stable && poll_septime_us(fc->septime) < poll_septime_us(fc->st_stable) &&
+      fc->rate < fc->rate_stable + fc->rate_stable / 20)
+    {
+    // No significant gain from the shorter separation time, keep the stable one:
+    fc->septime = fc->st_stable;
+    fc->adaptive = 2;
+    }
+  else
+    {
+    fc->st_stable = fc->septime;
+    fc->rate_stable = fc->rate;
+    uint8_t next = poll_septime_faster(fc->septime);
+    if (next == fc->septime)
+      fc->adaptive = 2;
+    else
+      fc->septime = next;
+    }
+  ESP_LOGD(TAG, "PollerFlowControl[%03X]: %u bytes/s, STmin now %02X%s", fc->txid, fc->rate,
+           fc->septime, (fc->adaptive == 2) ? " (settled)" : "");
+  }
+
+
+/**
+ * PollerSendConsecutiveFrames: internal: start sending (next block of) a multi frame request
+ *  Multi frame requests are only used by PollSingleRequest(). With a separation time
+ *  set, the frames are paced by a one shot timer (see PollerTxPace()), so neither
+ *  the vehicle task nor the poller mutex are blocked while waiting.
+ *  
+ *  @param blocksize    Block size requested by the ECU, 0 = all frames
+ *  @param septime      Separation time requested by the ECU
+ */
+void OvmsVehicle::PollerSendConsecutiveFrames(poll_session_t* session, uint8_t blocksize, uint8_t septime)
+  {
+  session->tx_block = blocksize;
+  session->tx_septime = septime;
+  m_poll_txsession = session;
+
+  if (poll_septime_us(septime) == 0)
+    {
+    // No separation time: send the block now
+    while (m_poll_txsession == session)
+      PollerSendConsecutiveFrame(session);
+    return;
+    }
+
+  // The first frame can follow the flow control immediately:
+  PollerSendConsecutiveFrame(session);
+  if (m_poll_txsession != session)
+    return;
+  if (!m_poll_txtimer)
+    m_poll_txtimer = xTimerCreate("Vehicle poller TX", 1, pdFALSE, this, PollerTxTimerCallback);
+  if (!m_poll_txtimer)
+    {
+    ESP_LOGE(TAG, "PollerSendConsecutiveFrames: can't create timer");
+    m_poll_txsession = NULL;
+    return;
+    }
+  xTimerChangePeriod(m_poll_txtimer, poll_septime_ticks(septime), 0);
   }
 
 
 /**
- * PollSetState: set the polling state
- *  Call this to change the polling state and restart the current polling list.
- *  This won't do anything if the state is already active. The state is changed without
- *  waiting for pending responses to finish (except PollSingleRequests).
- *  
- *  @param state
- *    The polling state to activate (0 … VEHICLE_POLL_NSTATES)
+ * PollerSendConsecutiveFrame: internal: send the next consecutive frame of a multi frame request
+ *  Clears m_poll_txsession when the request or the current block is complete.
  */
-void OvmsVehicle::PollSetState(uint8_t state)
+void OvmsVehicle::PollerSendConsecutiveFrame(poll_session_t* session)
   {
-  if ((state < VEHICLE_POLL_NSTATES)&&(state != m_poll_state))
+  const std::string& request = m_poll_single_txreq;
+  if (session->tx_offset >= request.size())
     {
-    OvmsRecMutexLock slock(&m_poll_single_mutex);
-    OvmsRecMutexLock lock(&m_poll_mutex);
-    m_poll_state = state;
-    m_poll_ticker = 0;
-    m_poll_sequence_cnt = 0;
-    m_poll_wait = 0;
-    m_poll_plcur = NULL;
-    m_poll_txmsgid = 0;
+    m_poll_txsession = NULL;
+    return;
+    }
+
+  uint8_t maxlen = (session->protocol == ISOTP_EXTADR) ? 6 : 7;
+  CAN_frame_t txframe;
+  uint8_t* txdata;
+  memset(&txframe,0,sizeof(txframe));
+  txframe.origin = session->bus;
+  txframe.FIR.B.FF = CAN_frame_std;
+  txframe.FIR.B.DLC = 8;
+  if (session->protocol == ISOTP_EXTADR)
+    {
+    txframe.MsgID = session->moduleid_sent >> 8;
+    txframe.data.u8[0] = session->moduleid_sent & 0xff;
+    txdata = &txframe.data.u8[1];
+    }
+  else
+    {
+    txframe.MsgID = session->moduleid_sent;
+    txdata = &txframe.data.u8[0];
+    }
+
+  uint8_t len = LIMIT_MAX(request.size() - session->tx_offset, maxlen);
+  txdata[0] = (ISOTP_FT_CONSECUTIVE << 4) | (session->tx_frame & 0x0f);
+  memcpy(&txdata[1], request.data() + session->tx_offset, len);
+  session->bus->Write(&txframe);
+  PollerCountFrame(session->bus, PollerGetStats(session->entry));
+
+  session->tx_offset += len;
+  session->tx_frame++;
+  if (session->tx_offset >= request.size() ||
+      (session->tx_block && --session->tx_block == 0))
+    {
+    // Request complete, or wait for the next flow control:
+    m_poll_txsession = NULL;
     }
   }
 
 
 /**
- * PollSetThrottling: configure polling speed / niceness
- *  If multiple requests are due at the same poll tick (second), this controls how many of
- *  them will be sent in series without a delay, i.e. as soon as the response/timeout for
- *  the previous request occurred.
- *  
- *  @param sequence_max
- *    Polls allowed to be sent in sequence per time tick (second), default 1, 0 = no limit.
- *  
- *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ * PollerTxPace: internal: pacing timer expired, executed in the vehicle task
  */
-void OvmsVehicle::PollSetThrottling(uint8_t sequence_max)
+void OvmsVehicle::PollerTxPace()
   {
   OvmsRecMutexLock lock(&m_poll_mutex);
-  m_poll_sequence_max = sequence_max;
+  poll_session_t* session = m_poll_txsession;
+  if (!session)
+    return;
+  if (!session->wait)
+    {
+    // Request aborted (timeout / TX failure):
+    m_poll_txsession = NULL;
+    return;
+    }
+  PollerSendConsecutiveFrame(session);
+  if (m_poll_txsession == session)
+    xTimerChangePeriod(m_poll_txtimer, poll_septime_ticks(session->tx_septime), 0);
   }
 
 
 /**
- * PollSetResponseSeparationTime: configure ISO TP multi frame response timing
- *  See: https://en.wikipedia.org/wiki/ISO_15765-2
- *  
- *  @param septime
- *    Separation Time (ST), the minimum delay time between frames. Default: 25 milliseconds
- *    ST values up to 127 (0x7F) specify the minimum number of milliseconds to delay between frames,
- *    while values in the range 241 (0xF1) to 249 (0xF9) specify delays increasing from
- *    100 to 900 microseconds.
+ * PollerTxTimerCallback: internal: forward the pacing timer to the vehicle task
+ */
+void OvmsVehicle::PollerTxTimerCallback(TimerHandle_t timer)
+  {
+  OvmsVehicle* me = (OvmsVehicle*) pvTimerGetTimerID(timer);
+  CAN_frame_t frame;
+  memset(&frame, 0, sizeof(frame)); // origin NULL = poller control message
+  frame.MsgID = VEHICLE_POLL_MSG_TXPACE;
+  if (xQueueSend(me->m_rxqueue, &frame, 0) != pdTRUE)
+    xTimerChangePeriod(timer, 1, 0); // queue full, retry on the next tick
+  }
+
+
+/**
+ * PollerStartRequest: internal: send a poll list request
  *  
- *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ *  @return             false if the request cannot be sent now (ECU busy / rate limited,
+ *                      or bus concurrency limit reached)
  */
-void OvmsVehicle::PollSetResponseSeparationTime(uint8_t septime)
+bool OvmsVehicle::PollerStartRequest(const poll_pid_t* entry, bool fromTicker)
   {
-  assert (septime <= 127 || (septime >= 241 && septime <= 249));
-  OvmsRecMutexLock lock(&m_poll_mutex);
-  m_poll_fc_septime = septime;
+  uint32_t moduleid_sent, moduleid_low, moduleid_high;
+  if (entry->rxmoduleid != 0)
+    {
+    // send to <moduleid>, listen to response from <rmoduleid>:
+    moduleid_sent = entry->txmoduleid;
+    moduleid_low = entry->rxmoduleid;
+    moduleid_high = entry->rxmoduleid;
+    }
+  else
+    {
+    // broadcast: send to 0x7df, listen to all responses:
+    moduleid_sent = 0x7df;
+    moduleid_low = 0x7e8;
+    moduleid_high = 0x7ef;
+    }
+
+  canbus* bus;
+  switch (entry->pollbus)
+    {
+    case 1:
+      bus = m_can1;
+      break;
+    case 2:
+      bus = m_can2;
+      break;
+    case 3:
+      bus = m_can3;
+      break;
+    case 4:
+      bus = m_can4;
+      break;
+    default:
+      bus = m_poll_bus_default;
+    }
+
+  poll_session_t* session = PollerGetSession(bus, moduleid_sent, moduleid_low, moduleid_high);
+  if (!session)
+    return false;
+
+  session->bus = bus;
+  session->entry = entry;
+  session->protocol = entry->protocol;
+  session->type = entry->type;
+  session->pid = entry->pid;
+  session->moduleid_sent = moduleid_sent;
+  session->moduleid_low = moduleid_low;
+  session->moduleid_high = moduleid_high;
+
+  ESP_LOGD(TAG, "PollerSend(%d): send [bus=%d, type=%02X, pid=%X], expecting %03x/%03x-%03x",
+           fromTicker, entry->pollbus, session->type, session->pid, moduleid_sent,
+           moduleid_low, moduleid_high);
+
+  CAN_frame_t txframe;
+  uint8_t* txdata;
+  memset(&txframe,0,sizeof(txframe));
+  txframe.origin = bus;
+  txframe.callback = &m_poll_txcallback;
+  txframe.FIR.B.FF = CAN_frame_std;
+  txframe.FIR.B.DLC = 8;
+
+  if (session->protocol == ISOTP_EXTADR)
+    {
+    txframe.MsgID = moduleid_sent >> 8;
+    txframe.data.u8[0] = moduleid_sent & 0xff;
+    txdata = &txframe.data.u8[1];
+    }
+  else
+    {
+    txframe.MsgID = moduleid_sent;
+    txdata = &txframe.data.u8[0];
+    }
+
+  session->tx_offset = 0;
+  session->tx_frame = 0;
+
+  if (!m_poll_single_txreq.empty())
+    {
+    // Multi frame request (PollSingleRequest): send first frame,
+    //  the consecutive frames follow on the flow control response
+    uint16_t len = m_poll_single_txreq.size();
+    uint8_t fflen = (session->protocol == ISOTP_EXTADR) ? 5 : 6;
+    txdata[0] = (ISOTP_FT_FIRST << 4) | (len >> 8);
+    txdata[1] = len & 0xff;
+    memcpy(&txdata[2], m_poll_single_txreq.data(), fflen);
+    session->tx_offset = fflen;
+    session->tx_frame = 1;
+    }
+  else if (POLL_TYPE_HAS_16BIT_PID(entry->type))
+    {
+    uint8_t datalen = LIMIT_MAX(entry->args.datalen, 4);
+    txdata[0] = (ISOTP_FT_SINGLE << 4) + 3 + datalen;
+    txdata[1] = session->type;
+    txdata[2] = session->pid >> 8;
+    txdata[3] = session->pid & 0xff;
+    memcpy(&txdata[4], entry->args.data, datalen);
+    }
+  else if (POLL_TYPE_HAS_8BIT_PID(entry->type))
+    {
+    uint8_t datalen = LIMIT_MAX(entry->args.datalen, 5);
+    txdata[0] = (ISOTP_FT_SINGLE << 4) + 2 + datalen;
+    txdata[1] = session->type;
+    txdata[2] = session->pid;
+    memcpy(&txdata[3], entry->args.data, datalen);
+    }
+  else
+    {
+    uint8_t datalen = LIMIT_MAX(entry->args.datalen, 6);
+    txdata[0] = (ISOTP_FT_SINGLE << 4) + 1 + datalen;
+    txdata[1] = session->type;
+    memcpy(&txdata[2], entry->args.data, datalen);
+    }
+
+  session->txmsgid = txframe.MsgID;
+  session->ml_frame = 0;
+  session->ml_offset = 0;
+  session->ml_remain = 0;
+  session->wait = 2;
+  session->lastsent = session->waitstart = esp_log_timestamp();
+  m_poll_busy++;
+  PollerUpdateRxFilter();
+  PollerLoadSession(session);
+
+  poll_stats_t* stats = PollerGetStats(entry);
+  m_poll_total.requests++;
+  if (stats) stats->requests++;
+  PollerCountFrame(bus, stats);
+  if (m_poll_cycle_sent++ == 0)
+    m_poll_cycle_start = session->lastsent;
+
+  m_poll_sequence_cnt++;
+  bus->Write(&txframe);
+  return true;
   }
 
 
 /**
- * PollerSend: internal: start next due request
+ * PollerSend: internal: start next due request(s)
+ *  In serial mode, this sends the next due request if none is outstanding.
+ *  With concurrency enabled, all due requests are sent that can run in parallel
+ *  to the outstanding ones. Entries that need to wait for their ECU are retried
+ *  on the next call, the list position stays at the first unsent entry.
+ *  With a millisecond time base, the list is processed in deadline order instead,
+ *  see PollerSendScheduled().
  */
 void OvmsVehicle::PollerSend(bool fromTicker)
   {
@@ -240,148 +1277,252 @@ void OvmsVehicle::PollerSend(bool fromTicker)
 
   if (m_poll_plcur == NULL) m_poll_plcur = m_poll_plist;
 
-  // ESP_LOGD(TAG, "PollerSend(%d): entry at[type=%02X, pid=%X], ticker=%u, wait=%u, cnt=%u/%u",
+  // ESP_LOGD(TAG, "PollerSend(%d): entry at[type=%02X, pid=%X], ticker=%u, busy=%u, cnt=%u/%u",
   //          fromTicker, m_poll_plcur->type, m_poll_plcur->pid,
-  //          m_poll_ticker, m_poll_wait, m_poll_sequence_cnt, m_poll_sequence_max);
+  //          m_poll_ticker, m_poll_busy, m_poll_sequence_cnt, m_poll_sequence_max);
 
   if (fromTicker)
     {
-    // Timer ticker call: reset throttling counter, check response timeout
+    // Timer ticker call: reset throttling counter, check response timeouts
+    //  (time base mode: see PollerTick())
     m_poll_sequence_cnt = 0;
-    if (m_poll_wait > 0) m_poll_wait--;
-    }
-  if (m_poll_wait > 0) return;
-
-  while (m_poll_plcur->txmoduleid != 0)
-    {
-    if ((m_poll_plcur->polltime[m_poll_state] > 0) &&
-        ((m_poll_ticker % m_poll_plcur->polltime[m_poll_state]) == 0))
+    if (!m_poll_timebase)
       {
-      // We need to poll this one...
-      m_poll_protocol = m_poll_plcur->protocol;
-      m_poll_type = m_poll_plcur->type;
-      m_poll_pid = m_poll_plcur->pid;
-      if (m_poll_plcur->rxmoduleid != 0)
-        {
-        // send to <moduleid>, listen to response from <rmoduleid>:
-        m_poll_moduleid_sent = m_poll_plcur->txmoduleid;
-        m_poll_moduleid_low = m_poll_plcur->rxmoduleid;
-        m_poll_moduleid_high = m_poll_plcur->rxmoduleid;
-        }
-      else
-        {
-        // broadcast: send to 0x7df, listen to all responses:
-        m_poll_moduleid_sent = 0x7df;
-        m_poll_moduleid_low = 0x7e8;
-        m_poll_moduleid_high = 0x7ef;
-        }
-
-      switch (m_poll_plcur->pollbus)
+      bool expired = false;
+      for (int i = 0; i < VEHICLE_POLL_MAXSESSIONS; i++)
         {
-        case 1:
-          m_poll_bus = m_can1;
-          break;
-        case 2:
-          m_poll_bus = m_can2;
-          break;
-        case 3:
-          m_poll_bus = m_can3;
-          break;
-        case 4:
-          m_poll_bus = m_can4;
-          break;
-        default:
-          m_poll_bus = m_poll_bus_default;
+        poll_session_t* s = &m_poll_session[i];
+        if (s->wait > 0 && --s->wait == 0)
+          {
+          PollerExpireSession(s);
+          expired = true;
+          }
         }
+      if (expired)
+        PollerUpdateRxFilter();
+      }
+    PollerUpdateMetrics();
+    }
+  if (m_poll_concurrency == 0 && m_poll_busy > 0) return;
 
-      ESP_LOGD(TAG, "PollerSend(%d): send [bus=%d, type=%02X, pid=%X], expecting %03x/%03x-%03x",
-               fromTicker, m_poll_plcur->pollbus, m_poll_type, m_poll_pid, m_poll_moduleid_sent,
-               m_poll_moduleid_low, m_poll_moduleid_high);
-
-      CAN_frame_t txframe;
-      uint8_t* txdata;
-      memset(&txframe,0,sizeof(txframe));
-      txframe.origin = m_poll_bus;
-      txframe.callback = &m_poll_txcallback;
-      txframe.FIR.B.FF = CAN_frame_std;
-      txframe.FIR.B.DLC = 8;
+  if (m_poll_timebase)
+    {
+    PollerSendScheduled();
+    return;
+    }
 
-      if (m_poll_protocol == ISOTP_EXTADR)
-        {
-        txframe.MsgID = m_poll_moduleid_sent >> 8;
-        txframe.data.u8[0] = m_poll_moduleid_sent & 0xff;
-        txdata = &txframe.data.u8[1];
-        }
-      else
-        {
-        txframe.MsgID = m_poll_moduleid_sent;
-        txdata = &txframe.data.u8[0];
-        }
+  const poll_pid_t* entry;
+  bool blocked = false;
+  for (entry = m_poll_plcur; entry->txmoduleid != 0; entry++)
+    {
+    size_t index = entry - m_poll_plist;
+    if ((entry->polltime[m_poll_state] == 0) ||
+        ((m_poll_ticker % entry->polltime[m_poll_state]) != 0) ||
+        (index < m_poll_done.size() && m_poll_done[index]))
+      {
+      // Poll entry is not due or already sent, check next
+      if (!blocked) m_poll_plcur = entry + 1;
+      continue;
+      }
 
-      if (POLL_TYPE_HAS_16BIT_PID(m_poll_plcur->type))
-        {
-        uint8_t datalen = LIMIT_MAX(m_poll_plcur->args.datalen, 4);
-        txdata[0] = (ISOTP_FT_SINGLE << 4) + 3 + datalen;
-        txdata[1] = m_poll_type;
-        txdata[2] = m_poll_pid >> 8;
-        txdata[3] = m_poll_pid & 0xff;
-        memcpy(&txdata[4], m_poll_plcur->args.data, datalen);
-        }
-      else if (POLL_TYPE_HAS_8BIT_PID(m_poll_plcur->type))
-        {
-        uint8_t datalen = LIMIT_MAX(m_poll_plcur->args.datalen, 5);
-        txdata[0] = (ISOTP_FT_SINGLE << 4) + 2 + datalen;
-        txdata[1] = m_poll_type;
-        txdata[2] = m_poll_pid;
-        memcpy(&txdata[3], m_poll_plcur->args.data, datalen);
-        }
-      else
-        {
-        uint8_t datalen = LIMIT_MAX(m_poll_plcur->args.datalen, 6);
-        txdata[0] = (ISOTP_FT_SINGLE << 4) + 1 + datalen;
-        txdata[1] = m_poll_type;
-        memcpy(&txdata[2], m_poll_plcur->args.data, datalen);
-        }
+    // We need to poll this one...
+    if (m_poll_sequence_max && m_poll_sequence_cnt >= m_poll_sequence_max)
+      {
+      // Throttling limit reached for this tick
+      blocked = true;
+      break;
+      }
 
-      m_poll_txmsgid = txframe.MsgID;
-      m_poll_ml_frame = 0;
-      m_poll_ml_offset = 0;
-      m_poll_ml_remain = 0;
-      m_poll_wait = 2;
-      m_poll_plcur++;
-      m_poll_sequence_cnt++;
-      m_poll_bus->Write(&txframe);
+    // Out of order sends need to be tracked:
+    if (blocked && index >= m_poll_done.size())
+      continue;
 
-      return;
+    if (!PollerStartRequest(entry, fromTicker))
+      {
+      // ECU busy / rate limited, or bus concurrency limit reached
+      blocked = true;
+      if (m_poll_concurrency == 0) break;
+      continue;
       }
 
-    // Poll entry is not due, check next
-    m_poll_plcur++;
+    if (blocked)
+      m_poll_done[index] = true;
+    else
+      m_poll_plcur = entry + 1;
+
+    // Serial mode: wait for the response
+    if (m_poll_concurrency == 0) return;
     }
 
+  if (blocked) return;
+
   // Completed checking all poll entries for the current m_poll_ticker
   // ESP_LOGD(TAG, "PollerSend(%d): cycle complete for ticker=%u", fromTicker, m_poll_ticker);
   m_poll_plcur = m_poll_plist;
+  m_poll_done.assign(m_poll_done.size(), false);
+  if (m_poll_cycle_sent)
+    {
+    // Update cycle duration statistics (first request sent to last entry processed):
+    m_poll_cycle_last = esp_log_timestamp() - m_poll_cycle_start;
+    m_poll_cycle_count++;
+    m_poll_cycle_sum += m_poll_cycle_last;
+    if (m_poll_cycle_last > m_poll_cycle_max) m_poll_cycle_max = m_poll_cycle_last;
+    StandardMetrics.ms_m_poll_cycletime->SetValue((float)m_poll_cycle_last / 1000);
+    m_poll_cycle_sent = 0;
+    }
   m_poll_ticker++;
   if (m_poll_ticker > 3600) m_poll_ticker -= 3600;
   }
 
 
+/**
+ * PollerSendScheduled: internal: start due requests in deadline order (millisecond time base)
+ *  Entries are sent earliest deadline first. An entry that cannot be sent in time
+ *  for its next interval skips the missed intervals (counted as "missed").
+ */
+void OvmsVehicle::PollerSendScheduled()
+  {
+  uint32_t now = esp_log_timestamp();
+
+  // Collect due entries:
+  m_poll_duelist.clear();
+  for (size_t i = 0; i < m_poll_timing.size(); i++)
+    {
+    if (m_poll_plist[i].polltime[m_poll_state] > 0 &&
+        (int32_t)(now - m_poll_timing[i].due) >= 0)
+      m_poll_duelist.push_back(i);
+    }
+  if (m_poll_duelist.empty()) return;
+
+  std::sort(m_poll_duelist.begin(), m_poll_duelist.end(), [this](uint16_t a, uint16_t b)
+    {
+    int32_t diff = m_poll_timing[a].due - m_poll_timing[b].due;
+    return (diff < 0) || (diff == 0 && a < b);
+    });
+
+  for (uint16_t index : m_poll_duelist)
+    {
+    if (m_poll_sequence_max && m_poll_sequence_cnt >= m_poll_sequence_max)
+      break;
+    if (m_poll_concurrency == 0 && m_poll_busy > 0)
+      break;
+
+    const poll_pid_t* entry = &m_poll_plist[index];
+    if (!PollerStartRequest(entry, false))
+      continue;
+
+    // Update schedule & jitter statistics:
+    poll_timing_t* t = &m_poll_timing[index];
+    uint16_t interval = entry->polltime[m_poll_state];
+    uint32_t lag = now - t->due;
+    t->count++;
+    t->lag_sum += lag;
+    if (lag > t->lag_max) t->lag_max = lag;
+    t->due += interval;
+    if ((int32_t)(now - t->due) >= 0)
+      {
+      uint32_t missed = (now - t->due) / interval + 1;
+      t->missed += missed;
+      t->due += missed * interval;
+      }
+    }
+  }
+
+
+/**
+ * PollerExpireSession: internal: count a response timeout & end the session
+ *  (the wait counter has already been cleared by the caller)
+ */
+void OvmsVehicle::PollerExpireSession(poll_session_t* session)
+  {
+  m_poll_busy--;
+  poll_stats_t* stats = PollerGetStats(session->entry);
+  m_poll_total.timeouts++;
+  if (stats) stats->timeouts++;
+  if (session->ml_remain)
+    PollerFlowControlResult(session, false, 0);
+  }
+
+
+/**
+ * PollerTick: internal: poll timer tick, executed in the vehicle task
+ *  Response timeouts are checked here in milliseconds since the wait counter
+ *  was set, each count standing for VEHICLE_POLL_WAIT_MS.
+ */
+void OvmsVehicle::PollerTick()
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+  if (!m_poll_timebase) return;
+
+  uint32_t now = esp_log_timestamp();
+  bool expired = false;
+  for (int i = 0; i < VEHICLE_POLL_MAXSESSIONS; i++)
+    {
+    poll_session_t* s = &m_poll_session[i];
+    if (s->wait > 0 && (now - s->waitstart) >= (uint32_t)s->wait * VEHICLE_POLL_WAIT_MS)
+      {
+      s->wait = 0;
+      PollerExpireSession(s);
+      expired = true;
+      }
+    }
+  if (expired)
+    PollerUpdateRxFilter();
+
+  m_poll_sequence_cnt = 0;
+  PollerSend(false);
+  }
+
+
+/**
+ * PollerTimerCallback: internal: forward poll timer ticks to the vehicle task
+ */
+void OvmsVehicle::PollerTimerCallback(TimerHandle_t timer)
+  {
+  OvmsVehicle* me = (OvmsVehicle*) pvTimerGetTimerID(timer);
+  if (me->m_poll_tickpending) return;
+  CAN_frame_t frame;
+  memset(&frame, 0, sizeof(frame)); // origin NULL = poller control message
+  frame.MsgID = VEHICLE_POLL_MSG_TICK;
+  me->m_poll_tickpending = true;
+  if (xQueueSend(me->m_rxqueue, &frame, 0) != pdTRUE)
+    me->m_poll_tickpending = false;
+  }
+
+
 /**
  * PollerTxCallback: internal: process poll request callbacks
  */
 void OvmsVehicle::PollerTxCallback(const CAN_frame_t* frame, bool success)
   {
   OvmsRecMutexLock lock(&m_poll_mutex);
+  if (!m_poll_plist)
+    return;
 
-  // Check for a late callback:
-  if (!m_poll_wait || !m_poll_plist || frame->origin != m_poll_bus || frame->MsgID != m_poll_txmsgid)
+  // Find the request session, check for a late callback:
+  poll_session_t* session = NULL;
+  for (int i = 0; i < VEHICLE_POLL_MAXSESSIONS; i++)
+    {
+    poll_session_t* s = &m_poll_session[i];
+    if (s->wait && frame->origin == s->bus && frame->MsgID == s->txmsgid &&
+        (s->protocol != ISOTP_EXTADR || frame->data.u8[0] == (s->moduleid_sent & 0xff)))
+      {
+      session = s;
+      break;
+      }
+    }
+  if (!session)
     return;
+  PollerLoadSession(session);
 
   // On failure, try to speed up the current poll timeout:
   if (!success)
     {
+    poll_stats_t* stats = PollerGetStats(session->entry);
+    m_poll_total.txfails++;
+    if (stats) stats->txfails++;
     m_poll_wait = 0;
+    PollerSaveSession(session);
     if (m_poll_single_rxbuf)
       {
       m_poll_single_rxerr = POLLSINGLE_TXFAILURE;
@@ -396,21 +1537,46 @@ void OvmsVehicle::PollerTxCallback(const CAN_frame_t* frame, bool success)
 
 
 /**
- * PollerSend: internal: process poll response frame
+ * PollerReceive: internal: process poll response frame
  */
 void OvmsVehicle::PollerReceive(CAN_frame_t* frame, uint32_t msgid)
   {
   OvmsRecMutexLock lock(&m_poll_mutex);
-  char *hexdump = NULL;
 
   // After locking the mutex, check again for poll expectance match:
-  if (!m_poll_wait || !m_poll_plist || frame->origin != m_poll_bus ||
-      msgid < m_poll_moduleid_low || msgid > m_poll_moduleid_high)
+  poll_session_t* session = m_poll_plist ? PollerFindSession(frame, &msgid) : NULL;
+  if (!session)
     {
     ESP_LOGD(TAG, "PollerReceive[%03X]: dropping expired poll response", msgid);
     return;
     }
 
+  PollerCountFrame(frame->origin, PollerGetStats(session->entry));
+  PollerLoadSession(session);
+  PollerProcessResponse(session, frame, msgid);
+  PollerSaveSession(session);
+
+  // Immediately send the next poll for this tick if…
+  // - we are not waiting for another frame
+  // - the poll was no broadcast (with potential further responses from other devices)
+  // - poll throttling is unlimited or limit isn't reached yet
+  if (m_poll_wait == 0 &&
+      m_poll_moduleid_sent != 0x7df &&
+      (!m_poll_sequence_max || m_poll_sequence_cnt < m_poll_sequence_max))
+    {
+    PollerSend(false);
+    }
+  }
+
+
+/**
+ * PollerProcessResponse: internal: process poll response frame for the current session
+ */
+void OvmsVehicle::PollerProcessResponse(poll_session_t* session, CAN_frame_t* frame, uint32_t msgid)
+  {
+  char *hexdump = NULL;
+  poll_stats_t* stats = PollerGetStats(session->entry);
+
 
   // 
   // Get & validate ISO-TP meta data
@@ -437,6 +1603,34 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame, uint32_t msgid)
 
   tp_frametype = fr_data[0] >> 4;
 
+  if (tp_frametype == ISOTP_FT_FLOWCTRL && session->tx_offset < m_poll_single_txreq.size())
+    {
+    // Flow control for our multi frame request:
+    uint8_t fc_status = fr_data[0] & 0x0f;
+    if (fc_status == ISOTP_FC_CTS)
+      {
+      PollerSendConsecutiveFrames(session, fr_data[1], fr_data[2]);
+      m_poll_wait = 2;
+      }
+    else if (fc_status == ISOTP_FC_WAIT)
+      {
+      m_poll_wait = 2;
+      }
+    else
+      {
+      ESP_LOGW(TAG, "PollerReceive[%03X]: request %02X(%X) rejected, flow control status %u",
+               msgid, m_poll_type, m_poll_pid, fc_status);
+      m_poll_wait = 0;
+      if (m_poll_single_rxbuf)
+        {
+        m_poll_single_rxerr = POLLSINGLE_TXFAILURE;
+        m_poll_single_rxbuf = NULL;
+        m_poll_single_rxdone.Give();
+        }
+      }
+    return;
+    }
+
   switch (tp_frametype)
     {
     case ISOTP_FT_SINGLE:
@@ -481,6 +1675,9 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame, uint32_t msgid)
               msgid, tp_frameindex, m_poll_ml_frame & 0x0f, m_poll_type, m_poll_pid,
               hexdump ? hexdump : "-");
       if (hexdump) free(hexdump);
+      if (m_poll_ml_remain)
+        PollerFlowControlResult(session, false, 0);
+      m_poll_ml_remain = 0;
       m_poll_moduleid_low = m_poll_moduleid_high = 0; // ignore further frames
       m_poll_wait = 2; // give the bus time to let remaining frames pass
       return;
@@ -556,6 +1753,8 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame, uint32_t msgid)
       // Error: forward to application:
       ESP_LOGD(TAG, "PollerReceive[%03X]: process OBD/UDS error %02X(%X) code=%02X",
                msgid, m_poll_type, m_poll_pid, error_code);
+      m_poll_total.errors++;
+      if (stats) stats->errors++;
       // Running single poll?
       if (m_poll_single_rxbuf)
         {
@@ -578,6 +1777,24 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame, uint32_t msgid)
     ESP_LOGD(TAG, "PollerReceive[%03X]: process OBD/UDS response %02X(%X) frm=%u len=%u off=%u rem=%u",
              msgid, m_poll_type, m_poll_pid,
              m_poll_ml_frame, response_datalen, m_poll_ml_offset, m_poll_ml_remain);
+    if (m_poll_ml_remain == 0)
+      {
+      // Response complete, update statistics:
+      uint32_t size = m_poll_ml_offset + response_datalen;
+      uint32_t rtt = esp_log_timestamp() - session->lastsent;
+      int bin = 0;
+      while (bin < VEHICLE_POLL_HISTBINS-1 && rtt >= poll_rtt_bins[bin]) bin++;
+      for (poll_stats_t* s : { &m_poll_total, stats })
+        {
+        if (!s) continue;
+        s->responses++;
+        s->bytes += size;
+        if (size > s->size_max) s->size_max = size;
+        s->rtt_sum += rtt;
+        if (rtt > s->rtt_max) s->rtt_max = rtt;
+        s->rtt_hist[bin]++;
+        }
+      }
     // Running single poll?
     if (m_poll_single_rxbuf)
       {
@@ -616,47 +1833,36 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame, uint32_t msgid)
     if (tp_frametype == ISOTP_FT_FIRST)
       {
       // First frame; send flow control frame:
-      CAN_frame_t txframe;
-      uint8_t* txdata;
-      uint32_t txid;
-      memset(&txframe,0,sizeof(txframe));
-      txframe.origin = frame->origin;
-      txframe.FIR.B.FF = CAN_frame_std;
-      txframe.FIR.B.DLC = 8;
-
       if (m_poll_moduleid_sent == 0x7df)
         {
         // broadcast request: derive module ID from response ID:
         // (Note: this only works for the SAE standard ID scheme)
-        txid = frame->MsgID - 8;
+        session->fc_txid = frame->MsgID - 8;
         }
       else
         {
         // use known module ID:
-        txid = m_poll_moduleid_sent;
-        }
-
-      if (m_poll_protocol == ISOTP_EXTADR)
-        {
-        txframe.MsgID = txid >> 8;
-        txframe.data.u8[0] = txid & 0xff;
-        txdata = &txframe.data.u8[1];
-        }
-      else
-        {
-        txframe.MsgID = txid;
-        txdata = &txframe.data.u8[0];
+        session->fc_txid = m_poll_moduleid_sent;
         }
 
-      txdata[0] = 0x30;                // flow control frame type
-      txdata[1] = 0x00;                // request all frames available
-      txdata[2] = m_poll_fc_septime;   // with configured separation timing (default 25 ms)
-      txframe.Write();
+      // Use ECU specific or default block size & separation timing (default 25 ms):
+      poll_fc_t* fc = PollerGetFlowControl(session->fc_txid, m_poll_fc_adaptive);
+      session->fc_blocksize = fc ? fc->blocksize : m_poll_fc_blocksize;
+      session->fc_septime = fc ? fc->septime : m_poll_fc_septime;
+      session->ml_block = session->fc_blocksize;
+      session->ml_start = esp_timer_get_time();
+      PollerSendFlowControl(session, frame->origin);
       m_poll_ml_frame = 1;
       }
     else
       {
       m_poll_ml_frame++;
+      if (session->ml_block && --session->ml_block == 0)
+        {
+        // Block complete; request the next one:
+        session->ml_block = session->fc_blocksize;
+        PollerSendFlowControl(session, frame->origin);
+        }
       }
 
     m_poll_ml_offset += response_datalen; // next frame application payload offset
@@ -665,20 +1871,10 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame, uint32_t msgid)
   else
     {
     // Request response complete:
+    if (m_poll_ml_frame > 0)
+      PollerFlowControlResult(session, true, m_poll_ml_offset + response_datalen);
     m_poll_wait = 0;
     }
-
-
-  // Immediately send the next poll for this tick if…
-  // - we are not waiting for another frame
-  // - the poll was no broadcast (with potential further responses from other devices)
-  // - poll throttling is unlimited or limit isn't reached yet
-  if (m_poll_wait == 0 &&
-      m_poll_moduleid_sent != 0x7df &&
-      (!m_poll_sequence_max || m_poll_sequence_cnt < m_poll_sequence_max))
-    {
-    PollerSend(false);
-    }
   }
 
 
@@ -697,7 +1893,8 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame, uint32_t msgid)
  *  @param bus          CAN bus to use for the request
  *  @param txid         CAN ID to send to (0x7df = broadcast)
  *  @param rxid         CAN ID to expect response from (broadcast: 0)
- *  @param request      Request to send (binary string) (only single frame requests supported)
+ *  @param request      Request to send (binary string) (multi frame requests up to 4095 bytes
+ *                      supported, see PollSetFlowControl() for response flow control)
  *  @param response     Response buffer (binary string) (multiple response frames assembled)
  *  @param timeout_ms   Timeout for poller/response in milliseconds
  *  @param protocol     Protocol variant: ISOTP_STD / ISOTP_EXTADR
@@ -733,6 +1930,8 @@ int OvmsVehicle::PollSingleRequest(canbus* bus, uint32_t txid, uint32_t rxid,
     };
 
   assert(request.size() > 0);
+  if (request.size() > 4095)
+    return POLLSINGLE_TXFAILURE;
   poll[0].type = request[0];
 
   if (POLL_TYPE_HAS_16BIT_PID(poll[0].type))
@@ -765,9 +1964,15 @@ int OvmsVehicle::PollSingleRequest(canbus* bus, uint32_t txid, uint32_t rxid,
   const poll_pid_t* p_list   = m_poll_plist;
   const poll_pid_t* p_plcur  = m_poll_plcur;
   uint32_t          p_ticker = m_poll_ticker;
+  std::vector<poll_timing_t> p_timing;
+  p_timing.swap(m_poll_timing);
+  poll_stats_vector_t p_stats;
+  p_stats.swap(m_poll_stats);
 
   // start single poll:
   PollSetPidList(bus, poll);
+  if (request.size() > ((protocol == ISOTP_EXTADR) ? 6 : 7))
+    m_poll_single_txreq = request;
   m_poll_single_rxdone.Take(0);
   m_poll_single_rxbuf = &response;
   PollerSend(true);
@@ -779,6 +1984,9 @@ int OvmsVehicle::PollSingleRequest(canbus* bus, uint32_t txid, uint32_t rxid,
   // restore poller state:
   m_poll_mutex.Lock();
   PollSetPidList(p_bus, p_list);
+  m_poll_timing.swap(p_timing);
+  m_poll_stats.swap(p_stats);
+  m_poll_single_txreq.clear();
   m_poll_plcur = p_plcur;
   m_poll_ticker = p_ticker;
   m_poll_single_rxbuf = NULL;
@@ -454,6 +454,86 @@ void OvmsVehicleFactory::bms_alerts(int verbosity, OvmsWriter* writer, OvmsComma
     }
   }
 
+void OvmsVehicleFactory::bms_history_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (MyVehicleFactory.m_currentvehicle != NULL)
+    {
+    MyVehicleFactory.m_currentvehicle->m_bms_history.Status(writer);
+    }
+  else
+    {
+    writer->puts("No vehicle module selected");
+    }
+  }
+
+void OvmsVehicleFactory::bms_history_query(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (MyVehicleFactory.m_currentvehicle == NULL)
+    {
+    writer->puts("No vehicle module selected");
+    return;
+    }
+
+  bms_hist_tier_t tier;
+  std::vector<int> cells;
+  time_t now = time(NULL), from, to;
+  int maxrows = (argc > 4) ? atoi(argv[4]) : 100;
+  if (!OvmsBmsCellHistory::ParseTier(argv[0], &tier))
+    {
+    writer->printf("ERROR: invalid tier '%s'\n", argv[0]);
+    return;
+    }
+  if (!OvmsBmsCellHistory::ParseCells((argc > 1) ? argv[1] : "all", cells))
+    {
+    writer->printf("ERROR: invalid cell selection '%s'\n", argv[1]);
+    return;
+    }
+  if (!OvmsBmsCellHistory::ParseTime((argc > 2) ? argv[2] : "-1h", now, &from) ||
+      !OvmsBmsCellHistory::ParseTime((argc > 3) ? argv[3] : "now", now, &to))
+    {
+    writer->puts("ERROR: invalid time range");
+    return;
+    }
+
+  MyVehicleFactory.m_currentvehicle->m_bms_history.Query(writer, tier, from, to, cells, LIMIT_MIN(maxrows, 1), false);
+  }
+
+void OvmsVehicleFactory::bms_history_flush(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (MyVehicleFactory.m_currentvehicle != NULL)
+    {
+    MyVehicleFactory.m_currentvehicle->m_bms_history.Flush(time(NULL));
+    MyVehicleFactory.m_currentvehicle->m_bms_history.Status(writer);
+    }
+  else
+    {
+    writer->puts("No vehicle module selected");
+    }
+  }
+
+void OvmsVehicleFactory::vehicle_poller_timing(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (MyVehicleFactory.m_currentvehicle == NULL)
+    {
+    writer->puts("No vehicle module selected");
+    return;
+    }
+  bool reset = (strcmp(cmd->GetName(), "reset") == 0);
+  MyVehicleFactory.m_currentvehicle->PollerTimingStatus(verbosity, writer, reset);
+  }
+
+
+void OvmsVehicleFactory::vehicle_poller_stats(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (MyVehicleFactory.m_currentvehicle == NULL)
+    {
+    writer->puts("No vehicle module selected");
+    return;
+    }
+  bool reset = (strcmp(cmd->GetName(), "reset") == 0);
+  MyVehicleFactory.m_currentvehicle->PollerStatsStatus(verbosity, writer, reset);
+  }
+
 
 void OvmsVehicleFactory::obdii_request(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
@@ -0,0 +1,305 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Date:          14th March 2017
+;
+;    Changes:
+;    1.0  Initial release
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2017  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+#include "sdkconfig.h"
+#ifdef CONFIG_OVMS_VEHICLE_POLLER_TESTSIM
+
+#include <vector>
+#include <algorithm>
+#include "esp_timer.h"
+#include "ovms_malloc.h"
+#include "test_framework.h"
+#include "vehicle.h"
+
+/**
+ * test_isosim_bus: virtual CAN bus with simulated OBD/UDS ECUs 0x7E0…0x7E7,
+ *  answering ReadDataByIdentifier requests after m_delay ms with m_size data bytes.
+ *  Multi frame responses follow the flow control block size & separation time.
+ */
+
+#define TEST_ISOSIM_ECUS    8
+#define TEST_ISOSIM_MAXSIZE 256
+
+enum
+  {
+  TIS_Idle = 0,
+  TIS_Respond,
+  TIS_WaitFC,
+  TIS_Consecutive
+  };
+
+typedef struct
+  {
+  int       state;
+  uint32_t  due;            // next action time [ms]
+  uint8_t   data[TEST_ISOSIM_MAXSIZE + 3];
+  size_t    len;
+  size_t    pos;
+  uint8_t   seqno;
+  uint8_t   blksize;        // consecutive frames left in block, 0 = unlimited
+  uint8_t   septime;        // [ms]
+  } test_isosim_ecu_t;
+
+class test_isosim_bus : public test_simbus
+  {
+  public:
+    test_isosim_bus();
+
+  public:
+    TickType_t SimTick();
+    void SimFrame(const CAN_frame_t* frame);
+    void ProcessRequest(int ecu, const uint8_t* req);
+    void ProcessEcu(int ecu);
+
+  public:
+    uint32_t            m_delay;        // response delay [ms]
+    size_t              m_size;         // response data size [bytes]
+    test_isosim_ecu_t*  m_ecu;
+  };
+
+test_isosim_bus::test_isosim_bus()
+  : test_simbus("isosim1", "OVMS ISOsim")
+  {
+  m_delay = 10;
+  m_size = 4;
+  m_ecu = (test_isosim_ecu_t*) ExternalRamCalloc(TEST_ISOSIM_ECUS, sizeof(test_isosim_ecu_t));
+  }
+
+TickType_t test_isosim_bus::SimTick()
+  {
+  // Run due ECU actions, wait for the next one or a request:
+  uint32_t now = esp_log_timestamp();
+  TickType_t wait = portMAX_DELAY;
+  for (int ecu = 0; ecu < TEST_ISOSIM_ECUS; ecu++)
+    {
+    test_isosim_ecu_t& e = m_ecu[ecu];
+    while ((e.state == TIS_Respond || e.state == TIS_Consecutive) && (int32_t)(now - e.due) >= 0)
+      ProcessEcu(ecu);
+    if (e.state == TIS_Respond || e.state == TIS_Consecutive)
+      wait = std::min(wait, pdMS_TO_TICKS(e.due - now) + 1);
+    }
+  return wait;
+  }
+
+void test_isosim_bus::SimFrame(const CAN_frame_t* frame)
+  {
+  if (frame->MsgID >= 0x7e0 && frame->MsgID < 0x7e0 + TEST_ISOSIM_ECUS && frame->FIR.B.DLC == 8)
+    ProcessRequest(frame->MsgID - 0x7e0, frame->data.u8);
+  }
+
+void test_isosim_bus::ProcessRequest(int ecu, const uint8_t* req)
+  {
+  test_isosim_ecu_t& e = m_ecu[ecu];
+  uint8_t ft = req[0] >> 4;
+
+  if (ft == ISOTP_FT_SINGLE && req[1] == VEHICLE_POLL_TYPE_READDATA)
+    {
+    // new request: prepare response, delay processing
+    e.data[0] = 0x40 + VEHICLE_POLL_TYPE_READDATA;
+    e.data[1] = req[2];
+    e.data[2] = req[3];
+    for (size_t i = 0; i < m_size; i++)
+      e.data[3+i] = i + ecu;
+    e.len = m_size + 3;
+    e.state = TIS_Respond;
+    e.due = esp_log_timestamp() + m_delay;
+    }
+  else if (ft == ISOTP_FT_FLOWCTRL && e.state == TIS_WaitFC)
+    {
+    e.blksize = req[1];
+    e.septime = (req[2] <= 0x7f) ? req[2] : 0;
+    e.state = TIS_Consecutive;
+    e.due = esp_log_timestamp() + e.septime;
+    }
+  }
+
+void test_isosim_bus::ProcessEcu(int ecu)
+  {
+  test_isosim_ecu_t& e = m_ecu[ecu];
+  uint8_t rsp[8] = {};
+  size_t n;
+
+  if (e.state == TIS_Respond)
+    {
+    if (e.len <= 7)
+      {
+      // single frame:
+      rsp[0] = (ISOTP_FT_SINGLE << 4) | e.len;
+      memcpy(rsp+1, e.data, e.len);
+      e.state = TIS_Idle;
+      }
+    else
+      {
+      // first frame:
+      rsp[0] = (ISOTP_FT_FIRST << 4) | (e.len >> 8);
+      rsp[1] = e.len & 0xff;
+      memcpy(rsp+2, e.data, 6);
+      e.pos = 6;
+      e.seqno = 1;
+      e.state = TIS_WaitFC;
+      }
+    }
+  else
+    {
+    // consecutive frame:
+    n = std::min((size_t)7, e.len - e.pos);
+    rsp[0] = (ISOTP_FT_CONSECUTIVE << 4) | (e.seqno++ & 0x0f);
+    memcpy(rsp+1, e.data + e.pos, n);
+    e.pos += n;
+    if (e.pos == e.len)
+      e.state = TIS_Idle;
+    else if (e.blksize && --e.blksize == 0)
+      e.state = TIS_WaitFC;
+    else
+      e.due += e.septime;
+    }
+  SimRespond(0x7e8 + ecu, rsp);
+  }
+
+/**
+ * test_pollvehicle: temporary vehicle polling all PIDs every second,
+ *  measuring the time from the cycle start to the last response of the cycle.
+ *  The vehicle tickers run as usual during the test.
+ */
+class test_pollvehicle : public OvmsVehicle
+  {
+  public:
+    test_pollvehicle(canbus* bus, const poll_pid_t* plist, uint8_t concurrency, int expected)
+      {
+      m_expected = expected;
+      m_received = m_cycles = 0;
+      m_cycle_sum = m_cycle_max = 0;
+      m_cycle_start = 0;
+      MyCan.RegisterListener(m_rxqueue);
+      m_registeredlistener = true;
+      PollSetThrottling(0);
+      PollSetResponseSeparationTime(1);
+      PollSetConcurrency(concurrency);
+      PollSetPidList(bus, plist);
+      PollSetState(0);
+      m_ready = true;
+      }
+
+  public:
+    void Stop()
+      {
+      m_ready = false;
+      }
+
+  protected:
+    void PollerStateTicker()
+      {
+      // called by the ticker right before the poller starts the next cycle:
+      m_cycle_start = esp_timer_get_time();
+      m_received = 0;
+      }
+    void IncomingPollReply(canbus* bus, uint16_t type, uint16_t pid, uint8_t* data, uint8_t length, uint16_t mlremain)
+      {
+      if (mlremain || !m_cycle_start || ++m_received < m_expected)
+        return;
+      uint32_t us = esp_timer_get_time() - m_cycle_start;
+      m_cycles++;
+      m_cycle_sum += us;
+      if (us > m_cycle_max) m_cycle_max = us;
+      }
+
+  public:
+    int       m_expected;       // responses per cycle
+    int       m_received;       // responses in current cycle
+    int64_t   m_cycle_start;
+    int       m_cycles;         // cycles completed
+    uint32_t  m_cycle_sum, m_cycle_max;
+  };
+
+void OvmsVehicleFactory::vehicle_poller_testsim(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int ecus = (argc > 0) ? atoi(argv[0]) : 4;
+  int pids = (argc > 1) ? atoi(argv[1]) : 4;
+  int size = (argc > 2) ? atoi(argv[2]) : 4;
+  int delay = (argc > 3) ? atoi(argv[3]) : 10;
+  int seconds = 5;
+  if (ecus < 1 || ecus > TEST_ISOSIM_ECUS || pids < 1 || pids > 16 || size < 1 || size > TEST_ISOSIM_MAXSIZE || delay < 0)
+    {
+    writer->printf("Error: ecus 1…%d, pids 1…16, size 1…%d\n", TEST_ISOSIM_ECUS, TEST_ISOSIM_MAXSIZE);
+    return;
+    }
+  if (MyVehicleFactory.ActiveVehicle())
+    {
+    // the test vehicle would share the event & metrics listener registrations:
+    writer->puts("Error: a vehicle module is loaded, clear it first (vehicle module)");
+    return;
+    }
+
+  // the virtual bus stays allocated, as canbus instances cannot be removed:
+  static test_isosim_bus* simbus = NULL;
+  if (!simbus)
+    simbus = new test_isosim_bus();
+  simbus->Start(CAN_MODE_ACTIVE, CAN_SPEED_500KBPS);
+  simbus->m_size = size;
+  simbus->m_delay = delay;
+
+  std::vector<OvmsVehicle::poll_pid_t> plist;
+  for (int p = 0; p < pids; p++)
+    {
+    for (int ecu = 0; ecu < ecus; ecu++)
+      {
+      OvmsVehicle::poll_pid_t entry = { (uint32_t)(0x7e0 + ecu), (uint32_t)(0x7e8 + ecu),
+        VEHICLE_POLL_TYPE_READDATA, { (uint16_t)(0x1000 + p) }, { 1, 1, 1, 1 }, 0, ISOTP_STD };
+      plist.push_back(entry);
+      }
+    }
+  OvmsVehicle::poll_pid_t end = POLL_LIST_END;
+  plist.push_back(end);
+
+  writer->printf("%d ECUs, %d PIDs each, %d byte responses, %d ms ECU delay, %d seconds per mode:\n",
+    ecus, pids, size, delay, seconds);
+
+  for (int concurrency : { 0, ecus })
+    {
+    test_pollvehicle* vehicle = new test_pollvehicle(simbus, plist.data(), concurrency, ecus * pids);
+    vTaskDelay(pdMS_TO_TICKS(seconds * 1000 + 500));
+    vehicle->Stop();
+    vTaskDelay(pdMS_TO_TICKS(100));
+    if (concurrency == 0)
+      writer->printf("  serial      : ");
+    else
+      writer->printf("  concurrent %d: ", concurrency);
+    if (vehicle->m_cycles)
+      writer->printf("%d cycles, duration avg %u us, max %u us\n", vehicle->m_cycles,
+        vehicle->m_cycle_sum / vehicle->m_cycles, vehicle->m_cycle_max);
+    else
+      writer->puts("no complete cycle");
+    delete vehicle;
+    }
+
+  simbus->Stop();
+  }
+
+#endif // CONFIG_OVMS_VEHICLE_POLLER_TESTSIM
@@ -285,6 +285,7 @@ OvmsVehicleBMWi3::OvmsVehicleBMWi3()
         StdMetrics.ms_v_env_on->SetValue(false);
     PollSetThrottling(50);
     PollSetResponseSeparationTime(5);
+    PollSetConcurrency(4);
 }
 
 OvmsVehicleBMWi3::~OvmsVehicleBMWi3()
@@ -387,7 +388,8 @@ void OvmsVehicleBMWi3::Ticker10(uint32_t ticker)
 
 void OvmsVehicleBMWi3::IncomingPollReply(canbus* bus, uint16_t type, uint16_t pid, uint8_t* data, uint8_t length, uint16_t mlremain)
 {
-    string& rxbuf = bmwi3_obd_rxbuf;
+    // ECUs are polled concurrently, so responses may interleave:
+    string& rxbuf = bmwi3_obd_rxbuf[m_poll_moduleid_low];
   
     // Assemble first and following frames to get complete reply
     
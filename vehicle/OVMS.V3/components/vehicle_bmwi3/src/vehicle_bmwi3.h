@@ -74,7 +74,7 @@ class OvmsVehicleBMWi3 : public OvmsVehicle
 
 
   protected:
-    string bmwi3_obd_rxbuf;                               // CAN messages unpacked into here
+    std::map<uint32_t, string> bmwi3_obd_rxbuf;           // CAN messages unpacked into here, by ECU (response ID)
     float hv_volts;                                       // Traction battery voltage - used to calculate power from current
     float soc = 0.0f;                                     // Remember SOC for derivative calcs
     int framecount = 0, tickercount = 0, replycount = 0;  // Keep track of when the car is talking or schtum.
@@ -594,7 +594,7 @@ void OvmsVehicleKiaNiroEv::Ticker300(uint32_t ticker)
 	Save12VHistory();
 	}
 
-void OvmsVehicleKiaNiroEv::EventListener(std::string event, void* data)
+void OvmsVehicleKiaNiroEv::EventListener(const std::string& event, void* data)
   {
   if (event == "app.connected")
     {
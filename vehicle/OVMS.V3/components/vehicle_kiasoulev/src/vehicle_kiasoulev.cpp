@@ -703,7 +703,7 @@ void OvmsVehicleKiaSoulEv::Ticker300(uint32_t ticker)
 	{
 	}
 
-void OvmsVehicleKiaSoulEv::EventListener(std::string event, void* data)
+void OvmsVehicleKiaSoulEv::EventListener(const std::string& event, void* data)
   {
   if (event == "app.connected")
     {
@@ -82,7 +82,7 @@ class OvmsVehicleKiaSoulEv : public KiaVehicle
     void Ticker1(uint32_t ticker);
     void Ticker10(uint32_t ticker);
     void Ticker300(uint32_t ticker);
-    void EventListener(std::string event, void* data);
+    void EventListener(const std::string& event, void* data);
     void IncomingPollReply(canbus* bus, uint16_t type, uint16_t pid, uint8_t* data, uint8_t length, uint16_t mlremain);
     void ConfigChanged(OvmsConfigParam* param);
     bool SetFeature(int key, const char* value);
@@ -175,7 +175,7 @@ SevconClient* SevconClient::GetInstance(OvmsWriter* writer /*=NULL*/)
 }
 
 
-void SevconClient::UnmountListener(string event, void* data)
+void SevconClient::UnmountListener(const std::string& event, void* data)
 {
   // close monitor recording file:
   if (m_mon_file) {
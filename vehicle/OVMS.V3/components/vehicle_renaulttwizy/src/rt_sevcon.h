@@ -124,8 +124,8 @@ class SevconClient : public InternalRamAllocated
   
   public:
     // Framework interface:
-    void EmcyListener(string event, void* data);
-    void UnmountListener(string event, void* data);
+    void EmcyListener(const std::string& event, void* data);
+    void UnmountListener(const std::string& event, void* data);
     void SetStatus(bool car_awake);
     void Ticker1(uint32_t ticker);
   
@@ -230,7 +230,7 @@ static const SC_FaultCode_t SC_FaultCode[] = {
 #define FC_PreOp          0x4681      // controller in pre-operational state
 #define FC_SlaveState     0x4f01      // unexpected slave state: no error/suppress in cfgmode
 
-void SevconClient::EmcyListener(string event, void* data)
+void SevconClient::EmcyListener(const std::string& event, void* data)
 {
   CANopenEMCYEvent_t& emcy = *((CANopenEMCYEvent_t*)data);
 
@@ -371,7 +371,7 @@ const std::string OvmsVehicleRenaultTwizy::GetFeature(int key)
  * EventListener:
  *  - update GPS log ASAP
  */
-void OvmsVehicleRenaultTwizy::EventListener(string event, void* data)
+void OvmsVehicleRenaultTwizy::EventListener(const std::string& event, void* data)
 {
   if (event == "gps.lock.acquired")
   {
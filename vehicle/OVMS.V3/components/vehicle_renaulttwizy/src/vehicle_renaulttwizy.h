@@ -105,7 +105,7 @@ class OvmsVehicleRenaultTwizy : public OvmsVehicle
     void ConfigChanged(OvmsConfigParam* param);
     bool SetFeature(int key, const char* value);
     const std::string GetFeature(int key);
-    void EventListener(string event, void* data);
+    void EventListener(const std::string& event, void* data);
     vehicle_command_t ProcessMsgCommand(std::string &result, int command, const char* args);
 
   protected:
@@ -22,7 +22,7 @@ void OvmsVehicleSmartED::SaveStatus() {
       return;
     }
 
-    for (OvmsMetric* m=MyMetrics.m_first; m != NULL; m=m->m_next) {
+    for (OvmsMetric* m=MyMetrics.First(); m != NULL; m=m->m_next) {
       const char *k = m->m_name;
       std::string v = m->AsString();
       
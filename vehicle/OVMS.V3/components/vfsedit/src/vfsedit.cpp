@@ -30,6 +30,7 @@
 
 #include "vfsedit.h"
 #include "openemacs.h"
+#include "ovms_events.h"
 
 size_t vfs_edit_write(struct editor_state* E, const char *buf, size_t nbyte)
   {
@@ -42,7 +43,13 @@ bool vfs_edit_insert(OvmsWriter* writer, void* ctx, char ch)
   {
   struct editor_state* ed = (struct editor_state*)ctx;
 
+  bool dirty = ed->dirty;
   editor_process_keypress(ed, ch);
+  if (dirty && !ed->dirty && ed->filename)
+    {
+    // file has been saved:
+    MyEvents.SignalEvent("system.vfs.file.changed", (void*)ed->filename, strlen(ed->filename)+1);
+    }
   if (ed->editor_completed)
     {
     editor_free(ed);
@@ -56,6 +56,12 @@ MetricsStandard::MetricsStandard()
   ms_m_net_mdm_iccid = new OvmsMetricString(MS_N_MDM_ICCID, SM_STALE_MAX);
   ms_m_net_mdm_model = new OvmsMetricString(MS_N_MDM_MODEL, SM_STALE_MAX);
 
+  ms_m_poll_cycletime = new OvmsMetricFloat(MS_M_POLL_CYCLETIME, SM_STALE_MID, Seconds);
+  ms_m_poll_rate = new OvmsMetricFloat(MS_M_POLL_RATE, SM_STALE_MID);
+  ms_m_poll_timeouts = new OvmsMetricInt(MS_M_POLL_TIMEOUTS, SM_STALE_MID);
+  ms_m_poll_errors = new OvmsMetricInt(MS_M_POLL_ERRORS, SM_STALE_MID);
+  ms_m_poll_busload = new OvmsMetricFloat(MS_M_POLL_BUSLOAD, SM_STALE_MID, Percentage);
+
 #ifdef CONFIG_OVMS_COMP_MAX7317
   ms_m_egpio_input = new OvmsMetricBitset<10,0>(MS_M_EGPIO_INPUT, SM_STALE_MAX);
   ms_m_egpio_output = new OvmsMetricBitset<10,0>(MS_M_EGPIO_OUTPUT, SM_STALE_MAX);
@@ -59,6 +59,12 @@
 #define MS_N_WIFI_NETWORK           "m.net.wifi.network"
 #define MS_N_WIFI_SQ                "m.net.wifi.sq"
 
+#define MS_M_POLL_CYCLETIME         "m.poll.cycletime"
+#define MS_M_POLL_RATE              "m.poll.rate"
+#define MS_M_POLL_TIMEOUTS          "m.poll.timeouts"
+#define MS_M_POLL_ERRORS            "m.poll.errors"
+#define MS_M_POLL_BUSLOAD           "m.poll.busload"
+
 #ifdef CONFIG_OVMS_COMP_MAX7317
 #define MS_M_EGPIO_INPUT            "m.egpio.input"
 #define MS_M_EGPIO_MONITOR          "m.egpio.monitor"
@@ -289,6 +295,12 @@ class MetricsStandard
     OvmsMetricString* ms_m_net_mdm_iccid;
     OvmsMetricString* ms_m_net_mdm_model;
 
+    OvmsMetricFloat*  ms_m_poll_cycletime;                // Vehicle poller: last poll list cycle duration [s]
+    OvmsMetricFloat*  ms_m_poll_rate;                     // Vehicle poller: responses per second [1/s]
+    OvmsMetricInt*    ms_m_poll_timeouts;                 // Vehicle poller: response timeouts (since stats reset)
+    OvmsMetricInt*    ms_m_poll_errors;                   // Vehicle poller: negative responses (since stats reset)
+    OvmsMetricFloat*  ms_m_poll_busload;                  // Vehicle poller: estimated bus load of poll traffic [%]
+
 #ifdef CONFIG_OVMS_COMP_MAX7317
     OvmsMetricBitset<10,0>* ms_m_egpio_input;             // EGPIO (MAX7317) input port state (ports 0…9)
     OvmsMetricBitset<10,0>* ms_m_egpio_output;            // EGPIO (MAX7317) output port state
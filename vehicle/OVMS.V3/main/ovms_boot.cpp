@@ -364,7 +364,7 @@ void Boot::RestartReady(const char* tag)
     m_restart_timer = 2;
   }
 
-void Boot::Ticker1(std::string event, void* data)
+void Boot::Ticker1(const std::string& event, void* data)
   {
   if (m_restart_timer > 0)
     {
@@ -420,11 +420,11 @@ void Boot::ErrorCallback(XtExcFrame *frame, int core_id, bool is_abort)
     boot_data.crash_data.bt[i++].pc = 0;
 
   // Save Event debug info:
-  if (!MyEvents.m_current_event.empty())
+  if (MyEvents.m_current_event)
     {
-    strlcpy(boot_data.curr_event_name, MyEvents.m_current_event.c_str(), sizeof(boot_data.curr_event_name));
+    strlcpy(boot_data.curr_event_name, MyEvents.m_current_event, sizeof(boot_data.curr_event_name));
     if (MyEvents.m_current_callback)
-      strlcpy(boot_data.curr_event_handler, MyEvents.m_current_callback->m_caller.c_str(), sizeof(boot_data.curr_event_handler));
+      strlcpy(boot_data.curr_event_handler, MyEvents.m_current_callback->m_caller, sizeof(boot_data.curr_event_handler));
     else
       strlcpy(boot_data.curr_event_handler, "EventScript", sizeof(boot_data.curr_event_handler));
     boot_data.curr_event_runtime = monotonictime - MyEvents.m_current_started;
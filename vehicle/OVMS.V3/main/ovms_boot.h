@@ -109,7 +109,7 @@ class Boot
     void RestartPending(const char* tag);
     void RestartReady(const char* tag);
     bool IsShuttingDown();
-    void Ticker1(std::string event, void* data);
+    void Ticker1(const std::string& event, void* data);
 
   public:
     OvmsMutex m_restart_mutex;
@@ -1476,7 +1476,7 @@ void OvmsCommandApp::ShowLogStatus(int verbosity, OvmsWriter* writer)
     , m_logtask_fsynctime / 1e6);
   }
 
-void OvmsCommandApp::EventHandler(std::string event, void* data)
+void OvmsCommandApp::EventHandler(const std::string& event, void* data)
   {
   if (event == "config.changed")
     {
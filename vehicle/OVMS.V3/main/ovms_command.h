@@ -343,7 +343,7 @@ class OvmsCommandApp : public OvmsWriter
     void ExpireLogFiles(int verbosity, OvmsWriter* writer, int keepdays);
     void ShowLogStatus(int verbosity, OvmsWriter* writer);
     static void ExpireTask(void* data);
-    void EventHandler(std::string event, void* data);
+    void EventHandler(const std::string& event, void* data);
 
   private:
     bool CycleLogfile();
@@ -33,6 +33,7 @@ static const char *TAG = "events";
 
 #include <string.h>
 #include <stdio.h>
+#include <new>
 #include <esp_event_loop.h>
 #include <esp_task_wdt.h>
 #include "ovms_module.h"
@@ -46,7 +47,7 @@ OvmsEvents MyEvents __attribute__ ((init_priority (1200)));
 
 typedef void (*event_signal_done_fn)(const char* event, void* data);
 
-bool EventMap::GetCompletion(OvmsWriter* writer, const char* token) const
+bool OvmsEvents::GetCompletion(OvmsWriter* writer, const char* token)
   {
   unsigned int index = 0;
   bool match = false;
@@ -54,15 +55,19 @@ bool EventMap::GetCompletion(OvmsWriter* writer, const char* token) const
   if (token)
     {
     size_t len = strlen(token);
-    for (const_iterator it = begin(); it != end(); ++it)
+    std::set<std::string> sorted;
+    for (event_id_t id = 0; id < m_count; id++)
       {
-      if (it->first.compare("*") == 0)
+      event_entry_t* entry = Entry(id);
+      if (id == m_wildcard || entry->callbacks.empty())
         continue;
-      if (it->first.compare(0, len, token) == 0)
-        {
-        writer->SetCompletion(index++, it->first.c_str());
-        match = true;
-        }
+      if (entry->name.compare(0, len, token) == 0)
+        sorted.insert(entry->name);
+      }
+    for (auto it = sorted.begin(); it != sorted.end(); ++it)
+      {
+      writer->SetCompletion(index++, it->c_str());
+      match = true;
       }
     }
   return match;
@@ -92,17 +97,25 @@ void event_trace(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
 
 void event_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
-  writer->printf("Event map has %d listeners, and queue has %d/%d entries\n",
-    MyEvents.Map().size(),
+  int listened = 0;
+  for (event_id_t id = 0; id < MyEvents.Count(); id++)
+    {
+    if (!MyEvents.Entry(id)->callbacks.empty())
+      listened++;
+    }
+  writer->printf("Event map has %d listeners, %d interned events, and queue has %d/%d entries\n",
+    listened,
+    MyEvents.Count(),
     uxQueueMessagesWaiting(MyEvents.m_taskqueue),
     CONFIG_OVMS_HW_EVENT_QUEUE_SIZE);
+  writer->printf("Events dispatched: %u\n", MyEvents.m_dispatched);
 
   EventCallbackEntry* cbe = MyEvents.m_current_callback;
   if (cbe != NULL)
     {
     writer->printf("Currently dispatching:\n");
-    writer->printf("  Event: %s\n",MyEvents.m_current_event.c_str());
-    writer->printf("  To:    %s\n",cbe->m_caller.c_str());
+    writer->printf("  Event: %s\n",MyEvents.m_current_event ? MyEvents.m_current_event : "");
+    writer->printf("  To:    %s\n",cbe->m_caller);
     writer->printf("  For:   %u second(s)\n",monotonictime-MyEvents.m_current_started);
     }
   }
@@ -110,7 +123,14 @@ void event_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
 void event_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
   std::string event;
-  for (EventMap::const_iterator itm=MyEvents.Map().begin(); itm != MyEvents.Map().end(); ++itm)
+  std::map<std::string, EventCallbackList*> sorted;
+  for (event_id_t id = 0; id < MyEvents.Count(); id++)
+    {
+    event_entry_t* entry = MyEvents.Entry(id);
+    if (!entry->callbacks.empty())
+      sorted[entry->name] = &entry->callbacks;
+    }
+  for (auto itm=sorted.begin(); itm != sorted.end(); ++itm)
     {
     if (argc > 0 && itm->first.find(argv[0]) == std::string::npos)
       continue;
@@ -134,7 +154,7 @@ int event_validate(OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* c
   int argpos = 0;
   for (int i=0; i < argc; i++)
     argpos += (argv[i][0] != '-') ? 1 : 0;
-  if (argpos == 1 && MyEvents.Map().GetCompletion(writer, argv[argc-1]))
+  if (argpos == 1 && MyEvents.GetCompletion(writer, argv[argc-1]))
     return argc;
   return -1;
   }
@@ -169,6 +189,14 @@ OvmsEvents::OvmsEvents()
   ESP_LOGI(TAG, "Initialising EVENTS (1200)");
 
   m_current_callback = NULL;
+  m_current_event = NULL;
+  m_dispatched = 0;
+  memset(m_table, 0, sizeof(m_table));
+  m_count = 0;
+  m_hash = (std::atomic<event_id_t>*) ExternalRamMalloc(EVENT_HASH_SIZE * sizeof(std::atomic<event_id_t>));
+  for (int i = 0; i < EVENT_HASH_SIZE; i++)
+    new (&m_hash[i]) std::atomic<event_id_t>(EVENT_ID_NONE);
+  m_wildcard = Intern("*");
 
 #ifdef CONFIG_OVMS_DEV_DEBUGEVENTS
   m_trace = true;
@@ -211,10 +239,9 @@ void OvmsEvents::EventTask()
         case EVENT_none:
           break;
         case EVENT_signal:
-          m_current_event = msg.body.signal.event;
           HandleQueueSignalEvent(&msg);
           esp_task_wdt_reset(); // Reset WATCHDOG timer for this task
-          m_current_event.clear();
+          m_current_event = NULL;
           break;
         default:
           break;
@@ -239,50 +266,66 @@ void OvmsEvents::EventTask()
 
 void OvmsEvents::HandleQueueSignalEvent(event_queue_t* msg)
   {
+  event_entry_t* entry;
+  const std::string* name;
+  if (msg->body.signal.event)
+    {
+    // not interned at signal time, a listener may have registered since:
+    m_current_name.assign(msg->body.signal.event);
+    entry = Entry(FindEvent(m_current_name));
+    name = entry ? &entry->name : &m_current_name;
+    }
+  else
+    {
+    entry = Entry(msg->body.signal.id);
+    if (!entry)
+      {
+      ESP_LOGE(TAG, "Signal: unknown event id %u dropped", msg->body.signal.id);
+      FreeQueueSignalEvent(msg);
+      return;
+      }
+    name = &entry->name;
+    }
+  m_current_event = name->c_str();
+
   // Log everything but the ticker & clock signals
-  if (!startsWith(m_current_event, "ticker.") && !startsWith(m_current_event, "clock."))
+  if (!startsWith(*name, "ticker.") && !startsWith(*name, "clock."))
     {
     if (m_trace)
-      ESP_LOGI(TAG, "Signal(%s)",m_current_event.c_str());
+      ESP_LOGI(TAG, "Signal(%s)",m_current_event);
     else
-      ESP_LOGD(TAG, "Signal(%s)",m_current_event.c_str());
+      ESP_LOGD(TAG, "Signal(%s)",m_current_event);
     }
 
-  auto k = m_map.find(m_current_event);
-  if (k != m_map.end())
+  if (entry)
     {
-    EventCallbackList* el = k->second;
-    if (el)
+    EventCallbackList* el = &entry->callbacks;
+    for (EventCallbackList::iterator itc=el->begin(); itc!=el->end(); ++itc)
       {
-      for (EventCallbackList::iterator itc=el->begin(); itc!=el->end(); ++itc)
-        {
-        m_current_started = monotonictime;
-        m_current_callback = *itc;
-        m_current_callback->m_callback(m_current_event, msg->body.signal.data);
-        m_current_callback = NULL;
-        }
+      m_current_started = monotonictime;
+      m_current_callback = *itc;
+      m_current_callback->m_callback(*name, msg->body.signal.data);
+      m_current_callback = NULL;
       }
     }
 
-  k = m_map.find("*");
-  if (k != m_map.end())
+  entry = Entry(m_wildcard);
+  if (entry)
     {
-    EventCallbackList* el = k->second;
-    if (el)
+    EventCallbackList* el = &entry->callbacks;
+    for (EventCallbackList::iterator itc=el->begin(); itc!=el->end(); ++itc)
       {
-      for (EventCallbackList::iterator itc=el->begin(); itc!=el->end(); ++itc)
-        {
-        m_current_started = monotonictime;
-        m_current_callback = *itc;
-        m_current_callback->m_callback(m_current_event, msg->body.signal.data);
-        m_current_callback = NULL;
-        }
+      m_current_started = monotonictime;
+      m_current_callback = *itc;
+      m_current_callback->m_callback(*name, msg->body.signal.data);
+      m_current_callback = NULL;
       }
     }
 
   m_current_started = monotonictime;
-  MyScripts.EventScript(m_current_event, msg->body.signal.data);
+  MyScripts.EventScript(*name, msg->body.signal.data);
 
+  m_dispatched++;
   FreeQueueSignalEvent(msg);
   }
 
@@ -290,40 +333,102 @@ void OvmsEvents::FreeQueueSignalEvent(event_queue_t* msg)
   {
   if (msg->body.signal.donefn != NULL)
     {
-    msg->body.signal.donefn(msg->body.signal.event, msg->body.signal.data);
+    const char* event = msg->body.signal.event ? msg->body.signal.event : EventName(msg->body.signal.id);
+    msg->body.signal.donefn(event, msg->body.signal.data);
     }
   free(msg->body.signal.event);
   }
 
-void OvmsEvents::RegisterEvent(std::string caller, std::string event, EventCallback callback)
+static uint32_t event_namehash(const char* name, size_t len)
   {
-  auto k = m_map.find(event);
-  if (k == m_map.end())
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++)
+    hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+  return hash;
+  }
+
+/**
+ * Intern: get the ID of an event, adding it to the table if necessary
+ *  The entry is complete before its ID is published in the hash index,
+ *  so FindEvent() can probe the index without locking.
+ */
+event_id_t OvmsEvents::Intern(const std::string& event)
+  {
+  OvmsMutexLock lock(&m_ids_mutex);
+  event_id_t id = FindEvent(event);
+  if (id != EVENT_ID_NONE)
+    return id;
+
+  id = m_count;
+  if (id >= EVENT_TABLE_CHUNKS * EVENT_TABLE_CHUNKSIZE || !m_hash)
     {
-    m_map[event] = new EventCallbackList();
-    k = m_map.find(event);
+    ESP_LOGE(TAG, "Intern: event table full, cannot add '%s'", event.c_str());
+    return EVENT_ID_NONE;
     }
-  if (k == m_map.end())
+  event_entry_t*& chunk = m_table[id / EVENT_TABLE_CHUNKSIZE];
+  if (chunk == NULL)
+    chunk = new event_entry_t[EVENT_TABLE_CHUNKSIZE];
+  event_entry_t* entry = &chunk[id % EVENT_TABLE_CHUNKSIZE];
+  entry->name = event;
+  entry->hash = event_namehash(event.data(), event.size());
+  m_count = id + 1;
+
+  size_t i;
+  for (i = entry->hash & (EVENT_HASH_SIZE-1); m_hash[i].load() != EVENT_ID_NONE; i = (i+1) & (EVENT_HASH_SIZE-1));
+  m_hash[i].store(id, std::memory_order_release);
+  return id;
+  }
+
+/**
+ * FindEvent: look up the ID of an interned event (lock free)
+ */
+event_id_t OvmsEvents::FindEvent(const std::string& event)
+  {
+  if (!m_hash)
+    return EVENT_ID_NONE;
+  uint32_t hash = event_namehash(event.data(), event.size());
+  event_id_t id;
+  for (size_t i = hash & (EVENT_HASH_SIZE-1);
+       (id = m_hash[i].load(std::memory_order_acquire)) != EVENT_ID_NONE;
+       i = (i+1) & (EVENT_HASH_SIZE-1))
+    {
+    event_entry_t* entry = Entry(id);
+    if (entry->hash == hash && entry->name == event)
+      return id;
+    }
+  return EVENT_ID_NONE;
+  }
+
+const char* OvmsEvents::InternCaller(const std::string& caller)
+  {
+  OvmsMutexLock lock(&m_ids_mutex);
+  return m_callers.insert(caller).first->c_str();
+  }
+
+void OvmsEvents::RegisterEvent(const std::string& caller, const std::string& event, EventCallback callback)
+  {
+  event_entry_t* entry = Entry(Intern(event));
+  if (entry == NULL)
     {
     ESP_LOGE(TAG, "Problem registering event %s for caller %s",event.c_str(),caller.c_str());
     return;
     }
 
-  EventCallbackList *el = k->second;
-  el->push_back(new EventCallbackEntry(caller,callback));
+  entry->callbacks.push_back(new EventCallbackEntry(InternCaller(caller),callback));
   }
 
-void OvmsEvents::DeregisterEvent(std::string caller)
+void OvmsEvents::DeregisterEvent(const std::string& caller)
   {
-  EventMap::iterator itm=m_map.begin();
-  while (itm!=m_map.end())
+  // Note: table entries are kept when empty, so their IDs remain valid
+  for (event_id_t id = 0; id < m_count; id++)
     {
-    EventCallbackList* el = itm->second;
+    EventCallbackList* el = &Entry(id)->callbacks;
     EventCallbackList::iterator itc=el->begin();
     while (itc!=el->end())
       {
       EventCallbackEntry* ec = *itc;
-      if (ec->m_caller == caller)
+      if (caller == ec->m_caller)
         {
         itc = el->erase(itc);
         delete ec;
@@ -333,27 +438,18 @@ void OvmsEvents::DeregisterEvent(std::string caller)
         ++itc;
         }
       }
-    if (el->empty())
-      {
-      itm = m_map.erase(itm);
-      delete el;
-      }
-    else
-      {
-      ++itm;
-      }
     }
   }
 
-static void CheckQueueOverflow(const char* from, char* event)
+static void CheckQueueOverflow(const char* from, const char* event)
   {
   EventCallbackEntry* cbe = MyEvents.m_current_callback;
   if (cbe != NULL)
     {
     ESP_LOGE(TAG, "%s: queue overflow (running %s->%s for %u sec), event '%s' dropped",
       from,
-      MyEvents.m_current_event.c_str(),
-      cbe->m_caller.c_str(),
+      MyEvents.m_current_event ? MyEvents.m_current_event : "",
+      cbe->m_caller,
       monotonictime-MyEvents.m_current_started,
       event);
     }
@@ -380,7 +476,8 @@ static void SignalScheduledEvent(TimerHandle_t timer)
   event_queue_t* msg = (event_queue_t*) pvTimerGetTimerID(timer);
   if (xQueueSend(MyEvents.m_taskqueue, msg, 0) != pdTRUE)
     {
-    CheckQueueOverflow("SignalScheduledEvent", msg->body.signal.event);
+    const char* event = msg->body.signal.event ? msg->body.signal.event : MyEvents.EventName(msg->body.signal.id);
+    CheckQueueOverflow("SignalScheduledEvent", event);
     MyEvents.FreeQueueSignalEvent(msg);
     }
   delete msg;
@@ -433,73 +530,120 @@ bool OvmsEvents::ScheduleEvent(event_queue_t* msg, uint32_t delay_ms)
   return true;
   }
 
-void OvmsEvents::SignalEvent(std::string event, void* data, event_signal_done_fn callback /*=NULL*/,
-                             uint32_t delay_ms /*=0*/)
+bool OvmsEvents::QueueEvent(event_queue_t* msg, uint32_t delay_ms)
   {
-  event_queue_t msg;
-  memset(&msg, 0, sizeof(msg));
-
-  msg.type = EVENT_signal;
-  msg.body.signal.event = (char*)ExternalRamMalloc(event.size()+1);
-  strcpy(msg.body.signal.event, event.c_str());
-  msg.body.signal.data = data;
-  msg.body.signal.donefn = callback;
-
+  const char* event = msg->body.signal.event ? msg->body.signal.event : EventName(msg->body.signal.id);
   if (delay_ms == 0)
     {
-    if (xQueueSend(m_taskqueue, &msg, 0) != pdTRUE)
+    if (xQueueSend(m_taskqueue, msg, 0) != pdTRUE)
       {
-      CheckQueueOverflow("SignalEvent", msg.body.signal.event);
-      FreeQueueSignalEvent(&msg);
+      CheckQueueOverflow("SignalEvent", event);
+      FreeQueueSignalEvent(msg);
+      return false;
       }
     }
   else
     {
-    if (ScheduleEvent(&msg, delay_ms) != true)
+    if (ScheduleEvent(msg, delay_ms) != true)
       {
-      ESP_LOGE(TAG, "SignalEvent: no timer available, event '%s' dropped", msg.body.signal.event);
-      FreeQueueSignalEvent(&msg);
+      ESP_LOGE(TAG, "SignalEvent: no timer available, event '%s' dropped", event);
+      FreeQueueSignalEvent(msg);
+      return false;
       }
     }
+  return true;
   }
 
-void OvmsEvents::SignalEvent(std::string event, void* data, size_t length,
-                             uint32_t delay_ms /*=0*/)
+static void SetSignalData(event_queue_t* msg, void* data, size_t length)
   {
-  event_queue_t msg;
-  memset(&msg, 0, sizeof(msg));
-
-  msg.type = EVENT_signal;
-  msg.body.signal.event = (char*)ExternalRamMalloc(event.size()+1);
-  strcpy(msg.body.signal.event, event.c_str());
   if (data != NULL)
     {
-    msg.body.signal.data = ExternalRamMalloc(length);
-    memcpy(msg.body.signal.data, data, length);
-    msg.body.signal.donefn = EventStdFree;
+    msg->body.signal.data = ExternalRamMalloc(length);
+    memcpy(msg->body.signal.data, data, length);
+    msg->body.signal.donefn = EventStdFree;
     }
   else
     {
-    msg.body.signal.data = NULL;
-    msg.body.signal.donefn = NULL;
+    msg->body.signal.data = NULL;
+    msg->body.signal.donefn = NULL;
     }
+  }
 
-  if (delay_ms == 0)
+static void SetSignalName(event_queue_t* msg, const std::string& event)
+  {
+  msg->body.signal.id = EVENT_ID_NONE;
+  msg->body.signal.event = (char*)ExternalRamMalloc(event.size()+1);
+  strcpy(msg->body.signal.event, event.c_str());
+  }
+
+void OvmsEvents::SignalEvent(const std::string& event, void* data, event_signal_done_fn callback /*=NULL*/,
+                             uint32_t delay_ms /*=0*/)
+  {
+  event_id_t id = FindEvent(event);
+  if (id != EVENT_ID_NONE)
+    return SignalEvent(id, data, callback, delay_ms);
+
+  event_queue_t msg;
+  memset(&msg, 0, sizeof(msg));
+
+  msg.type = EVENT_signal;
+  SetSignalName(&msg, event);
+  msg.body.signal.data = data;
+  msg.body.signal.donefn = callback;
+  QueueEvent(&msg, delay_ms);
+  }
+
+void OvmsEvents::SignalEvent(const std::string& event, void* data, size_t length,
+                             uint32_t delay_ms /*=0*/)
+  {
+  event_id_t id = FindEvent(event);
+  if (id != EVENT_ID_NONE)
+    return SignalEvent(id, data, length, delay_ms);
+
+  event_queue_t msg;
+  memset(&msg, 0, sizeof(msg));
+
+  msg.type = EVENT_signal;
+  SetSignalName(&msg, event);
+  SetSignalData(&msg, data, length);
+  QueueEvent(&msg, delay_ms);
+  }
+
+void OvmsEvents::SignalEvent(event_id_t id, void* data, event_signal_done_fn callback /*=NULL*/,
+                             uint32_t delay_ms /*=0*/)
+  {
+  if (!Entry(id))
     {
-    if (xQueueSend(m_taskqueue, &msg, 0) != pdTRUE)
-      {
-      CheckQueueOverflow("SignalEvent", msg.body.signal.event);
-      FreeQueueSignalEvent(&msg);
-      }
+    ESP_LOGE(TAG, "SignalEvent: unknown event id %u dropped", id);
+    return;
     }
-  else
+  event_queue_t msg;
+  memset(&msg, 0, sizeof(msg));
+
+  msg.type = EVENT_signal;
+  msg.body.signal.id = id;
+  msg.body.signal.event = NULL;
+  msg.body.signal.data = data;
+  msg.body.signal.donefn = callback;
+  QueueEvent(&msg, delay_ms);
+  }
+
+void OvmsEvents::SignalEvent(event_id_t id, void* data, size_t length,
+                             uint32_t delay_ms /*=0*/)
+  {
+  if (!Entry(id))
     {
-    if (ScheduleEvent(&msg, delay_ms) != true)
-      {
-      ESP_LOGE(TAG, "SignalEvent: no timer available, event '%s' dropped", msg.body.signal.event);
-      FreeQueueSignalEvent(&msg);
-      }
+    ESP_LOGE(TAG, "SignalEvent: unknown event id %u dropped", id);
+    return;
     }
+  event_queue_t msg;
+  memset(&msg, 0, sizeof(msg));
+
+  msg.type = EVENT_signal;
+  msg.body.signal.id = id;
+  msg.body.signal.event = NULL;
+  SetSignalData(&msg, data, length);
+  QueueEvent(&msg, delay_ms);
   }
 
 esp_err_t OvmsEvents::ReceiveSystemEvent(void *ctx, system_event_t *event)
@@ -595,7 +739,7 @@ void OvmsEvents::SignalSystemEvent(system_event_t *event)
     }
   }
 
-EventCallbackEntry::EventCallbackEntry(std::string caller, EventCallback callback)
+EventCallbackEntry::EventCallbackEntry(const char* caller, EventCallback callback)
   {
   m_caller = caller;
   m_callback = callback;
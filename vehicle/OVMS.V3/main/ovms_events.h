@@ -34,7 +34,9 @@
 #include <string>
 #include <functional>
 #include <map>
+#include <set>
 #include <list>
+#include <atomic>
 #include <esp_event.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -43,26 +45,39 @@
 #include "ovms_command.h"
 #include "ovms_mutex.h"
 
-typedef std::function<void(std::string,void*)> EventCallback;
+typedef std::function<void(const std::string&,void*)> EventCallback;
 
 class EventCallbackEntry
   {
   public:
-    EventCallbackEntry(std::string caller, EventCallback callback);
+    EventCallbackEntry(const char* caller, EventCallback callback);
     virtual ~EventCallbackEntry();
 
   public:
-    std::string m_caller;
+    const char* m_caller;                     // interned, see OvmsEvents::InternCaller()
     EventCallback m_callback;
   };
 
 typedef std::list<EventCallbackEntry*> EventCallbackList;
 
-class EventMap : public  std::map<std::string, EventCallbackList*>
+/**
+ * Event IDs:
+ *  Event names are interned to small integer IDs on registration (or by Intern()),
+ *  the dispatch table is indexed by ID. The table is allocated in chunks that
+ *  never move, so the event task can read entries without locking.
+ */
+typedef uint16_t event_id_t;
+#define EVENT_ID_NONE           0xffff
+#define EVENT_TABLE_CHUNKSIZE   64
+#define EVENT_TABLE_CHUNKS      32        // → max 2048 interned events
+#define EVENT_HASH_SIZE         4096      // name → ID index slots (power of 2, > max events)
+
+typedef struct
   {
-  public:
-    bool GetCompletion(OvmsWriter* writer, const char* token) const;
-  };
+  std::string name;
+  uint32_t hash;
+  EventCallbackList callbacks;
+  } event_entry_t;
 
 typedef void (*event_signal_done_fn)(const char* event, void* data);
 
@@ -80,7 +95,8 @@ typedef struct
     {
     struct
       {
-      char* event;
+      event_id_t id;          // interned event, or EVENT_ID_NONE
+      char* event;            // name of non-interned event, else NULL
       void* data;
       event_signal_done_fn donefn;
       } signal;
@@ -97,10 +113,30 @@ class OvmsEvents
     ~OvmsEvents();
 
   public:
-    void RegisterEvent(std::string caller, std::string event, EventCallback callback);
-    void DeregisterEvent(std::string caller);
-    void SignalEvent(std::string event, void* data, event_signal_done_fn callback = NULL, uint32_t delay_ms = 0);
-    void SignalEvent(std::string event, void* data, size_t length, uint32_t delay_ms = 0);
+    void RegisterEvent(const std::string& caller, const std::string& event, EventCallback callback);
+    void DeregisterEvent(const std::string& caller);
+    void SignalEvent(const std::string& event, void* data, event_signal_done_fn callback = NULL, uint32_t delay_ms = 0);
+    void SignalEvent(const std::string& event, void* data, size_t length, uint32_t delay_ms = 0);
+    void SignalEvent(event_id_t id, void* data, event_signal_done_fn callback = NULL, uint32_t delay_ms = 0);
+    void SignalEvent(event_id_t id, void* data, size_t length, uint32_t delay_ms = 0);
+
+  public:
+    event_id_t Intern(const std::string& event);
+    event_id_t FindEvent(const std::string& event);
+    event_id_t Count() { return m_count; }
+    event_entry_t* Entry(event_id_t id)
+      {
+      return (id < m_count) ? &m_table[id / EVENT_TABLE_CHUNKSIZE][id % EVENT_TABLE_CHUNKSIZE] : NULL;
+      }
+    const char* EventName(event_id_t id)
+      {
+      event_entry_t* e = Entry(id);
+      return e ? e->name.c_str() : "";
+      }
+    bool GetCompletion(OvmsWriter* writer, const char* token);
+
+  protected:
+    const char* InternCaller(const std::string& caller);
 
   public:
     void EventTask();
@@ -108,13 +144,18 @@ class OvmsEvents
     void FreeQueueSignalEvent(event_queue_t* msg);
     static esp_err_t ReceiveSystemEvent(void *ctx, system_event_t *event);
     void SignalSystemEvent(system_event_t *event);
-    const EventMap& Map() { return m_map; }
 
   protected:
+    bool QueueEvent(event_queue_t* msg, uint32_t delay_ms);
     bool ScheduleEvent(event_queue_t* msg, uint32_t delay_ms);
 
   protected:
-    EventMap m_map;
+    event_entry_t* m_table[EVENT_TABLE_CHUNKS];
+    std::atomic<event_id_t> m_count;
+    std::atomic<event_id_t>* m_hash;        // name hash index, open addressing, insert only
+    std::set<std::string> m_callers;
+    OvmsMutex m_ids_mutex;
+    event_id_t m_wildcard;
     TimerList m_timers;
     OvmsMutex m_timers_mutex;
 
@@ -122,13 +163,20 @@ class OvmsEvents
     bool m_trace;
     TaskHandle_t m_taskid;
     QueueHandle_t m_taskqueue;
+    uint32_t m_dispatched;
 
   public:
     EventCallbackEntry* m_current_callback;
-    std::string m_current_event;
+    const char* m_current_event;            // name of the event being dispatched, NULL if idle
+    std::string m_current_name;             // name buffer for events not interned
     uint32_t m_current_started;
   };
 
 extern OvmsEvents MyEvents;
 
+// EVENT_ID: get the ID of an event name, interned once per call site
+//  Use this to signal frequent events without the name lookup, e.g.
+//    MyEvents.SignalEvent(EVENT_ID("vehicle.charge.start"), NULL);
+#define EVENT_ID(name)  ([]() -> event_id_t { static const event_id_t id = MyEvents.Intern(name); return id; }())
+
 #endif //#ifndef __EVENT_H__
@@ -66,6 +66,7 @@ static const char *TAG = "housekeeping";
 #define AUTO_INIT_INHIBIT_CRASHCOUNT    5
 
 static int tick = 0;
+static event_id_t ev_ticker_1, ev_ticker_10, ev_ticker_60, ev_ticker_300, ev_ticker_600, ev_ticker_3600;
 
 void HousekeepingUpdate12V()
   {
@@ -98,17 +99,17 @@ void HousekeepingTicker1( TimerHandle_t timer )
   StandardMetrics.ms_m_timeutc->SetValue((int)time(NULL));
 
   HousekeepingUpdate12V();
-  MyEvents.SignalEvent("ticker.1", NULL);
+  MyEvents.SignalEvent(ev_ticker_1, NULL);
 
   tick++;
-  if ((tick % 10)==0) MyEvents.SignalEvent("ticker.10", NULL);
-  if ((tick % 60)==0) MyEvents.SignalEvent("ticker.60", NULL);
-  if ((tick % 300)==0) MyEvents.SignalEvent("ticker.300", NULL);
-  if ((tick % 600)==0) MyEvents.SignalEvent("ticker.600", NULL);
+  if ((tick % 10)==0) MyEvents.SignalEvent(ev_ticker_10, NULL);
+  if ((tick % 60)==0) MyEvents.SignalEvent(ev_ticker_60, NULL);
+  if ((tick % 300)==0) MyEvents.SignalEvent(ev_ticker_300, NULL);
+  if ((tick % 600)==0) MyEvents.SignalEvent(ev_ticker_600, NULL);
   if ((tick % 3600)==0)
     {
     tick = 0;
-    MyEvents.SignalEvent("ticker.3600", NULL);
+    MyEvents.SignalEvent(ev_ticker_3600, NULL);
     }
 
   time_t rawtime;
@@ -143,6 +144,14 @@ Housekeeping::Housekeeping()
   MyEvents.RegisterEvent(TAG,"ticker.10", std::bind(&Housekeeping::Metrics, this, _1, _2));
   MyEvents.RegisterEvent(TAG,"ticker.300", std::bind(&Housekeeping::TimeLogger, this, _1, _2));
 
+  // Intern the ticker events, so the timer signals them by ID:
+  ev_ticker_1 = MyEvents.Intern("ticker.1");
+  ev_ticker_10 = MyEvents.Intern("ticker.10");
+  ev_ticker_60 = MyEvents.Intern("ticker.60");
+  ev_ticker_300 = MyEvents.Intern("ticker.300");
+  ev_ticker_600 = MyEvents.Intern("ticker.600");
+  ev_ticker_3600 = MyEvents.Intern("ticker.3600");
+
   // Fire off the event that causes us to be called back in Events tasks context
   MyEvents.SignalEvent("housekeeping.init", NULL);
   }
@@ -151,7 +160,7 @@ Housekeeping::~Housekeeping()
   {
   }
 
-void Housekeeping::Init(std::string event, void* data)
+void Housekeeping::Init(const std::string& event, void* data)
   {
   ESP_LOGI(TAG, "Executing on CPU core %d",xPortGetCoreID());
   ESP_LOGI(TAG, "reset_reason: cpu0=%d, cpu1=%d", rtc_get_reset_reason(0), rtc_get_reset_reason(1));
@@ -240,7 +249,7 @@ void Housekeeping::Init(std::string event, void* data)
   Metrics(event,data); // Causes the metrics to be produced
   }
 
-void Housekeeping::Metrics(std::string event, void* data)
+void Housekeeping::Metrics(const std::string& event, void* data)
   {
   OvmsMetricInt* m2 = StandardMetrics.ms_m_tasks;
   if (m2 == NULL)
@@ -270,7 +279,7 @@ void Housekeeping::Metrics(std::string event, void* data)
     }
   }
 
-void Housekeeping::TimeLogger(std::string event, void* data)
+void Housekeeping::TimeLogger(const std::string& event, void* data)
   {
   time_t rawtime;
   time ( &rawtime );
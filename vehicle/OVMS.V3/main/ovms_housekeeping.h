@@ -44,9 +44,9 @@ class Housekeeping
     virtual ~Housekeeping();
 
   public:
-    void Init(std::string event, void* data);
-    void Metrics(std::string event, void* data);
-    void TimeLogger(std::string event, void* data);
+    void Init(const std::string& event, void* data);
+    void Metrics(const std::string& event, void* data);
+    void TimeLogger(const std::string& event, void* data);
 
   protected:
     TimerHandle_t m_timer1;
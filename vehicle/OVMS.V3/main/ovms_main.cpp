@@ -14,6 +14,7 @@ static const char *TAG = "ovms_main";
 #include "ovms_housekeeping.h"
 #include "ovms_events.h"
 #include "ovms_config.h"
+#include "ovms_metrics.h"
 #include "ovms_module.h"
 #include <esp_task_wdt.h>
 
@@ -63,6 +64,9 @@ void app_main(void)
   ESP_LOGI(TAG, "Registering default configs...");
   MyConfig.RegisterParam("vehicle", "Vehicle", true, true);
 
+  ESP_LOGI(TAG, "Building METRICS registry...");
+  MyMetrics.BuildRegistry();
+
   ESP_LOGI(TAG, "Starting HOUSEKEEPING...");
   MyHousekeeping = new Housekeeping();
   }
@@ -36,11 +36,14 @@ static const char *TAG = "metrics";
 #include <sstream>
 #include <functional>
 #include <map>
+#include <algorithm>
 #include "ovms.h"
 #include "ovms_metrics.h"
 #include "ovms_command.h"
 #include "ovms_events.h"
 #include "ovms_script.h"
+#include "ovms_malloc.h"
+#include "esp_timer.h"
 #include "rom/rtc.h"
 #include "string.h"
 
@@ -58,6 +61,19 @@ std::map<std::size_t, const char*>      pmetrics_keymap       // hash key → me
 OvmsMetrics                             MyMetrics
                                         __attribute__ ((init_priority (1800)));
 
+#define METRICS_HASH_MINSIZE           256                   // initial hash index slots (power of 2)
+
+/**
+ * metric_namehash: FNV-1a hash of a metric name, used for the lookup index
+ */
+static inline uint32_t metric_namehash(const char* name)
+  {
+  uint32_t hash = 2166136261u;
+  for (const char* cp = name; *cp; cp++)
+    hash = (hash ^ (uint8_t)*cp) * 16777619u;
+  return hash;
+  }
+
 void metrics_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
   bool found = false;
@@ -91,28 +107,32 @@ void metrics_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
     }
   int firstmetric = i;
   bool show_only = (firstmetric < argc);
-  for (OvmsMetric* m=MyMetrics.m_first; m != NULL; m=m->m_next)
+  MyMetrics.ForEach([&](OvmsMetric* m) -> bool
     {
     if (only_persist && !m->m_persist)
-      continue;
+      return true;
     const char *k = m->m_name;
     if (show_only)
       {
       bool match = false;
-      for (i=firstmetric;i<argc;i++)
-        if (strstr(k,argv[i]))
+      for (int j=firstmetric;j<argc;j++)
+        if (strstr(k,argv[j]))
           match = true;
       if (!match)
-        continue;
+        return true;
       }
     found = true;
     if (show_set)
       {
       if (m->IsDefined())
-        writer->printf("metrics set %s %s\n", k, m->AsString().c_str());
-      continue;
+        writer->printf("metrics set %s %s\n", k, m->AsCachedString().c_str());
+      return true;
       }
-    std::string v = m->AsUnitString("", m->GetUnits() == TimeUTC ? TimeLocal : m->GetUnits());
+    std::string v;
+    if (m->GetUnits() == TimeUTC || m->GetUnits() == TimeLocal)
+      v = m->AsUnitString("", TimeLocal);
+    else if (m->IsDefined())
+      v = m->AsCachedString() + OvmsMetricUnitLabel(m->GetUnits());
     if (show_staleness)
       {
       int age = m->Age();
@@ -127,7 +147,8 @@ void metrics_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
       writer->printf("%s\n",k);
     else
       writer->printf("%-40.40s %s\n", k, v.c_str());
-    }
+    return true;
+    });
   if (show_only && !found)
     writer->puts("Unrecognised metric name");
   }
@@ -146,6 +167,16 @@ void metrics_persist(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int ar
   writer->printf("%d of %d slots used\n", pmetrics.used, NUM_PERSISTENT_VALUES);
   }
 
+void metrics_registry(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  writer->printf("%u metrics registered, generation %u\n", MyMetrics.Count(), MyMetrics.Generation());
+  writer->printf("Boot time registration took %lld ms\n", MyMetrics.m_registry_boottime / 1000);
+  writer->printf("Registry build took %lld us\n", MyMetrics.m_registry_buildtime);
+  writer->printf("Serialization cache: %u entries, %u of %u bytes used, %u hits, %u misses\n",
+    MyMetrics.m_cache_entries, MyMetrics.m_cache_size, METRICS_CACHE_MAXSIZE,
+    MyMetrics.m_cache_hits, MyMetrics.m_cache_misses);
+  }
+
 void metrics_set(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
   if (MyMetrics.Set(argv[0],argv[1]))
@@ -177,7 +208,7 @@ bool pmetrics_check()
     ESP_LOGE(TAG, "pmetrics_check: out of range used");
     ret = false;
     }
-  for (OvmsMetric* m = MyMetrics.m_first; m != NULL; m = m->m_next)
+  for (OvmsMetric* m = MyMetrics.First(); m != NULL; m = m->m_next)
     {
     if (m->m_persist && !m->CheckPersist())
       {
@@ -209,7 +240,7 @@ void pmetrics_init(bool refresh = false)
   pmetrics.size = sizeof(persistent_metrics);
   if (refresh)
     {
-    for (OvmsMetric* m = MyMetrics.m_first; m != NULL; m = m->m_next)
+    for (OvmsMetric* m = MyMetrics.First(); m != NULL; m = m->m_next)
       m->RefreshPersist();
     }
   }
@@ -255,7 +286,7 @@ persistent_values *pmetrics_register(const char *name)
   return vp;
   }
 
-void OvmsMetrics::EventSystemShutDown(std::string event, void* data)
+void OvmsMetrics::EventSystemShutDown(const std::string& event, void* data)
   {
   /* Check for corruption and repair of possible before shutting down */
   if (!pmetrics_check())
@@ -365,7 +396,7 @@ static duk_ret_t DukOvmsMetricGetValues(duk_context *ctx)
     {
     // simple metric name substring filter:
     const char *filter = duk_opt_string(ctx, 0, "");
-    for (m = MyMetrics.m_first; m; m = m->m_next)
+    for (m = MyMetrics.First(); m; m = m->m_next)
       {
       if (*filter && !strstr(m->m_name, filter))
         continue;
@@ -393,13 +424,33 @@ OvmsMetrics::OvmsMetrics()
   ESP_LOGI(TAG, "Initialising METRICS (1810)");
 
   m_nextmodifier = 1;
+  for (int i = 0; i < METRICS_MAX_MODIFIERS; i++)
+    m_journal[i] = NULL;
+  m_journalmask = 0;
   m_first = NULL;
   m_trace = false;
+  m_hashtable = NULL;
+  m_hash_readers = 0;
+  m_hashcount = 0;
+  m_hashpartial = false;
+  m_wildcard = NULL;
+  m_sorted = 0;
+  m_dirty = false;
+  m_bulk = 0;
+  m_generation = 0;
+  m_registry_start = 0;
+  m_registry_boottime = 0;
+  m_registry_buildtime = 0;
+  m_cache_size = 0;
+  m_cache_entries = 0;
+  m_cache_hits = 0;
+  m_cache_misses = 0;
 
   // Register our commands
   OvmsCommand* cmd_metric = MyCommandApp.RegisterCommand("metrics","METRICS framework");
   cmd_metric->RegisterCommand("list","Show all metrics", metrics_list, "[<metric>] [-ps]", 0, 2);
   cmd_metric->RegisterCommand("persist","Show persistent metrics info", metrics_persist, "[-r]", 0, 1);
+  cmd_metric->RegisterCommand("registry","Show metrics registry info", metrics_registry);
   cmd_metric->RegisterCommand("set","Set the value of a metric",metrics_set, "<metric> <value>", 2, 2);
   OvmsCommand* cmd_metrictrace = cmd_metric->RegisterCommand("trace","METRIC trace framework");
   cmd_metrictrace->RegisterCommand("on","Turn metric tracing ON",metrics_trace);
@@ -431,68 +482,221 @@ OvmsMetrics::OvmsMetrics()
 
 OvmsMetrics::~OvmsMetrics()
   {
-  for (OvmsMetric* m = m_first; m!=NULL;)
+  MetricRegistry registry;
     {
-    OvmsMetric* c = m;
-    m = m->m_next;
-    delete c;
+    OvmsRecMutexLock lock(&m_registry_mutex);
+    registry.swap(m_registry);
+    m_sorted = 0;
+    m_first = NULL;
+    MetricHashTable* table = m_hashtable.exchange(NULL);
+    while (m_hash_readers.load() != 0)
+      vTaskDelay(1);
+    if (table)
+      free(table);
+    m_hashcount = 0;
     }
+  // the registry is empty now, so ~OvmsMetric() does not need to search it:
+  for (OvmsMetric* m : registry)
+    delete m;
+  }
+
+static bool metric_namecmp(const OvmsMetric* a, const OvmsMetric* b)
+  {
+  return strcmp(a->m_name, b->m_name) < 0;
   }
 
+/**
+ * RegisterMetric: add a metric to the registry
+ *  During the system init and bulk registrations (vehicle module init, see
+ *  BeginBulkRegistration()), metrics are appended to the unsorted tail and
+ *  sorted in bulk by BuildRegistry(). Single registrations after that are
+ *  inserted at their sorted position and linked into the m_next list, so
+ *  the list is always ordered for readers.
+ *  Name lookups via Find() work immediately.
+ */
 void OvmsMetrics::RegisterMetric(OvmsMetric* metric)
   {
-  // Quick simple check for if we are the first metric.
-  if (m_first == NULL)
+  OvmsRecMutexLock lock(&m_registry_mutex);
+  if (m_registry.empty() && m_registry_start == 0)
+    m_registry_start = esp_timer_get_time();
+
+  if (m_registry_boottime == 0 || m_bulk > 0)
     {
-    m_first = metric;
-    return;
+    metric->m_index = m_registry.size();
+    m_registry.push_back(metric);
+    m_dirty = true;
     }
-
-  // Now, check if we are before the first
-  if (strcmp(m_first->m_name,metric->m_name)>=0)
+  else
     {
-    metric->m_next = m_first;
-    m_first = metric;
-    return;
+    // insert after metrics of the same name, so the order of existing
+    // metrics does not change:
+    auto it = std::upper_bound(m_registry.begin(), m_registry.begin() + m_sorted, metric, metric_namecmp);
+    size_t pos = it - m_registry.begin();
+    m_registry.insert(it, metric);
+    m_sorted++;
+    for (size_t i = pos; i < m_registry.size(); i++)
+      m_registry[i]->m_index = i;
+    // link the metric before publishing it, readers walk the list unlocked:
+    metric->m_next = (pos+1 < m_sorted) ? m_registry[pos+1] : NULL;
+    std::atomic_thread_fence(std::memory_order_release);
+    if (pos == 0)
+      m_first = metric;
+    else
+      m_registry[pos-1]->m_next = metric;
     }
+  HashInsert(metric);
+
+  // attach listeners registered in advance:
+  auto k = m_listeners.find(metric->m_name);
+  if (k != m_listeners.end())
+    metric->m_listeners = k->second;
+  m_generation++;
+  }
 
-  // Search for the correct place to insert
-  for (OvmsMetric*m = m_first; m!=NULL; m=m->m_next)
+void OvmsMetrics::DeregisterMetric(OvmsMetric* metric)
+  {
+  OvmsRecMutexLock lock(&m_registry_mutex);
+  auto end = m_registry.begin() + m_sorted;
+  auto it = std::lower_bound(m_registry.begin(), end, metric, metric_namecmp);
+  while (it != end && *it != metric && strcmp((*it)->m_name, metric->m_name) == 0)
+    ++it;
+  if (it == end || *it != metric)
     {
-    if (m->m_next == NULL)
-      {
-      m->m_next = metric;
+    it = std::find(end, m_registry.end(), metric);
+    if (it == m_registry.end())
       return;
-      }
-    if (strcmp(m->m_next->m_name,metric->m_name)>=0)
-      {
-      metric->m_next = m->m_next;
-      m->m_next = metric;
-      return;
-      }
     }
+
+  size_t pos = it - m_registry.begin();
+  m_registry.erase(it);
+  for (size_t i = pos; i < m_registry.size(); i++)
+    m_registry[i]->m_index = i;
+  HashRemove(metric);
+  if (pos < m_sorted)
+    {
+    // unlink from sorted list:
+    m_sorted--;
+    if (pos == 0)
+      m_first = metric->m_next;
+    else
+      m_registry[pos-1]->m_next = metric->m_next;
+    }
+
+  // journals may hold references to the metric:
+  for (int i = 0; i < METRICS_MAX_MODIFIERS; i++)
+    {
+    if (m_journal[i])
+      m_journal[i]->Purge(metric);
+    }
+
+  metric->m_next = NULL;
+  m_generation++;
+  delete metric;
   }
 
-void OvmsMetrics::DeregisterMetric(OvmsMetric* metric)
+/**
+ * BuildRegistry: sort the metrics registered in bulk
+ *  The tail is sorted and merged into the sorted part (O(n log n)), then
+ *  the m_next list and registry indexes are renewed in a single pass. The
+ *  first build (at the end of the system init) logs the boot time metrics
+ *  init statistics.
+ *  The merge keeps the order of the sorted part, and the list is linked
+ *  from the end, so concurrent readers walking the list may miss new
+ *  metrics, but never skip a metric listed before.
+ */
+void OvmsMetrics::BuildRegistry()
   {
-  if (m_first == metric)
-    {
-    m_first = metric->m_next;
-    delete metric;
+  OvmsRecMutexLock lock(&m_registry_mutex);
+  if (!m_dirty)
     return;
+
+  int64_t started = esp_timer_get_time();
+  size_t added = m_registry.size() - m_sorted;
+  if (m_sorted < m_registry.size())
+    {
+    std::stable_sort(m_registry.begin() + m_sorted, m_registry.end(), metric_namecmp);
+    std::inplace_merge(m_registry.begin(), m_registry.begin() + m_sorted, m_registry.end(), metric_namecmp);
+    }
+  size_t cnt = m_registry.size();
+  OvmsMetric* next = NULL;
+  for (size_t i = cnt; i-- > 0; )
+    {
+    OvmsMetric* m = m_registry[i];
+    m->m_index = i;
+    std::atomic_thread_fence(std::memory_order_release);
+    m->m_next = next;
+    next = m;
     }
+  std::atomic_thread_fence(std::memory_order_release);
+  m_first = next;
+  m_sorted = cnt;
+  m_dirty = false;
+  m_generation++;
+  m_registry_buildtime = esp_timer_get_time() - started;
 
-  for (OvmsMetric* m=m_first;m!=NULL;m=m->m_next)
+  if (m_registry_boottime == 0)
     {
-    if (m->m_next == metric)
-      {
-      m->m_next = metric->m_next;
-      delete metric;
-      return;
-      }
+    m_registry_boottime = started - m_registry_start;
+    ESP_LOGI(TAG, "Registry built: %u metrics, registration took %lld ms, sorting %lld us",
+      cnt, m_registry_boottime / 1000, m_registry_buildtime);
+    }
+  else
+    {
+    ESP_LOGD(TAG, "Registry built: %u metrics added, sorting %lld us", added, m_registry_buildtime);
     }
   }
 
+/**
+ * BeginBulkRegistration: defer sorting metrics registered from now on
+ *  Used around the vehicle module init, which registers the vehicle
+ *  specific metric sets. EndBulkRegistration() sorts them in one pass.
+ *  Metrics registered in bulk are found by Find() and ForEach() right
+ *  away, but are only listed in the m_next list after the build.
+ */
+void OvmsMetrics::BeginBulkRegistration()
+  {
+  OvmsRecMutexLock lock(&m_registry_mutex);
+  m_bulk++;
+  }
+
+void OvmsMetrics::EndBulkRegistration()
+  {
+  OvmsRecMutexLock lock(&m_registry_mutex);
+  if (m_bulk > 0 && --m_bulk == 0 && m_registry_boottime != 0)
+    BuildRegistry();
+  }
+
+/**
+ * First: get the first metric of the name sorted list
+ *  Use this to iterate over all metrics (following m_next).
+ */
+OvmsMetric* OvmsMetrics::First()
+  {
+  return m_first;
+  }
+
+/**
+ * ForEach: iterate over the registry (contiguous, sorted by name)
+ *  Calls the callback for the metrics from registry index start on, until
+ *  it returns false. Returns the index of the metric the iteration stopped
+ *  at, or Count() if all metrics have been visited.
+ *  The registry is locked during the iteration, so the callback must not
+ *  register or deregister metrics. Indexes are stable as long as
+ *  Generation() does not change.
+ */
+size_t OvmsMetrics::ForEach(std::function<bool(OvmsMetric*)> callback, size_t start)
+  {
+  OvmsRecMutexLock lock(&m_registry_mutex);
+  size_t cnt = m_registry.size();
+  size_t i;
+  for (i = start; i < cnt; i++)
+    {
+    if (!callback(m_registry[i]))
+      break;
+    }
+  return i;
+  }
+
 bool OvmsMetrics::Set(const char* metric, const char* value)
   {
   OvmsMetric* m = Find(metric);
@@ -529,13 +733,143 @@ bool OvmsMetrics::SetFloat(const char* metric, float value)
   return true;
   }
 
+/**
+ * Find: look up a metric by name
+ *  The hash table is read without locking: it is only replaced as a whole
+ *  (see HashResize()), new entries are added by storing a single slot.
+ *  Falls back to a linear search of the registry if the table could not be
+ *  grown (out of memory), so a registered metric is always found.
+ */
 OvmsMetric* OvmsMetrics::Find(const char* metric)
   {
-  for (OvmsMetric* m=m_first; m != NULL; m=m->m_next)
+  uint32_t hash = metric_namehash(metric);
+  OvmsMetric* found = NULL;
+
+  m_hash_readers++;
+  const MetricHashTable* table = m_hashtable.load();
+  if (table)
     {
-    if (strcmp(m->m_name,metric)==0) return m;
+    size_t mask = table->size - 1;
+    OvmsMetric* m;
+    for (size_t i = hash & mask; (m = table->slot[i]) != NULL; i = (i+1) & mask)
+      {
+      if (m->m_namehash == hash && strcmp(m->m_name,metric)==0)
+        {
+        found = m;
+        break;
+        }
+      }
     }
-  return NULL;
+  m_hash_readers--;
+
+  if (!found && m_hashpartial)
+    {
+    // most recent registration wins, as with the hash table:
+    OvmsRecMutexLock lock(&m_registry_mutex);
+    for (auto it = m_registry.rbegin(); it != m_registry.rend(); ++it)
+      {
+      OvmsMetric* m = *it;
+      if (m->m_namehash == hash && strcmp(m->m_name,metric)==0) return m;
+      }
+    }
+  return found;
+  }
+
+/**
+ * HashInsert: add metric to the name lookup hash table
+ *  A metric registered with a name already in use replaces the previous
+ *  entry, so Find() returns the most recent registration (as the sorted
+ *  list did before).
+ */
+void OvmsMetrics::HashInsert(OvmsMetric* metric)
+  {
+  MetricHashTable* table = m_hashtable.load();
+  size_t size = table ? table->size : 0;
+  if ((m_hashcount+1) * 2 > size)
+    {
+    // the resize indexes the new metric from the registry:
+    if (HashResize(size ? size * 2 : METRICS_HASH_MINSIZE))
+      return;
+    }
+  if (!table || m_hashcount+1 >= size)
+    {
+    // table full, Find() needs to fall back to the registry:
+    m_hashpartial = true;
+    return;
+    }
+  size_t mask = size - 1;
+  size_t i;
+  for (i = metric->m_namehash & mask; table->slot[i] != NULL; i = (i+1) & mask)
+    {
+    OvmsMetric* m = table->slot[i];
+    if (m->m_namehash == metric->m_namehash && strcmp(m->m_name,metric->m_name)==0)
+      break;
+    }
+  if (table->slot[i] == NULL)
+    m_hashcount++;
+  // publish the metric after its name & hash:
+  std::atomic_thread_fence(std::memory_order_release);
+  table->slot[i] = metric;
+  }
+
+/**
+ * HashRemove: remove metric from the name lookup hash table
+ *  Removing an entry in place would shift probe chains under concurrent
+ *  Find() calls, so the table is rebuilt from the registry instead (the
+ *  metric has already been removed from it). This also re-indexes an older
+ *  metric with the same name, if any. Deregistrations are rare (vehicle
+ *  module unload).
+ */
+void OvmsMetrics::HashRemove(OvmsMetric* metric)
+  {
+  MetricHashTable* table = m_hashtable.load();
+  if (!table)
+    return;
+  HashResize(table->size);
+  }
+
+/**
+ * HashResize: rebuild the hash table with a new size
+ *  The new table is filled from the registry before it replaces the old one,
+ *  this also indexes metrics missed after a previous allocation failure.
+ *  The old table is freed when no Find() is using it anymore.
+ *  Called with the registry mutex held.
+ */
+bool OvmsMetrics::HashResize(size_t size)
+  {
+  MetricHashTable* table = (MetricHashTable*) ExternalRamCalloc(1,
+    sizeof(MetricHashTable) + size * sizeof(OvmsMetric*));
+  if (!table)
+    {
+    ESP_LOGE(TAG, "HashResize: out of memory for %u slots, using linear search", size);
+    m_hashpartial = true;
+    return false;
+    }
+  table->size = size;
+  table->slot = (OvmsMetric**) (table + 1);
+  size_t mask = size - 1;
+  size_t count = 0;
+  for (OvmsMetric* metric : m_registry)
+    {
+    size_t i;
+    for (i = metric->m_namehash & mask; table->slot[i] != NULL; i = (i+1) & mask)
+      {
+      if (table->slot[i]->m_namehash == metric->m_namehash && strcmp(table->slot[i]->m_name,metric->m_name)==0)
+        break;
+      }
+    if (table->slot[i] == NULL)
+      count++;
+    table->slot[i] = metric;
+    }
+  m_hashcount = count;
+
+  MetricHashTable* oldtable = m_hashtable.exchange(table);
+  m_hashpartial = false;
+  while (m_hash_readers.load() != 0)
+    vTaskDelay(1);
+  if (oldtable)
+    free(oldtable);
+  return true;
   }
 
 OvmsMetricInt* OvmsMetrics::InitInt(const char* metric, uint16_t autostale, int value, metric_unit_t units, bool persist)
@@ -580,8 +914,16 @@ OvmsMetricString* OvmsMetrics::InitString(const char* metric, uint16_t autostale
   return m;
   }
 
+/**
+ * RegisterListener: add a callback for modifications of a metric (or "*" for all)
+ *  The listener list is resolved once into the metric (or the wildcard slot),
+ *  so NotifyModified() does not need to look up listeners by name.
+ *  Listeners can be registered before the metric exists, they will be
+ *  attached on registration of the metric (both under the registry mutex).
+ */
 void OvmsMetrics::RegisterListener(const char* caller, const char* name, MetricCallback callback)
   {
+  OvmsRecMutexLock lock(&m_registry_mutex);
   auto k = m_listeners.find(name);
   if (k == m_listeners.end())
     {
@@ -596,10 +938,21 @@ void OvmsMetrics::RegisterListener(const char* caller, const char* name, MetricC
 
   MetricCallbackList *ml = k->second;
   ml->push_back(new MetricCallbackEntry(caller,callback));
+
+  if (strcmp(name, "*") == 0)
+    {
+    m_wildcard = ml;
+    }
+  else
+    {
+    OvmsMetric* m = Find(name);
+    if (m) m->m_listeners = ml;
+    }
   }
 
 void OvmsMetrics::DeregisterListener(const char* caller)
   {
+  OvmsRecMutexLock lock(&m_registry_mutex);
   MetricCallbackMap::iterator itm=m_listeners.begin();
   while (itm!=m_listeners.end())
     {
@@ -620,6 +973,14 @@ void OvmsMetrics::DeregisterListener(const char* caller)
       }
     if (ml->empty())
       {
+      // detach list from the metrics resp. the wildcard slot:
+      if (m_wildcard == ml)
+        m_wildcard = NULL;
+      for (OvmsMetric* m : m_registry)
+        {
+        if (m->m_listeners == ml)
+          m->m_listeners = NULL;
+        }
       itm = m_listeners.erase(itm);
       delete ml;
       }
@@ -643,22 +1004,22 @@ void OvmsMetrics::NotifyModified(OvmsMetric* metric)
       metric->m_name, metric->AsUnitString().c_str());
     }
 
-  auto k = m_listeners.find("*");
-  for (int x=0;x<2;x++)
+  if (m_wildcard)
     {
-    if (k != m_listeners.end())
+    for (MetricCallbackList::iterator itc=m_wildcard->begin(); itc!=m_wildcard->end(); ++itc)
       {
-      MetricCallbackList* ml = k->second;
-      if (ml)
-        {
-        for (MetricCallbackList::iterator itc=ml->begin(); itc!=ml->end(); ++itc)
-          {
-          MetricCallbackEntry* ec = *itc;
-          ec->m_callback(metric);
-          }
-        }
+      MetricCallbackEntry* ec = *itc;
+      ec->m_callback(metric);
+      }
+    }
+  if (metric->m_listeners)
+    {
+    MetricCallbackList* ml = metric->m_listeners;
+    for (MetricCallbackList::iterator itc=ml->begin(); itc!=ml->end(); ++itc)
+      {
+      MetricCallbackEntry* ec = *itc;
+      ec->m_callback(metric);
       }
-    k = m_listeners.find(metric->m_name);
     }
   }
 
@@ -667,16 +1028,189 @@ size_t OvmsMetrics::RegisterModifier()
   return m_nextmodifier++;
   }
 
+/**
+ * RegisterJournal: enable the change journal for a modifier
+ *  Journals are kept once allocated (modifiers are never released) and
+ *  start with a full scan on (re-)enabling.
+ */
+OvmsMetricJournal* OvmsMetrics::RegisterJournal(size_t modifier)
+  {
+  if (modifier >= METRICS_MAX_MODIFIERS)
+    {
+    ESP_LOGE(TAG, "RegisterJournal: invalid modifier %u", modifier);
+    return NULL;
+    }
+  if (!m_journal[modifier])
+    m_journal[modifier] = new OvmsMetricJournal(modifier);
+  m_journal[modifier]->Reset();
+  m_journalmask |= (1ul << modifier);
+  return m_journal[modifier];
+  }
+
+void OvmsMetrics::DeregisterJournal(size_t modifier)
+  {
+  if (modifier < METRICS_MAX_MODIFIERS)
+    m_journalmask &= ~(1ul << modifier);
+  }
+
+/**
+ * JournalModified: append metric to the journals of all modifiers that
+ *  had already consumed the previous change (flag was clear)
+ */
+void OvmsMetrics::JournalModified(OvmsMetric* metric, unsigned long oldmodified)
+  {
+  unsigned long mask = m_journalmask & ~oldmodified;
+  for (size_t modifier = 0; mask; modifier++, mask >>= 1)
+    {
+    if (mask & 1)
+      m_journal[modifier]->Append(metric);
+    }
+  }
+
+OvmsMetricJournal::OvmsMetricJournal(size_t modifier)
+  {
+  m_modifier = modifier;
+  m_ring = (entry_t*) ExternalRamCalloc(METRICS_JOURNAL_SIZE, sizeof(entry_t));
+  m_head = 0;
+  m_tail = 0;
+  m_reset = true;
+  m_scanning = false;
+  m_scan = NULL;
+  m_fullscans = 0;
+  vPortCPUInitializeMutex(&m_lock);
+  }
+
+OvmsMetricJournal::~OvmsMetricJournal()
+  {
+  if (m_ring)
+    free(m_ring);
+  }
+
+/**
+ * Append: add a metric to the journal (any context)
+ */
+void OvmsMetricJournal::Append(OvmsMetric* metric)
+  {
+  if (!m_ring)
+    {
+    m_reset = true;
+    return;
+    }
+  uint32_t pos = m_head.fetch_add(1);
+  entry_t* e = &m_ring[pos & (METRICS_JOURNAL_SIZE-1)];
+  e->metric = metric;
+  e->seq.store(pos+1, std::memory_order_release);
+  }
+
+/**
+ * Purge: remove references to a metric being deregistered
+ *  Ring entries are cleared, a full scan positioned on the metric skips it.
+ *  Called by DeregisterMetric() before the metric is unlinked from m_next.
+ */
+void OvmsMetricJournal::Purge(OvmsMetric* metric)
+  {
+  portENTER_CRITICAL(&m_lock);
+  if (m_ring)
+    {
+    for (int i = 0; i < METRICS_JOURNAL_SIZE; i++)
+      {
+      if (m_ring[i].metric == metric)
+        m_ring[i].metric = NULL;
+      }
+    }
+  if (m_scan == metric)
+    m_scan = metric->m_next;
+  portEXIT_CRITICAL(&m_lock);
+  }
+
+/**
+ * Next: get next modified metric (consumer context)
+ *  Returns NULL if no further changes are available (yet).
+ *  Entries are read under m_lock, so Purge() cannot remove a metric in between.
+ */
+OvmsMetric* OvmsMetricJournal::Next()
+  {
+  OvmsMetric* m;
+  bool modified;
+  for (;;)
+    {
+    if (m_reset.exchange(false))
+      {
+      // discard journal, fall back to (restart) full scan:
+      m_tail = m_head.load();
+      portENTER_CRITICAL(&m_lock);
+      m_scan = MyMetrics.First();
+      portEXIT_CRITICAL(&m_lock);
+      m_scanning = true;
+      m_fullscans++;
+      continue;
+      }
+
+    if (m_scanning)
+      {
+      portENTER_CRITICAL(&m_lock);
+      m = m_scan;
+      if (m)
+        m_scan = m->m_next;
+      modified = (m && m->IsModifiedAndClear(m_modifier));
+      portEXIT_CRITICAL(&m_lock);
+      if (!m)
+        m_scanning = false;
+      else if (modified)
+        return m;
+      continue;
+      }
+
+    uint32_t head = m_head.load();
+    if (m_tail == head)
+      return NULL;
+    if (head - m_tail > METRICS_JOURNAL_SIZE)
+      {
+      m_reset = true;
+      continue;
+      }
+
+    entry_t* e = &m_ring[m_tail & (METRICS_JOURNAL_SIZE-1)];
+    uint32_t seq = e->seq.load(std::memory_order_acquire);
+    if (seq != m_tail+1)
+      {
+      if ((int32_t)(seq - (m_tail+1)) > 0)
+        m_reset = true;     // overwritten by producers
+      else
+        return NULL;        // producer has not finished writing yet
+      continue;
+      }
+    portENTER_CRITICAL(&m_lock);
+    m = e->metric;
+    if (e->seq.load(std::memory_order_acquire) != seq)
+      {
+      portEXIT_CRITICAL(&m_lock);
+      m_reset = true;
+      continue;
+      }
+    m_tail++;
+    modified = (m && m->IsModifiedAndClear(m_modifier));   // NULL: purged
+    portEXIT_CRITICAL(&m_lock);
+    if (modified)
+      return m;
+    }
+  }
+
 OvmsMetric::OvmsMetric(const char* name, uint16_t autostale, metric_unit_t units, bool persist)
   {
   m_defined = NeverDefined;
   m_modified = 0;
   m_name = name;
+  m_namehash = metric_namehash(name);
+  m_listeners = NULL;
+  m_serial = 1;
+  m_cache = NULL;
   m_lastmodified = 0;
   m_autostale = autostale;
   m_stale = false;
   m_units = units;
   m_next = NULL;
+  m_index = 0;
   m_persist = false;          // only set by metrics supporting persistence
   MyMetrics.RegisterMetric(this);
   }
@@ -685,6 +1219,17 @@ OvmsMetric::~OvmsMetric()
   {
   MyMetrics.DeregisterMetric(this);
 
+  if (m_cache)
+    {
+    OvmsMutexLock lock(&MyMetrics.m_cache_mutex);
+    for (int i = 0; i < MetricCacheCount; i++)
+      MyMetrics.m_cache_size -= m_cache->value[i].capacity();
+    MyMetrics.m_cache_size -= sizeof(metric_cache_t);
+    MyMetrics.m_cache_entries--;
+    delete m_cache;
+    m_cache = NULL;
+    }
+
   // Warning: pointers to a deleted OvmsMetric can still be held locally in
   //  other modules. If you delete metrics, take care to inform all readers
   //  (i.e. by broadcasting a module shutdown event).
@@ -748,6 +1293,8 @@ uint32_t OvmsMetric::Age()
 
 void OvmsMetric::SetModified(bool changed)
   {
+  if (changed || m_defined == NeverDefined)
+    m_serial++;   // invalidates the serialization cache
   if (m_defined == NeverDefined)
     m_defined = FirstDefined;
   else
@@ -756,11 +1303,78 @@ void OvmsMetric::SetModified(bool changed)
   m_lastmodified = monotonictime;
   if (changed)
     {
-    m_modified = ULONG_MAX;
+    unsigned long oldmodified = m_modified.exchange(ULONG_MAX);
+    MyMetrics.JournalModified(this, oldmodified);
     MyMetrics.NotifyModified(this);
     }
   }
 
+/**
+ * GetCached: append cached serialization to buf
+ *  Returns false if the serialization is not cached and the cache memory
+ *  limit does not allow caching it, caller needs to serialize itself then.
+ *  The cache is shared by all readers (i.e. web clients, servers, commands),
+ *  so a value change costs one serialization regardless of the number of readers.
+ */
+bool OvmsMetric::GetCached(metric_cache_type_t type, std::string& buf)
+  {
+  uint32_t serial = m_serial;
+  OvmsMutexLock lock(&MyMetrics.m_cache_mutex);
+  if (m_cache && m_cache->serial[type] == serial)
+    {
+    MyMetrics.m_cache_hits++;
+    buf.append(m_cache->value[type]);
+    return true;
+    }
+  MyMetrics.m_cache_misses++;
+  if (!m_cache)
+    {
+    if (MyMetrics.m_cache_size + sizeof(metric_cache_t) > METRICS_CACHE_MAXSIZE)
+      return false;
+    m_cache = new metric_cache_t();
+    MyMetrics.m_cache_size += sizeof(metric_cache_t);
+    MyMetrics.m_cache_entries++;
+    }
+
+  // Note: serialization is done holding the cache mutex and may lock the metric
+  //  value mutex. Value setters never take the cache mutex, so the lock order
+  //  is always cache → value.
+  std::string value = (type == MetricCacheJSON) ? AsJSON() : AsString();
+  size_t oldcap = m_cache->value[type].capacity();
+  if (MyMetrics.m_cache_size - oldcap + value.capacity() > METRICS_CACHE_MAXSIZE)
+    {
+    buf.append(value);
+    return true;
+    }
+  m_cache->value[type] = std::move(value);
+  m_cache->serial[type] = serial;
+  MyMetrics.m_cache_size += m_cache->value[type].capacity() - oldcap;
+  buf.append(m_cache->value[type]);
+  return true;
+  }
+
+std::string OvmsMetric::AsCachedString()
+  {
+  std::string buf;
+  if (!GetCached(MetricCacheString, buf))
+    return AsString();
+  return buf;
+  }
+
+std::string OvmsMetric::AsCachedJSON()
+  {
+  std::string buf;
+  if (!GetCached(MetricCacheJSON, buf))
+    return AsJSON();
+  return buf;
+  }
+
+void OvmsMetric::AppendCachedJSON(std::string& buf)
+  {
+  if (!GetCached(MetricCacheJSON, buf))
+    buf.append(AsJSON());
+  }
+
 bool OvmsMetric::IsDefined()
   {
   return (m_defined != NeverDefined);
@@ -52,6 +52,8 @@
 #define TAG ((const char*)"metric")
 
 #define METRICS_MAX_MODIFIERS 32
+#define METRICS_JOURNAL_SIZE  128             // change journal ring entries (power of 2)
+#define METRICS_CACHE_MAXSIZE 32768           // serialization cache memory limit [bytes]
 
 using namespace std;
 
@@ -140,6 +142,22 @@ struct persistent_metrics
 extern persistent_values *pmetrics_find(const char *name);
 extern persistent_values *pmetrics_register(const char *name);
 
+class MetricCallbackEntry;
+typedef std::list<MetricCallbackEntry*> MetricCallbackList;
+
+typedef enum
+  {
+  MetricCacheString = 0,                    // AsString()
+  MetricCacheJSON,                          // AsJSON()
+  MetricCacheCount
+  } metric_cache_type_t;
+
+struct metric_cache_t
+  {
+  uint32_t serial[MetricCacheCount];        // value serial the entry was built from, 0 = empty
+  std::string value[MetricCacheCount];
+  };
+
 class OvmsMetric
   {
   public:
@@ -174,9 +192,22 @@ class OvmsMetric
     virtual void ClearModified(size_t modifier);
     virtual void SetModified(bool changed=true);
 
+  public:
+    std::string AsCachedString();
+    std::string AsCachedJSON();
+    void AppendCachedJSON(std::string& buf);
+
+  protected:
+    bool GetCached(metric_cache_type_t type, std::string& buf);
+
   public:
     OvmsMetric* m_next;
+    size_t m_index;                         // registry position, stable while MyMetrics.Generation() is unchanged
     const char* m_name;
+    uint32_t m_namehash;
+    MetricCallbackList* m_listeners;        // listeners registered for this metric name, NULL if none
+    std::atomic<uint32_t> m_serial;         // value serial, incremented on every value change
+    metric_cache_t* m_cache;                // serialization cache, NULL if not used yet
     std::atomic_ulong m_modified;
     uint32_t m_lastmodified;
     uint16_t m_autostale;
@@ -913,7 +944,56 @@ class MetricCallbackEntry
     MetricCallback m_callback;
   };
 
-typedef std::list<MetricCallbackEntry*> MetricCallbackList;
+typedef std::vector<OvmsMetric*, ExtRamAllocator<OvmsMetric*>> MetricRegistry;
+
+typedef struct
+  {
+  size_t size;                  // number of slots, power of 2
+  OvmsMetric** slot;            // open addressing (linear probing), follows the header
+  } MetricHashTable;
+
+/**
+ * OvmsMetricJournal: change journal for a metrics modifier
+ *  - lock free multiple producer / single consumer ring of modified metrics
+ *  - a metric is appended when its modifier flag changes from clear to set,
+ *    so it's recorded only once per consumer pass
+ *  - Next() returns the next modified metric (clearing the modifier flag)
+ *    or NULL if there are currently no more changes
+ *  - on ring overflow, metric deregistration or (re-)enabling, Next()
+ *    transparently falls back to one full scan over all metrics
+ */
+class OvmsMetricJournal
+  {
+  public:
+    OvmsMetricJournal(size_t modifier);
+    ~OvmsMetricJournal();
+
+  public:
+    void Append(OvmsMetric* metric);
+    void Reset() { m_reset = true; }
+    void Purge(OvmsMetric* metric);
+    OvmsMetric* Next();
+
+  protected:
+    struct entry_t
+      {
+      std::atomic<uint32_t> seq;            // position + 1 when written
+      OvmsMetric* metric;
+      };
+
+  protected:
+    size_t m_modifier;
+    entry_t* m_ring;
+    std::atomic<uint32_t> m_head;           // producer position
+    uint32_t m_tail;                        // consumer position
+    std::atomic<bool> m_reset;              // consumer shall do a full scan
+    bool m_scanning;                        // full scan in progress
+    OvmsMetric* m_scan;                     // full scan position
+    portMUX_TYPE m_lock;                    // consumer entry access vs. Purge()
+
+  public:
+    uint32_t m_fullscans;                   // number of full scans done
+  };
 typedef std::map<const char*, MetricCallbackList*, CmpStrOp> MetricCallbackMap;
 
 class OvmsMetrics
@@ -925,6 +1005,13 @@ class OvmsMetrics
   public:
     void RegisterMetric(OvmsMetric* metric);
     void DeregisterMetric(OvmsMetric* metric);
+    void BuildRegistry();
+    void BeginBulkRegistration();
+    void EndBulkRegistration();
+    OvmsMetric* First();
+    size_t ForEach(std::function<bool(OvmsMetric*)> callback, size_t start=0);
+    size_t Count() { return m_registry.size(); }
+    uint32_t Generation() { return m_generation; }
 
   public:
     bool Set(const char* metric, const char* value);
@@ -971,19 +1058,56 @@ class OvmsMetrics
     void NotifyModified(OvmsMetric* metric);
 
   protected:
-    MetricCallbackMap m_listeners;
+    MetricCallbackMap m_listeners;        // name → listeners, resolved into OvmsMetric::m_listeners
+    MetricCallbackList* m_wildcard;       // listeners for "*", NULL if none
 
   public:
     size_t RegisterModifier();
+    OvmsMetricJournal* RegisterJournal(size_t modifier);
+    void DeregisterJournal(size_t modifier);
+    void JournalModified(OvmsMetric* metric, unsigned long oldmodified);
 
   public:
-    void EventSystemShutDown(std::string event, void* data);
+    void EventSystemShutDown(const std::string& event, void* data);
 
   protected:
     size_t m_nextmodifier;
+    OvmsMetricJournal* m_journal[METRICS_MAX_MODIFIERS];
+    std::atomic_ulong m_journalmask;      // modifiers with active journals
+
+  protected:
+    void HashInsert(OvmsMetric* metric);
+    void HashRemove(OvmsMetric* metric);
+    bool HashResize(size_t size);
+
+  protected:
+    std::atomic<MetricHashTable*> m_hashtable;  // read lock free by Find()
+    std::atomic<int> m_hash_readers;            // Find() calls using the table
+    size_t m_hashcount;           // number of slots used
+    std::atomic<bool> m_hashpartial;  // not all metrics indexed (out of memory), Find() searches m_registry
+
+  protected:
+    OvmsRecMutex m_registry_mutex;
+    MetricRegistry m_registry;    // metrics sorted by name, unsorted tail from m_sorted on
+    size_t m_sorted;              // number of sorted entries in m_registry
+    bool m_dirty;                 // unsorted tail needs to be merged (see BuildRegistry())
+    int m_bulk;                   // bulk registration nesting level
+    uint32_t m_generation;        // incremented on every registry change
+    OvmsMetric* m_first;          // use First() to iterate
+
+  public:
+    int64_t m_registry_start;     // time of first metric registration [us]
+    int64_t m_registry_boottime;  // time from first registration to first build [us]
+    int64_t m_registry_buildtime; // duration of the initial build [us]
+
+  public:
+    OvmsMutex m_cache_mutex;
+    size_t m_cache_size;          // serialization cache memory used [bytes]
+    size_t m_cache_entries;       // serialization cache entries allocated
+    uint32_t m_cache_hits;
+    uint32_t m_cache_misses;
 
   public:
-    OvmsMetric* m_first;
     bool m_trace;
   };
 
@@ -901,7 +901,7 @@ static void module_trigger_twdt(int verbosity, OvmsWriter* writer, OvmsCommand*
   {
   ESP_LOGI(TAG,"Triggering task watchdog (on command)");
   // trigger twdt on event task by blocking all events:
-  static auto covid19 = [](std::string event, void* data) { vTaskDelay(portMAX_DELAY); };
+  static auto covid19 = [](const std::string& event, void* data) { vTaskDelay(portMAX_DELAY); };
   MyEvents.RegisterEvent(TAG, "ticker.1", covid19);
   writer->puts(
     "Task watchdog will be triggered in " STR(CONFIG_TASK_WDT_TIMEOUT_S) " seconds.\n"
@@ -982,7 +982,7 @@ static void module_factory_reset(int verbosity, OvmsWriter* writer, OvmsCommand*
     }
   }
 
-static void module_eventhandler(std::string event, void* data)
+static void module_eventhandler(const std::string& event, void* data)
   {
   if (event == "ticker.300")
     {
@@ -336,7 +336,7 @@ void OvmsNetManager::WifiDisconnect()
     }
   }
 
-void OvmsNetManager::WifiStaGotIP(std::string event, void* data)
+void OvmsNetManager::WifiStaGotIP(const std::string& event, void* data)
   {
   m_wifi_sta = true;
   ESP_LOGI(TAG, "WIFI client got IP");
@@ -353,7 +353,7 @@ void OvmsNetManager::WifiStaGotIP(std::string event, void* data)
   WifiStaCheckSQ(StdMetrics.ms_m_net_wifi_sq);
   }
 
-void OvmsNetManager::WifiStaLostIP(std::string event, void* data)
+void OvmsNetManager::WifiStaLostIP(const std::string& event, void* data)
   {
   // Re-prioritise, just in case, as Wifi stack seems to mess with this
   // (in particular if an AP interface is up, and STA goes down, Wifi
@@ -364,7 +364,7 @@ void OvmsNetManager::WifiStaLostIP(std::string event, void* data)
   #endif
   }
 
-void OvmsNetManager::WifiStaConnected(std::string event, void* data)
+void OvmsNetManager::WifiStaConnected(const std::string& event, void* data)
   {
   // Re-prioritise, just in case, as Wifi stack seems to mess with this
   // (in particular if an AP interface is up, and STA goes down, Wifi
@@ -375,7 +375,7 @@ void OvmsNetManager::WifiStaConnected(std::string event, void* data)
   #endif
   }
 
-void OvmsNetManager::WifiStaStop(std::string event, void* data)
+void OvmsNetManager::WifiStaStop(const std::string& event, void* data)
   {
   WifiStaSetSQ(false);
   if (m_wifi_sta)
@@ -398,7 +398,7 @@ void OvmsNetManager::WifiStaStop(std::string event, void* data)
   #endif
   }
 
-void OvmsNetManager::WifiStaGood(std::string event, void* data)
+void OvmsNetManager::WifiStaGood(const std::string& event, void* data)
   {
   if (m_wifi_sta && !m_connected_wifi)
     {
@@ -408,7 +408,7 @@ void OvmsNetManager::WifiStaGood(std::string event, void* data)
     }
   }
 
-void OvmsNetManager::WifiStaBad(std::string event, void* data)
+void OvmsNetManager::WifiStaBad(const std::string& event, void* data)
   {
   if (m_wifi_sta && m_connected_wifi)
     {
@@ -453,7 +453,7 @@ void OvmsNetManager::WifiStaSetSQ(bool good)
     }
   }
 
-void OvmsNetManager::WifiUpAP(std::string event, void* data)
+void OvmsNetManager::WifiUpAP(const std::string& event, void* data)
   {
   m_wifi_ap = true;
   PrioritiseAndIndicate();
@@ -467,7 +467,7 @@ void OvmsNetManager::WifiUpAP(std::string event, void* data)
   MyEvents.SignalEvent("network.interface.change",NULL);
   }
 
-void OvmsNetManager::WifiDownAP(std::string event, void* data)
+void OvmsNetManager::WifiDownAP(const std::string& event, void* data)
   {
   m_wifi_ap = false;
   PrioritiseAndIndicate();
@@ -481,7 +481,7 @@ void OvmsNetManager::WifiDownAP(std::string event, void* data)
   MyEvents.SignalEvent("network.interface.change",NULL);
   }
 
-void OvmsNetManager::WifiApStaDisconnect(std::string event, void* data)
+void OvmsNetManager::WifiApStaDisconnect(const std::string& event, void* data)
   {
   ESP_LOGI(TAG, "WIFI access point station disconnected");
 #ifdef CONFIG_OVMS_SC_GPL_MONGOOSE
@@ -489,7 +489,7 @@ void OvmsNetManager::WifiApStaDisconnect(std::string event, void* data)
 #endif
   }
 
-void OvmsNetManager::ModemUp(std::string event, void* data)
+void OvmsNetManager::ModemUp(const std::string& event, void* data)
   {
   m_connected_modem = true;
   SaveDNSServer(m_dns_modem);
@@ -514,7 +514,7 @@ void OvmsNetManager::ModemUp(std::string event, void* data)
   MyEvents.SignalEvent("network.interface.change",NULL);
   }
 
-void OvmsNetManager::ModemDown(std::string event, void* data)
+void OvmsNetManager::ModemDown(const std::string& event, void* data)
   {
   if (m_connected_modem)
     {
@@ -554,7 +554,7 @@ void OvmsNetManager::ModemDown(std::string event, void* data)
     }
   }
 
-void OvmsNetManager::ConfigChanged(std::string event, void* data)
+void OvmsNetManager::ConfigChanged(const std::string& event, void* data)
   {
   OvmsConfigParam* param = (OvmsConfigParam*)data;
   if (!param || param->GetName() == "network")
@@ -574,7 +574,7 @@ void OvmsNetManager::ConfigChanged(std::string event, void* data)
     }
   }
 
-void OvmsNetManager::EventSystemShuttingDown(std::string event, void* data)
+void OvmsNetManager::EventSystemShuttingDown(const std::string& event, void* data)
   {
 #ifdef CONFIG_OVMS_SC_GPL_MONGOOSE
   StopMongooseTask();
@@ -88,22 +88,22 @@ class OvmsNetManager
     ~OvmsNetManager();
 
   public:
-    void WifiStaGotIP(std::string event, void* data);
-    void WifiStaLostIP(std::string event, void* data);
-    void WifiStaConnected(std::string event, void* data);
-    void WifiStaStop(std::string event, void* data);
-    void WifiStaGood(std::string event, void* data);
-    void WifiStaBad(std::string event, void* data);
+    void WifiStaGotIP(const std::string& event, void* data);
+    void WifiStaLostIP(const std::string& event, void* data);
+    void WifiStaConnected(const std::string& event, void* data);
+    void WifiStaStop(const std::string& event, void* data);
+    void WifiStaGood(const std::string& event, void* data);
+    void WifiStaBad(const std::string& event, void* data);
     void WifiStaCheckSQ(OvmsMetric* metric);
     void WifiStaSetSQ(bool good);
-    void WifiUpAP(std::string event, void* data);
-    void WifiDownAP(std::string event, void* data);
-    void WifiApStaDisconnect(std::string event, void* data);
-    void ModemUp(std::string event, void* data);
-    void ModemDown(std::string event, void* data);
-    void InterfaceUp(std::string event, void* data);
-    void ConfigChanged(std::string event, void* data);
-    void EventSystemShuttingDown(std::string event, void* data);
+    void WifiUpAP(const std::string& event, void* data);
+    void WifiDownAP(const std::string& event, void* data);
+    void WifiApStaDisconnect(const std::string& event, void* data);
+    void ModemUp(const std::string& event, void* data);
+    void ModemDown(const std::string& event, void* data);
+    void InterfaceUp(const std::string& event, void* data);
+    void ConfigChanged(const std::string& event, void* data);
+    void EventSystemShuttingDown(const std::string& event, void* data);
     void RestartNetwork();
 
   protected:
@@ -151,7 +151,7 @@ OvmsTime::~OvmsTime()
   {
   }
 
-void OvmsTime::EventConfigChanged(std::string event, void* data)
+void OvmsTime::EventConfigChanged(const std::string& event, void* data)
   {
   OvmsConfigParam* p = (OvmsConfigParam*)data;
 
@@ -163,14 +163,14 @@ void OvmsTime::EventConfigChanged(std::string event, void* data)
     }
   }
 
-void OvmsTime::EventSystemStart(std::string event, void* data)
+void OvmsTime::EventSystemStart(const std::string& event, void* data)
   {
   std::string tz = MyConfig.GetParamValue("vehicle","timezone");
   setenv("TZ", tz.c_str(), 1);
   tzset();
   }
 
-void OvmsTime::EventTicker60(std::string event, void* data)
+void OvmsTime::EventTicker60(const std::string& event, void* data)
   {
   // Refresh SNTP, if possible
   if (sntp_enabled() && MyNetManager.m_connected_any)
@@ -188,19 +188,19 @@ void OvmsTime::EventTicker60(std::string event, void* data)
     Elect();
   }
 
-void OvmsTime::EventNetUp(std::string event, void* data)
+void OvmsTime::EventNetUp(const std::string& event, void* data)
   {
   ESP_LOGI(TAG, "Starting SNTP client");
   sntp_init();
   }
 
-void OvmsTime::EventNetDown(std::string event, void* data)
+void OvmsTime::EventNetDown(const std::string& event, void* data)
   {
   ESP_LOGI(TAG, "Stopping SNTP client");
   sntp_stop();
   }
 
-void OvmsTime::EventNetReconfigured(std::string event, void* data)
+void OvmsTime::EventNetReconfigured(const std::string& event, void* data)
   {
   ESP_LOGI(TAG, "Network was reconfigured: restarting SNTP client");
   sntp_stop();
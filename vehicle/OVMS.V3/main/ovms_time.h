@@ -74,12 +74,12 @@ class OvmsTime
     void Elect();
 
   public:
-    void EventConfigChanged(std::string event, void* data);
-    void EventSystemStart(std::string event, void* data);
-    void EventTicker60(std::string event, void* data);
-    void EventNetUp(std::string event, void* data);
-    void EventNetDown(std::string event, void* data);
-    void EventNetReconfigured(std::string event, void* data);
+    void EventConfigChanged(const std::string& event, void* data);
+    void EventSystemStart(const std::string& event, void* data);
+    void EventTicker60(const std::string& event, void* data);
+    void EventNetUp(const std::string& event, void* data);
+    void EventNetDown(const std::string& event, void* data);
+    void EventNetReconfigured(const std::string& event, void* data);
   };
 
 extern OvmsTime MyTime;
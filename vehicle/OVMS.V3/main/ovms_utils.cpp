@@ -263,6 +263,47 @@ char* HexByte(char* p, uint8_t byte)
   return p;
   }
 
+/**
+ * FormatUInt: Write an unsigned integer in decimal, zero padded to mindigits
+ * Returns new pointer to end of string (not terminated)
+ */
+char* FormatUInt(char* p, uint32_t value, int mindigits)
+  {
+  char digits[10];
+  int n = 0;
+  do
+    {
+    digits[n++] = '0' + (value % 10);
+    value /= 10;
+    } while (value);
+  for (int k = n; k < mindigits; k++)
+    *p++ = '0';
+  while (n)
+    *p++ = digits[--n];
+  return p;
+  }
+
+/**
+ * FormatHex: Write an unsigned integer in hexadecimal, zero padded to mindigits
+ * Returns new pointer to end of string (not terminated)
+ */
+char* FormatHex(char* p, uint32_t value, int mindigits, bool uppercase)
+  {
+  const char* hexchars = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+  char digits[8];
+  int n = 0;
+  do
+    {
+    digits[n++] = hexchars[value & 0x0f];
+    value >>= 4;
+    } while (value);
+  for (int k = n; k < mindigits; k++)
+    *p++ = '0';
+  while (n)
+    *p++ = digits[--n];
+  return p;
+  }
+
 /**
  * FormatHexDump: create/fill hexdump buffer including printable representation
  * Note: allocates buffer as necessary in *bufferp, caller must free.
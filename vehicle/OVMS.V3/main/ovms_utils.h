@@ -163,6 +163,18 @@ bool endsWith(const string_t& haystack, const char needle)
  */
 char* HexByte(char* p, uint8_t byte);
 
+/**
+ * FormatUInt: Write an unsigned integer in decimal, zero padded to mindigits
+ * Returns new pointer to end of string (not terminated)
+ */
+char* FormatUInt(char* p, uint32_t value, int mindigits=1);
+
+/**
+ * FormatHex: Write an unsigned integer in hexadecimal, zero padded to mindigits
+ * Returns new pointer to end of string (not terminated)
+ */
+char* FormatHex(char* p, uint32_t value, int mindigits=1, bool uppercase=false);
+
 /**
  * FormatHexDump: create/fill hexdump buffer including printable representation
  * Note: allocates buffer as necessary in *bufferp, caller must free.
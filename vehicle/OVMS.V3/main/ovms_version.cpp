@@ -168,7 +168,7 @@ std::string GetOVMSHardware()
   return hardware;
   }
 
-void Version(std::string event, void* data)
+void Version(const std::string& event, void* data)
   {
 //  char buf[20];
 //  uint8_t mac[6];
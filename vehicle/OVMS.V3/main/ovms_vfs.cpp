@@ -44,6 +44,7 @@ static const char *TAG = "vfs";
 #include "ovms_vfs.h"
 #include "ovms_config.h"
 #include "ovms_command.h"
+#include "ovms_events.h"
 #include "ovms_peripherals.h"
 #include "crypt_md5.h"
 
@@ -51,6 +52,11 @@ static const char *TAG = "vfs";
 #include "vfsedit.h"
 #endif // #ifdef CONFIG_OVMS_COMP_EDITOR
 
+static void vfs_changed(const char* path)
+  {
+  MyEvents.SignalEvent("system.vfs.file.changed", (void*)path, strlen(path)+1);
+  }
+
 void vfs_ls(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
   DIR *dir;
@@ -222,7 +228,7 @@ void vfs_rm(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const
     }
 
   if (unlink(argv[0]) == 0)
-    { writer->puts("VFS File deleted"); }
+    { writer->puts("VFS File deleted"); vfs_changed(argv[0]); }
   else
     { writer->puts("Error: Could not delete VFS file"); }
   }
@@ -240,7 +246,7 @@ void vfs_mv(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const
     return;
     }
   if (rename(argv[0],argv[1]) == 0)
-    { writer->puts("VFS File renamed"); }
+    { writer->puts("VFS File renamed"); vfs_changed(argv[0]); vfs_changed(argv[1]); }
   else
     { writer->puts("Error: Could not rename VFS file"); }
   }
@@ -254,7 +260,7 @@ void vfs_mkdir(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, co
     }
 
   if (mkdir(argv[0],0) == 0)
-    { writer->puts("VFS directory created"); }
+    { writer->puts("VFS directory created"); vfs_changed(argv[0]); }
   else
     { writer->puts("Error: Could not create VFS directory"); }
   }
@@ -268,7 +274,7 @@ void vfs_rmdir(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, co
     }
 
   if (rmdir(argv[0]) == 0)
-    { writer->puts("VFS directory removed"); }
+    { writer->puts("VFS directory removed"); vfs_changed(argv[0]); }
   else
     { writer->puts("Error: Could not remove VFS directory"); }
   }
@@ -309,6 +315,7 @@ void vfs_cp(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const
   fclose(w);
   fclose(f);
   writer->puts("VFS copy complete");
+  vfs_changed(argv[1]);
   }
 
 void vfs_append(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
@@ -330,6 +337,7 @@ void vfs_append(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, c
   fwrite(argv[0], len, 1, w);
   fwrite("\n", 1, 1, w);
   fclose(w);
+  vfs_changed(argv[1]);
   }
 
 
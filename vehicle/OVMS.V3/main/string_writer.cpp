@@ -71,3 +71,42 @@ ssize_t StringWriter::write(const void *buf, size_t nbyte)
   append((const char*)buf, nbyte);
   return nbyte;
   }
+
+
+ExtRamStringWriter::ExtRamStringWriter(size_t capacity /*=0*/)
+  {
+  if (capacity)
+    reserve(capacity);
+  }
+
+ExtRamStringWriter::~ExtRamStringWriter()
+  {
+  }
+
+int ExtRamStringWriter::puts(const char* s)
+  {
+  append(s);
+  push_back('\n');
+  return 0;
+  }
+
+int ExtRamStringWriter::printf(const char* fmt, ...)
+  {
+  char *buffer = NULL;
+  va_list args;
+  va_start(args, fmt);
+  int ret = vasprintf(&buffer, fmt, args);
+  va_end(args);
+  if (ret >= 0)
+    {
+    append(buffer, ret);
+    free(buffer);
+    }
+  return ret;
+  }
+
+ssize_t ExtRamStringWriter::write(const void *buf, size_t nbyte)
+  {
+  append((const char*)buf, nbyte);
+  return nbyte;
+  }
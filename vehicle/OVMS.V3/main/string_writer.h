@@ -32,6 +32,7 @@
 #define __string_writer_h__
 
 #include <string>
+#include "ovms.h"
 #include "ovms_command.h"
 
 class LogBuffers;
@@ -53,4 +54,21 @@ class StringWriter : public std::string, public OvmsWriter
     virtual bool IsInteractive() { return false; }
   };
 
+// StringWriter variant collecting the output in SPIRAM, for large results:
+class ExtRamStringWriter : public extram::string, public OvmsWriter
+  {
+  public:
+    ExtRamStringWriter(size_t capacity=0);
+    ~ExtRamStringWriter();
+
+  public:
+    int puts(const char* s);
+    int printf(const char* fmt, ...);
+    ssize_t write(const void *buf, size_t nbyte);
+
+  public:
+    void Log(LogBuffers* message) {}
+    virtual bool IsInteractive() { return false; }
+  };
+
 #endif // __string_writer_h__
@@ -34,6 +34,9 @@ static const char *TAG = "test";
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <dirent.h>
+#include <ctype.h>
+#include <vector>
 #include "esp_system.h"
 #include "esp_event.h"
 #include "esp_event_loop.h"
@@ -42,10 +45,19 @@ static const char *TAG = "test";
 #include "ovms_command.h"
 #include "ovms_peripherals.h"
 #include "ovms_script.h"
+#include "ovms_events.h"
 #include "metrics_standard.h"
 #include "ovms_config.h"
 #include "can.h"
+#include "canformat.h"
+#include "canlog_vfs.h"
+#include "dbc.h"
+#include "dbc_app.h"
+#ifdef CONFIG_OVMS_COMP_RE_TOOLS
+#include "retools.h"
+#endif // #ifdef CONFIG_OVMS_COMP_RE_TOOLS
 #include "strverscmp.h"
+#include "vehicle.h"
 
 void test_deepsleep(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
@@ -292,6 +304,590 @@ void test_can(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, con
     frames, elapsed / 1000000, elapsed % 1000000, uspt);
   }
 
+/**
+ * test_load_crtd: load up to maxframes RX frames from a CRTD trace,
+ *  e.g. "1524311386.811100 1R11 100 01 02 03"
+ *  If times is given, the frame timestamps are added to it.
+ */
+bool test_load_crtd(OvmsWriter* writer, const char* path, test_framelist_t& frames, size_t maxframes,
+  test_timelist_t* times /*=NULL*/)
+  {
+  FILE* f = fopen(path, "r");
+  if (f == NULL)
+    {
+    writer->puts("Error: Cannot open CRTD file");
+    return false;
+    }
+
+  CAN_frame_t frame;
+  char line[128];
+  while (frames.size() < maxframes && fgets(line, sizeof(line), f) != NULL)
+    {
+    char* b = strchr(line, ' ');
+    if (!isdigit(line[0]) || b == NULL)
+      continue;
+    b++;
+    int bus = 0;
+    if (isdigit(*b))
+      bus = *b++ - '1';
+    if (b[0] != 'R' || b[3] != ' ')
+      continue;
+    memset(&frame, 0, sizeof(frame));
+    if (b[1] == '1' && b[2] == '1')
+      frame.FIR.B.FF = CAN_frame_std;
+    else if (b[1] == '2' && b[2] == '9')
+      frame.FIR.B.FF = CAN_frame_ext;
+    else
+      continue;
+    frame.origin = MyCan.GetBus(bus);
+    char* p;
+    frame.MsgID = strtoul(b+4, &p, 16);
+    while (*p == ' ' && frame.FIR.B.DLC < 8)
+      {
+      frame.data.u8[frame.FIR.B.DLC++] = strtoul(p+1, &p, 16);
+      }
+    frames.push_back(frame);
+    if (times)
+      {
+      struct timeval tv = {};
+      tv.tv_sec = strtoul(line, &p, 10);
+      if (*p == '.')
+        tv.tv_usec = strtoul(p+1, NULL, 10);
+      times->push_back(tv);
+      }
+    }
+  fclose(f);
+  if (frames.empty())
+    {
+    writer->puts("Error: No RX frames found");
+    return false;
+    }
+  return true;
+  }
+
+/**
+ * test_print_time: print a benchmark time as total, per item and items per second
+ */
+void test_print_time(OvmsWriter* writer, const char* label, int64_t time_us, int count, const char* unit)
+  {
+  writer->printf("%s: %lld us total = %d ns/%s = %d %ss/s\n", label, time_us,
+    count ? (int)(time_us * 1000 / count) : 0, unit,
+    time_us ? (int)(count * 1000000LL / time_us) : 0, unit);
+  }
+
+static void test_simbus_task(void *pvParameters)
+  {
+  ((test_simbus*)pvParameters)->SimTask();
+  }
+
+test_simbus::test_simbus(const char* name, const char* taskname)
+  : canbus(name)
+  {
+  m_taskname = taskname;
+  m_simqueue = xQueueCreate(32, sizeof(CAN_frame_t));
+  m_simtask = NULL;
+  }
+
+esp_err_t test_simbus::Start(CAN_mode_t mode, CAN_speed_t speed)
+  {
+  // create the task here, as it calls into the derived simulator:
+  if (!m_simtask)
+    xTaskCreatePinnedToCore(test_simbus_task, m_taskname, 4096, (void*)this, 10, &m_simtask, CORE(0));
+  m_mode = mode;
+  m_speed = speed;
+  return ESP_OK;
+  }
+
+esp_err_t test_simbus::Stop()
+  {
+  m_mode = CAN_MODE_OFF;
+  return ESP_OK;
+  }
+
+esp_err_t test_simbus::Write(const CAN_frame_t* p_frame, TickType_t maxqueuewait /*=0*/)
+  {
+  if (xQueueSend(m_simqueue, p_frame, maxqueuewait) != pdTRUE)
+    {
+    m_status.txbuf_overflow++;
+    return ESP_FAIL;
+    }
+  m_status.packets_tx++;
+  return ESP_OK;
+  }
+
+void test_simbus::SimTask()
+  {
+  CAN_frame_t frame;
+  while (1)
+    {
+    if (xQueueReceive(m_simqueue, &frame, SimTick()) == pdTRUE)
+      SimFrame(&frame);
+    }
+  }
+
+void test_simbus::SimRespond(uint32_t msgid, const uint8_t* data)
+  {
+  CAN_frame_t frame = {};
+  frame.origin = this;
+  frame.FIR.B.FF = CAN_frame_std;
+  frame.FIR.B.DLC = 8;
+  frame.MsgID = msgid;
+  memcpy(frame.data.u8, data, 8);
+  MyCan.IncomingFrame(&frame);
+  }
+
+void test_canroute(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  test_framelist_t frames;
+  if (!test_load_crtd(writer, argv[0], frames, 10000))
+    return;
+
+  // Route all frames through the current listener dispatch tables:
+  uint32_t copies = 0;
+  int64_t time_start_us = esp_timer_get_time();
+  for (auto& fr : frames)
+    copies += __builtin_popcount(MyCan.RouteFrame(&fr));
+  int64_t elapsed = esp_timer_get_time() - time_start_us;
+
+  uint32_t unfiltered = frames.size() * MyCan.ListenerCount();
+  writer->printf("%u RX frames, %d listeners\n", frames.size(), MyCan.ListenerCount());
+  writer->printf("unfiltered: %u queue copies\n", unfiltered);
+  writer->printf("routed    : %u queue copies (%d%%), %d ns/frame routing\n",
+    copies, unfiltered ? (int)(copies * 100LL / unfiltered) : 0,
+    (int)(elapsed * 1000 / frames.size()));
+  }
+
+void test_canlog(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int fps = (argc > 2) ? atoi(argv[2]) : 2000;
+  int seconds = (argc > 3) ? atoi(argv[3]) : 10;
+  if (fps < 1) fps = 1;
+  if (seconds < 1) seconds = 1;
+
+  test_framelist_t frames;
+  if (!test_load_crtd(writer, argv[0], frames, 10000))
+    return;
+
+  canlog_vfs* logger = new canlog_vfs(argv[1], "crtd");
+  if (!logger->Open())
+    {
+    writer->printf("Error: Cannot open log file %s\n", argv[1]);
+    delete logger;
+    return;
+    }
+
+  // Feed the trace repeatedly, one tick worth of frames per tick:
+  int total = fps * seconds;
+  int pertick = (fps * portTICK_PERIOD_MS + 999) / 1000;
+  int64_t time_start_us = esp_timer_get_time();
+  size_t k = 0;
+  for (int sent = 0; sent < total; )
+    {
+    for (int j = 0; j < pertick && sent < total; j++, sent++)
+      {
+      const CAN_frame_t& fr = frames[k];
+      logger->LogFrame(fr.origin, CAN_LogFrame_RX, &fr);
+      if (++k == frames.size()) k = 0;
+      }
+    vTaskDelay(1);
+    }
+  int64_t time_feed_us = esp_timer_get_time() - time_start_us;
+
+  // Wait for the logger to finish writing:
+  for (int j = 0; j < 500 && logger->m_ringhead != logger->m_ringtail; j++)
+    vTaskDelay(pdMS_TO_TICKS(10));
+  vTaskDelay(pdMS_TO_TICKS(2*CANLOG_BATCH_DELAY_MS));
+  int64_t time_total_us = esp_timer_get_time() - time_start_us;
+
+  uint32_t logged = logger->m_msgcount - logger->m_dropcount;
+  writer->printf("%u frames offered at %d fps in %lld ms\n", logger->m_msgcount, fps, time_feed_us / 1000);
+  writer->printf("%u frames logged, %u dropped, %u batches\n", logged, logger->m_dropcount, logger->m_batches);
+  writer->printf("sustained: %d fps\n", (int)(logged * 1000000LL / time_total_us));
+
+  logger->Close();
+  delete logger;
+  }
+
+void test_canformat(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loopcnt = (argc > 0) ? atoi(argv[0]) : 10;
+  if (loopcnt < 1) loopcnt = 1;
+  int count = loopcnt * 1000;
+
+  // Sample RX frame with 8 data bytes:
+  CAN_log_message_t msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.type = CAN_LogFrame_RX;
+  gettimeofday(&msg.timestamp, NULL);
+  msg.frame.origin = MyCan.GetBus(0);
+  msg.frame.FIR.B.FF = CAN_frame_std;
+  msg.frame.FIR.B.DLC = 8;
+  msg.frame.MsgID = 0x7e8;
+  for (int k = 0; k < 8; k++)
+    msg.frame.data.u8[k] = 0x11 * k;
+
+  writer->printf("%d frames per format:\n", count);
+  char buf[CANFORMAT_MAXLEN];
+  for (auto& entry : MyCanFormatFactory.m_fmap)
+    {
+    canformat* fmt = MyCanFormatFactory.NewFormat(entry.first);
+    if (!fmt) continue;
+
+    size_t total = 0;
+    int64_t time_start_us = esp_timer_get_time();
+    for (int j = 0; j < count; j++)
+      {
+      msg.timestamp.tv_usec = j % 1000000;
+      total += fmt->get(&msg).length();
+      }
+    int64_t time_get_us = esp_timer_get_time() - time_start_us;
+
+    size_t totalbuf = 0;
+    time_start_us = esp_timer_get_time();
+    for (int j = 0; j < count; j++)
+      {
+      msg.timestamp.tv_usec = j % 1000000;
+      totalbuf += fmt->getbuf(&msg, buf, sizeof(buf));
+      }
+    int64_t time_getbuf_us = esp_timer_get_time() - time_start_us;
+
+    writer->printf("%-10s get: %7d frames/s  getbuf: %7d frames/s%s\n", entry.first,
+      time_get_us ? (int)(count * 1000000LL / time_get_us) : 0,
+      time_getbuf_us ? (int)(count * 1000000LL / time_getbuf_us) : 0,
+      (total != totalbuf) ? "  LENGTH MISMATCH" : "");
+    delete fmt;
+    }
+
+  if (argc < 2)
+    return;
+
+  // Output size per frame for a real trace, compared to CRTD:
+  test_framelist_t frames;
+  test_timelist_t times;
+  if (!test_load_crtd(writer, argv[1], frames, 10000, &times))
+    return;
+  std::vector<std::pair<const char*, size_t>> sizes;
+  size_t crtdsize = 0;
+  for (auto& entry : MyCanFormatFactory.m_fmap)
+    {
+    canformat* fmt = MyCanFormatFactory.NewFormat(entry.first);
+    if (!fmt) continue;
+    size_t size = fmt->getheader(&times[0]).length();
+    for (size_t j = 0; j < frames.size(); j++)
+      {
+      msg.timestamp = times[j];
+      msg.frame = frames[j];
+      size += fmt->get(&msg).length();
+      }
+    size += fmt->getfooter().length();
+    sizes.push_back(std::make_pair(entry.first, size));
+    if (strcmp(entry.first, "crtd") == 0)
+      crtdsize = size;
+    delete fmt;
+    }
+
+  writer->printf("\n%d frames from %s:\n", frames.size(), argv[1]);
+  for (auto& entry : sizes)
+    {
+    writer->printf("%-10s %8u bytes = %6.2f bytes/frame", entry.first, entry.second,
+      (double)entry.second / frames.size());
+    if (crtdsize && entry.second)
+      writer->printf(" = 1/%.1f crtd\n", (double)crtdsize / entry.second);
+    else
+      writer->puts("");
+    }
+  }
+
+void test_canfilter(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loopcnt = (argc > 0) ? atoi(argv[0]) : 10;
+  if (loopcnt < 1) loopcnt = 1;
+  const int nframes = 1000;
+  const int sizes[] = { 1, 10, 100 };
+
+  // Random mix of standard & extended frames on buses 1-3:
+  std::vector<CAN_frame_t, ExtRamAllocator<CAN_frame_t>> frames(nframes);
+  for (auto& fr : frames)
+    {
+    memset(&fr, 0, sizeof(fr));
+    fr.origin = MyCan.GetBus(esp_random() % 3);
+    if (esp_random() & 1)
+      {
+      fr.FIR.B.FF = CAN_frame_std;
+      fr.MsgID = esp_random() & 0x7ff;
+      }
+    else
+      {
+      fr.FIR.B.FF = CAN_frame_ext;
+      fr.MsgID = 0x18da0000 + (esp_random() & 0xffff);
+      }
+    }
+
+  for (int size : sizes)
+    {
+    // Random single IDs and ranges, on any or a specific bus:
+    canfilter filter;
+    std::vector<CAN_filter_t> list(size);
+    for (auto& f : list)
+      {
+      int bus = esp_random() % 3;
+      f.bus = bus ? '0' + bus : 0;
+      if (esp_random() & 1)
+        {
+        f.id_from = esp_random() & 0x7ff;
+        f.id_to = f.id_from + ((esp_random() & 3) ? 0 : esp_random() % 16);
+        }
+      else
+        {
+        f.id_from = 0x18da0000 + (esp_random() & 0xffff);
+        f.id_to = f.id_from + ((esp_random() & 3) ? 0 : esp_random() % 256);
+        }
+      filter.AddFilter(f.bus, f.id_from, f.id_to);
+      }
+
+    // Compiled filter:
+    int matches = 0, errcnt = 0;
+    int64_t time_start_us = esp_timer_get_time();
+    for (int j = 0; j < loopcnt; j++)
+      {
+      for (auto& fr : frames)
+        matches += filter.IsFiltered(&fr);
+      }
+    int64_t time_compiled_us = esp_timer_get_time() - time_start_us;
+
+    // Same checks by linear list scan (the previous IsFiltered implementation):
+    int scanmatches = 0;
+    time_start_us = esp_timer_get_time();
+    for (int j = 0; j < loopcnt; j++)
+      {
+      for (auto& fr : frames)
+        {
+        char buskey = fr.origin ? fr.origin->m_busnumber + '1' : '0';
+        bool match = false;
+        for (auto& f : list)
+          {
+          if ((f.bus)&&(f.bus != buskey)) continue;
+          if ((fr.MsgID >= f.id_from) && (fr.MsgID <= f.id_to))
+            {
+            match = true;
+            break;
+            }
+          }
+        scanmatches += match;
+        if (j == 0 && match != filter.IsFiltered(&fr))
+          errcnt++;
+        }
+      }
+    int64_t time_scan_us = esp_timer_get_time() - time_start_us;
+
+    int checks = loopcnt * nframes;
+    writer->printf("%d filters, %d checks, %d/%d matches, %d errors\n", size, checks, matches, scanmatches, errcnt);
+    test_print_time(writer, "  compiled", time_compiled_us, checks, "frame");
+    test_print_time(writer, "  scan    ", time_scan_us, checks, "frame");
+    }
+  }
+
+void test_dbcdecode(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  dbcfile* dbc = MyDBC.Find(argv[0]);
+  if (!dbc)
+    {
+    writer->printf("Error: DBC '%s' not loaded\n", argv[0]);
+    return;
+    }
+  // The benchmark recompiles the decoder & sets the signal metrics:
+  if (dbc->IsLocked() || MyVehicleFactory.ActiveVehicle())
+    {
+    writer->puts("Error: DBC in use, detach it from all buses and clear the vehicle module first");
+    return;
+    }
+  int loopcnt = (argc > 2) ? atoi(argv[2]) : 10;
+  if (loopcnt < 1) loopcnt = 1;
+
+  test_framelist_t frames;
+  if (!test_load_crtd(writer, argv[1], frames, 10000))
+    return;
+
+  // Message map lookup & dbcNumber decoding per signal (the previous IncomingFrame implementation):
+  int64_t time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    {
+    for (auto& fr : frames)
+      {
+      dbcMessage* msg = dbc->m_messages.FindMessage(fr.FIR.B.FF, fr.MsgID);
+      if (!msg) continue;
+      dbcSignal* mux = msg->GetMultiplexorSignal();
+      uint32_t muxval = 0;
+      if (mux)
+        muxval = mux->Decode(&fr).GetSignedInteger();
+      for (dbcSignal* sig : msg->m_signals)
+        {
+        OvmsMetric* m = sig->GetMetric();
+        if (m && (mux == NULL || sig->GetMultiplexSwitchvalue() == muxval))
+          {
+          dbcNumber r = sig->Decode(&fr);
+          m->SetValue(r);
+          }
+        }
+      }
+    }
+  int64_t time_map_us = esp_timer_get_time() - time_start_us;
+
+  // Precompiled decoder (includes the compilation on first use):
+  int decoded = 0;
+  dbc->InvalidateDecoder();
+  time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    {
+    for (auto& fr : frames)
+      decoded += dbc->DecodeFrame(&fr);
+    }
+  int64_t time_compiled_us = esp_timer_get_time() - time_start_us;
+
+  int total = loopcnt * frames.size();
+  writer->printf("%d frames, %d decoded\n", total, decoded);
+  test_print_time(writer, "  compiled", time_compiled_us, total, "frame");
+  test_print_time(writer, "  map     ", time_map_us, total, "frame");
+  writer->puts("  (a fully loaded 500 kbit/s bus carries ~3900 frames/s)");
+  }
+
+static int test_dbc_metricsignals(dbcfile* dbc)
+  {
+  int count = 0;
+  for (auto& it : dbc->m_messages.m_entrymap)
+    {
+    for (dbcSignal* sig : it.second->m_signals)
+      {
+      if (sig->GetMetric()) count++;
+      }
+    }
+  return count;
+  }
+
+void test_dbcload(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  bool strip = (argc > 1) && (strcmp(argv[1], "strip") == 0);
+  FILE* fd = fopen(argv[0], "r");
+  if (!fd)
+    {
+    writer->printf("Error: cannot open '%s'\n", argv[0]);
+    return;
+    }
+
+  // Parse the source (passing the file handle bypasses the cache):
+  size_t heap_start = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  int64_t time_start_us = esp_timer_get_time();
+  dbcfile* dbc = new dbcfile();
+  bool ok = dbc->LoadFile("test", argv[0], fd);
+  if (ok && strip) dbc->Strip();
+  int64_t time_parse_us = esp_timer_get_time() - time_start_us;
+  int heap_parse = heap_start - heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  fclose(fd);
+  if (!ok || !dbc->SaveCache(strip))
+    {
+    writer->printf("Error: %s\n", ok ? "cannot write cache" : "parsing failed");
+    delete dbc;
+    return;
+    }
+  writer->printf("%s\n", dbc->Status().c_str());
+  int metrics_parse = test_dbc_metricsignals(dbc);
+  delete dbc;
+
+  // Load the binary cache:
+  heap_start = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  time_start_us = esp_timer_get_time();
+  dbc = new dbcfile();
+  ok = dbc->LoadCache("test", argv[0], strip);
+  int64_t time_cache_us = esp_timer_get_time() - time_start_us;
+  int heap_cache = heap_start - heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  int metrics_cache = ok ? test_dbc_metricsignals(dbc) : 0;
+  delete dbc;
+  if (!ok)
+    {
+    writer->puts("Error: cannot load cache");
+    return;
+    }
+  if (metrics_cache != metrics_parse)
+    writer->printf("Error: %d metric signals parsed, %d cached\n", metrics_parse, metrics_cache);
+
+  writer->printf("  parser: %lld ms, %d bytes heap\n", time_parse_us / 1000, heap_parse);
+  writer->printf("  cache : %lld ms, %d bytes heap%s\n", time_cache_us / 1000, heap_cache, strip ? " (stripped)" : "");
+  writer->printf("  %d signals mapped to metrics\n", metrics_parse);
+  }
+
+#ifdef CONFIG_OVMS_COMP_RE_TOOLS
+void test_retools(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loopcnt = (argc > 1) ? atoi(argv[1]) : 10;
+  if (loopcnt < 1) loopcnt = 1;
+
+  test_framelist_t frames;
+  if (!test_load_crtd(writer, argv[0], frames, 10000))
+    return;
+
+  // Packed keys in the record hash table:
+  re* bench = new re("re.test");
+  int64_t time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    {
+    for (auto& fr : frames)
+      bench->DoAnalyse(&fr);
+    }
+  int64_t time_table_us = esp_timer_get_time() - time_start_us;
+  int keys = bench->m_rmap.size();
+
+  // String keys in a std::map (the previous implementation):
+  std::map<std::string, re_record_t*> smap;
+  time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    {
+    for (auto& fr : frames)
+      {
+      std::string key = bench->GetKeyName(bench->GetKey(&fr));
+      auto k = smap.find(key);
+      re_record_t* r;
+      if (k == smap.end())
+        {
+        r = new re_record_t;
+        memset(r, 0, sizeof(re_record_t));
+        smap[key] = r;
+        }
+      else
+        r = k->second;
+      memcpy(&r->last, &fr, sizeof(CAN_frame_t));
+      r->rxcount++;
+      }
+    }
+  int64_t time_map_us = esp_timer_get_time() - time_start_us;
+  for (auto& it : smap)
+    delete it.second;
+  delete bench;
+
+  int total = loopcnt * frames.size();
+  writer->printf("%d frames, %d/%d keys\n", total, keys, smap.size());
+  test_print_time(writer, "  table", time_table_us, total, "frame");
+  test_print_time(writer, "  map  ", time_map_us, total, "frame");
+  }
+#endif // #ifdef CONFIG_OVMS_COMP_RE_TOOLS
+
+void test_bms(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int series = (argc > 0) ? atoi(argv[0]) : 100;
+  if (series < 1) series = 1;
+  if (MyVehicleFactory.ActiveVehicle())
+    {
+    writer->puts("Error: a vehicle module is loaded, clear it first (vehicle module)");
+    return;
+    }
+
+  // Use an instance not fed by any bus, so the benchmark can own the cell arrays:
+  OvmsVehicle* vehicle = new OvmsVehicle();
+  static const int readings[] = { 96, 108, 192 };
+  for (int n : readings)
+    vehicle->BmsBenchmark(writer, n, series);
+  delete vehicle;
+  }
+
 void test_mkstemp(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
   int fd1, e1, fd2, e2;
@@ -322,7 +918,7 @@ void test_string(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
     {
     std::string msg;
     msg.reserve(2048);
-    for (m = MyMetrics.m_first; msg.size() < 1024; m = m->m_next ? m->m_next : MyMetrics.m_first)
+    for (m = MyMetrics.First(); msg.size() < 1024; m = m->m_next ? m->m_next : MyMetrics.First())
       {
       if (mode == 1)
         msg += m->AsJSON();
@@ -362,6 +958,283 @@ void test_string(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
     (int)((esp_timer_get_time() - time_start_us) / 1000));
   }
 
+void test_metricfind(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loopcnt = (argc > 0) ? atoi(argv[0]) : 10;
+  if (loopcnt < 1) loopcnt = 1;
+  int count = 0, errcnt = 0;
+  OvmsMetric* first = MyMetrics.First();
+  OvmsMetric* m;
+  OvmsMetric* f;
+
+  for (m = first; m != NULL; m = m->m_next)
+    count++;
+  if (count == 0)
+    {
+    writer->puts("No metrics registered");
+    return;
+    }
+
+  // Lookup every metric by name, using the index:
+  int64_t time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    {
+    for (m = first; m != NULL; m = m->m_next)
+      {
+      if (MyMetrics.Find(m->m_name) == NULL)
+        errcnt++;
+      }
+    }
+  int64_t time_index_us = esp_timer_get_time() - time_start_us;
+
+  // Same lookups by linear list scan (the previous Find implementation):
+  time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    {
+    for (m = first; m != NULL; m = m->m_next)
+      {
+      for (f = first; f != NULL; f = f->m_next)
+        {
+        if (strcmp(f->m_name, m->m_name) == 0) break;
+        }
+      if (f == NULL)
+        errcnt++;
+      }
+    }
+  int64_t time_scan_us = esp_timer_get_time() - time_start_us;
+
+  int lookups = loopcnt * count;
+  writer->printf("%d metrics, %d lookups, %d errors\n", count, lookups, errcnt);
+  test_print_time(writer, "index", time_index_us, lookups, "lookup");
+  test_print_time(writer, "scan ", time_scan_us, lookups, "lookup");
+  }
+
+// Simulated WebSocket full metrics transfer: one chunk per client and round,
+//  the chunk start is found by skipping the metrics sent (before) or taken
+//  from the client cursor (after). Chunk size as XFER_CHUNK_SIZE.
+static int64_t test_wsmetrics_run(int clients, bool cursor, size_t* bytes)
+  {
+  std::vector<int> sent(clients, 0);
+  std::vector<OvmsMetric*> next(clients, MyMetrics.First());
+  std::vector<bool> done(clients, false);
+  std::string msg;
+  msg.reserve(2*1024+128);
+  int active = clients;
+  *bytes = 0;
+
+  int64_t time_start_us = esp_timer_get_time();
+  while (active)
+    {
+    for (int c = 0; c < clients; c++)
+      {
+      if (done[c]) continue;
+      int i;
+      OvmsMetric* m;
+      if (cursor)
+        m = next[c];
+      else
+        for (i=0, m=MyMetrics.First(); i < sent[c] && m != NULL; m=m->m_next, i++);
+      msg = "{\"metrics\":{";
+      for (i=0; m && msg.size() < 1024; m=m->m_next)
+        {
+        if (i) msg += ',';
+        msg += '\"';
+        msg += m->m_name;
+        msg += "\":";
+        m->AppendCachedJSON(msg);
+        i++;
+        }
+      msg += "}}";
+      *bytes += msg.size();
+      sent[c] += i;
+      next[c] = m;
+      if (!m)
+        {
+        done[c] = true;
+        active--;
+        }
+      }
+    }
+  return esp_timer_get_time() - time_start_us;
+  }
+
+void test_wsmetrics(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  const int clientcnt[] = { 1, 4, 8 };
+  size_t bytes;
+  int count = 0;
+  for (OvmsMetric* m = MyMetrics.First(); m != NULL; m = m->m_next)
+    count++;
+  if (count == 0)
+    {
+    writer->puts("No metrics registered");
+    return;
+    }
+
+  // warm up the serialization cache:
+  test_wsmetrics_run(1, true, &bytes);
+  writer->printf("%d metrics, %u bytes per full transfer\n", count, bytes);
+  writer->puts("clients  before [ms]  after [ms]");
+  for (int n : clientcnt)
+    {
+    int64_t time_skip_us = test_wsmetrics_run(n, false, &bytes);
+    int64_t time_cursor_us = test_wsmetrics_run(n, true, &bytes);
+    writer->printf("%7d  %11.1f  %10.1f\n", n, (float)time_skip_us / 1000, (float)time_cursor_us / 1000);
+    }
+  }
+
+static const char* test_notify_caller = "test.notify";
+static int test_notify_count;
+
+void test_metricnotify(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loopcnt = (argc > 0) ? atoi(argv[0]) : 10000;
+  if (loopcnt < 1) loopcnt = 1;
+  const int listenercnt[] = { 0, 1, 5 };
+
+  OvmsMetricInt* m = new OvmsMetricInt("test.notify");
+  int value = 0;
+
+  for (int n : listenercnt)
+    {
+    for (int i = 0; i < n; i++)
+      MyMetrics.RegisterListener(test_notify_caller, "test.notify", [](OvmsMetric* metric) { test_notify_count++; });
+    test_notify_count = 0;
+
+    int64_t time_start_us = esp_timer_get_time();
+    for (int j = 0; j < loopcnt; j++)
+      m->SetValue(++value);
+    int64_t elapsed = esp_timer_get_time() - time_start_us;
+
+    MyMetrics.DeregisterListener(test_notify_caller);
+    writer->printf("%d listeners: %d SetValue calls in %lld us = %d calls/s (%d callbacks)\n",
+      n, loopcnt, elapsed, elapsed ? (int)(loopcnt * 1000000LL / elapsed) : 0, test_notify_count);
+    }
+
+  MyMetrics.DeregisterMetric(m);
+  }
+
+void test_metriccache(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loopcnt = (argc > 0) ? atoi(argv[0]) : 10;
+  if (loopcnt < 1) loopcnt = 1;
+  OvmsMetric* first = MyMetrics.First();
+  OvmsMetric* m;
+  int count = 0;
+  for (m = first; m != NULL; m = m->m_next)
+    count++;
+
+  std::string msg;
+  msg.reserve(32768);
+
+  // Serialize all metrics per cycle, building a temporary string for each metric:
+  int64_t time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    {
+    msg.clear();
+    for (m = first; m != NULL; m = m->m_next)
+      msg += m->AsJSON();
+    }
+  int64_t time_plain_us = esp_timer_get_time() - time_start_us;
+
+  // Same using the serialization cache, appending directly to the buffer:
+  uint32_t misses = MyMetrics.m_cache_misses;
+  time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    {
+    msg.clear();
+    for (m = first; m != NULL; m = m->m_next)
+      m->AppendCachedJSON(msg);
+    }
+  int64_t time_cached_us = esp_timer_get_time() - time_start_us;
+  misses = MyMetrics.m_cache_misses - misses;
+
+  writer->printf("%d metrics, %d cycles, %u bytes JSON per cycle\n", count, loopcnt, msg.size());
+  writer->printf("AsJSON          : %d us/cycle, %d serializations + temporary strings per cycle\n",
+    (int)(time_plain_us / loopcnt), count);
+  writer->printf("AppendCachedJSON: %d us/cycle, %u serializations in %d cycles, no temporary strings\n",
+    (int)(time_cached_us / loopcnt), misses, loopcnt);
+  writer->printf("Cache: %u entries, %u bytes\n", MyMetrics.m_cache_entries, MyMetrics.m_cache_size);
+  }
+
+void test_eventscripts(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  std::string event = (argc > 0) ? argv[0] : "ticker.1";
+  int loopcnt = (argc > 1) ? atoi(argv[1]) : 100;
+  if (loopcnt < 1) loopcnt = 1;
+  std::vector<std::string> roots;
+#ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
+  roots.push_back("/sd/events/");
+#endif // #ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
+  roots.push_back("/store/events/");
+
+  // Event directory scans per event (the previous EventScript implementation):
+  int64_t time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    {
+    for (auto& root : roots)
+      {
+      std::string path = root + event;
+      DIR* dir = opendir(path.c_str());
+      if (dir)
+        {
+        while (readdir(dir) != NULL) {}
+        closedir(dir);
+        }
+      }
+    }
+  int64_t time_scan_us = esp_timer_get_time() - time_start_us;
+
+  // Same lookups using the event script index, including the initial load:
+  OvmsScripts::EventScriptList scripts;
+  MyScripts.EventScriptsChanged("");
+  uint32_t loads = MyScripts.m_evscript_loads;
+  time_start_us = esp_timer_get_time();
+  for (int j = 0; j < loopcnt; j++)
+    MyScripts.FindEventScripts(event, scripts);
+  int64_t time_index_us = esp_timer_get_time() - time_start_us;
+  loads = MyScripts.m_evscript_loads - loads;
+
+  writer->printf("event '%s': %d scripts, %d lookups\n", event.c_str(), scripts.size(), loopcnt);
+  writer->printf("scan : %lld us total = %d us/event\n", time_scan_us, (int)(time_scan_us / loopcnt));
+  writer->printf("index: %lld us total = %d us/event (%u root scans)\n", time_index_us, (int)(time_index_us / loopcnt), loads);
+  }
+
+static volatile int test_events_count;
+
+void test_events(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loopcnt = (argc > 0) ? atoi(argv[0]) : 1000;
+  if (loopcnt < 1) loopcnt = 1;
+
+  MyEvents.RegisterEvent("test.events", "test.events", [](const std::string& event, void* data) { test_events_count++; });
+  event_id_t id = MyEvents.FindEvent("test.events");
+
+  for (int byid = 0; byid < 2; byid++)
+    {
+    test_events_count = 0;
+    int64_t time_start_us = esp_timer_get_time();
+    for (int j = 0; j < loopcnt; j++)
+      {
+      // keep headroom in the queue, a dropped non-ticker event aborts the system:
+      while (uxQueueSpacesAvailable(MyEvents.m_taskqueue) < 2)
+        taskYIELD();
+      if (byid)
+        MyEvents.SignalEvent(id, NULL);
+      else
+        MyEvents.SignalEvent("test.events", NULL);
+      }
+    while (test_events_count < loopcnt && esp_timer_get_time() - time_start_us < 10000000)
+      taskYIELD();
+    int64_t elapsed = esp_timer_get_time() - time_start_us;
+    writer->printf("%s: %d events dispatched in %lld us = %d events/s\n",
+      byid ? "by ID  " : "by name", test_events_count, elapsed,
+      elapsed ? (int)(test_events_count * 1000000LL / elapsed) : 0);
+    }
+
+  MyEvents.DeregisterEvent("test.events");
+  }
+
 void test_command(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
   MyCommandApp.Display(writer);
@@ -390,8 +1263,24 @@ TestFrameworkInit::TestFrameworkInit()
   cmd_test->RegisterCommand("strverscmp", "Test strverscmp function", test_strverscmp, "", 2, 2);
   cmd_test->RegisterCommand("cantx", "Test CAN bus transmission", test_can, "[<port>] [<number>]", 0, 2);
   cmd_test->RegisterCommand("canrx", "Test CAN bus reception", test_can, "[<port>] [<number>]", 0, 2);
+  cmd_test->RegisterCommand("canroute", "Test CAN listener routing using a CRTD trace", test_canroute, "<crtdfile>", 1, 1);
+  cmd_test->RegisterCommand("canlog", "Test CAN logging throughput using a CRTD trace", test_canlog, "<crtdfile> <logfile> [<fps>] [<seconds>]", 2, 4);
+  cmd_test->RegisterCommand("canformat", "Test CAN log formatter performance and trace output size", test_canformat, "[<loopcnt>] [<crtdfile>]", 0, 2);
+  cmd_test->RegisterCommand("canfilter", "Test CAN filter matching performance", test_canfilter, "[<loopcnt>]", 0, 1);
+  cmd_test->RegisterCommand("dbcdecode", "Test DBC signal decoding performance using a CRTD trace", test_dbcdecode, "<dbc> <crtdfile> [<loopcnt>]", 2, 3);
+  cmd_test->RegisterCommand("dbcload", "Test DBC file loading by parser and binary cache", test_dbcload, "<dbcfile> [strip]", 1, 2);
+#ifdef CONFIG_OVMS_COMP_RE_TOOLS
+  cmd_test->RegisterCommand("retools", "Test RE frame analysis performance using a CRTD trace", test_retools, "<crtdfile> [<loopcnt>]", 1, 2);
+#endif // #ifdef CONFIG_OVMS_COMP_RE_TOOLS
+  cmd_test->RegisterCommand("bms", "Test BMS cell voltage series processing performance", test_bms, "[<series>]", 0, 1);
   cmd_test->RegisterCommand("mkstemp", "Test mkstemp function", test_mkstemp, "<file>", 1, 1);
   cmd_test->RegisterCommand("string", "Test std::string memory corruption", test_string, "<loopcnt> <mode>\n"
     "mode: 1=m.AsJSON, 2=m.AsString, 3=m.name, 4=const cfg string, 5=const local cstr, 6=const local string", 2, 2);
+  cmd_test->RegisterCommand("metricfind", "Test metrics name lookup performance", test_metricfind, "[<loopcnt>]", 0, 1);
+  cmd_test->RegisterCommand("metricnotify", "Test metrics modification notification performance", test_metricnotify, "[<loopcnt>]", 0, 1);
+  cmd_test->RegisterCommand("metriccache", "Test metrics serialization cache performance", test_metriccache, "[<loopcnt>]", 0, 1);
+  cmd_test->RegisterCommand("wsmetrics", "Test WebSocket full metrics transfer time for 1/4/8 clients", test_wsmetrics);
+  cmd_test->RegisterCommand("eventscripts", "Test event script lookup performance", test_eventscripts, "[<event>] [<loopcnt>]", 0, 2);
+  cmd_test->RegisterCommand("events", "Test event dispatch performance", test_events, "[<loopcnt>]", 0, 1);
   cmd_test->RegisterCommand("commands", "List command tree", test_command);
   }
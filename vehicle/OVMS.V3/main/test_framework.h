@@ -33,4 +33,50 @@
 #ifndef __TEST_FRAMEWORK_H__
 #define __TEST_FRAMEWORK_H__
 
+#include <vector>
+#include <sys/time.h>
+#include "ovms.h"
+#include "ovms_command.h"
+#include "can.h"
+
+/**
+ * Shared benchmark scaffolding for the "test" commands, including those
+ *  registered by components (e.g. "test canopen", "test poller").
+ */
+
+typedef std::vector<CAN_frame_t, ExtRamAllocator<CAN_frame_t>> test_framelist_t;
+typedef std::vector<struct timeval, ExtRamAllocator<struct timeval>> test_timelist_t;
+
+extern bool test_load_crtd(OvmsWriter* writer, const char* path, test_framelist_t& frames, size_t maxframes,
+  test_timelist_t* times=NULL);
+extern void test_print_time(OvmsWriter* writer, const char* label, int64_t time_us, int count, const char* unit);
+
+/**
+ * test_simbus: virtual CAN bus for simulated devices. Frames written to the bus
+ *  are passed to SimFrame() by the simulator task, SimRespond() delivers frames
+ *  as received on the bus. SimTick() runs due timed actions and returns the
+ *  ticks to wait for the next one. The task is created on the first Start().
+ */
+class test_simbus : public canbus
+  {
+  public:
+    test_simbus(const char* name, const char* taskname);
+
+  public:
+    esp_err_t Start(CAN_mode_t mode, CAN_speed_t speed);
+    esp_err_t Stop();
+    esp_err_t Write(const CAN_frame_t* p_frame, TickType_t maxqueuewait=0);
+
+  public:
+    void SimTask();
+    virtual TickType_t SimTick() { return portMAX_DELAY; }
+    virtual void SimFrame(const CAN_frame_t* frame) = 0;
+    void SimRespond(uint32_t msgid, const uint8_t* data);
+
+  protected:
+    const char*         m_taskname;
+    QueueHandle_t       m_simqueue;
+    TaskHandle_t        m_simtask;
+  };
+
 #endif //#ifndef __TEST_FRAMEWORK_H__
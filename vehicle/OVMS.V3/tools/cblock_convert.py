@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+#
+# Convert OVMS "cblock" compressed CAN traces to CRTD or PCAP
+#
+# Usage: cblock_convert.py [-f crtd|pcap] <infile.cb> [<outfile>]
+#
+# See components/can/src/canformat_cblock.h for the file format.
+#
+
+import argparse
+import struct
+import sys
+
+MAGIC_FILE  = b"OVCB"
+MAGIC_BLOCK = b"CBLK"
+MAGIC_INDEX = b"CIDX"
+
+FL_BUSMASK  = 0x07
+FL_EXT      = 0x08
+FL_TX       = 0x10
+FL_RTR      = 0x20
+
+
+def read_frames(data):
+  """Yield (timestamp_us, bus, flags, id, payload) for all frames in data."""
+  pos = 0
+  if data[0:4] == MAGIC_FILE:
+    pos = 8
+  while pos + 20 <= len(data):
+    magic = data[pos:pos+4]
+    if magic == MAGIC_INDEX:
+      return
+    if magic != MAGIC_BLOCK:
+      pos += 1    # resynchronize
+      continue
+    length, count, sec, usec, idcount = struct.unpack_from("<HHIIB", data, pos+4)
+    pos += 20
+    end = pos + length
+    if end > len(data):
+      sys.stderr.write("warning: truncated block at offset %d\n" % (pos-20))
+      end = len(data)
+    ids = []
+    for k in range(idcount):
+      flags, canid = struct.unpack_from("<BI", data, pos)
+      ids.append([canid, flags, None])
+      pos += 5
+    ts = sec * 1000000 + usec
+    try:
+      for n in range(count):
+        dt = 0
+        shift = 0
+        while True:
+          b = data[pos]
+          pos += 1
+          dt |= (b & 0x7f) << shift
+          shift += 7
+          if not (b & 0x80):
+            break
+        ts += dt
+        entry = ids[data[pos]]
+        mode = data[pos+1] >> 4
+        dlc = data[pos+1] & 0x0f
+        pos += 2
+        if mode == 0:
+          payload = bytes(data[pos:pos+dlc])
+          pos += dlc
+        elif mode == 1:
+          payload = entry[2]
+        else:
+          mask = data[pos]
+          pos += 1
+          payload = bytearray(entry[2])
+          for k in range(dlc):
+            if mask & (1 << k):
+              payload[k] = data[pos]
+              pos += 1
+          payload = bytes(payload)
+        if payload is None or len(payload) != dlc:
+          raise ValueError("invalid frame record")
+        entry[2] = payload
+        yield (ts, entry[1], entry[0], payload)
+    except (IndexError, ValueError):
+      sys.stderr.write("warning: corrupt block at offset %d, skipping\n" % pos)
+    pos = end
+
+
+def write_crtd(frames, out):
+  for ts, flags, canid, payload in frames:
+    line = "%d.%06d %d%s%s " % (ts // 1000000, ts % 1000000,
+      (flags & FL_BUSMASK) + 1,
+      "T" if flags & FL_TX else "R",
+      "29" if flags & FL_EXT else "11")
+    line += "%0*X" % (8 if flags & FL_EXT else 3, canid)
+    for b in payload:
+      line += " %02x" % b
+    out.write((line + "\n").encode())
+
+
+def write_pcap(frames, out):
+  out.write(struct.pack(">IHHIIII", 0xa1b2c3d4, 2, 4, 0, 0, 8, 0xe3))
+  for ts, flags, canid, payload in frames:
+    idflags = canid
+    if flags & FL_EXT:
+      idflags |= 0x80000000
+    if flags & FL_RTR:
+      idflags |= 0x40000000
+    out.write(struct.pack(">IIIIIB3x8s", ts // 1000000, ts % 1000000, 16, 16,
+      idflags, len(payload), payload))
+
+
+def main():
+  parser = argparse.ArgumentParser(description="Convert OVMS cblock CAN traces")
+  parser.add_argument("-f", "--format", choices=["crtd", "pcap"], default="crtd")
+  parser.add_argument("infile")
+  parser.add_argument("outfile", nargs="?")
+  args = parser.parse_args()
+
+  with open(args.infile, "rb") as f:
+    data = f.read()
+  out = open(args.outfile, "wb") if args.outfile else sys.stdout.buffer
+  if args.format == "pcap":
+    write_pcap(read_frames(data), out)
+  else:
+    write_crtd(read_frames(data), out)
+  if args.outfile:
+    out.close()
+
+
+if __name__ == "__main__":
+  main()